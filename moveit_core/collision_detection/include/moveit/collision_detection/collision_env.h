@@ -43,6 +43,8 @@
 #include <moveit_msgs/msg/link_scale.hpp>
 #include <moveit/collision_detection/world.h>
 
+#include <functional>
+
 namespace collision_detection
 {
 MOVEIT_CLASS_FORWARD(CollisionEnv);  // Defines CollisionEnvPtr, ConstPtr, WeakPtr... etc
@@ -110,6 +112,26 @@ public:
   virtual void checkCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                               const AllowedCollisionMatrix& acm) const;
 
+  /** \brief Check a batch of robot states for collisions with the robot itself and the world, as checkCollision()
+   *  does for a single state. Allowed collisions specified by the allowed collision matrix are taken into account.
+   *
+   *  Implementations share the per-query setup of the collision library between the states. The default
+   *  implementation calls checkCollision() for one state after the other, as collision environments are not required
+   *  to be thread safe. Environments which are thread safe override it to distribute the states over several threads.
+   *  @param req A CollisionRequest object that is applied to every state
+   *  @param res Receives one CollisionResult per state, in the order of \e states
+   *  @param states The kinematic states for which checks are being made
+   *  @param acm The allowed collision matrix
+   *  @param num_threads The number of threads the states are distributed over, if the environment supports it. 0 uses
+   *  one thread per core.
+   *  @param stop_at_first_collision Stop once any state was found in collision. Results of states that were not
+   *  checked remain empty.
+   *  @return True if any of the checked states is in collision */
+  virtual bool checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                   const std::vector<const moveit::core::RobotState*>& states,
+                                   const AllowedCollisionMatrix& acm, std::size_t num_threads = 1,
+                                   bool stop_at_first_collision = false) const;
+
   /** \brief Check whether the robot model is in collision with the world. Any collisions between a robot link
    *  and the world are considered. Self collisions are not checked.
    *  @param req A CollisionRequest object that encapsulates the collision request
@@ -311,6 +333,16 @@ protected:
       @param links the names of the links whose padding or scaling were updated */
   virtual void updatedPaddingOrScaling(const std::vector<std::string>& links);
 
+  /** @brief Distributes the indices [0, \e count) of a batch query over \e num_threads threads of the shared thread
+      pool.
+      @param count The number of items in the batch
+      @param num_threads The number of threads to use. 0 uses one thread per core.
+      @param stop_early If set, no further indices are handed out once an item was reported in collision
+      @param make_worker Called once per thread, returns the function checking a single index with the thread's own
+     scratch data. The function returns true if the item is in collision. */
+  static void runBatch(std::size_t count, std::size_t num_threads, bool stop_early,
+                       const std::function<std::function<bool(std::size_t)>()>& make_worker);
+
   /** @brief The kinematic model corresponding to this collision model*/
   moveit::core::RobotModelConstPtr robot_model_;
 
@@ -39,10 +39,15 @@
 #include <moveit/collision_detection/collision_common.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/msg/allowed_collision_matrix.hpp>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 
 namespace collision_detection
 {
@@ -71,6 +76,7 @@ enum Type
 using DecideContactFn = std::function<bool(collision_detection::Contact&)>;
 
 MOVEIT_CLASS_FORWARD(AllowedCollisionMatrix);  // Defines AllowedCollisionMatrixPtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(CompiledAllowedCollisionMatrix);  // Defines CompiledAllowedCollisionMatrixPtr, ConstPtr, ...
 
 /** @class AllowedCollisionMatrix
  *  @brief Definition of a structure for the allowed collision matrix. All elements in the collision world are referred
@@ -93,8 +99,14 @@ public:
   /** @brief Construct the structure from a message representation */
   AllowedCollisionMatrix(const moveit_msgs::msg::AllowedCollisionMatrix& msg);
 
-  /** @brief Copy constructor */
-  AllowedCollisionMatrix(const AllowedCollisionMatrix& acm) = default;
+  /** @brief Copy constructor. The compiled form is shared with \e acm until either matrix is modified. */
+  AllowedCollisionMatrix(const AllowedCollisionMatrix& acm);
+
+  /** @brief Copy assignment. The compiled form is shared with \e acm until either matrix is modified. */
+  AllowedCollisionMatrix& operator=(const AllowedCollisionMatrix& acm);
+
+  AllowedCollisionMatrix(AllowedCollisionMatrix&& acm) = default;
+  AllowedCollisionMatrix& operator=(AllowedCollisionMatrix&& acm) = default;
 
   /** @brief Get the type of the allowed collision between two elements.
    *  Return true if the entry is included in the collision matrix. Return false if the entry is not found.
@@ -243,14 +255,158 @@ public:
   /** @brief Print the allowed collision matrix */
   void print(std::ostream& out) const;
 
+  /** @brief Get the dense, index-based form of this matrix, for use in collision checking callbacks.
+   *  It is built on first use and invalidated by any modification of the matrix. It is safe to call this
+   *  concurrently from multiple threads, as long as the matrix itself is not modified at the same time. */
+  CompiledAllowedCollisionMatrixConstPtr getCompiled() const;
+
 private:
+  friend class CompiledAllowedCollisionMatrix;
+
   bool getDefaultEntry(const std::string& name1, const std::string& name2,
                        AllowedCollision::Type& allowed_collision) const;
 
+  /** @brief Drop the compiled form, called by every modifying function */
+  void invalidateCompiled();
+
   std::map<std::string, std::map<std::string, AllowedCollision::Type> > entries_;
   std::map<std::string, std::map<std::string, DecideContactFn> > allowed_contacts_;
 
   std::map<std::string, AllowedCollision::Type> default_entries_;
   std::map<std::string, DecideContactFn> default_allowed_contacts_;
+
+  mutable CompiledAllowedCollisionMatrixConstPtr compiled_;
+};
+
+/** @class CompiledAllowedCollisionMatrix
+ *  @brief Read-only snapshot of an AllowedCollisionMatrix in which every known name is mapped to an index and
+ *  the explicit entries are stored in a dense table.
+ *
+ *  Names are resolved to indices with getIndex(), pairs are then looked up without any string comparisons.
+ *  Collision callbacks see the same object in many pairs, so they should keep an IndexCache per object and resolve
+ *  its name only once per compiled matrix. Pairs without an explicit entry fall back to the combined default
+ *  entries, and names unknown to the matrix map to UNKNOWN, for which only the default entry of the other element
+ *  applies, exactly as for AllowedCollisionMatrix::getAllowedCollision(). */
+class CompiledAllowedCollisionMatrix
+{
+public:
+  /** @brief Index of names that are not known to the matrix */
+  static constexpr std::size_t UNKNOWN = std::numeric_limits<std::size_t>::max();
+
+  /** @brief Remembers the index an element resolved to in the compiled matrix it was last looked up in.
+   *  It may be shared between threads. Copies start out empty. */
+  class IndexCache
+  {
+  public:
+    IndexCache() = default;
+    IndexCache(const IndexCache& /*other*/)
+    {
+    }
+    IndexCache& operator=(const IndexCache& /*other*/)
+    {
+      value_ = 0;
+      return *this;
+    }
+
+    /** \brief Forget the index, e.g. because the name of the element may have changed */
+    void clear() const
+    {
+      value_ = 0;
+    }
+
+  private:
+    friend class CompiledAllowedCollisionMatrix;
+
+    /** \brief The id of the compiled matrix in the upper and the index in the lower 32 bits, 0 if empty */
+    mutable std::atomic<std::uint64_t> value_{ 0 };
+  };
+
+  /** @brief Compile \e acm. Prefer AllowedCollisionMatrix::getCompiled(), which caches the result. */
+  explicit CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm);
+
+  /** @brief Get the index of element \e name, or UNKNOWN */
+  std::size_t getIndex(const std::string& name) const
+  {
+    const auto it = index_.find(name);
+    return it == index_.end() ? UNKNOWN : it->second;
+  }
+
+  /** @brief Get the index of element \e name, or UNKNOWN. The name is only resolved if \e cache does not hold the
+   *  index for this matrix yet. */
+  std::size_t getIndex(const std::string& name, const IndexCache& cache) const
+  {
+    const std::uint64_t value = cache.value_.load(std::memory_order_relaxed);
+    if ((value >> 32) == id_)
+    {
+      const std::uint32_t index = static_cast<std::uint32_t>(value);
+      return index == UNKNOWN_32 ? UNKNOWN : index;
+    }
+    const std::size_t index = getIndex(name);
+    const std::uint32_t index_32 = index == UNKNOWN ? UNKNOWN_32 : static_cast<std::uint32_t>(index);
+    cache.value_.store((static_cast<std::uint64_t>(id_) << 32) | index_32, std::memory_order_relaxed);
+    return index;
+  }
+
+  /** @brief Get the number of names known to the matrix */
+  std::size_t getSize() const
+  {
+    return size_;
+  }
+
+  /** @brief Get the type of the allowed collision between two elements given by their index.
+   *  Return false if neither an entry nor a default was found. */
+  bool getAllowedCollision(std::size_t index1, std::size_t index2, AllowedCollision::Type& allowed_collision) const
+  {
+    const std::uint8_t type = lookup(index1, index2);
+    if (type == NOT_FOUND)
+      return false;
+    allowed_collision = static_cast<AllowedCollision::Type>(type);
+    return true;
+  }
+
+  /** @brief Get the allowed collision predicate between two elements given by their index.
+   *  Return false if neither an entry nor a default predicate was found. */
+  bool getAllowedCollision(std::size_t index1, std::size_t index2, DecideContactFn& fn) const;
+
+private:
+  static constexpr std::uint8_t NOT_FOUND = std::numeric_limits<std::uint8_t>::max();
+  static constexpr std::uint32_t UNKNOWN_32 = std::numeric_limits<std::uint32_t>::max();
+
+  std::uint8_t lookup(std::size_t index1, std::size_t index2) const
+  {
+    if (index1 != UNKNOWN && index2 != UNKNOWN)
+    {
+      const std::uint8_t type = types_[index1 * size_ + index2];
+      if (type != NOT_FOUND)
+        return type;
+    }
+
+    // combine the defaults as AllowedCollisionMatrix::getDefaultEntry() does
+    const std::uint8_t type1 = index1 == UNKNOWN ? NOT_FOUND : default_types_[index1];
+    const std::uint8_t type2 = index2 == UNKNOWN ? NOT_FOUND : default_types_[index2];
+    if (type1 == NOT_FOUND)
+      return type2;
+    if (type2 == NOT_FOUND)
+      return type1;
+    if (type1 == AllowedCollision::NEVER || type2 == AllowedCollision::NEVER)
+      return AllowedCollision::NEVER;
+    if (type1 == AllowedCollision::CONDITIONAL || type2 == AllowedCollision::CONDITIONAL)
+      return AllowedCollision::CONDITIONAL;
+    return AllowedCollision::ALWAYS;
+  }
+
+  /** \brief Distinguishes the compiled matrices for the IndexCache, never 0 */
+  std::uint32_t id_;
+
+  std::size_t size_;
+  std::unordered_map<std::string, std::size_t> index_;
+
+  /** \brief Row-major size_ x size_ table of explicit AllowedCollision::Type values, NOT_FOUND for missing entries */
+  std::vector<std::uint8_t> types_;
+  std::vector<std::uint8_t> default_types_;
+
+  /** \brief Explicit predicates, keyed by index1 * size_ + index2 */
+  std::unordered_map<std::size_t, DecideContactFn> allowed_contacts_;
+  std::vector<DecideContactFn> default_allowed_contacts_;
 };
 }  // namespace collision_detection
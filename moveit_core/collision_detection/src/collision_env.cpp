@@ -37,6 +37,9 @@
 #include <moveit/collision_detection/collision_env.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <moveit/utils/thread_pool.h>
+#include <algorithm>
+#include <atomic>
 #include <limits>
 
 // Logger
@@ -316,4 +319,38 @@ void CollisionEnv::checkCollision(const CollisionRequest& req, CollisionResult&
   if (!res.collision || (req.contacts && res.contacts.size() < req.max_contacts))
     checkRobotCollision(req, res, state, acm);
 }
+
+bool CollisionEnv::checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                       const std::vector<const moveit::core::RobotState*>& states,
+                                       const AllowedCollisionMatrix& acm, std::size_t /*num_threads*/,
+                                       bool stop_at_first_collision) const
+{
+  // checkCollision() is not required to be thread safe, so the states are checked one after the other
+  res.clear();
+  res.resize(states.size());
+  bool collision = false;
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkCollision(req, res[i], *states[i], acm);
+    if (res[i].collision)
+    {
+      collision = true;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return collision;
+}
+
+void CollisionEnv::runBatch(std::size_t count, std::size_t num_threads, bool stop_early,
+                            const std::function<std::function<bool(std::size_t)>()>& make_worker)
+{
+  std::atomic<bool> stop(false);
+  moveit::core::getThreadPool().parallelForWithState(count, num_threads, [&]() {
+    return [&stop, stop_early, check = make_worker()](std::size_t i) {
+      if (!stop && check(i) && stop_early)
+        stop = true;
+    };
+  });
+}
 }  // end of namespace collision_detection
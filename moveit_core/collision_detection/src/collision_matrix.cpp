@@ -37,6 +37,7 @@
 #include <moveit/collision_detection/collision_matrix.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <algorithm>
 #include <functional>
 #include <iomanip>
 
@@ -49,6 +50,28 @@ AllowedCollisionMatrix::AllowedCollisionMatrix()
 {
 }
 
+AllowedCollisionMatrix::AllowedCollisionMatrix(const AllowedCollisionMatrix& acm)
+  : entries_(acm.entries_)
+  , allowed_contacts_(acm.allowed_contacts_)
+  , default_entries_(acm.default_entries_)
+  , default_allowed_contacts_(acm.default_allowed_contacts_)
+  , compiled_(std::atomic_load(&acm.compiled_))
+{
+}
+
+AllowedCollisionMatrix& AllowedCollisionMatrix::operator=(const AllowedCollisionMatrix& acm)
+{
+  if (this != &acm)
+  {
+    entries_ = acm.entries_;
+    allowed_contacts_ = acm.allowed_contacts_;
+    default_entries_ = acm.default_entries_;
+    default_allowed_contacts_ = acm.default_allowed_contacts_;
+    std::atomic_store(&compiled_, std::atomic_load(&acm.compiled_));
+  }
+  return *this;
+}
+
 AllowedCollisionMatrix::AllowedCollisionMatrix(const std::vector<std::string>& names, const bool allowed)
 {
   for (std::size_t i = 0; i < names.size(); ++i)
@@ -146,6 +169,7 @@ bool AllowedCollisionMatrix::hasEntry(const std::string& name1, const std::strin
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, const bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   entries_[name1][name2] = entries_[name2][name1] = v;
 
@@ -168,12 +192,14 @@ void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::strin
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, DecideContactFn& fn)
 {
+  invalidateCompiled();
   entries_[name1][name2] = entries_[name2][name1] = AllowedCollision::CONDITIONAL;
   allowed_contacts_[name1][name2] = allowed_contacts_[name2][name1] = fn;
 }
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name)
 {
+  invalidateCompiled();
   entries_.erase(name);
   allowed_contacts_.erase(name);
   for (auto& entry : entries_)
@@ -184,6 +210,7 @@ void AllowedCollisionMatrix::removeEntry(const std::string& name)
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::string& name2)
 {
+  invalidateCompiled();
   auto jt = entries_.find(name1);
   if (jt != entries_.end())
   {
@@ -247,6 +274,7 @@ void AllowedCollisionMatrix::setEntry(const std::string& name, const bool allowe
 
 void AllowedCollisionMatrix::setEntry(const bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   for (auto& entry : entries_)
   {
@@ -257,6 +285,7 @@ void AllowedCollisionMatrix::setEntry(const bool allowed)
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   default_entries_[name] = v;
   default_allowed_contacts_.erase(name);
@@ -264,6 +293,7 @@ void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const bool
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, DecideContactFn& fn)
 {
+  invalidateCompiled();
   default_entries_[name] = AllowedCollision::CONDITIONAL;
   default_allowed_contacts_[name] = fn;
 }
@@ -364,12 +394,30 @@ bool AllowedCollisionMatrix::getAllowedCollision(const std::string& name1, const
 
 void AllowedCollisionMatrix::clear()
 {
+  invalidateCompiled();
   entries_.clear();
   allowed_contacts_.clear();
   default_entries_.clear();
   default_allowed_contacts_.clear();
 }
 
+void AllowedCollisionMatrix::invalidateCompiled()
+{
+  std::atomic_store(&compiled_, CompiledAllowedCollisionMatrixConstPtr());
+}
+
+CompiledAllowedCollisionMatrixConstPtr AllowedCollisionMatrix::getCompiled() const
+{
+  CompiledAllowedCollisionMatrixConstPtr compiled = std::atomic_load(&compiled_);
+  if (!compiled)
+  {
+    // concurrent callers may both compile, the results are identical
+    compiled = std::make_shared<const CompiledAllowedCollisionMatrix>(*this);
+    std::atomic_store(&compiled_, compiled);
+  }
+  return compiled;
+}
+
 void AllowedCollisionMatrix::getAllEntryNames(std::vector<std::string>& names) const
 {
   names.clear();
@@ -483,4 +531,99 @@ void AllowedCollisionMatrix::print(std::ostream& out) const
   }
 }
 
+CompiledAllowedCollisionMatrix::CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm)
+{
+  static std::atomic<std::uint32_t> next_id(1);
+  do
+    id_ = next_id++;
+  while (id_ == 0);
+
+  std::vector<std::string> names;
+  names.reserve(acm.entries_.size() + acm.default_entries_.size());
+  for (const auto& entry : acm.entries_)
+    names.push_back(entry.first);
+  for (const auto& entry : acm.default_entries_)
+    names.push_back(entry.first);
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+
+  size_ = names.size();
+  index_.reserve(size_);
+  for (std::size_t i = 0; i < size_; ++i)
+    index_.emplace(names[i], i);
+
+  default_types_.resize(size_, NOT_FOUND);
+  default_allowed_contacts_.resize(size_);
+  for (const auto& entry : acm.default_entries_)
+    default_types_[index_[entry.first]] = entry.second;
+  for (const auto& entry : acm.default_allowed_contacts_)
+  {
+    const auto it = index_.find(entry.first);
+    if (it != index_.end())
+      default_allowed_contacts_[it->second] = entry.second;
+  }
+
+  // only the explicit entries are stored, the defaults are combined on lookup
+  types_.resize(size_ * size_, NOT_FOUND);
+  for (const auto& entry : acm.entries_)
+  {
+    std::uint8_t* row = &types_[index_[entry.first] * size_];
+    for (const auto& other : entry.second)
+    {
+      const auto it = index_.find(other.first);
+      if (it != index_.end())
+        row[it->second] = other.second;
+    }
+  }
+  for (const auto& entry : acm.allowed_contacts_)
+  {
+    const auto it1 = index_.find(entry.first);
+    if (it1 == index_.end())
+      continue;
+    for (const auto& other : entry.second)
+    {
+      const auto it2 = index_.find(other.first);
+      if (it2 != index_.end())
+        allowed_contacts_[it1->second * size_ + it2->second] = other.second;
+    }
+  }
+}
+
+bool CompiledAllowedCollisionMatrix::getAllowedCollision(std::size_t index1, std::size_t index2,
+                                                         DecideContactFn& fn) const
+{
+  if (index1 != UNKNOWN && index2 != UNKNOWN)
+  {
+    const auto it = allowed_contacts_.find(index1 * size_ + index2);
+    if (it != allowed_contacts_.end())
+    {
+      fn = it->second;
+      return true;
+    }
+  }
+
+  // fall back to the default predicates, as AllowedCollisionMatrix::getAllowedCollision() does
+  const bool found1 = index1 != UNKNOWN && default_allowed_contacts_[index1];
+  const bool found2 = index2 != UNKNOWN && default_allowed_contacts_[index2];
+  if (found1 && !found2)
+  {
+    fn = default_allowed_contacts_[index1];
+  }
+  else if (!found1 && found2)
+  {
+    fn = default_allowed_contacts_[index2];
+  }
+  else if (found1 && found2)
+  {
+    const DecideContactFn& fn1 = default_allowed_contacts_[index1];
+    const DecideContactFn& fn2 = default_allowed_contacts_[index2];
+    fn = [fn1, fn2](Contact& contact) { return andDecideContact(fn1, fn2, contact); };
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
 }  // end of namespace collision_detection
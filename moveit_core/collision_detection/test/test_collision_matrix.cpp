@@ -0,0 +1,164 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/collision_matrix.h>
+
+using namespace collision_detection;
+
+/** \brief Every pair of names has to resolve to the same entry through the compiled matrix as through the strings */
+static void expectCompiledMatches(const AllowedCollisionMatrix& acm, const std::vector<std::string>& names)
+{
+  const CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+  for (const std::string& name1 : names)
+  {
+    for (const std::string& name2 : names)
+    {
+      const std::size_t index1 = compiled->getIndex(name1);
+      const std::size_t index2 = compiled->getIndex(name2);
+
+      AllowedCollision::Type type = AllowedCollision::NEVER, compiled_type = AllowedCollision::NEVER;
+      const bool found = acm.getAllowedCollision(name1, name2, type);
+      EXPECT_EQ(found, compiled->getAllowedCollision(index1, index2, compiled_type)) << name1 << " " << name2;
+      if (found)
+      {
+        EXPECT_EQ(type, compiled_type) << name1 << " " << name2;
+      }
+
+      DecideContactFn fn, compiled_fn;
+      const bool found_fn = acm.getAllowedCollision(name1, name2, fn);
+      EXPECT_EQ(found_fn, compiled->getAllowedCollision(index1, index2, compiled_fn)) << name1 << " " << name2;
+      if (found_fn)
+      {
+        Contact contact;
+        for (double depth : { 0.005, 0.05 })
+        {
+          contact.depth = depth;
+          EXPECT_EQ(fn(contact), compiled_fn(contact)) << name1 << " " << name2;
+        }
+      }
+    }
+  }
+}
+
+TEST(CompiledAllowedCollisionMatrix, MatchesStringLookup)
+{
+  AllowedCollisionMatrix acm({ "link1", "link2", "link3", "link4" }, false);
+  acm.setEntry("link1", "link2", true);
+  DecideContactFn shallow = [](Contact& contact) { return contact.depth < 0.01; };
+  acm.setEntry("link3", "link4", shallow);
+  acm.setDefaultEntry("object1", true);
+  acm.setDefaultEntry("object2", false);
+  acm.setDefaultEntry("object3", shallow);
+
+  const std::vector<std::string> names = { "link1",   "link2",   "link3",   "link4",  "object1",
+                                           "object2", "object3", "unknown", "other" };
+  expectCompiledMatches(acm, names);
+  EXPECT_EQ(acm.getCompiled()->getIndex("unknown"), CompiledAllowedCollisionMatrix::UNKNOWN);
+}
+
+TEST(CompiledAllowedCollisionMatrix, InvalidatedOnModification)
+{
+  AllowedCollisionMatrix acm({ "link1", "link2", "link3" }, false);
+  const std::vector<std::string> names = { "link1", "link2", "link3", "object" };
+
+  const CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+  EXPECT_EQ(compiled, acm.getCompiled());
+
+  acm.setEntry("link1", "object", true);
+  EXPECT_NE(compiled, acm.getCompiled());
+  expectCompiledMatches(acm, names);
+
+  acm.removeEntry("link2");
+  expectCompiledMatches(acm, names);
+
+  acm.setDefaultEntry("object", false);
+  expectCompiledMatches(acm, names);
+
+  AllowedCollisionMatrix copy(acm);
+  copy.setEntry(true);
+  expectCompiledMatches(copy, names);
+  expectCompiledMatches(acm, names);
+
+  acm.clear();
+  EXPECT_EQ(acm.getCompiled()->getSize(), 0u);
+  expectCompiledMatches(acm, names);
+}
+
+TEST(CompiledAllowedCollisionMatrix, SharedOnCopy)
+{
+  AllowedCollisionMatrix acm({ "link1", "link2", "link3" }, false);
+  const std::vector<std::string> names = { "link1", "link2", "link3", "object" };
+  const CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+
+  AllowedCollisionMatrix copy(acm);
+  EXPECT_EQ(copy.getCompiled(), compiled);
+  copy.setEntry("link1", "object", true);
+  EXPECT_NE(copy.getCompiled(), compiled);
+  EXPECT_EQ(acm.getCompiled(), compiled);
+  expectCompiledMatches(copy, names);
+
+  copy = acm;
+  EXPECT_EQ(copy.getCompiled(), compiled);
+  expectCompiledMatches(copy, names);
+}
+
+TEST(CompiledAllowedCollisionMatrix, IndexCache)
+{
+  AllowedCollisionMatrix acm({ "link1", "link2", "link3" }, false);
+  CompiledAllowedCollisionMatrix::IndexCache cache, unknown_cache;
+
+  CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+  EXPECT_EQ(compiled->getIndex("link2", cache), compiled->getIndex("link2"));
+  EXPECT_EQ(compiled->getIndex("link2", cache), compiled->getIndex("link2"));
+  EXPECT_EQ(compiled->getIndex("unknown", unknown_cache), CompiledAllowedCollisionMatrix::UNKNOWN);
+  EXPECT_EQ(compiled->getIndex("unknown", unknown_cache), CompiledAllowedCollisionMatrix::UNKNOWN);
+
+  // a new compiled matrix resolves the names again
+  const std::size_t old_index = compiled->getIndex("link2");
+  acm.removeEntry("link1");
+  compiled = acm.getCompiled();
+  EXPECT_NE(compiled->getIndex("link2"), old_index);
+  EXPECT_EQ(compiled->getIndex("link2", cache), compiled->getIndex("link2"));
+
+  // a cleared cache resolves the name again
+  cache.clear();
+  EXPECT_EQ(compiled->getIndex("link3", cache), compiled->getIndex("link3"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
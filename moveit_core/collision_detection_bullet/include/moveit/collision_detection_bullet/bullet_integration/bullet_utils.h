@@ -140,6 +140,9 @@ public:
   /** \brief The robot links the collision objects is allowed to touch */
   std::set<std::string> m_touch_links;
 
+  /** \brief The index of this object in the compiled ACM, resolved once per ACM */
+  collision_detection::CompiledAllowedCollisionMatrix::IndexCache m_acm_index;
+
   /** @brief Get the collision object name */
   const std::string& getName() const
   {
@@ -233,6 +236,10 @@ protected:
   std::vector<std::shared_ptr<void>> m_data;
 };
 
+/** \brief Allowed = true, looked up in the compiled form of the ACM with the indices cached in the objects */
+bool acmCheck(const CollisionObjectWrapper* cow0, const CollisionObjectWrapper* cow1,
+              const collision_detection::CompiledAllowedCollisionMatrix* acm);
+
 /** @brief Casted collision shape used for checking if an object is collision free between two discrete poses
  *
  *  The cast is not explicitly computed but implicitly represented through the single shape and the transformation
@@ -534,7 +541,8 @@ struct BroadphaseContactResultCallback
 {
   ContactTestData& collisions_;
   double contact_distance_;
-  const collision_detection::AllowedCollisionMatrix* acm_{ nullptr };
+  /** \brief Compiled form of the ACM passed on construction, consulted for every broadphase pair */
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr acm_;
 
   /** \brief Indicates if the callback is used for only self-collision checking */
   bool self_;
@@ -544,7 +552,11 @@ struct BroadphaseContactResultCallback
 
   BroadphaseContactResultCallback(ContactTestData& collisions, double contact_distance,
                                   const collision_detection::AllowedCollisionMatrix* acm, bool self, bool cast = false)
-    : collisions_(collisions), contact_distance_(contact_distance), acm_(acm), self_(self), cast_(cast)
+    : collisions_(collisions)
+    , contact_distance_(contact_distance)
+    , acm_(acm ? acm->getCompiled() : nullptr)
+    , self_(self)
+    , cast_(cast)
   {
   }
 
@@ -557,12 +569,12 @@ struct BroadphaseContactResultCallback
   {
     if (cast_)
     {
-      return !collisions_.done && !isOnlyKinematic(cow0, cow1) && !acmCheck(cow0->getName(), cow1->getName(), acm_);
+      return !collisions_.done && !isOnlyKinematic(cow0, cow1) && !acmCheck(cow0, cow1, acm_.get());
     }
     else
     {
       return !collisions_.done && (self_ ? isOnlyKinematic(cow0, cow1) : !isOnlyKinematic(cow0, cow1)) &&
-             !acmCheck(cow0->getName(), cow1->getName(), acm_);
+             !acmCheck(cow0, cow1, acm_.get());
     }
   }
 
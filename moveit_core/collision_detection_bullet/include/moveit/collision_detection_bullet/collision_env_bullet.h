@@ -40,6 +40,7 @@
 #include <moveit/collision_detection_bullet/bullet_integration/bullet_discrete_bvh_manager.h>
 #include <moveit/collision_detection_bullet/bullet_integration/bullet_cast_bvh_manager.h>
 #include <mutex>
+#include <vector>
 
 namespace collision_detection
 {
@@ -78,6 +79,13 @@ public:
   void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state1,
                            const moveit::core::RobotState& state2, const AllowedCollisionMatrix& acm) const override;
 
+  /** \brief Distributes the states over \e num_threads threads, each of which checks its states with a manager
+   *   clone of its own */
+  bool checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                           const std::vector<const moveit::core::RobotState*>& states,
+                           const AllowedCollisionMatrix& acm, std::size_t num_threads = 1,
+                           bool stop_at_first_collision = false) const override;
+
   void distanceSelf(const DistanceRequest& req, DistanceResult& res,
                     const moveit::core::RobotState& state) const override;
 
@@ -87,6 +95,67 @@ public:
   void setWorld(const WorldPtr& world) override;
 
 protected:
+  /** \brief Clones of a collision manager, so that concurrent queries neither share nor lock a manager.
+   *
+   * A query takes a clone out of the pool, moves the robot and its attached objects in the clone and puts it back
+   * afterwards. The clones are discarded whenever the manager they were made from changes. */
+  template <class ManagerPtr>
+  class ManagerPool
+  {
+  public:
+    /** \brief Take a clone out of the pool, or get a new one from \e clone_fn if the pool is empty. The clone is
+     *   put back into the pool once the returned pointer and all of its copies are destroyed. */
+    template <class CloneFn>
+    ManagerPtr acquire(const CloneFn& clone_fn)
+    {
+      ManagerPtr clone;
+      std::size_t version;
+      {
+        std::scoped_lock lock(mutex_);
+        version = version_;
+        if (!clones_.empty())
+        {
+          clone = std::move(clones_.back());
+          clones_.pop_back();
+        }
+      }
+      if (!clone)
+        clone = clone_fn();
+      return ManagerPtr(clone.get(), [this, clone, version](auto* /*unused*/) { release(clone, version); });
+    }
+
+    /** \brief Discard all clones, as the manager they were made from changed. Clones that are in use are discarded
+     *   when they are put back. */
+    void clear()
+    {
+      std::scoped_lock lock(mutex_);
+      clones_.clear();
+      ++version_;
+    }
+
+  private:
+    void release(const ManagerPtr& clone, std::size_t version)
+    {
+      std::scoped_lock lock(mutex_);
+      if (version == version_)
+        clones_.push_back(clone);
+    }
+
+    std::mutex mutex_;
+    std::vector<ManagerPtr> clones_;
+    std::size_t version_ = 0;
+  };
+
+  /** \brief Get a clone of manager_ for a single query. Its contact distance threshold is raised to
+   *   \e contact_distance if that is larger than the one of manager_. */
+  collision_detection_bullet::BulletDiscreteBVHManagerPtr getManager(double contact_distance) const;
+
+  /** \brief Get a clone of manager_CCD_ for a single continuous query */
+  collision_detection_bullet::BulletCastBVHManagerPtr getManagerCCD() const;
+
+  /** \brief Discard the clones of the managers after the managers changed */
+  void clearManagerPools();
+
   /** \brief Updates the poses of the objects in the manager according to given robot state */
   void updateTransformsFromState(const moveit::core::RobotState& state,
                                  const collision_detection_bullet::BulletDiscreteBVHManagerPtr& manager) const;
@@ -110,6 +179,12 @@ protected:
   void checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                  const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
 
+  /** \brief Bundles distanceSelf and distanceRobot. The closest points of all pairs within the distance threshold
+   *  are collected as contacts by the discrete manager and converted into \e res.
+   *  @param self Compute the distances between the robot links instead of between the robot and the world */
+  void distanceHelper(const DistanceRequest& req, DistanceResult& res, const moveit::core::RobotState& state,
+                      bool self) const;
+
   /** \brief Construts a bullet collision object out of a robot link */
   void addLinkAsCollisionObject(const urdf::LinkSharedPtr& link);
 
@@ -123,8 +198,10 @@ protected:
     new collision_detection_bullet::BulletCastBVHManager()
   };
 
-  // Lock manager_ and manager_CCD_, for thread-safe collision tests
-  mutable std::mutex collision_env_mutex_;
+  /** \brief The clones of manager_ and manager_CCD_ the queries run on, so manager_ and manager_CCD_ themselves are
+   *   only changed along with the world or the robot links */
+  mutable ManagerPool<collision_detection_bullet::BulletDiscreteBVHManagerPtr> manager_pool_;
+  mutable ManagerPool<collision_detection_bullet::BulletCastBVHManagerPtr> manager_CCD_pool_;
 
   /** \brief Adds a world object to the collision managers */
   void addToManager(const World::Object* obj);
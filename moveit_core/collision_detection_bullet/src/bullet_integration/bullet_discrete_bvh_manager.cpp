@@ -56,7 +56,8 @@ BulletDiscreteBVHManagerPtr BulletDiscreteBVHManager::clone() const
     manager->addCollisionObject(new_cow);
   }
 
-  manager->setActiveCollisionObjects(active_);
+  // the clones carry the collision filters of the original objects, which setActiveCollisionObjects() would reset
+  manager->active_ = active_;
   manager->setContactDistanceThreshold(contact_distance_);
 
   return manager;
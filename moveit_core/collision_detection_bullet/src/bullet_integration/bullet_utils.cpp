@@ -47,14 +47,15 @@ static const rclcpp::Logger BULLET_LOGGER = rclcpp::get_logger("collision_detect
 
 namespace collision_detection_bullet
 {
-bool acmCheck(const std::string& body_1, const std::string& body_2,
-              const collision_detection::AllowedCollisionMatrix* acm)
+/** \brief Allowed = true, \e index_1 and \e index_2 are the indices of the bodies in \e acm */
+static bool checkACMEntry(const std::string& body_1, const std::string& body_2, std::size_t index_1,
+                          std::size_t index_2, const collision_detection::CompiledAllowedCollisionMatrix* acm)
 {
   collision_detection::AllowedCollision::Type allowed_type;
 
   if (acm != nullptr)
   {
-    if (acm->getAllowedCollision(body_1, body_2, allowed_type))
+    if (acm->getAllowedCollision(index_1, index_2, allowed_type))
     {
       if (allowed_type == collision_detection::AllowedCollision::Type::NEVER)
       {
@@ -83,6 +84,24 @@ bool acmCheck(const std::string& body_1, const std::string& body_2,
   }
 }
 
+bool acmCheck(const std::string& body_1, const std::string& body_2,
+              const collision_detection::AllowedCollisionMatrix* acm)
+{
+  if (acm == nullptr)
+    return checkACMEntry(body_1, body_2, 0, 0, nullptr);
+  const collision_detection::CompiledAllowedCollisionMatrixConstPtr compiled = acm->getCompiled();
+  return checkACMEntry(body_1, body_2, compiled->getIndex(body_1), compiled->getIndex(body_2), compiled.get());
+}
+
+bool acmCheck(const CollisionObjectWrapper* cow0, const CollisionObjectWrapper* cow1,
+              const collision_detection::CompiledAllowedCollisionMatrix* acm)
+{
+  if (acm == nullptr)
+    return checkACMEntry(cow0->getName(), cow1->getName(), 0, 0, nullptr);
+  return checkACMEntry(cow0->getName(), cow1->getName(), acm->getIndex(cow0->getName(), cow0->m_acm_index),
+                       acm->getIndex(cow1->getName(), cow1->m_acm_index), acm);
+}
+
 btCollisionShape* createShapePrimitive(const shapes::Box* geom, const CollisionObjectType& collision_object_type)
 {
   (void)(collision_object_type);
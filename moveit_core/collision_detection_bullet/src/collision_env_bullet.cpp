@@ -38,7 +38,10 @@
 #include <moveit/collision_detection_bullet/collision_detector_allocator_bullet.h>
 #include <moveit/collision_detection_bullet/bullet_integration/ros_bullet_utils.h>
 #include <moveit/collision_detection_bullet/bullet_integration/contact_checker_common.h>
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <limits>
 #include <bullet/btBulletCollisionCommon.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
@@ -48,6 +51,8 @@ namespace collision_detection
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.core.collision_detection.bullet");
 const std::string CollisionDetectorAllocatorBullet::NAME("Bullet");
 const double MAX_DISTANCE_MARGIN = 99;
+// Links made of several shapes report one closest point per pair of shapes, of which distance queries keep the closest
+const std::size_t MAX_DISTANCE_CONTACTS_PER_PAIR = 16;
 
 CollisionEnvBullet::CollisionEnvBullet(const moveit::core::RobotModelConstPtr& model, double padding, double scale)
   : CollisionEnv(model, padding, scale)
@@ -116,34 +121,30 @@ void CollisionEnvBullet::checkSelfCollisionHelper(const CollisionRequest& req, C
                                                   const moveit::core::RobotState& state,
                                                   const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  collision_detection_bullet::BulletDiscreteBVHManagerPtr manager =
+      getManager(req.distance ? MAX_DISTANCE_MARGIN : 0.0);
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> cows;
   addAttachedOjects(state, cows);
 
-  if (req.distance)
-  {
-    manager_->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
-  }
-
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : cows)
   {
-    manager_->addCollisionObject(cow);
-    manager_->setCollisionObjectsTransform(
+    manager->addCollisionObject(cow);
+    manager->setCollisionObjectsTransform(
         cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
   }
 
   // updating link positions with the current robot state
   for (const std::string& link : active_)
   {
-    manager_->setCollisionObjectsTransform(link, state.getCollisionBodyTransform(link, 0));
+    manager->setCollisionObjectsTransform(link, state.getCollisionBodyTransform(link, 0));
   }
 
-  manager_->contactTest(res, req, acm, true);
+  manager->contactTest(res, req, acm, true);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : cows)
   {
-    manager_->removeCollisionObject(cow->getName());
+    manager->removeCollisionObject(cow->getName());
   }
 }
 
@@ -179,29 +180,25 @@ void CollisionEnvBullet::checkRobotCollisionHelper(const CollisionRequest& req,
                                                    const moveit::core::RobotState& state,
                                                    const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
-
-  if (req.distance)
-  {
-    manager_->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
-  }
+  collision_detection_bullet::BulletDiscreteBVHManagerPtr manager =
+      getManager(req.distance ? MAX_DISTANCE_MARGIN : 0.0);
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
   addAttachedOjects(state, attached_cows);
-  updateTransformsFromState(state, manager_);
+  updateTransformsFromState(state, manager);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_->addCollisionObject(cow);
-    manager_->setCollisionObjectsTransform(
+    manager->addCollisionObject(cow);
+    manager->setCollisionObjectsTransform(
         cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
   }
 
-  manager_->contactTest(res, req, acm, false);
+  manager->contactTest(res, req, acm, false);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_->removeCollisionObject(cow->getName());
+    manager->removeCollisionObject(cow->getName());
   }
 }
 
@@ -210,43 +207,208 @@ void CollisionEnvBullet::checkRobotCollisionHelperCCD(const CollisionRequest& re
                                                       const moveit::core::RobotState& state2,
                                                       const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  collision_detection_bullet::BulletCastBVHManagerPtr manager = getManagerCCD();
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
   addAttachedOjects(state1, attached_cows);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_CCD_->addCollisionObject(cow);
-    manager_CCD_->setCastCollisionObjectsTransform(
+    manager->addCollisionObject(cow);
+    manager->setCastCollisionObjectsTransform(
         cow->getName(), state1.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0],
         state2.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
   }
 
   for (const std::string& link : active_)
   {
-    manager_CCD_->setCastCollisionObjectsTransform(link, state1.getCollisionBodyTransform(link, 0),
-                                                   state2.getCollisionBodyTransform(link, 0));
+    manager->setCastCollisionObjectsTransform(link, state1.getCollisionBodyTransform(link, 0),
+                                              state2.getCollisionBodyTransform(link, 0));
   }
 
-  manager_CCD_->contactTest(res, req, acm, false);
+  manager->contactTest(res, req, acm, false);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_CCD_->removeCollisionObject(cow->getName());
+    manager->removeCollisionObject(cow->getName());
   }
 }
 
-void CollisionEnvBullet::distanceSelf(const DistanceRequest& /*req*/, DistanceResult& /*res*/,
-                                      const moveit::core::RobotState& /*state*/) const
+bool CollisionEnvBullet::checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                             const std::vector<const moveit::core::RobotState*>& states,
+                                             const AllowedCollisionMatrix& acm, std::size_t num_threads,
+                                             bool stop_at_first_collision) const
+{
+  res.clear();
+  res.resize(states.size());
+
+  std::atomic<bool> collision(false);
+  runBatch(states.size(), num_threads, stop_at_first_collision, [&]() {
+    // the clone goes back into the pool once the thread is done with its states
+    collision_detection_bullet::BulletDiscreteBVHManagerPtr manager =
+        getManager(req.distance ? MAX_DISTANCE_MARGIN : 0.0);
+    std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
+    return [&, manager, attached_cows](std::size_t i) mutable {
+      const moveit::core::RobotState& state = *states[i];
+      attached_cows.clear();
+      addAttachedOjects(state, attached_cows);
+      for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
+      {
+        manager->addCollisionObject(cow);
+        manager->setCollisionObjectsTransform(
+            cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
+      }
+      updateTransformsFromState(state, manager);
+
+      manager->contactTest(res[i], req, &acm, true);
+      if (!res[i].collision || (req.contacts && res[i].contacts.size() < req.max_contacts))
+        manager->contactTest(res[i], req, &acm, false);
+      if (res[i].collision)
+        collision = true;
+
+      for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
+      {
+        manager->removeCollisionObject(cow->getName());
+      }
+      return res[i].collision;
+    };
+  });
+  return collision;
+}
+
+collision_detection_bullet::BulletDiscreteBVHManagerPtr CollisionEnvBullet::getManager(double contact_distance) const
+{
+  collision_detection_bullet::BulletDiscreteBVHManagerPtr manager =
+      manager_pool_.acquire([this] { return manager_->clone(); });
+
+  contact_distance = std::max(contact_distance, manager_->getContactDistanceThreshold());
+  if (manager->getContactDistanceThreshold() != contact_distance)
+    manager->setContactDistanceThreshold(contact_distance);
+  return manager;
+}
+
+collision_detection_bullet::BulletCastBVHManagerPtr CollisionEnvBullet::getManagerCCD() const
 {
-  RCLCPP_INFO(LOGGER, "distanceSelf is not implemented for Bullet.");
+  return manager_CCD_pool_.acquire([this] {
+    // manager_CCD_ holds the cast shapes of the links, which are changed by every query. Clone the plain objects of
+    // manager_ instead, for which the new manager creates cast shapes of its own.
+    auto manager = std::make_shared<collision_detection_bullet::BulletCastBVHManager>();
+    for (const std::pair<const std::string, collision_detection_bullet::CollisionObjectWrapperPtr>& cow :
+         manager_->getCollisionObjects())
+    {
+      manager->addCollisionObject(cow.second->clone());
+    }
+    manager->setContactDistanceThreshold(manager_CCD_->getContactDistanceThreshold());
+    return manager;
+  });
 }
 
-void CollisionEnvBullet::distanceRobot(const DistanceRequest& /*req*/, DistanceResult& /*res*/,
-                                       const moveit::core::RobotState& /*state*/) const
+void CollisionEnvBullet::clearManagerPools()
 {
-  RCLCPP_INFO(LOGGER, "distanceRobot is not implemented for Bullet.");
+  manager_pool_.clear();
+  manager_CCD_pool_.clear();
+}
+
+void CollisionEnvBullet::distanceSelf(const DistanceRequest& req, DistanceResult& res,
+                                      const moveit::core::RobotState& state) const
+{
+  distanceHelper(req, res, state, true);
+}
+
+void CollisionEnvBullet::distanceRobot(const DistanceRequest& req, DistanceResult& res,
+                                       const moveit::core::RobotState& state) const
+{
+  distanceHelper(req, res, state, false);
+}
+
+void CollisionEnvBullet::distanceHelper(const DistanceRequest& req, DistanceResult& res,
+                                        const moveit::core::RobotState& state, bool self) const
+{
+  collision_detection_bullet::BulletDiscreteBVHManagerPtr manager =
+      getManager(std::min(req.distance_threshold, MAX_DISTANCE_MARGIN));
+
+  std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
+  addAttachedOjects(state, attached_cows);
+  updateTransformsFromState(state, manager);
+
+  for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
+  {
+    manager->addCollisionObject(cow);
+    manager->setCollisionObjectsTransform(
+        cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
+  }
+
+  // every pair within the contact distance threshold is reported with its closest points or deepest penetration
+  CollisionRequest contact_req;
+  contact_req.contacts = true;
+  contact_req.max_contacts = std::numeric_limits<std::size_t>::max();
+  contact_req.max_contacts_per_pair = std::max(req.max_contacts_per_body, MAX_DISTANCE_CONTACTS_PER_PAIR);
+  CollisionResult contact_res;
+  manager->contactTest(contact_res, contact_req, req.acm, self);
+
+  for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
+  {
+    manager->removeCollisionObject(cow->getName());
+  }
+
+  auto is_active = [&req, &state, this](const std::string& name, BodyType type) {
+    const moveit::core::LinkModel* link = nullptr;
+    if (type == BodyType::ROBOT_LINK)
+    {
+      link = robot_model_->getLinkModel(name);
+    }
+    else if (type == BodyType::ROBOT_ATTACHED)
+    {
+      const moveit::core::AttachedBody* body = state.getAttachedBody(name);
+      link = body ? body->getAttachedLink() : nullptr;
+    }
+    return link && req.active_components_only->find(link) != req.active_components_only->end();
+  };
+
+  for (std::pair<const std::pair<std::string, std::string>, std::vector<Contact>>& pair : contact_res.contacts)
+  {
+    std::vector<Contact>& contacts = pair.second;
+    if (req.active_components_only && !is_active(contacts.front().body_name_1, contacts.front().body_type_1) &&
+        !is_active(contacts.front().body_name_2, contacts.front().body_type_2))
+    {
+      continue;
+    }
+
+    std::sort(contacts.begin(), contacts.end(),
+              [](const Contact& a, const Contact& b) { return a.depth < b.depth; });
+    std::size_t count = 1;
+    if (req.type == DistanceRequestType::ALL)
+      count = contacts.size();
+    else if (req.type == DistanceRequestType::LIMITED)
+      count = std::min(contacts.size(), req.max_contacts_per_body);
+
+    std::vector<DistanceResultsData> data;
+    for (std::size_t i = 0; i < count && contacts[i].depth < req.distance_threshold; ++i)
+    {
+      const Contact& contact = contacts[i];
+      DistanceResultsData dist_result;
+      // Bullet reports the penetration depth of colliding pairs as negative distance
+      dist_result.distance = req.enable_signed_distance ? contact.depth : std::max(contact.depth, 0.0);
+      dist_result.nearest_points[0] = contact.nearest_points[0];
+      dist_result.nearest_points[1] = contact.nearest_points[1];
+      dist_result.link_names[0] = contact.body_name_1;
+      dist_result.link_names[1] = contact.body_name_2;
+      dist_result.body_types[0] = contact.body_type_1;
+      dist_result.body_types[1] = contact.body_type_2;
+      if (req.enable_nearest_points || req.compute_gradient)
+        dist_result.normal = contact.normal;
+
+      if (dist_result.distance < res.minimum_distance.distance)
+        res.minimum_distance = dist_result;
+      if (dist_result.distance <= 0)
+        res.collision = true;
+      if (req.type != DistanceRequestType::GLOBAL)
+        data.push_back(dist_result);
+    }
+
+    if (!data.empty())
+      res.distances[pair.first] = std::move(data);
+  }
 }
 
 void CollisionEnvBullet::addToManager(const World::Object* obj)
@@ -319,7 +481,7 @@ void CollisionEnvBullet::setWorld(const WorldPtr& world)
 
 void CollisionEnvBullet::notifyObjectChange(const ObjectConstPtr& obj, World::Action action)
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  clearManagerPools();
   if (action == World::DESTROY)
   {
     manager_->removeCollisionObject(obj->id_);
@@ -361,6 +523,7 @@ void CollisionEnvBullet::addAttachedOjects(const moveit::core::RobotState& state
 
 void CollisionEnvBullet::updatedPaddingOrScaling(const std::vector<std::string>& links)
 {
+  clearManagerPools();
   for (const std::string& link : links)
   {
     if (robot_model_->getURDF()->links_.find(link) != robot_model_->getURDF()->links_.end())
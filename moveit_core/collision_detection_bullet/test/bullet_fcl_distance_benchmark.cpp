@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection_bullet/collision_env_bullet.h>
+#include <moveit/collision_detection_fcl/collision_env_fcl.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <geometric_shapes/shapes.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr std::size_t NUM_STATES = 200;
+constexpr std::size_t NUM_ROUNDS = 5;
+
+std::vector<moveit::core::RobotState> sampleStates(const moveit::core::RobotModelConstPtr& model)
+{
+  std::vector<moveit::core::RobotState> states(NUM_STATES, moveit::core::RobotState(model));
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToRandomPositions();
+    state.update();
+  }
+  return states;
+}
+
+// A grid of boxes around the robot, some of which the sampled states reach
+void addClutter(const collision_detection::WorldPtr& world)
+{
+  shapes::ShapeConstPtr box = std::make_shared<const shapes::Box>(0.1, 0.1, 0.1);
+  for (int i = 0; i < 5; ++i)
+    for (int j = 0; j < 5; ++j)
+    {
+      Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+      pose.translation() = Eigen::Vector3d(-1.0 + 0.5 * i, -1.0 + 0.5 * j, 0.4 + 0.1 * ((i + j) % 3));
+      world->addToObject("box_" + std::to_string(i) + "_" + std::to_string(j), box, pose);
+    }
+}
+
+// Computes the minimum distance of every state NUM_ROUNDS times and reports the rate
+std::vector<double> benchmarkEnv(const collision_detection::CollisionEnv& env, const std::string& name,
+                                 const std::vector<moveit::core::RobotState>& states,
+                                 const collision_detection::DistanceRequest& req, bool self)
+{
+  std::vector<double> distances(states.size());
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; round < NUM_ROUNDS; ++round)
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+      collision_detection::DistanceResult res;
+      if (self)
+        env.distanceSelf(req, res, states[i]);
+      else
+        env.distanceRobot(req, res, states[i]);
+      distances[i] = res.minimum_distance.distance;
+    }
+  const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  std::cerr << name << (self ? " self distance: " : " robot-world distance: ")
+            << NUM_ROUNDS * states.size() / seconds.count() << " queries/s\n";
+  return distances;
+}
+
+void benchmarkDistance(bool self)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  ASSERT_TRUE(bool(model));
+  collision_detection::AllowedCollisionMatrix acm(*model->getSRDF());
+  collision_detection::CollisionEnvFCL fcl_env(model);
+  collision_detection::CollisionEnvBullet bullet_env(model);
+  addClutter(fcl_env.getWorld());
+  addClutter(bullet_env.getWorld());
+  const std::vector<moveit::core::RobotState> states = sampleStates(model);
+
+  collision_detection::DistanceRequest req;
+  req.type = collision_detection::DistanceRequestTypes::GLOBAL;
+  req.enable_nearest_points = true;
+  req.enable_signed_distance = true;
+  req.acm = &acm;
+
+  const std::vector<double> fcl_distances = benchmarkEnv(fcl_env, "FCL", states, req, self);
+  const std::vector<double> bullet_distances = benchmarkEnv(bullet_env, "Bullet", states, req, self);
+
+  // Bullet uses convex hulls of the meshes, so the distances are close but not equal
+  double difference = 0.0;
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    ASSERT_TRUE(std::isfinite(fcl_distances[i])) << "state " << i;
+    ASSERT_TRUE(std::isfinite(bullet_distances[i])) << "state " << i;
+    difference += std::abs(fcl_distances[i] - bullet_distances[i]);
+  }
+  std::cerr << "Mean difference of the minimum distances: " << difference / states.size() << '\n';
+}
+}  // namespace
+
+TEST(BulletFCLDistanceBenchmark, Self)
+{
+  benchmarkDistance(true);
+}
+
+TEST(BulletFCLDistanceBenchmark, RobotWorld)
+{
+  benchmarkDistance(false);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -35,11 +35,101 @@
 /* Author: Jens Petit */
 
 #include <moveit/collision_detection_bullet/collision_detector_allocator_bullet.h>
+#include <moveit/collision_detection_bullet/collision_env_bullet.h>
 #include <moveit/collision_detection/test_collision_common_panda.h>
 
+#include <thread>
+
 INSTANTIATE_TYPED_TEST_CASE_P(BulletCollisionCheckPanda, CollisionDetectorPandaTest,
                               collision_detection::CollisionDetectorAllocatorBullet);
 
+INSTANTIATE_TYPED_TEST_CASE_P(BulletDistanceCheckPanda, DistanceCheckPandaTest,
+                              collision_detection::CollisionDetectorAllocatorBullet);
+
+INSTANTIATE_TYPED_TEST_CASE_P(BulletDistanceCheckPanda, DistanceFullPandaTest,
+                              collision_detection::CollisionDetectorAllocatorBullet);
+
+/** \brief Concurrent queries run on clones of the collision managers and have to agree with sequential ones, also
+ *  after the world changed. */
+TEST(BulletCollisionCheckPanda, ConcurrentQueries)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  collision_detection::AllowedCollisionMatrix acm(*robot_model->getSRDF());
+  collision_detection::CollisionEnvBullet cenv(robot_model);
+
+  shapes::ShapeConstPtr shape_ptr(new shapes::Box(.1, .1, .1));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().z() = 0.3;
+  cenv.getWorld()->addToObject("box", shape_ptr, pos);
+
+  // Home (world collision), default values (self collision) and states rotated about panda_joint1
+  moveit::core::RobotState home(robot_model);
+  setToHome(home);
+  std::vector<moveit::core::RobotState> states;
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    states.emplace_back(home);
+    if (i % 5 == 1)
+      states.back().setToDefaultValues();
+    else if (i % 5 != 0)
+    {
+      double joint1 = -0.3 * static_cast<double>(i % 5);
+      states.back().setJointPositions("panda_joint1", &joint1);
+    }
+    states.back().update();
+  }
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  for (const moveit::core::RobotState& state : states)
+    state_ptrs.push_back(&state);
+
+  collision_detection::CollisionRequest req;
+  auto check_concurrently = [&]() {
+    std::vector<bool> expected;
+    for (const moveit::core::RobotState& state : states)
+    {
+      collision_detection::CollisionResult res;
+      cenv.checkCollision(req, res, state, acm);
+      expected.push_back(res.collision);
+    }
+
+    std::vector<std::vector<bool>> results(4, std::vector<bool>(states.size()));
+    std::vector<std::thread> threads;
+    for (std::vector<bool>& result : results)
+    {
+      threads.emplace_back([&] {
+        for (std::size_t i = 0; i < states.size(); ++i)
+        {
+          collision_detection::CollisionResult res;
+          cenv.checkCollision(req, res, states[i], acm);
+          result[i] = res.collision;
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+    for (const std::vector<bool>& result : results)
+      EXPECT_EQ(result, expected);
+
+    std::vector<collision_detection::CollisionResult> res;
+    cenv.checkCollisionBatch(req, res, state_ptrs, acm, 4);
+    ASSERT_EQ(res.size(), states.size());
+    for (std::size_t i = 0; i < states.size(); ++i)
+      EXPECT_EQ(res[i].collision, expected[i]) << "state " << i;
+    return expected;
+  };
+
+  std::vector<bool> expected = check_concurrently();
+  EXPECT_TRUE(expected[0]);
+  EXPECT_TRUE(expected[1]);
+
+  // the pooled clones must not keep the box where it was
+  pos.translation().z() = 3.0;
+  cenv.getWorld()->setObjectPose("box", pos);
+  expected = check_concurrently();
+  EXPECT_FALSE(expected[0]);
+  EXPECT_TRUE(expected[1]);
+}
+
 int main(int argc, char* argv[])
 {
   testing::InitGoogleTest(&argc, argv);
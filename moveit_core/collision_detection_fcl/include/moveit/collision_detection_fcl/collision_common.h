@@ -135,6 +135,10 @@ struct CollisionGeometryData
     const World::Object* obj;
     const void* raw;
   } ptr;
+
+  /** \brief The index of this object in the compiled collision matrix, resolved once per matrix. Cleared when the
+   *  data is reused for a source object at the same address, as that may be a new object with a different name. */
+  CompiledAllowedCollisionMatrix::IndexCache acm_index;
 };
 
 /** \brief Data structure which is passed to the collision callback function of the collision manager. */
@@ -145,7 +149,12 @@ struct CollisionData
   }
 
   CollisionData(const CollisionRequest* req, CollisionResult* res, const AllowedCollisionMatrix* acm)
-    : req_(req), active_components_only_(nullptr), res_(res), acm_(acm), done_(false)
+    : req_(req)
+    , active_components_only_(nullptr)
+    , res_(res)
+    , acm_(acm)
+    , compiled_acm_(acm ? acm->getCompiled() : nullptr)
+    , done_(false)
   {
   }
 
@@ -171,6 +180,9 @@ struct CollisionData
   /** \brief The user-specified collision matrix (may be nullptr). */
   const AllowedCollisionMatrix* acm_;
 
+  /** \brief The compiled form of \e acm_, which is what the callbacks consult (nullptr if \e acm_ is). */
+  CompiledAllowedCollisionMatrixConstPtr compiled_acm_;
+
   /** \brief Flag indicating whether collision checking is complete. */
   bool done_;
 };
@@ -178,7 +190,8 @@ struct CollisionData
 /** \brief Data structure which is passed to the distance callback function of the collision manager. */
 struct DistanceData
 {
-  DistanceData(const DistanceRequest* req, DistanceResult* res) : req(req), res(res), done(false)
+  DistanceData(const DistanceRequest* req, DistanceResult* res)
+    : req(req), res(res), compiled_acm(req->acm ? req->acm->getCompiled() : nullptr), done(false)
   {
   }
   ~DistanceData()
@@ -191,10 +204,40 @@ struct DistanceData
   /** \brief Distance query results information. */
   DistanceResult* res;
 
+  /** \brief The compiled form of the collision matrix in \e req (nullptr if there is none). */
+  CompiledAllowedCollisionMatrixConstPtr compiled_acm;
+
   /** \brief Indicates if distance query is finished. */
   bool done;
 };
 
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+/** \brief Data structure which is passed to the continuous collision callback function of the collision manager.
+ *
+ *  It describes a single robot collision object moving from its transform in the start state to \e robot_tf_end_.
+ *  The object queried against the manager is \e proxy_, a box enclosing the volume swept by the robot object. */
+struct ContinuousCollisionData
+{
+  ContinuousCollisionData(CollisionData* cdata, const fcl::CollisionObjectd* robot_obj,
+                          const fcl::Transform3d& robot_tf_end, const fcl::CollisionObjectd* proxy)
+    : cdata_(cdata), robot_obj_(robot_obj), robot_tf_end_(robot_tf_end), proxy_(proxy)
+  {
+  }
+
+  /** \brief Request, result and allowed collision matrix of the query */
+  CollisionData* cdata_;
+
+  /** \brief The robot collision object, placed at its start transform */
+  const fcl::CollisionObjectd* robot_obj_;
+
+  /** \brief The transform of the robot collision object in the end state */
+  fcl::Transform3d robot_tf_end_;
+
+  /** \brief The broadphase proxy of the swept volume, which is not a collision object by itself */
+  const fcl::CollisionObjectd* proxy_;
+};
+#endif
+
 MOVEIT_STRUCT_FORWARD(FCLGeometry);
 
 /** \brief Bundles the \e CollisionGeometryData and FCL collision geometry representation into a single class. */
@@ -235,8 +278,12 @@ struct FCLGeometry
   {
     if (!newType && collision_geometry_data_)
     {
-      if (collision_geometry_data_->ptr.raw == reinterpret_cast<const void*>(data))
+      if (collision_geometry_data_->ptr.raw == reinterpret_cast<const void*>(data) &&
+          collision_geometry_data_->shape_index == shape_index)
+      {
+        collision_geometry_data_->acm_index.clear();
         return;
+      }
     }
     collision_geometry_data_ = std::make_shared<CollisionGeometryData>(data, shape_index);
     collision_geometry_->setUserData(collision_geometry_data_.get());
@@ -282,6 +329,21 @@ struct FCLManager
  *   \return True terminates the collision check, false continues it to the next pair of objects */
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data);
 
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+/** \brief Callback function used by the FCLManager for each world object whose AABB overlaps the swept volume of a
+ *   moving robot object. It runs FCL's continuous collision check between the two and reports the first time of
+ *   contact.
+ *
+ *   The motion of the robot object is approximated by interpolating its pose linearly between the start and the end
+ *   state, the world object is static.
+ *
+ *   \param o1 First FCL collision object
+ *   \param o2 Second FCL collision object
+ *   \data Pointer to the ContinuousCollisionData of the moving robot object
+ *   \return True terminates the collision check, false continues it to the next pair of objects */
+bool continuousCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data);
+#endif
+
 /** \brief Callback function used by the FCLManager used for each pair of collision objects to
  *   calculate collisions and distances.
  *
@@ -316,6 +378,17 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding,
                                             const World::Object* obj);
 
+/** \brief Retrieve the FCL geometry and a collision object prototype for every shape of the attached body \e ab.
+ *
+ *  The geometries come from the same per-thread caches as createCollisionGeometry(), scaled or padded ones included,
+ *  and the prototypes already have their local AABB computed, so bodies carried over between robot states neither
+ *  rebuild their geometry nor recompute its AABB. Collision objects are obtained by copying a prototype and setting
+ *  its transform. Both output vectors are indexed like the shapes of \e ab and hold nullptr for unsupported shapes.
+ *  The returned geometries have to be kept alive while their collision objects are in use. */
+void getAttachedBodyCollisionObjects(const moveit::core::AttachedBody* ab, double scale, double padding,
+                                     std::vector<FCLGeometryConstPtr>& geoms,
+                                     std::vector<FCLCollisionObjectConstPtr>& prototypes);
+
 /** \brief Increases the counter of the caches which can trigger the cleaning of expired entries from them. */
 void cleanCollisionGeometryCache();
 
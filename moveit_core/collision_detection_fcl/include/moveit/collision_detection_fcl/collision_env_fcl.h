@@ -46,6 +46,7 @@
 #endif
 
 #include <memory>
+#include <mutex>
 
 namespace collision_detection
 {
@@ -82,6 +83,11 @@ public:
   void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state1,
                            const moveit::core::RobotState& state2) const override;
 
+  bool checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                           const std::vector<const moveit::core::RobotState*>& states,
+                           const AllowedCollisionMatrix& acm, std::size_t num_threads = 1,
+                           bool stop_at_first_collision = false) const override;
+
   void distanceSelf(const DistanceRequest& req, DistanceResult& res,
                     const moveit::core::RobotState& state) const override;
 
@@ -108,6 +114,14 @@ protected:
   void checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                  const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
 
+  /** \brief Bundles the different continuous checkRobotCollision functions into a single function.
+   *
+   *   Every robot collision object is swept from its pose in \e state1 to its pose in \e state2. World objects
+   *   overlapping the swept volume are checked with FCL's continuous collision check. */
+  void checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                    const moveit::core::RobotState& state1, const moveit::core::RobotState& state2,
+                                    const AllowedCollisionMatrix* acm) const;
+
   /** \brief Construct an FCL collision object from MoveIt's World::Object. */
   void constructFCLObjectWorld(const World::Object* obj, FCLObject& fcl_obj) const;
 
@@ -130,6 +144,45 @@ protected:
    *   state and specifying a broadphase collision manager of FCL where the constructed object is registered to. */
   void allocSelfCollisionBroadPhase(const moveit::core::RobotState& state, FCLManager& manager) const;
 
+  /** \brief A self-collision broadphase which is kept alive across queries.
+   *
+   *   It owns private copies of the robot's link collision objects, which are registered only once with the FCL
+   *   manager. For each query only their transforms are set and the tree is refitted. Objects of attached bodies are
+   *   kept registered as well, until a query comes with different attached bodies. */
+  struct SelfCollisionBroadPhase
+  {
+    /** \brief Copies of the non-empty entries of \e robot_fcl_objs_ */
+    FCLObject links_;
+
+    /** \brief Index into \e robot_geoms_ for each entry of \e links_ */
+    std::vector<std::size_t> link_indices_;
+
+    /** \brief Attached body objects registered for the last query. Their geometries are only held during a query. */
+    FCLObject attached_;
+
+    std::unique_ptr<fcl::BroadPhaseCollisionManagerd> manager_;
+
+    /** \brief Value of \e robot_geoms_version_ at construction time */
+    std::size_t robot_geoms_version_;
+  };
+
+  /** \brief Takes a self-collision broadphase out of the pool (building a new one if the pool is empty) and updates
+   *   it to \e state.
+   *
+   *   The returned broadphase is used exclusively by the calling thread until it is handed back through
+   *   releaseSelfCollisionBroadPhase(). */
+  std::unique_ptr<SelfCollisionBroadPhase> acquireSelfCollisionBroadPhase(const moveit::core::RobotState& state) const;
+
+  /** \brief Updates the transforms of all objects in \e broadphase to \e state and refits its tree. */
+  void updateSelfCollisionBroadPhase(SelfCollisionBroadPhase& broadphase, const moveit::core::RobotState& state) const;
+
+  /** \brief Brings the attached body objects in \e broadphase in line with the bodies attached in \e state. */
+  void updateAttachedBodiesInBroadPhase(SelfCollisionBroadPhase& broadphase,
+                                        const moveit::core::RobotState& state) const;
+
+  /** \brief Releases the attached body geometries of the last query and returns the broadphase to the pool. */
+  void releaseSelfCollisionBroadPhase(std::unique_ptr<SelfCollisionBroadPhase> broadphase) const;
+
   /** \brief Converts all shapes which make up an attached body into a vector of FCLGeometryConstPtr.
    *
    *   When they are converted, they can be added to the FCL representation of the robot for collision checking.
@@ -150,6 +203,13 @@ protected:
 
   std::map<std::string, FCLObject> fcl_objs_;
 
+  /** \brief Incremented whenever \e robot_fcl_objs_ changes, invalidating pooled self-collision broadphases */
+  std::size_t robot_geoms_version_{ 0 };
+
+  /** \brief Idle self-collision broadphases, one is handed out per concurrent query */
+  mutable std::vector<std::unique_ptr<SelfCollisionBroadPhase>> self_collision_pool_;
+  mutable std::mutex self_collision_pool_lock_;
+
 private:
   /** \brief Callback function executed for each change to the world environment */
   void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
@@ -43,12 +43,14 @@
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/geometry/bvh/BVH_model.h>
 #include <fcl/geometry/octree/octree.h>
+#include <fcl/narrowphase/continuous_collision.h>
 #else
 #include <fcl/BVH/BVH_model.h>
 #include <fcl/shape/geometric_shapes.h>
 #include <fcl/octree.h>
 #endif
 
+#include <algorithm>
 #include <memory>
 #include <type_traits>
 #include <mutex>
@@ -91,10 +93,13 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   // use the collision matrix (if any) to avoid certain collision checks
   DecideContactFn dcf;
   bool always_allow_collision = false;
-  if (cdata->acm_)
+  if (cdata->compiled_acm_)
   {
+    const CompiledAllowedCollisionMatrix& acm = *cdata->compiled_acm_;
+    const std::size_t index1 = acm.getIndex(cd1->getID(), cd1->acm_index);
+    const std::size_t index2 = acm.getIndex(cd2->getID(), cd2->acm_index);
     AllowedCollision::Type type;
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = acm.getAllowedCollision(index1, index2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -112,7 +117,7 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
       }
       else if (type == AllowedCollision::CONDITIONAL)
       {
-        cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), dcf);
+        acm.getAllowedCollision(index1, index2, dcf);
         if (cdata->req_->verbose)
         {
           RCLCPP_DEBUG(LOGGER, "Collision between '%s' and '%s' is conditionally allowed", cd1->getID().c_str(),
@@ -396,6 +401,136 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   return cdata->done_;
 }
 
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+bool continuousCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  ContinuousCollisionData* ccdata = reinterpret_cast<ContinuousCollisionData*>(data);
+  CollisionData* cdata = ccdata->cdata_;
+  if (cdata->done_)
+    return true;
+
+  // one of the objects is the swept volume proxy, the other one is a world object
+  const fcl::CollisionObjectd* world_obj = o1 == ccdata->proxy_ ? o2 : o1;
+  const fcl::CollisionObjectd* robot_obj = ccdata->robot_obj_;
+  const CollisionGeometryData* cd1 =
+      static_cast<const CollisionGeometryData*>(robot_obj->collisionGeometry()->getUserData());
+  const CollisionGeometryData* cd2 =
+      static_cast<const CollisionGeometryData*>(world_obj->collisionGeometry()->getUserData());
+
+  // use the collision matrix (if any) to avoid certain collision checks
+  DecideContactFn dcf;
+  if (cdata->compiled_acm_)
+  {
+    const CompiledAllowedCollisionMatrix& acm = *cdata->compiled_acm_;
+    const std::size_t index1 = acm.getIndex(cd1->getID(), cd1->acm_index);
+    const std::size_t index2 = acm.getIndex(cd2->getID(), cd2->acm_index);
+    AllowedCollision::Type type;
+    if (acm.getAllowedCollision(index1, index2, type))
+    {
+      if (type == AllowedCollision::ALWAYS)
+      {
+        if (cdata->req_->verbose)
+        {
+          RCLCPP_DEBUG(LOGGER, "Collision between '%s' and '%s' is always allowed. No contacts are computed.",
+                       cd1->getID().c_str(), cd2->getID().c_str());
+        }
+        return false;
+      }
+      else if (type == AllowedCollision::CONDITIONAL)
+        acm.getAllowedCollision(index1, index2, dcf);
+    }
+  }
+
+  fcl::ContinuousCollisionRequestd ccd_request;
+  ccd_request.ccd_motion_type = fcl::CCDM_LINEAR;
+  ccd_request.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
+  fcl::ContinuousCollisionResultd ccd_result;
+  double time_of_contact = fcl::continuousCollide(robot_obj, ccdata->robot_tf_end_, world_obj,
+                                                  world_obj->getTransform(), ccd_request, ccd_result);
+  if (time_of_contact < 0)
+  {
+    // conservative advancement is not available for this pair of geometry types, fall back to sampling the motion
+    ccd_request.ccd_solver_type = fcl::CCDC_NAIVE;
+    ccd_result = fcl::ContinuousCollisionResultd();
+    fcl::continuousCollide(robot_obj, ccdata->robot_tf_end_, world_obj, world_obj->getTransform(), ccd_request,
+                           ccd_result);
+  }
+  if (!ccd_result.is_collide)
+    return false;
+
+  // compute contacts with the robot object placed at the time of contact
+  fcl::CollisionObjectd robot_at_contact(*robot_obj);
+  robot_at_contact.setTransform(ccd_result.contact_tf1);
+  robot_at_contact.computeAABB();
+  fcl::CollisionResultd col_result;
+  std::size_t num_contacts = 0;
+  if (cdata->req_->contacts || dcf)
+  {
+    num_contacts = fcl::collide(&robot_at_contact, world_obj,
+                                fcl::CollisionRequestd(std::numeric_limits<size_t>::max(), true), col_result);
+  }
+
+  std::vector<Contact> contacts;
+  for (std::size_t i = 0; i < num_contacts; ++i)
+  {
+    Contact c;
+    fcl2contact(col_result.getContact(i), c);
+    c.percent_interpolation = ccd_result.time_of_contact;
+    // if we have a decider for allowed contacts, only the contacts it rejects constitute a collision
+    if (!dcf || !dcf(c))
+      contacts.push_back(c);
+  }
+  if (dcf && num_contacts > 0 && contacts.empty())
+    return false;
+
+  if (contacts.empty())
+  {
+    // the bodies only touch at the time of contact, report the contact at the robot object
+    Contact c;
+    const fcl::AABBd& aabb = robot_at_contact.getAABB();
+    c.pos = aabb.center();
+    c.normal.setZero();
+    c.depth = 0.0;
+    c.body_name_1 = cd1->getID();
+    c.body_type_1 = cd1->type;
+    c.body_name_2 = cd2->getID();
+    c.body_type_2 = cd2->type;
+    c.percent_interpolation = ccd_result.time_of_contact;
+    contacts.push_back(c);
+  }
+
+  cdata->res_->collision = true;
+  if (cdata->req_->verbose)
+  {
+    RCLCPP_INFO(LOGGER, "Found a continuous collision between '%s' (type '%s') and '%s' (type '%s') at %f of motion",
+                cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(),
+                cd2->getTypeString().c_str(), ccd_result.time_of_contact);
+  }
+
+  if (cdata->req_->contacts && cdata->res_->contact_count < cdata->req_->max_contacts)
+  {
+    const std::pair<std::string, std::string> pc = cd1->getID() < cd2->getID() ?
+                                                       std::make_pair(cd1->getID(), cd2->getID()) :
+                                                       std::make_pair(cd2->getID(), cd1->getID());
+    std::vector<Contact>& pair_contacts = cdata->res_->contacts[pc];
+    for (std::size_t i = 0; i < contacts.size() && pair_contacts.size() < cdata->req_->max_contacts_per_pair &&
+                            cdata->res_->contact_count < cdata->req_->max_contacts;
+         ++i)
+    {
+      pair_contacts.push_back(contacts[i]);
+      cdata->res_->contact_count++;
+    }
+  }
+
+  if (!cdata->req_->contacts || cdata->res_->contact_count >= cdata->req_->max_contacts)
+    cdata->done_ = true;
+  if (!cdata->done_ && cdata->req_->is_done)
+    cdata->done_ = cdata->req_->is_done(*cdata->res_);
+
+  return cdata->done_;
+}
+#endif
+
 /** \brief Cache for an arbitrary type of shape. It is assigned during the execution of \e createCollisionGeometry().
  *
  *  Only a single cache per thread and object type is created as it is a quasi-singleton instance. */
@@ -473,10 +608,13 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
 
   // use the collision matrix (if any) to avoid certain distance checks
   bool always_allow_collision = false;
-  if (cdata->req->acm)
+  if (cdata->compiled_acm)
   {
+    const CompiledAllowedCollisionMatrix& acm = *cdata->compiled_acm;
     AllowedCollision::Type type;
-    bool found = cdata->req->acm->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    const std::size_t index1 = acm.getIndex(cd1->getID(), cd1->acm_index);
+    const std::size_t index2 = acm.getIndex(cd2->getID(), cd2->acm_index);
+    bool found = acm.getAllowedCollision(index1, index2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -742,11 +880,13 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
     ShapeMap::const_iterator cache_it = cache.map_.find(wptr);
     if (cache_it != cache.map_.end())
     {
-      if (cache_it->second->collision_geometry_data_->ptr.raw == data)
+      if (cache_it->second->collision_geometry_data_->ptr.raw == data &&
+          cache_it->second->collision_geometry_data_->shape_index == shape_index)
       {
         //        RCLCPP_DEBUG(LOGGER, "Collision data structures for object %s retrieved from
         //        cache.",
         //        cache_it->second->collision_geometry_data_->getID().c_str());
+        cache_it->second->collision_geometry_data_->acm_index.clear();
         return cache_it->second;
       }
       else if (cache_it->second.unique())
@@ -964,6 +1104,144 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   return createCollisionGeometry<fcl::OBBRSSd, World::Object>(shape, scale, padding, obj, 0);
 }
 
+/** \brief Cache for the FCL representation of attached body shapes, complementing \e FCLShapeCache.
+ *
+ *  Unscaled and unpadded geometries are owned by \e FCLShapeCache, which also moves them between the world and the
+ *  attached body caches on attach and detach. Scaled or padded geometries cannot be found there again, as they are
+ *  built from a scaled copy of the shape, so they are owned by this cache. For both kinds, a collision object
+ *  prototype with a precomputed local AABB is kept.
+ *
+ *  A geometry is only redirected to another body or shape index if nobody but the cache holds it, just like
+ *  \e FCLShapeCache does. Otherwise another geometry is used, so every collision object of a query carries the user
+ *  data of its own body and shape.
+ *
+ *  Like \e FCLShapeCache, a single instance per thread is created. */
+struct FCLAttachedBodyCache
+{
+  using ShapeKey = shapes::ShapeConstWeakPtr;
+  using GeometryKey = std::weak_ptr<const FCLGeometry>;
+
+  struct ScaledEntry
+  {
+    double scale;
+    double padding;
+    FCLGeometryConstPtr geometry;
+  };
+
+  /** \brief Remove entries of shapes and geometries that do not exist anymore */
+  void clean()
+  {
+    for (auto it = scaled_.begin(); it != scaled_.end();)
+    {
+      if (it->first.expired())
+        it = scaled_.erase(it);
+      else
+        ++it;
+    }
+    for (auto it = prototypes_.begin(); it != prototypes_.end();)
+    {
+      if (it->first.expired())
+        it = prototypes_.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  /** \brief Count a cache miss and clean the cache every \m FCLShapeCache::MAX_CLEAN_COUNT misses */
+  void bumpMissCount()
+  {
+    if (++clean_count_ > FCLShapeCache::MAX_CLEAN_COUNT)
+    {
+      clean_count_ = 0;
+      clean();
+    }
+  }
+
+  /** \brief Get a scaled or padded geometry of \e shape for the shape at \e shape_index of \e ab */
+  FCLGeometryConstPtr getScaledGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding,
+                                        const moveit::core::AttachedBody* ab, int shape_index)
+  {
+    std::vector<ScaledEntry>& entries = scaled_[shape];
+    ScaledEntry* unused = nullptr;
+    for (ScaledEntry& entry : entries)
+    {
+      if (entry.scale != scale || entry.padding != padding)
+        continue;
+      const CollisionGeometryData& data = *entry.geometry->collision_geometry_data_;
+      if (data.ptr.ab == ab && data.shape_index == shape_index)
+      {
+        data.acm_index.clear();
+        return entry.geometry;
+      }
+      if (!unused && entry.geometry.unique())
+        unused = &entry;
+    }
+    if (unused)
+    {
+      const_cast<FCLGeometry*>(unused->geometry.get())->updateCollisionGeometryData(ab, shape_index, false);
+      return unused->geometry;
+    }
+
+    FCLGeometryConstPtr geometry = createCollisionGeometry(shape, scale, padding, ab, shape_index);
+    if (geometry)
+    {
+      entries.push_back({ scale, padding, geometry });
+      bumpMissCount();
+    }
+    return geometry;
+  }
+
+  /** \brief Get the collision object prototype of \e geometry */
+  const FCLCollisionObjectConstPtr& getPrototype(const FCLGeometryConstPtr& geometry)
+  {
+    FCLCollisionObjectConstPtr& prototype = prototypes_[geometry];
+    if (!prototype)
+    {
+      prototype = std::make_shared<const fcl::CollisionObjectd>(geometry->collision_geometry_);
+      bumpMissCount();
+    }
+    return prototype;
+  }
+
+  static FCLAttachedBodyCache& get()
+  {
+    static thread_local FCLAttachedBodyCache cache;
+    return cache;
+  }
+
+  /** \brief Scaled or padded geometries of each shape, possibly several per combination of scale and padding */
+  std::map<ShapeKey, std::vector<ScaledEntry>, std::owner_less<ShapeKey>> scaled_;
+
+  /** \brief Collision object prototypes. They only hold the FCL geometry, so they do not keep a \e FCLGeometry from
+   *  being unique in \e FCLShapeCache. */
+  std::map<GeometryKey, FCLCollisionObjectConstPtr, std::owner_less<GeometryKey>> prototypes_;
+
+  /** \brief Counts cache misses and triggers clean() when \m FCLShapeCache::MAX_CLEAN_COUNT is exceeded. */
+  unsigned int clean_count_ = 0;
+};
+
+void getAttachedBodyCollisionObjects(const moveit::core::AttachedBody* ab, double scale, double padding,
+                                     std::vector<FCLGeometryConstPtr>& geoms,
+                                     std::vector<FCLCollisionObjectConstPtr>& prototypes)
+{
+  FCLAttachedBodyCache& cache = FCLAttachedBodyCache::get();
+  const std::vector<shapes::ShapeConstPtr>& shapes = ab->getShapes();
+  const bool scaled = fabs(scale - 1.0) > std::numeric_limits<double>::epsilon() ||
+                      fabs(padding) > std::numeric_limits<double>::epsilon();
+  geoms.clear();
+  prototypes.clear();
+  geoms.resize(shapes.size());
+  prototypes.resize(shapes.size());
+  for (std::size_t i = 0; i < shapes.size(); ++i)
+  {
+    // the geometries of earlier shapes are held in geoms, so a shape listed twice gets a geometry of its own
+    geoms[i] = scaled ? cache.getScaledGeometry(shapes[i], scale, padding, ab, i) :
+                        createCollisionGeometry(shapes[i], ab, i);
+    if (geoms[i])
+      prototypes[i] = cache.getPrototype(geoms[i]);
+  }
+}
+
 void cleanCollisionGeometryCache()
 {
   FCLShapeCache& cache1 = GetShapeCache<fcl::OBBRSSd, World::Object>();
@@ -974,6 +1252,7 @@ void cleanCollisionGeometryCache()
   {
     cache2.bumpUseCount(true);
   }
+  FCLAttachedBodyCache::get().clean();
 }
 
 void CollisionData::enableGroup(const moveit::core::RobotModelConstPtr& robot_model)
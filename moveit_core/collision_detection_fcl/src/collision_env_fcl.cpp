@@ -42,8 +42,12 @@
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
+#include <fcl/geometry/shape/box.h>
 #endif
 
 namespace collision_detection
@@ -223,25 +227,28 @@ void CollisionEnvFCL::constructFCLObjectRobot(const moveit::core::RobotState& st
     }
   }
 
-  // TODO: Implement a method for caching fcl::CollisionObject's for moveit::core::AttachedBody's
   std::vector<const moveit::core::AttachedBody*> ab;
   state.getAttachedBodies(ab);
+  std::vector<FCLGeometryConstPtr> geoms;
+  std::vector<FCLCollisionObjectConstPtr> prototypes;
   for (auto& body : ab)
   {
-    std::vector<FCLGeometryConstPtr> objs;
-    getAttachedBodyObjects(body, objs);
+    getAttachedBodyCollisionObjects(body, getLinkScale(body->getAttachedLinkName()),
+                                    getLinkPadding(body->getAttachedLinkName()), geoms, prototypes);
     const EigenSTL::vector_Isometry3d& ab_t = body->getGlobalCollisionBodyTransforms();
-    for (std::size_t k = 0; k < objs.size(); ++k)
+    for (std::size_t k = 0; k < geoms.size(); ++k)
     {
-      if (objs[k]->collision_geometry_)
-      {
-        transform2fcl(ab_t[k], fcl_tf);
-        fcl_obj.collision_objects_.push_back(
-            std::make_shared<fcl::CollisionObjectd>(objs[k]->collision_geometry_, fcl_tf));
-        // we copy the shared ptr to the CollisionGeometryData, as this is not stored by the class itself,
-        // and would be destroyed when objs goes out of scope.
-        fcl_obj.collision_geometry_.push_back(objs[k]);
-      }
+      if (!geoms[k])
+        continue;
+      // copying the prototype avoids recomputing the local AABB of the geometry
+      auto coll_obj = std::make_shared<fcl::CollisionObjectd>(*prototypes[k]);
+      transform2fcl(ab_t[k], fcl_tf);
+      coll_obj->setTransform(fcl_tf);
+      coll_obj->computeAABB();
+      fcl_obj.collision_objects_.push_back(coll_obj);
+      // we copy the shared ptr to the CollisionGeometryData, as this is not stored by the class itself,
+      // and would be destroyed when geoms goes out of scope.
+      fcl_obj.collision_geometry_.push_back(geoms[k]);
     }
   }
 }
@@ -254,6 +261,137 @@ void CollisionEnvFCL::allocSelfCollisionBroadPhase(const moveit::core::RobotStat
   manager.object_.registerTo(manager.manager_.get());
 }
 
+std::unique_ptr<CollisionEnvFCL::SelfCollisionBroadPhase>
+CollisionEnvFCL::acquireSelfCollisionBroadPhase(const moveit::core::RobotState& state) const
+{
+  std::unique_ptr<SelfCollisionBroadPhase> broadphase;
+  {
+    std::scoped_lock slock(self_collision_pool_lock_);
+    while (!self_collision_pool_.empty() && !broadphase)
+    {
+      broadphase = std::move(self_collision_pool_.back());
+      self_collision_pool_.pop_back();
+      // drop broadphases built before the last padding or scaling change
+      if (broadphase->robot_geoms_version_ != robot_geoms_version_)
+        broadphase.reset();
+    }
+  }
+
+  if (!broadphase)
+  {
+    // build the tree once, subsequent queries only refit it
+    broadphase = std::make_unique<SelfCollisionBroadPhase>();
+    broadphase->manager_ = std::make_unique<fcl::DynamicAABBTreeCollisionManagerd>();
+    broadphase->robot_geoms_version_ = robot_geoms_version_;
+    fcl::Transform3d fcl_tf;
+    for (std::size_t i = 0; i < robot_geoms_.size(); ++i)
+    {
+      if (robot_geoms_[i] && robot_geoms_[i]->collision_geometry_)
+      {
+        transform2fcl(state.getCollisionBodyTransform(robot_geoms_[i]->collision_geometry_data_->ptr.link,
+                                                      robot_geoms_[i]->collision_geometry_data_->shape_index),
+                      fcl_tf);
+        auto coll_obj = std::make_shared<fcl::CollisionObjectd>(*robot_fcl_objs_[i]);
+        coll_obj->setTransform(fcl_tf);
+        coll_obj->computeAABB();
+        broadphase->links_.collision_objects_.push_back(coll_obj);
+        broadphase->link_indices_.push_back(i);
+      }
+    }
+    broadphase->links_.registerTo(broadphase->manager_.get());
+    updateAttachedBodiesInBroadPhase(*broadphase, state);
+    broadphase->manager_->update();
+  }
+  else
+    updateSelfCollisionBroadPhase(*broadphase, state);
+
+  return broadphase;
+}
+
+void CollisionEnvFCL::updateSelfCollisionBroadPhase(SelfCollisionBroadPhase& broadphase,
+                                                    const moveit::core::RobotState& state) const
+{
+  fcl::Transform3d fcl_tf;
+  for (std::size_t i = 0; i < broadphase.link_indices_.size(); ++i)
+  {
+    const CollisionGeometryData& data = *robot_geoms_[broadphase.link_indices_[i]]->collision_geometry_data_;
+    transform2fcl(state.getCollisionBodyTransform(data.ptr.link, data.shape_index), fcl_tf);
+    fcl::CollisionObjectd& coll_obj = *broadphase.links_.collision_objects_[i];
+    coll_obj.setTransform(fcl_tf);
+    coll_obj.computeAABB();
+  }
+  updateAttachedBodiesInBroadPhase(broadphase, state);
+
+  // refit the tree to the new AABBs
+  broadphase.manager_->update();
+}
+
+void CollisionEnvFCL::updateAttachedBodiesInBroadPhase(SelfCollisionBroadPhase& broadphase,
+                                                       const moveit::core::RobotState& state) const
+{
+  // Attached objects stay registered as long as consecutive queries carry the same bodies. From the first body that
+  // differs on, the objects of the previous query are replaced.
+  fcl::Transform3d fcl_tf;
+  std::vector<const moveit::core::AttachedBody*> ab;
+  state.getAttachedBodies(ab);
+  std::vector<FCLGeometryConstPtr> geoms;
+  std::vector<FCLCollisionObjectConstPtr> prototypes;
+  FCLObject& attached = broadphase.attached_;
+  // the geometries are index-aligned with the registered objects, a released broadphase holds no geometries
+  attached.collision_geometry_.resize(attached.collision_objects_.size());
+  std::size_t num_attached = 0;
+  for (auto& body : ab)
+  {
+    getAttachedBodyCollisionObjects(body, getLinkScale(body->getAttachedLinkName()),
+                                    getLinkPadding(body->getAttachedLinkName()), geoms, prototypes);
+    const EigenSTL::vector_Isometry3d& ab_t = body->getGlobalCollisionBodyTransforms();
+    for (std::size_t k = 0; k < geoms.size(); ++k)
+    {
+      if (!geoms[k])
+        continue;
+      transform2fcl(ab_t[k], fcl_tf);
+      if (num_attached < attached.collision_objects_.size() &&
+          attached.collision_objects_[num_attached]->collisionGeometry() == geoms[k]->collision_geometry_)
+      {
+        fcl::CollisionObjectd& coll_obj = *attached.collision_objects_[num_attached];
+        coll_obj.setTransform(fcl_tf);
+        coll_obj.computeAABB();
+        attached.collision_geometry_[num_attached] = geoms[k];
+      }
+      else
+      {
+        for (std::size_t j = num_attached; j < attached.collision_objects_.size(); ++j)
+          broadphase.manager_->unregisterObject(attached.collision_objects_[j].get());
+        attached.collision_objects_.resize(num_attached);
+        attached.collision_geometry_.resize(num_attached);
+
+        auto coll_obj = std::make_shared<fcl::CollisionObjectd>(*prototypes[k]);
+        coll_obj->setTransform(fcl_tf);
+        coll_obj->computeAABB();
+        broadphase.manager_->registerObject(coll_obj.get());
+        attached.collision_objects_.push_back(coll_obj);
+        attached.collision_geometry_.push_back(geoms[k]);
+      }
+      ++num_attached;
+    }
+  }
+  for (std::size_t j = num_attached; j < attached.collision_objects_.size(); ++j)
+    broadphase.manager_->unregisterObject(attached.collision_objects_[j].get());
+  attached.collision_objects_.resize(num_attached);
+  attached.collision_geometry_.resize(num_attached);
+}
+
+void CollisionEnvFCL::releaseSelfCollisionBroadPhase(std::unique_ptr<SelfCollisionBroadPhase> broadphase) const
+{
+  // Pooled broadphases must not hold on to the geometries of attached bodies, as the caches only redirect geometries
+  // which nobody else holds to other bodies. The registered objects keep their FCL geometries alive, which is enough to
+  // recognize them on the next query.
+  broadphase->attached_.collision_geometry_.clear();
+  std::scoped_lock slock(self_collision_pool_lock_);
+  if (broadphase->robot_geoms_version_ == robot_geoms_version_)
+    self_collision_pool_.push_back(std::move(broadphase));
+}
+
 void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                          const moveit::core::RobotState& state) const
 {
@@ -270,11 +408,11 @@ void CollisionEnvFCL::checkSelfCollisionHelper(const CollisionRequest& req, Coll
                                                const moveit::core::RobotState& state,
                                                const AllowedCollisionMatrix* acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  std::unique_ptr<SelfCollisionBroadPhase> broadphase = acquireSelfCollisionBroadPhase(state);
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
-  manager.manager_->collide(&cd, &collisionCallback);
+  broadphase->manager_->collide(&cd, &collisionCallback);
+  releaseSelfCollisionBroadPhase(std::move(broadphase));
   if (req.distance)
   {
     DistanceRequest dreq;
@@ -301,19 +439,19 @@ void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, Collision
   checkRobotCollisionHelper(req, res, state, &acm);
 }
 
-void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& /*req*/, CollisionResult& /*res*/,
-                                          const moveit::core::RobotState& /*state1*/,
-                                          const moveit::core::RobotState& /*state2*/) const
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                          const moveit::core::RobotState& state1,
+                                          const moveit::core::RobotState& state2) const
 {
-  RCLCPP_ERROR(LOGGER, "Continuous collision not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, nullptr);
 }
 
-void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& /*req*/, CollisionResult& /*res*/,
-                                          const moveit::core::RobotState& /*state1*/,
-                                          const moveit::core::RobotState& /*state2*/,
-                                          const AllowedCollisionMatrix& /*acm*/) const
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
+                                          const moveit::core::RobotState& state1,
+                                          const moveit::core::RobotState& state2,
+                                          const AllowedCollisionMatrix& acm) const
 {
-  RCLCPP_ERROR(LOGGER, "Not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, &acm);
 }
 
 void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
@@ -341,16 +479,140 @@ void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, Col
   }
 }
 
+bool CollisionEnvFCL::checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const std::vector<const moveit::core::RobotState*>& states,
+                                          const AllowedCollisionMatrix& acm, std::size_t num_threads,
+                                          bool stop_at_first_collision) const
+{
+  res.clear();
+  res.resize(states.size());
+  if (states.empty())
+    return false;
+
+  // the set of active links only depends on the request
+  CollisionData group_data(&req, nullptr, &acm);
+  group_data.enableGroup(getRobotModel());
+  const std::set<const moveit::core::LinkModel*>* active_components_only = group_data.active_components_only_;
+
+  std::atomic<bool> collision(false);
+  runBatch(states.size(), num_threads, stop_at_first_collision, [&]() {
+    // Every thread keeps one broadphase for its share of the batch. The robot objects it holds are checked against
+    // the world as well, so they are updated only once per state.
+    std::shared_ptr<SelfCollisionBroadPhase> broadphase(
+        acquireSelfCollisionBroadPhase(*states.front()).release(), [this](SelfCollisionBroadPhase* bp) {
+          releaseSelfCollisionBroadPhase(std::unique_ptr<SelfCollisionBroadPhase>(bp));
+        });
+    return [&, broadphase](std::size_t i) {
+      const moveit::core::RobotState& state = *states[i];
+      updateSelfCollisionBroadPhase(*broadphase, state);
+
+      CollisionResult& result = res[i];
+      CollisionData cd(&req, &result, &acm);
+      cd.active_components_only_ = active_components_only;
+      broadphase->manager_->collide(&cd, &collisionCallback);
+
+      if (!result.collision || (req.contacts && result.contacts.size() < req.max_contacts))
+      {
+        CollisionData robot_cd(&req, &result, &acm);
+        robot_cd.active_components_only_ = active_components_only;
+        for (const FCLObject* object : { &broadphase->links_, &broadphase->attached_ })
+        {
+          for (std::size_t j = 0; !robot_cd.done_ && j < object->collision_objects_.size(); ++j)
+            manager_->collide(object->collision_objects_[j].get(), &robot_cd, &collisionCallback);
+        }
+      }
+
+      if (req.distance)
+      {
+        DistanceRequest dreq;
+        DistanceResult dres;
+        dreq.group_name = req.group_name;
+        dreq.acm = &acm;
+        dreq.enableGroup(getRobotModel());
+        distanceSelf(dreq, dres, state);
+        result.distance = dres.minimum_distance.distance;
+        dres.clear();
+        distanceRobot(dreq, dres, state);
+        result.distance = std::min(result.distance, dres.minimum_distance.distance);
+      }
+
+      if (result.collision)
+        collision = true;
+      return result.collision;
+    };
+  });
+  return collision;
+}
+
+void CollisionEnvFCL::checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state1,
+                                                   const moveit::core::RobotState& state2,
+                                                   const AllowedCollisionMatrix* acm) const
+{
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+  FCLObject fcl_obj1;
+  FCLObject fcl_obj2;
+  constructFCLObjectRobot(state1, fcl_obj1);
+  constructFCLObjectRobot(state2, fcl_obj2);
+  if (fcl_obj1.collision_objects_.size() != fcl_obj2.collision_objects_.size())
+  {
+    RCLCPP_ERROR(LOGGER, "Continuous collision checking requires the same attached bodies in both states");
+    return;
+  }
+
+  CollisionData cd(&req, &res, acm);
+  cd.enableGroup(getRobotModel());
+  for (std::size_t i = 0; !cd.done_ && i < fcl_obj1.collision_objects_.size(); ++i)
+  {
+    const fcl::CollisionObjectd* obj1 = fcl_obj1.collision_objects_[i].get();
+    const fcl::CollisionObjectd* obj2 = fcl_obj2.collision_objects_[i].get();
+
+    // world objects are never active, so the robot object has to be
+    if (cd.active_components_only_)
+    {
+      const CollisionGeometryData* data =
+          static_cast<const CollisionGeometryData*>(obj1->collisionGeometry()->getUserData());
+      const moveit::core::LinkModel* link =
+          data->type == BodyTypes::ROBOT_LINK ? data->ptr.link : data->ptr.ab->getAttachedLink();
+      if (cd.active_components_only_->find(link) == cd.active_components_only_->end())
+        continue;
+    }
+
+    // The object's origin moves linearly between the two transforms, so the swept volume is enclosed by the
+    // segment between both origins, padded by the object's extent around its origin.
+    const fcl::CollisionGeometryd& geometry = *obj1->collisionGeometry();
+    const double extent = geometry.aabb_center.norm() + geometry.aabb_radius;
+    const fcl::Vector3d& origin1 = obj1->getTranslation();
+    const fcl::Vector3d& origin2 = obj2->getTranslation();
+    const fcl::Vector3d lower = (origin1.cwiseMin(origin2).array() - extent).matrix();
+    const fcl::Vector3d upper = (origin1.cwiseMax(origin2).array() + extent).matrix();
+    fcl::Transform3d proxy_tf = fcl::Transform3d::Identity();
+    proxy_tf.translation() = 0.5 * (lower + upper);
+    fcl::CollisionObjectd proxy(std::make_shared<fcl::Boxd>(upper - lower), proxy_tf);
+
+    ContinuousCollisionData ccd(&cd, obj1, obj2->getTransform(), &proxy);
+    manager_->collide(&proxy, &ccd, &continuousCollisionCallback);
+  }
+#else
+  (void)(req);
+  (void)(res);
+  (void)(state1);
+  (void)(state2);
+  (void)(acm);
+  RCLCPP_ERROR(LOGGER, "Continuous collision checking requires FCL 0.6.0 or later");
+#endif
+}
+
 void CollisionEnvFCL::distanceSelf(const DistanceRequest& req, DistanceResult& res,
                                    const moveit::core::RobotState& state) const
 {
   checkFCLCapabilities(req);
 
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  std::unique_ptr<SelfCollisionBroadPhase> broadphase = acquireSelfCollisionBroadPhase(state);
   DistanceData drd(&req, &res);
 
-  manager.manager_->distance(&drd, &distanceCallback);
+  broadphase->manager_->distance(&drd, &distanceCallback);
+  releaseSelfCollisionBroadPhase(std::move(broadphase));
 }
 
 void CollisionEnvFCL::distanceRobot(const DistanceRequest& req, DistanceResult& res,
@@ -468,6 +730,11 @@ void CollisionEnvFCL::updatedPaddingOrScaling(const std::vector<std::string>& li
     else
       RCLCPP_ERROR(LOGGER, "Updating padding or scaling for unknown link: '%s'", link.c_str());
   }
+
+  // pooled self-collision broadphases hold copies of the old collision objects
+  std::scoped_lock slock(self_collision_pool_lock_);
+  ++robot_geoms_version_;
+  self_collision_pool_.clear();
 }
 
 }  // end of namespace collision_detection
@@ -0,0 +1,136 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection_fcl/collision_env_fcl.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/utils/robot_model_test_utils.h>
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr std::size_t NUM_STATES = 1000;
+constexpr std::size_t NUM_ROUNDS = 20;
+
+// Exposes the per-query broadphase allocation, which was used for every self-collision check before broadphases
+// were pooled, as a baseline for the timings below.
+class CollisionEnvFCLBaseline : public collision_detection::CollisionEnvFCL
+{
+public:
+  using CollisionEnvFCL::CollisionEnvFCL;
+
+  void checkSelfCollisionRebuild(const collision_detection::CollisionRequest& req,
+                                 collision_detection::CollisionResult& res, const moveit::core::RobotState& state,
+                                 const collision_detection::AllowedCollisionMatrix& acm) const
+  {
+    collision_detection::FCLManager manager;
+    allocSelfCollisionBroadPhase(state, manager);
+    collision_detection::CollisionData cd(&req, &res, &acm);
+    cd.enableGroup(getRobotModel());
+    manager.manager_->collide(&cd, &collision_detection::collisionCallback);
+  }
+};
+
+std::vector<moveit::core::RobotState> sampleStates(const moveit::core::RobotModelConstPtr& model)
+{
+  std::vector<moveit::core::RobotState> states(NUM_STATES, moveit::core::RobotState(model));
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToRandomPositions();
+    state.update();
+  }
+  return states;
+}
+
+void printRate(const char* msg, std::size_t checks, const std::chrono::steady_clock::duration& elapsed)
+{
+  std::chrono::duration<double> seconds = elapsed;
+  std::cerr << msg << checks / seconds.count() << " checks/s\n";
+}
+
+void benchmarkSelfCollision(const std::string& robot_name)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel(robot_name);
+  ASSERT_TRUE(bool(model));
+  CollisionEnvFCLBaseline env(model);
+  collision_detection::AllowedCollisionMatrix acm(*model->getSRDF());
+  const std::vector<moveit::core::RobotState> states = sampleStates(model);
+
+  collision_detection::CollisionRequest req;
+  std::size_t collisions_rebuild = 0;
+  std::size_t collisions_pooled = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; round < NUM_ROUNDS; ++round)
+    for (const moveit::core::RobotState& state : states)
+    {
+      collision_detection::CollisionResult res;
+      env.checkSelfCollisionRebuild(req, res, state, acm);
+      collisions_rebuild += res.collision;
+    }
+  printRate((robot_name + " self-collision, rebuilt broadphase: ").c_str(), NUM_ROUNDS * NUM_STATES,
+            std::chrono::steady_clock::now() - start);
+
+  start = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; round < NUM_ROUNDS; ++round)
+    for (const moveit::core::RobotState& state : states)
+    {
+      collision_detection::CollisionResult res;
+      env.checkSelfCollision(req, res, state, acm);
+      collisions_pooled += res.collision;
+    }
+  printRate((robot_name + " self-collision, pooled broadphase: ").c_str(), NUM_ROUNDS * NUM_STATES,
+            std::chrono::steady_clock::now() - start);
+
+  EXPECT_EQ(collisions_rebuild, collisions_pooled);
+}
+}  // namespace
+
+TEST(FCLSelfCollisionBenchmark, Panda)
+{
+  benchmarkSelfCollision("panda");
+}
+
+TEST(FCLSelfCollisionBenchmark, PR2)
+{
+  benchmarkSelfCollision("pr2");
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -223,6 +223,139 @@ TEST_F(CollisionDetectionEnvTest, PaddingTest)
   ASSERT_FALSE(res.collision);
 }
 
+/** \brief Self-collision broadphases are reused between queries, results must follow the state and the padding. */
+TEST_F(CollisionDetectionEnvTest, SelfCollisionBroadPhaseReuse)
+{
+  moveit::core::RobotState colliding_state(robot_model_);
+  colliding_state.setToDefaultValues();
+  colliding_state.update();
+
+  collision_detection::CollisionRequest req;
+  for (int i = 0; i < 3; ++i)
+  {
+    collision_detection::CollisionResult res;
+    c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+    ASSERT_FALSE(res.collision);
+    res.clear();
+
+    c_env_->checkSelfCollision(req, res, colliding_state, *acm_);
+    ASSERT_TRUE(res.collision);
+  }
+
+  // padding the hand into the arm has to invalidate the pooled broadphases
+  c_env_->setLinkPadding("panda_hand", 0.3);
+  collision_detection::CollisionResult res;
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  ASSERT_TRUE(res.collision);
+  res.clear();
+
+  c_env_->setLinkPadding("panda_hand", 0.0);
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  ASSERT_FALSE(res.collision);
+}
+
+/** \brief Cached FCL objects of an attached body have to follow the body across state copies and detaching. */
+TEST_F(CollisionDetectionEnvTest, AttachedBodyCaching)
+{
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<const shapes::Box>(0.05, 0.05, 0.05);
+  EigenSTL::vector_Isometry3d poses{ Eigen::Isometry3d::Identity() };
+  std::set<std::string> touch_links{ "panda_link7", "panda_hand", "panda_leftfinger", "panda_rightfinger" };
+  // the tool sits in front of the fingers
+  Eigen::Isometry3d tool_offset = Eigen::Isometry3d::Identity();
+  tool_offset.translation().z() = 0.2;
+  robot_state_->attachBody("tool", tool_offset, { shape_ptr }, poses, touch_links, "panda_hand");
+  robot_state_->update();
+
+  // place an obstacle at the attached body only
+  const Eigen::Isometry3d tool_pose = robot_state_->getGlobalLinkTransform("panda_hand") * tool_offset;
+  c_env_->getWorld()->addToObject("obstacle", std::make_shared<const shapes::Sphere>(0.01), tool_pose);
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  collision_detection::CollisionResult res;
+  for (int i = 0; i < 3; ++i)
+  {
+    moveit::core::RobotState state(*robot_state_);
+    c_env_->checkRobotCollision(req, res, state, *acm_);
+    ASSERT_TRUE(res.collision);
+    ASSERT_EQ(res.contacts.begin()->second.front().body_type_1 == collision_detection::BodyTypes::ROBOT_ATTACHED ?
+                  res.contacts.begin()->second.front().body_name_1 :
+                  res.contacts.begin()->second.front().body_name_2,
+              "tool");
+    res.clear();
+
+    c_env_->checkSelfCollision(req, res, state, *acm_);
+    ASSERT_FALSE(res.collision);
+    res.clear();
+  }
+
+  moveit::core::RobotState detached_state(*robot_state_);
+  detached_state.clearAttachedBody("tool");
+  c_env_->checkRobotCollision(req, res, detached_state, *acm_);
+  ASSERT_FALSE(res.collision);
+  res.clear();
+  c_env_->checkSelfCollision(req, res, detached_state, *acm_);
+  ASSERT_FALSE(res.collision);
+}
+
+/** \brief Cached FCL objects must keep the identity of their body and shape when a shape pointer is used more than
+ *  once, both within an attached body and across attached bodies. */
+TEST_F(CollisionDetectionEnvTest, AttachedBodySharedShapes)
+{
+  shapes::ShapeConstPtr shape_ptr = std::make_shared<const shapes::Box>(0.05, 0.05, 0.05);
+
+  // the same shape twice, in front of the fingers and further out
+  Eigen::Isometry3d near_pose = Eigen::Isometry3d::Identity();
+  near_pose.translation().z() = 0.2;
+  Eigen::Isometry3d far_pose = Eigen::Isometry3d::Identity();
+  far_pose.translation().z() = 0.35;
+  std::set<std::string> touch_links{ "panda_link7", "panda_hand", "panda_leftfinger", "panda_rightfinger" };
+  robot_state_->attachBody("tool", Eigen::Isometry3d::Identity(), { shape_ptr, shape_ptr }, { near_pose, far_pose },
+                           touch_links, "panda_hand");
+
+  // another body sharing the shape, which sits inside the hand but is not allowed to touch it
+  robot_state_->attachBody("fixture", Eigen::Isometry3d::Identity(), { shape_ptr },
+                           { Eigen::Isometry3d::Identity() }, std::set<std::string>(), "panda_hand");
+  robot_state_->update();
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 10;
+  collision_detection::CollisionResult res;
+
+  // only the fixture collides with the hand
+  for (int i = 0; i < 2; ++i)
+  {
+    c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+    ASSERT_TRUE(res.collision);
+    for (const auto& contacts : res.contacts)
+      ASSERT_TRUE(contacts.first.first == "fixture" || contacts.first.second == "fixture");
+    res.clear();
+  }
+
+  // an obstacle at either copy of the shape collides with the tool
+  const Eigen::Isometry3d& hand_pose = robot_state_->getGlobalLinkTransform("panda_hand");
+  for (const Eigen::Isometry3d& pose : { near_pose, far_pose })
+  {
+    c_env_->getWorld()->addToObject("obstacle", std::make_shared<const shapes::Sphere>(0.01), hand_pose * pose);
+    for (int i = 0; i < 2; ++i)
+    {
+      moveit::core::RobotState state(*robot_state_);
+      c_env_->checkRobotCollision(req, res, state, *acm_);
+      ASSERT_TRUE(res.collision);
+      ASSERT_EQ(res.contacts.size(), 1u);
+      ASSERT_TRUE(res.contacts.count(std::make_pair(std::string("obstacle"), std::string("tool"))));
+      res.clear();
+    }
+    c_env_->getWorld()->removeObject("obstacle");
+  }
+
+  // with the fixture removed, no self collision is left
+  robot_state_->clearAttachedBody("fixture");
+  c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+  ASSERT_FALSE(res.collision);
+}
+
 /** \brief Continuous self collision checks of the robot.
  *
  *  Functionality not supported yet. */
@@ -267,10 +400,8 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionSelf)
   res.clear();
 }
 
-/** \brief Two similar robot poses are used as start and end pose of a continuous collision check.
- *
- *  Functionality not supported yet. */
-TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
+/** \brief Two similar robot poses are used as start and end pose of a continuous collision check. */
+TEST_F(CollisionDetectionEnvTest, ContinuousCollisionWorld)
 {
   collision_detection::CollisionRequest req;
   req.contacts = true;
@@ -314,10 +445,74 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
 
   c_env_->checkRobotCollision(req, res, state1, state2, *acm_);
   ASSERT_TRUE(res.collision);
+  // the links swept through the box are the same as in the Bullet backend test, each pair reports a single contact
+  // because max_contacts_per_pair defaults to one
   ASSERT_EQ(res.contact_count, 4u);
+  ASSERT_EQ(res.contacts.size(), 4u);
+  for (const auto& contacts : res.contacts)
+  {
+    for (const collision_detection::Contact& contact : contacts.second)
+    {
+      EXPECT_GE(contact.percent_interpolation, 0.0);
+      EXPECT_LE(contact.percent_interpolation, 1.0);
+    }
+  }
   res.clear();
 }
 
+/** \brief Batched checks have to agree with checking every state on its own, for any number of threads. */
+TEST_F(CollisionDetectionEnvTest, CollisionBatch)
+{
+  shapes::ShapeConstPtr shape_ptr(new shapes::Box(.1, .1, .1));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().z() = 0.3;
+  c_env_->getWorld()->addToObject("box", shape_ptr, pos);
+
+  // Home (world collision), default values (self collision) and states rotated about panda_joint1
+  std::vector<moveit::core::RobotState> states;
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    states.emplace_back(*robot_state_);
+    if (i % 5 == 1)
+      states.back().setToDefaultValues();
+    else if (i % 5 != 0)
+    {
+      double joint1 = -0.3 * static_cast<double>(i % 5);
+      states.back().setJointPositions("panda_joint1", &joint1);
+    }
+    states.back().update();
+  }
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  for (const moveit::core::RobotState& state : states)
+    state_ptrs.push_back(&state);
+
+  collision_detection::CollisionRequest req;
+  std::vector<bool> expected;
+  for (const moveit::core::RobotState& state : states)
+  {
+    collision_detection::CollisionResult res;
+    c_env_->checkCollision(req, res, state, *acm_);
+    expected.push_back(res.collision);
+  }
+  ASSERT_TRUE(expected[0]);
+  ASSERT_TRUE(expected[1]);
+
+  for (std::size_t num_threads : { 1, 3, 0 })
+  {
+    std::vector<collision_detection::CollisionResult> res;
+    ASSERT_TRUE(c_env_->checkCollisionBatch(req, res, state_ptrs, *acm_, num_threads));
+    ASSERT_EQ(res.size(), states.size());
+    for (std::size_t i = 0; i < states.size(); ++i)
+      EXPECT_EQ(res[i].collision, expected[i]) << "state " << i << " with " << num_threads << " threads";
+  }
+
+  std::vector<collision_detection::CollisionResult> res;
+  ASSERT_TRUE(c_env_->checkCollisionBatch(req, res, state_ptrs, *acm_, 1, true));
+  ASSERT_EQ(res.size(), states.size());
+  EXPECT_TRUE(res[0].collision);
+  EXPECT_FALSE(res.back().collision);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -123,9 +123,10 @@ public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   PosedDistanceField(const Eigen::Vector3d& size, const Eigen::Vector3d& origin, double resolution, double max_distance,
-                     bool propagate_negative_distances = false)
+                     bool propagate_negative_distances = false, bool use_sparse_storage = false)
     : distance_field::PropagationDistanceField(size.x(), size.y(), size.z(), resolution, origin.x(), origin.y(),
-                                               origin.z(), max_distance, propagate_negative_distances)
+                                               origin.z(), max_distance, propagate_negative_distances,
+                                               use_sparse_storage)
     , pose_(Eigen::Isometry3d::Identity())
   {
   }
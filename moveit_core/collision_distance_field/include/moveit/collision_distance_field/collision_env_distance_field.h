@@ -42,6 +42,7 @@
 #include <moveit/collision_detection/collision_env.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <rclcpp/rclcpp.hpp>
+#include <memory>
 #include <mutex>
 
 namespace collision_detection
@@ -207,7 +208,7 @@ public:
 
   collision_detection::GroupStateRepresentationConstPtr getLastGroupStateRepresentation() const
   {
-    return last_gsr_;
+    return std::atomic_load(&last_gsr_);
   }
 
   void getCollisionGradients(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
@@ -305,6 +306,7 @@ protected:
 
   mutable std::mutex update_cache_lock_world_;
   DistanceFieldCacheEntryWorldPtr distance_field_cache_entry_world_;
+  // written by every check, which may run concurrently with different group state representations
   GroupStateRepresentationPtr last_gsr_;
   World::ObserverHandle observer_handle_;
 };
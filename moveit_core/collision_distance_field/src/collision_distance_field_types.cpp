@@ -50,6 +50,49 @@ namespace collision_detection
 static const rclcpp::Logger LOGGER =
     rclcpp::get_logger("moveit_collision_distance_field.collision_distance_field_types");
 
+namespace
+{
+// Structure of arrays scratch space for DistanceField::getDistanceGradients, kept per thread so that collision
+// checks do not allocate once it has grown to the largest sphere list
+struct SphereGradientQuery
+{
+  void resize(std::size_t count)
+  {
+    if (count > capacity)
+    {
+      values.resize(7 * count);
+      in_bounds = std::make_unique<bool[]>(count);
+      capacity = count;
+    }
+    x = values.data();
+    y = x + count;
+    z = y + count;
+    distances = z + count;
+    gradient_x = distances + count;
+    gradient_y = gradient_x + count;
+    gradient_z = gradient_y + count;
+  }
+
+  std::vector<double> values;
+  std::unique_ptr<bool[]> in_bounds;
+  std::size_t capacity = 0;
+  double* x = nullptr;
+  double* y = nullptr;
+  double* z = nullptr;
+  double* distances = nullptr;
+  double* gradient_x = nullptr;
+  double* gradient_y = nullptr;
+  double* gradient_z = nullptr;
+};
+
+SphereGradientQuery& getSphereGradientQuery(std::size_t count)
+{
+  thread_local SphereGradientQuery query;
+  query.resize(count);
+  return query;
+}
+}  // namespace
+
 std::vector<CollisionSphere> determineCollisionSpheres(const bodies::Body* body, Eigen::Isometry3d& relative_transform)
 {
   std::vector<CollisionSphere> css;
@@ -86,13 +129,27 @@ bool PosedDistanceField::getCollisionSphereGradients(const std::vector<Collision
 {
   // assumes gradient is properly initialized
 
+  // look up all spheres in one pass, transformed the same way as in getDistanceGradient
+  const std::size_t count = sphere_list.size();
+  SphereGradientQuery& query = getSphereGradientQuery(count);
+  const Eigen::Matrix3d inverse_rotation = pose_.linear().transpose();
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const Eigen::Vector3d rel_pos = inverse_rotation * sphere_centers[i];
+    query.x[i] = rel_pos.x();
+    query.y[i] = rel_pos.y();
+    query.z[i] = rel_pos.z();
+  }
+  distance_field::PropagationDistanceField::getDistanceGradients(query.x, query.y, query.z, count, query.distances,
+                                                                 query.gradient_x, query.gradient_y,
+                                                                 query.gradient_z, query.in_bounds.get(), false);
+
   bool in_collision{ false };
-  for (unsigned int i{ 0 }; i < sphere_list.size(); ++i)
+  for (unsigned int i{ 0 }; i < count; ++i)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad(0, 0, 0);
-    bool in_bounds;
-    double dist = getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
+    Eigen::Vector3d grad = pose_ * Eigen::Vector3d(query.gradient_x[i], query.gradient_y[i], query.gradient_z[i]);
+    bool in_bounds = query.in_bounds[i];
+    double dist = query.distances[i];
     if (!in_bounds && grad.norm() > 0)
     {
       // out of bounds
@@ -149,15 +206,26 @@ bool getCollisionSphereGradients(const distance_field::DistanceField* distance_f
 {
   // assumes gradient is properly initialized
 
+  const std::size_t count = sphere_list.size();
+  SphereGradientQuery& query = getSphereGradientQuery(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    query.x[i] = sphere_centers[i].x();
+    query.y[i] = sphere_centers[i].y();
+    query.z[i] = sphere_centers[i].z();
+  }
+  distance_field->getDistanceGradients(query.x, query.y, query.z, count, query.distances, query.gradient_x,
+                                       query.gradient_y, query.gradient_z, query.in_bounds.get(), false);
+
   bool in_collision{ false };
-  for (unsigned int i{ 0 }; i < sphere_list.size(); ++i)
+  for (unsigned int i{ 0 }; i < count; ++i)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
+    Eigen::Vector3d grad(query.gradient_x[i], query.gradient_y[i], query.gradient_z[i]);
+    bool in_bounds = query.in_bounds[i];
+    double dist = query.distances[i];
     if (!in_bounds && grad.norm() > EPSILON)
     {
+      const Eigen::Vector3d& p = sphere_centers[i];
       RCLCPP_DEBUG(LOGGER, "Collision sphere point is out of bounds %lf, %lf, %lf", p.x(), p.y(), p.z());
       return true;
     }
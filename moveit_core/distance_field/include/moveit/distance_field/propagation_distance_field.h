@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/distance_field/voxel_grid.h>
+#include <moveit/distance_field/sparse_voxel_grid.h>
 #include <moveit/distance_field/distance_field.h>
 #include <vector>
 #include <Eigen/Core>
@@ -168,10 +169,14 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] use_sparse_storage Whether to store the cells in a
+   * \ref SparseVoxelGrid, which only allocates memory for the blocks
+   * of cells within the maximum distance of obstacles, instead of a
+   * dense \ref VoxelGrid.
    */
   PropagationDistanceField(double size_x, double size_y, double size_z, double resolution, double origin_x,
                            double origin_y, double origin_z, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, bool use_sparse_storage = false);
 
   /**
    * \brief Constructor based on an OcTree and bounding box
@@ -194,10 +199,15 @@ public:
    * and all obstacle cells will be assigned zero distance.  See the
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
+   *
+   * @param [in] use_sparse_storage Whether to store the cells in a
+   * \ref SparseVoxelGrid, which only allocates memory for the blocks
+   * of cells within the maximum distance of obstacles, instead of a
+   * dense \ref VoxelGrid.
    */
   PropagationDistanceField(const octomap::OcTree& octree, const octomap::point3d& bbx_min,
                            const octomap::point3d& bbx_max, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, bool use_sparse_storage = false);
 
   /**
    * \brief Constructor that takes an istream and reads the contents
@@ -218,9 +228,15 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] use_sparse_storage Whether to store the cells in a
+   * \ref SparseVoxelGrid, which only allocates memory for the blocks
+   * of cells within the maximum distance of obstacles, instead of a
+   * dense \ref VoxelGrid.
+   *
    * @return
    */
-  PropagationDistanceField(std::istream& stream, double max_distance, bool propagate_negative_distances = false);
+  PropagationDistanceField(std::istream& stream, double max_distance, bool propagate_negative_distances = false,
+                           bool use_sparse_storage = false);
   /**
    * \brief Empty destructor
    *
@@ -298,6 +314,30 @@ public:
    */
   void reset() override;
 
+  /**
+   * \brief Selects the algorithm used to update the field when
+   * obstacle points are added in bulk.
+   *
+   * By default, \ref addPointsToField and \ref readFromStream
+   * propagate distances outward from the new obstacle cells using a
+   * bucket queue.  When the distance transform is enabled, they
+   * instead mark the new obstacle cells and recompute the whole field
+   * with an exact Euclidean distance transform.  The transform is
+   * computed in separable passes along the z, y and x axes, where
+   * each pass processes the lines of cells in parallel.  This is
+   * faster for large grids that are filled with many obstacle points
+   * spread throughout the grid, as the cost only depends on the number
+   * of cells and not on the number of points or the maximum distance.
+   * The transform computes exact distances, whereas propagation may
+   * slightly overestimate some of them.  Removing points and \ref
+   * updatePointsInField always use propagation, and so do additions
+   * to fields with sparse storage, as the transform writes all cells.
+   *
+   * @param [in] use_distance_transform Whether bulk additions recompute the field with the distance transform
+   * @param [in] num_threads The number of threads used for the distance transform, 0 for one per CPU core
+   */
+  void setUseDistanceTransform(bool use_distance_transform, unsigned int num_threads = 0);
+
   /**
    * \brief Get the distance value associated with the cell indicated
    * by the world coordinate.  If the cell is invalid, max_distance
@@ -332,6 +372,15 @@ public:
    */
   double getDistance(int x, int y, int z) const override;
 
+  /**
+   * \brief Batched distance and gradient lookup, see \ref
+   * DistanceField::getDistanceGradients. Reads the cells of the
+   * underlying grid directly.
+   */
+  void getDistanceGradients(const double* x, const double* y, const double* z, std::size_t count, double* distances,
+                            double* gradient_x, double* gradient_y, double* gradient_z, bool* in_bounds,
+                            bool interpolate) const override;
+
   bool isCellValid(int x, int y, int z) const override;
   int getXNumCells() const override;
   int getYNumCells() const override;
@@ -394,6 +443,9 @@ public:
    */
   const PropDistanceFieldVoxel& getCell(int x, int y, int z) const
   {
+    // reading must not go through the non-const SparseVoxelGrid::getCell, which allocates blocks
+    if (sparse_voxel_grid_)
+      return static_cast<const SparseVoxelGrid<PropDistanceFieldVoxel>&>(*sparse_voxel_grid_).getCell(x, y, z);
     return voxel_grid_->getCell(x, y, z);
   }
 
@@ -417,19 +469,19 @@ public:
    */
   const PropDistanceFieldVoxel* getNearestCell(int x, int y, int z, double& dist, Eigen::Vector3i& pos) const
   {
-    const PropDistanceFieldVoxel* cell = &voxel_grid_->getCell(x, y, z);
+    const PropDistanceFieldVoxel* cell = &getCell(x, y, z);
     if (cell->distance_square_ > 0)
     {
       dist = sqrt_table_[cell->distance_square_];
       pos = cell->closest_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &getCell(pos.x(), pos.y(), pos.z());
       return ncell == cell ? nullptr : ncell;
     }
     if (cell->negative_distance_square_ > 0)
     {
       dist = -sqrt_table_[cell->negative_distance_square_];
       pos = cell->closest_negative_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &getCell(pos.x(), pos.y(), pos.z());
       return ncell == cell ? nullptr : ncell;
     }
     dist = 0.0;
@@ -452,6 +504,24 @@ public:
     return max_distance_sq_;
   }
 
+  /**
+   * \brief Whether the cells are stored in a \ref SparseVoxelGrid
+   * rather than a dense \ref VoxelGrid.
+   */
+  bool usesSparseStorage() const
+  {
+    return use_sparse_storage_;
+  }
+
+  /**
+   * \brief Gets the number of bytes used to store the cells.  For
+   * sparse storage this depends on the number of blocks allocated
+   * around the obstacles added so far.
+   *
+   * @return The memory used by the cells in bytes
+   */
+  std::size_t getMemoryUsage() const;
+
 private:
   /** Typedef for set of integer indices */
   typedef std::set<Eigen::Vector3i, CompareEigenVector3i, Eigen::aligned_allocator<Eigen::Vector3i>> VoxelSet;
@@ -463,6 +533,16 @@ private:
    */
   void initialize();
 
+  /**
+   * \brief Gives a reference to a cell that can be written to.  With
+   * sparse storage, this allocates the block of the cell, so cells
+   * that are only read should be accessed through \ref getCell.
+   */
+  PropDistanceFieldVoxel& getMutableCell(int x, int y, int z)
+  {
+    return sparse_voxel_grid_ ? sparse_voxel_grid_->getCell(x, y, z) : voxel_grid_->getCell(x, y, z);
+  }
+
   /**
    * \brief Adds a valid set of integer points to the voxel grid
    *
@@ -485,6 +565,14 @@ private:
    */
   void propagatePositive();
 
+  /**
+   * \brief Implements \ref propagatePositive on the cells of \e grid,
+   * so that the cell accesses of the dense and the sparse grid are
+   * resolved at compile time rather than for every cell.
+   */
+  template <typename Grid>
+  void propagatePositive(Grid& grid);
+
   /**
    * \brief Propagates inward to a maximum distance given the contents
    * of the \ref negative_bucket_queue_, and clears the \ref
@@ -493,6 +581,30 @@ private:
    */
   void propagateNegative();
 
+  /**
+   * \brief Implements \ref propagateNegative on the cells of \e grid.
+   */
+  template <typename Grid>
+  void propagateNegative(Grid& grid);
+
+  /**
+   * \brief Marks the voxel points as obstacle cells and recomputes
+   * the positive distances of all cells with the distance transform,
+   * and the negative distances as well if these are propagated.
+   *
+   * @param [in] voxel_points The set of new obstacle voxels
+   */
+  void transformNewObstacleVoxels(const EigenSTL::vector_Vector3i& voxel_points);
+
+  /**
+   * \brief Computes the squared distance and closest point of every
+   * cell to the nearest obstacle cell, or to the nearest free cell if
+   * \e negative is set.
+   *
+   * @param [in] negative Whether to compute the negative distances
+   */
+  void computeDistanceTransform(bool negative);
+
   /**
    * \brief Determines distance based on actual voxel data
    *
@@ -547,8 +659,13 @@ private:
 
   bool propagate_negative_; /**< \brief Whether or not to propagate negative distances */
 
+  bool use_sparse_storage_; /**< \brief Whether the cells are stored in sparse_voxel_grid_ instead of voxel_grid_ */
+
   VoxelGrid<PropDistanceFieldVoxel>::Ptr voxel_grid_; /**< \brief Actual container for distance data */
 
+  SparseVoxelGrid<PropDistanceFieldVoxel>::Ptr sparse_voxel_grid_; /**< \brief Container for distance data when
+                                                                         using sparse storage */
+
   /// \brief Structure used to hold propagation frontier
   std::vector<EigenSTL::vector_Vector3i> bucket_queue_; /**< \brief Data member that holds points from which to
                                                               propagate, where each vector holds points that are a
@@ -561,6 +678,9 @@ private:
                                                                        integer distance from the closest unoccupied
                                                                        points*/
 
+  bool use_distance_transform_ = false; /**< \brief Whether bulk additions use the distance transform */
+  unsigned int distance_transform_threads_ = 0; /**< \brief Number of threads used for the distance transform */
+
   double max_distance_; /**< \brief Holds maximum distance  */
   int max_distance_sq_; /**< \brief Holds maximum distance squared in cells */
 
@@ -0,0 +1,408 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/distance_field/voxel_grid.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <Eigen/Core>
+#include <moveit/macros/declare_ptr.h>
+
+namespace distance_field
+{
+/**
+ * \brief SparseVoxelGrid holds a 3D, axis-aligned set of data at a
+ * given resolution, with the same interface as \ref VoxelGrid.
+ *
+ * The volume is divided into cubic blocks of BLOCK_SIZE cells along
+ * each axis.  Memory for a block is only allocated once one of its
+ * cells is written, all other cells share the value the grid was
+ * last reset to.  This makes large volumes affordable when only a
+ * small part of them differs from that value, e.g. the cells close
+ * to obstacles in a distance field.
+ */
+template <typename T>
+class SparseVoxelGrid
+{
+public:
+  MOVEIT_DECLARE_PTR_MEMBER(SparseVoxelGrid);
+
+  static const int BLOCK_BITS = 3;                                     /**< \brief log2 of BLOCK_SIZE */
+  static const int BLOCK_SIZE = 1 << BLOCK_BITS;                       /**< \brief Cells per block along each axis */
+  static const int BLOCK_CELLS = BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE; /**< \brief Cells per block */
+
+  /**
+   * \brief Constructor for the SparseVoxelGrid.
+   *
+   * The parameters are the same as for \ref VoxelGrid::VoxelGrid.
+   * Unlike the dense grid, all cells start out with the value of \e
+   * default_object, and no memory is allocated for them until they
+   * are written.
+   *
+   * @param [in] size_x Size of the X axis in meters
+   * @param [in] size_y Size of the Y axis in meters
+   * @param [in] size_z Size of the Z axis in meters
+   *
+   * @param [in] resolution Resolution of a single cell in meters
+   *
+   * @param [in] origin_x Minimum point along the X axis of the volume
+   * @param [in] origin_y Minimum point along the Y axis of the volume
+   * @param [in] origin_z Minimum point along the Z axis of the volume
+   *
+   * @param [in] default_object An object that will be returned for any
+   * future queries that are not valid
+   */
+  SparseVoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
+                  double origin_z, T default_object);
+
+  /** \brief Discards all blocks and reinitializes the grid with a new size and resolution */
+  void resize(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
+              double origin_z, T default_object);
+
+  /**
+   * \brief Gets the value of the given world location, or the
+   * default object if the location is not valid.
+   */
+  const T& operator()(double x, double y, double z) const;
+  const T& operator()(const Eigen::Vector3d& pos) const;
+
+  /**
+   * \brief Gives a reference to the cell at the given grid location
+   * that can be written to, allocating the block of the cell first if
+   * needed.
+   *
+   * @return The data in the indicated cell.  If x,y,z is invalid then
+   * corruption and/or SEGFAULTS will occur.
+   */
+  T& getCell(int x, int y, int z);
+  T& getCell(const Eigen::Vector3i& pos);
+
+  /**
+   * \brief Gives the value of the cell at the given grid location.
+   * Cells of blocks that are not allocated have the value the grid
+   * was last reset to, and reading them allocates nothing.
+   *
+   * @return The data in the indicated cell.  If x,y,z is invalid then
+   * corruption and/or SEGFAULTS will occur.
+   */
+  const T& getCell(int x, int y, int z) const;
+  const T& getCell(const Eigen::Vector3i& pos) const;
+
+  void setCell(int x, int y, int z, const T& obj);
+  void setCell(const Eigen::Vector3i& pos, const T& obj);
+
+  /**
+   * \brief Sets every cell in the voxel grid to the supplied data by
+   * releasing all allocated blocks.
+   *
+   * @param [in] initial The template variable to which to set the data
+   */
+  void reset(const T& initial);
+
+  double getSize(Dimension dim) const;
+  double getResolution() const;
+  double getOrigin(Dimension dim) const;
+  int getNumCells(Dimension dim) const;
+
+  void gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const;
+  void gridToWorld(const Eigen::Vector3i& grid, Eigen::Vector3d& world) const;
+  bool worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const;
+  bool worldToGrid(const Eigen::Vector3d& world, Eigen::Vector3i& grid) const;
+
+  bool isCellValid(int x, int y, int z) const;
+  bool isCellValid(const Eigen::Vector3i& pos) const;
+  bool isCellValid(Dimension dim, int cell) const;
+
+  /** \brief Gets the number of blocks that have memory allocated */
+  std::size_t getNumAllocatedBlocks() const;
+
+  /** \brief Gets the number of bytes used by the allocated blocks and the block index */
+  std::size_t getMemoryUsage() const;
+
+protected:
+  std::vector<std::unique_ptr<T[]>> blocks_; /**< \brief Storage of each block, empty for unallocated blocks */
+  std::size_t num_allocated_blocks_;         /**< \brief The number of non-empty entries of blocks_ */
+  T default_object_;       /**< \brief The default object to return in case of out-of-bounds query */
+  T initial_object_;       /**< \brief The value of all cells in unallocated blocks */
+  double size_[3];         /**< \brief The size of each dimension in meters (in Dimension order) */
+  double resolution_;      /**< \brief The resolution of each dimension in meters (in Dimension order) */
+  double oo_resolution_;   /**< \brief 1.0/resolution_ */
+  double origin_[3];       /**< \brief The origin (minimum point) of each dimension in meters (in Dimension order) */
+  double origin_minus_[3]; /**< \brief origin - 0.5/resolution */
+  int num_cells_[3];       /**< \brief The number of cells in each dimension (in Dimension order) */
+  int num_blocks_[3];      /**< \brief The number of blocks in each dimension (in Dimension order) */
+
+  /** \brief Gets the index of the block that holds a cell into blocks_, with no validity check */
+  int blockRef(int x, int y, int z) const;
+
+  /** \brief Gets the index of a cell within its block */
+  int cellRef(int x, int y, int z) const;
+
+  /** \brief Gets the cell index in a given dimension given a world value.  No validity check. */
+  int getCellFromLocation(Dimension dim, double loc) const;
+
+  /** \brief Gets the center of the cell in world coordinates along the given dimension.  No validity check. */
+  double getLocationFromCell(Dimension dim, int cell) const;
+};
+
+//////////////////////////// template function definitions follow //////////////////
+
+template <typename T>
+SparseVoxelGrid<T>::SparseVoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                                    double origin_y, double origin_z, T default_object)
+{
+  resize(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object);
+}
+
+template <typename T>
+void SparseVoxelGrid<T>::resize(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                                double origin_y, double origin_z, T default_object)
+{
+  size_[DIM_X] = size_x;
+  size_[DIM_Y] = size_y;
+  size_[DIM_Z] = size_z;
+  origin_[DIM_X] = origin_x;
+  origin_[DIM_Y] = origin_y;
+  origin_[DIM_Z] = origin_z;
+  origin_minus_[DIM_X] = origin_x - 0.5 * resolution;
+  origin_minus_[DIM_Y] = origin_y - 0.5 * resolution;
+  origin_minus_[DIM_Z] = origin_z - 0.5 * resolution;
+  resolution_ = resolution;
+  oo_resolution_ = 1.0 / resolution_;
+  int num_blocks_total = 1;
+  for (int i = DIM_X; i <= DIM_Z; ++i)
+  {
+    num_cells_[i] = size_[i] * oo_resolution_;
+    num_blocks_[i] = (num_cells_[i] + BLOCK_SIZE - 1) >> BLOCK_BITS;
+    num_blocks_total *= num_blocks_[i];
+  }
+
+  default_object_ = default_object;
+
+  blocks_.clear();
+  blocks_.resize(std::max(num_blocks_total, 0));
+  reset(default_object);
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::isCellValid(int x, int y, int z) const
+{
+  return (x >= 0 && x < num_cells_[DIM_X] && y >= 0 && y < num_cells_[DIM_Y] && z >= 0 && z < num_cells_[DIM_Z]);
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::isCellValid(const Eigen::Vector3i& pos) const
+{
+  return isCellValid(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::isCellValid(Dimension dim, int cell) const
+{
+  return cell >= 0 && cell < num_cells_[dim];
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::blockRef(int x, int y, int z) const
+{
+  return ((x >> BLOCK_BITS) * num_blocks_[DIM_Y] + (y >> BLOCK_BITS)) * num_blocks_[DIM_Z] + (z >> BLOCK_BITS);
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::cellRef(int x, int y, int z) const
+{
+  const int mask = BLOCK_SIZE - 1;
+  return ((((x & mask) << BLOCK_BITS) | (y & mask)) << BLOCK_BITS) | (z & mask);
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getSize(Dimension dim) const
+{
+  return size_[dim];
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getResolution() const
+{
+  return resolution_;
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getOrigin(Dimension dim) const
+{
+  return origin_[dim];
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::getNumCells(Dimension dim) const
+{
+  return num_cells_[dim];
+}
+
+template <typename T>
+inline std::size_t SparseVoxelGrid<T>::getNumAllocatedBlocks() const
+{
+  return num_allocated_blocks_;
+}
+
+template <typename T>
+inline std::size_t SparseVoxelGrid<T>::getMemoryUsage() const
+{
+  return num_allocated_blocks_ * BLOCK_CELLS * sizeof(T) + blocks_.size() * sizeof(std::unique_ptr<T[]>);
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::operator()(double x, double y, double z) const
+{
+  int cell_x = getCellFromLocation(DIM_X, x);
+  int cell_y = getCellFromLocation(DIM_Y, y);
+  int cell_z = getCellFromLocation(DIM_Z, z);
+  if (!isCellValid(cell_x, cell_y, cell_z))
+    return default_object_;
+  return getCell(cell_x, cell_y, cell_z);
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::operator()(const Eigen::Vector3d& pos) const
+{
+  return operator()(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline T& SparseVoxelGrid<T>::getCell(int x, int y, int z)
+{
+  std::unique_ptr<T[]>& block = blocks_[blockRef(x, y, z)];
+  if (!block)
+  {
+    block.reset(new T[BLOCK_CELLS]);
+    std::fill(block.get(), block.get() + BLOCK_CELLS, initial_object_);
+    ++num_allocated_blocks_;
+  }
+  return block[cellRef(x, y, z)];
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::getCell(int x, int y, int z) const
+{
+  const std::unique_ptr<T[]>& block = blocks_[blockRef(x, y, z)];
+  return block ? block[cellRef(x, y, z)] : initial_object_;
+}
+
+template <typename T>
+inline T& SparseVoxelGrid<T>::getCell(const Eigen::Vector3i& pos)
+{
+  return getCell(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::getCell(const Eigen::Vector3i& pos) const
+{
+  return getCell(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::setCell(int x, int y, int z, const T& obj)
+{
+  getCell(x, y, z) = obj;
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::setCell(const Eigen::Vector3i& pos, const T& obj)
+{
+  getCell(pos.x(), pos.y(), pos.z()) = obj;
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::getCellFromLocation(Dimension dim, double loc) const
+{
+  // the rounded quantized location, see VoxelGrid::getCellFromLocation
+  return int(floor((loc - origin_minus_[dim]) * oo_resolution_));
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getLocationFromCell(Dimension dim, int cell) const
+{
+  return origin_[dim] + resolution_ * (double(cell));
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::reset(const T& initial)
+{
+  for (std::unique_ptr<T[]>& block : blocks_)
+    block.reset();
+  num_allocated_blocks_ = 0;
+  initial_object_ = initial;
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::gridToWorld(int x, int y, int z, double& world_x, double& world_y,
+                                            double& world_z) const
+{
+  world_x = getLocationFromCell(DIM_X, x);
+  world_y = getLocationFromCell(DIM_Y, y);
+  world_z = getLocationFromCell(DIM_Z, z);
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::gridToWorld(const Eigen::Vector3i& grid, Eigen::Vector3d& world) const
+{
+  world.x() = getLocationFromCell(DIM_X, grid.x());
+  world.y() = getLocationFromCell(DIM_Y, grid.y());
+  world.z() = getLocationFromCell(DIM_Z, grid.z());
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y,
+                                            int& z) const
+{
+  x = getCellFromLocation(DIM_X, world_x);
+  y = getCellFromLocation(DIM_Y, world_y);
+  z = getCellFromLocation(DIM_Z, world_z);
+  return isCellValid(x, y, z);
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::worldToGrid(const Eigen::Vector3d& world, Eigen::Vector3i& grid) const
+{
+  grid.x() = getCellFromLocation(DIM_X, world.x());
+  grid.y() = getCellFromLocation(DIM_Y, world.y());
+  grid.z() = getCellFromLocation(DIM_Z, world.z());
+  return isCellValid(grid.x(), grid.y(), grid.z());
+}
+
+}  // namespace distance_field
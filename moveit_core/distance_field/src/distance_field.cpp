@@ -90,6 +90,14 @@ double DistanceField::getDistanceGradient(double x, double y, double z, double&
   return getDistance(gx, gy, gz);
 }
 
+void DistanceField::getDistanceGradients(const double* x, const double* y, const double* z, std::size_t count,
+                                         double* distances, double* gradient_x, double* gradient_y,
+                                         double* gradient_z, bool* in_bounds, bool interpolate) const
+{
+  computeDistanceGradients(x, y, z, count, distances, gradient_x, gradient_y, gradient_z, in_bounds, interpolate,
+                           [this](int cx, int cy, int cz) { return getDistance(cx, cy, cz); });
+}
+
 void DistanceField::getIsoSurfaceMarkers(double min_distance, double max_distance, const std::string& frame_id,
                                          const rclcpp::Time& stamp, visualization_msgs::msg::Marker& inf_marker) const
 {
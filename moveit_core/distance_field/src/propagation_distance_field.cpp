@@ -41,17 +41,94 @@
 #include <boost/iostreams/filter/zlib.hpp>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <moveit/utils/thread_pool.h>
+#include <functional>
+#include <limits>
 
 namespace distance_field
 {
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_distance_field.propagation_distance_field");
 
+namespace
+{
+// marks cells that have no feature cell on the lines processed so far
+const int NO_FEATURE = -1;
+
+// scratch space of one thread for the one-dimensional distance transforms
+struct DistanceTransformLine
+{
+  explicit DistanceTransformLine(int size) : f(size), d(size), site(size), v(size), z(size + 1), closest(size)
+  {
+  }
+
+  std::vector<int> f;
+  std::vector<int> d;
+  std::vector<int> site;
+  std::vector<int> v;
+  std::vector<double> z;
+  EigenSTL::vector_Vector3i closest;
+};
+
+/* Squared Euclidean distance transform of a line of n cells (Felzenszwalb and Huttenlocher): computes
+   d[p] = min_q (f[q] + (p - q)^2) over all q with f[q] != NO_FEATURE and the q in site[p] that attains it,
+   by building the lower envelope of the parabolas rooted at the cells. */
+void distanceTransform1D(DistanceTransformLine& line, int n)
+{
+  int k = -1;
+  for (int q = 0; q < n; ++q)
+  {
+    if (line.f[q] == NO_FEATURE)
+      continue;
+    double s = -std::numeric_limits<double>::infinity();
+    while (k >= 0)
+    {
+      const int r = line.v[k];
+      s = ((line.f[q] + static_cast<double>(q) * q) - (line.f[r] + static_cast<double>(r) * r)) / (2.0 * (q - r));
+      if (s > line.z[k])
+        break;
+      --k;
+    }
+    ++k;
+    line.v[k] = q;
+    line.z[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+  }
+
+  if (k < 0)
+  {
+    std::fill(line.d.begin(), line.d.begin() + n, NO_FEATURE);
+    return;
+  }
+
+  int j = 0;
+  for (int q = 0; q < n; ++q)
+  {
+    while (j < k && line.z[j + 1] < q)
+      ++j;
+    const int r = line.v[j];
+    line.d[q] = line.f[r] + (q - r) * (q - r);
+    line.site[q] = r;
+  }
+}
+
+// calls process for every line index, spread over num_threads threads of the shared thread pool that each own their
+// scratch space
+void forEachLine(std::size_t num_lines, int line_size, unsigned int num_threads,
+                 const std::function<void(DistanceTransformLine&, std::size_t)>& process)
+{
+  moveit::core::getThreadPool().parallelForWithState(num_lines, num_threads, [&] {
+    return [&process, line = DistanceTransformLine(line_size)](std::size_t i) mutable { process(line, i); };
+  });
+}
+}  // namespace
+
 PropagationDistanceField::PropagationDistanceField(double size_x, double size_y, double size_z, double resolution,
                                                    double origin_x, double origin_y, double origin_z,
-                                                   double max_distance, bool propagate_negative)
+                                                   double max_distance, bool propagate_negative,
+                                                   bool use_sparse_storage)
   : DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z)
   , propagate_negative_(propagate_negative)
+  , use_sparse_storage_(use_sparse_storage)
   , max_distance_(max_distance)
 {
   initialize();
@@ -59,10 +136,11 @@ PropagationDistanceField::PropagationDistanceField(double size_x, double size_y,
 
 PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree, const octomap::point3d& bbx_min,
                                                    const octomap::point3d& bbx_max, double max_distance,
-                                                   bool propagate_negative_distances)
+                                                   bool propagate_negative_distances, bool use_sparse_storage)
   : DistanceField(bbx_max.x() - bbx_min.x(), bbx_max.y() - bbx_min.y(), bbx_max.z() - bbx_min.z(),
                   octree.getResolution(), bbx_min.x(), bbx_min.y(), bbx_min.z())
   , propagate_negative_(propagate_negative_distances)
+  , use_sparse_storage_(use_sparse_storage)
   , max_distance_(max_distance)
   , max_distance_sq_(0)  // avoid gcc warning about uninitialized value
 {
@@ -71,8 +149,11 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
 }
 
 PropagationDistanceField::PropagationDistanceField(std::istream& is, double max_distance,
-                                                   bool propagate_negative_distances)
-  : DistanceField(0, 0, 0, 0, 0, 0, 0), propagate_negative_(propagate_negative_distances), max_distance_(max_distance)
+                                                   bool propagate_negative_distances, bool use_sparse_storage)
+  : DistanceField(0, 0, 0, 0, 0, 0, 0)
+  , propagate_negative_(propagate_negative_distances)
+  , use_sparse_storage_(use_sparse_storage)
+  , max_distance_(max_distance)
 {
   readFromStream(is);
 }
@@ -80,9 +161,14 @@ PropagationDistanceField::PropagationDistanceField(std::istream& is, double max_
 void PropagationDistanceField::initialize()
 {
   max_distance_sq_ = ceil(max_distance_ / resolution_) * ceil(max_distance_ / resolution_);
-  voxel_grid_ =
-      std::make_shared<VoxelGrid<PropDistanceFieldVoxel>>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_,
-                                                          origin_z_, PropDistanceFieldVoxel(max_distance_sq_, 0));
+  if (use_sparse_storage_)
+    sparse_voxel_grid_ = std::make_shared<SparseVoxelGrid<PropDistanceFieldVoxel>>(
+        size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_, origin_z_,
+        PropDistanceFieldVoxel(max_distance_sq_, 0));
+  else
+    voxel_grid_ = std::make_shared<VoxelGrid<PropDistanceFieldVoxel>>(size_x_, size_y_, size_z_, resolution_, origin_x_,
+                                                                      origin_y_, origin_z_,
+                                                                      PropDistanceFieldVoxel(max_distance_sq_, 0));
 
   initNeighborhoods();
 
@@ -158,7 +244,7 @@ void PropagationDistanceField::updatePointsInField(const EigenSTL::vector_Vector
   EigenSTL::vector_Vector3i new_not_in_current;
   for (Eigen::Vector3i& voxel_loc : new_not_old)
   {
-    if (voxel_grid_->getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ != 0)
+    if (getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ != 0)
     {
       new_not_in_current.push_back(voxel_loc);
     }
@@ -180,13 +266,17 @@ void PropagationDistanceField::addPointsToField(const EigenSTL::vector_Vector3d&
 
     if (valid)
     {
-      if (voxel_grid_->getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ > 0)
+      if (getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ > 0)
       {
         voxel_points.push_back(voxel_loc);
       }
     }
   }
-  addNewObstacleVoxels(voxel_points);
+
+  if (use_distance_transform_ && !use_sparse_storage_)
+    transformNewObstacleVoxels(voxel_points);
+  else
+    addNewObstacleVoxels(voxel_points);
 }
 
 void PropagationDistanceField::removePointsFromField(const EigenSTL::vector_Vector3d& points)
@@ -215,17 +305,20 @@ void PropagationDistanceField::removePointsFromField(const EigenSTL::vector_Vect
 void PropagationDistanceField::addNewObstacleVoxels(const EigenSTL::vector_Vector3i& voxel_points)
 {
   int initial_update_direction = getDirectionNumber(0, 0, 0);
+  // sparse storage is meant for grids too large to reserve a stack entry for every cell
+  const std::size_t stack_size =
+      use_sparse_storage_ ? voxel_points.size() : getXNumCells() * getYNumCells() * getZNumCells();
   bucket_queue_[0].reserve(voxel_points.size());
   EigenSTL::vector_Vector3i negative_stack;
   if (propagate_negative_)
   {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    negative_stack.reserve(stack_size);
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
   for (const Eigen::Vector3i& voxel_point : voxel_points)
   {
-    PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(voxel_point.x(), voxel_point.y(), voxel_point.z());
+    PropDistanceFieldVoxel& voxel = getMutableCell(voxel_point.x(), voxel_point.y(), voxel_point.z());
     const Eigen::Vector3i& loc = voxel_point;
     voxel.distance_square_ = 0;
     voxel.closest_point_ = loc;
@@ -256,14 +349,14 @@ void PropagationDistanceField::addNewObstacleVoxels(const EigenSTL::vector_Vecto
 
         if (isCellValid(nloc.x(), nloc.y(), nloc.z()))
         {
-          PropDistanceFieldVoxel& nvoxel = voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+          PropDistanceFieldVoxel& nvoxel = getMutableCell(nloc.x(), nloc.y(), nloc.z());
           Eigen::Vector3i& close_point = nvoxel.closest_negative_point_;
           if (!isCellValid(close_point.x(), close_point.y(), close_point.z()))
           {
             close_point = nloc;
           }
-          PropDistanceFieldVoxel& closest_point_voxel =
-              voxel_grid_->getCell(close_point.x(), close_point.y(), close_point.z());
+          const PropDistanceFieldVoxel& closest_point_voxel =
+              getCell(close_point.x(), close_point.y(), close_point.z());
 
           // our closest non-obstacle cell has become an obstacle
           if (closest_point_voxel.negative_distance_square_ != 0)
@@ -300,12 +393,14 @@ void PropagationDistanceField::removeObstacleVoxels(const EigenSTL::vector_Vecto
   EigenSTL::vector_Vector3i stack;
   EigenSTL::vector_Vector3i negative_stack;
   int initial_update_direction = getDirectionNumber(0, 0, 0);
+  const std::size_t stack_size =
+      use_sparse_storage_ ? voxel_points.size() : getXNumCells() * getYNumCells() * getZNumCells();
 
-  stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+  stack.reserve(stack_size);
   bucket_queue_[0].reserve(voxel_points.size());
   if (propagate_negative_)
   {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    negative_stack.reserve(stack_size);
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
@@ -319,7 +414,7 @@ void PropagationDistanceField::removeObstacleVoxels(const EigenSTL::vector_Vecto
   //     continue;
   for (const Eigen::Vector3i& voxel_point : voxel_points)
   {
-    PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(voxel_point.x(), voxel_point.y(), voxel_point.z());
+    PropDistanceFieldVoxel& voxel = getMutableCell(voxel_point.x(), voxel_point.y(), voxel_point.z());
     voxel.distance_square_ = max_distance_sq_;
     voxel.closest_point_ = voxel_point;
     voxel.update_direction_ = initial_update_direction;  // not needed?
@@ -346,14 +441,13 @@ void PropagationDistanceField::removeObstacleVoxels(const EigenSTL::vector_Vecto
 
       if (isCellValid(nloc.x(), nloc.y(), nloc.z()))
       {
-        PropDistanceFieldVoxel& nvoxel = voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+        PropDistanceFieldVoxel& nvoxel = getMutableCell(nloc.x(), nloc.y(), nloc.z());
         Eigen::Vector3i& close_point = nvoxel.closest_point_;
         if (!isCellValid(close_point.x(), close_point.y(), close_point.z()))
         {
           close_point = nloc;
         }
-        PropDistanceFieldVoxel& closest_point_voxel =
-            voxel_grid_->getCell(close_point.x(), close_point.y(), close_point.z());
+        const PropDistanceFieldVoxel& closest_point_voxel = getCell(close_point.x(), close_point.y(), close_point.z());
 
         if (closest_point_voxel.distance_square_ != 0)
         {  // closest point no longer exists
@@ -382,6 +476,15 @@ void PropagationDistanceField::removeObstacleVoxels(const EigenSTL::vector_Vecto
 }
 
 void PropagationDistanceField::propagatePositive()
+{
+  if (sparse_voxel_grid_)
+    propagatePositive(*sparse_voxel_grid_);
+  else
+    propagatePositive(*voxel_grid_);
+}
+
+template <typename Grid>
+void PropagationDistanceField::propagatePositive(Grid& grid)
 {
   // now process the queue:
   for (unsigned int i = 0; i < bucket_queue_.size(); ++i)
@@ -391,7 +494,7 @@ void PropagationDistanceField::propagatePositive()
     for (; list_it != list_end; ++list_it)
     {
       const Eigen::Vector3i& loc = *list_it;
-      PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+      PropDistanceFieldVoxel* vptr = &grid.getCell(loc.x(), loc.y(), loc.z());
 
       // select the neighborhood list based on the update direction:
       EigenSTL::vector_Vector3i* neighborhood;
@@ -416,10 +519,10 @@ void PropagationDistanceField::propagatePositive()
 
         // the real update code:
         // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
         int new_distance_sq = (vptr->closest_point_ - nloc).squaredNorm();
         if (new_distance_sq > max_distance_sq_)
           continue;
+        PropDistanceFieldVoxel* neighbor = &grid.getCell(nloc.x(), nloc.y(), nloc.z());
 
         if (new_distance_sq < neighbor->distance_square_)
         {
@@ -438,6 +541,15 @@ void PropagationDistanceField::propagatePositive()
 }
 
 void PropagationDistanceField::propagateNegative()
+{
+  if (sparse_voxel_grid_)
+    propagateNegative(*sparse_voxel_grid_);
+  else
+    propagateNegative(*voxel_grid_);
+}
+
+template <typename Grid>
+void PropagationDistanceField::propagateNegative(Grid& grid)
 {
   // now process the queue:
   for (unsigned int i = 0; i < negative_bucket_queue_.size(); ++i)
@@ -447,7 +559,7 @@ void PropagationDistanceField::propagateNegative()
     for (; list_it != list_end; ++list_it)
     {
       const Eigen::Vector3i& loc = *list_it;
-      PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+      PropDistanceFieldVoxel* vptr = &grid.getCell(loc.x(), loc.y(), loc.z());
 
       // select the neighborhood list based on the update direction:
       EigenSTL::vector_Vector3i* neighborhood;
@@ -473,10 +585,10 @@ void PropagationDistanceField::propagateNegative()
 
         // the real update code:
         // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
         int new_distance_sq = (vptr->closest_negative_point_ - nloc).squaredNorm();
         if (new_distance_sq > max_distance_sq_)
           continue;
+        PropDistanceFieldVoxel* neighbor = &grid.getCell(nloc.x(), nloc.y(), nloc.z());
         // std::cout << "Looking at " << nloc.x() << " " << nloc.y() << " " << nloc.z() << " " << new_distance_sq << " "
         // << neighbor->negative_distance_square_ << '\n';
         if (new_distance_sq < neighbor->negative_distance_square_)
@@ -497,8 +609,119 @@ void PropagationDistanceField::propagateNegative()
   }
 }
 
+void PropagationDistanceField::setUseDistanceTransform(bool use_distance_transform, unsigned int num_threads)
+{
+  if (use_distance_transform && use_sparse_storage_)
+  {
+    RCLCPP_WARN(LOGGER, "The distance transform is not used with sparse storage, additions are still propagated");
+  }
+  use_distance_transform_ = use_distance_transform;
+  distance_transform_threads_ = num_threads;
+}
+
+void PropagationDistanceField::transformNewObstacleVoxels(const EigenSTL::vector_Vector3i& voxel_points)
+{
+  for (const Eigen::Vector3i& voxel_point : voxel_points)
+    voxel_grid_->getCell(voxel_point.x(), voxel_point.y(), voxel_point.z()).distance_square_ = 0;
+
+  computeDistanceTransform(false);
+  if (propagate_negative_)
+    computeDistanceTransform(true);
+}
+
+void PropagationDistanceField::computeDistanceTransform(bool negative)
+{
+  int PropDistanceFieldVoxel::*distance_square =
+      negative ? &PropDistanceFieldVoxel::negative_distance_square_ : &PropDistanceFieldVoxel::distance_square_;
+  Eigen::Vector3i PropDistanceFieldVoxel::*closest_point =
+      negative ? &PropDistanceFieldVoxel::closest_negative_point_ : &PropDistanceFieldVoxel::closest_point_;
+  int PropDistanceFieldVoxel::*update_direction =
+      negative ? &PropDistanceFieldVoxel::negative_update_direction_ : &PropDistanceFieldVoxel::update_direction_;
+
+  const int initial_update_direction = getDirectionNumber(0, 0, 0);
+  Eigen::Vector3i uninitialized;
+  uninitialized.x() = PropDistanceFieldVoxel::UNINITIALIZED;
+  uninitialized.y() = PropDistanceFieldVoxel::UNINITIALIZED;
+  uninitialized.z() = PropDistanceFieldVoxel::UNINITIALIZED;
+  const Eigen::Vector3i num_cells(getXNumCells(), getYNumCells(), getZNumCells());
+
+  // The transform is separable: a pass along each axis takes the minimum over the results of the previous passes.
+  // The pass along z comes first, as the cells of a z line are contiguous in the grid.
+  for (int axis = 2; axis >= 0; --axis)
+  {
+    const int outer = axis == 0 ? 1 : 0;
+    const int inner = axis == 2 ? 1 : 2;
+    const int n = num_cells[axis];
+    const bool first_pass = axis == 2;
+    const bool last_pass = axis == 0;
+
+    forEachLine(num_cells[outer] * num_cells[inner], n, distance_transform_threads_,
+                [&](DistanceTransformLine& line, std::size_t index) {
+                  Eigen::Vector3i loc;
+                  loc[outer] = index / num_cells[inner];
+                  loc[inner] = index % num_cells[inner];
+
+                  for (int i = 0; i < n; ++i)
+                  {
+                    loc[axis] = i;
+                    const PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+                    if (first_pass)
+                    {
+                      // obstacle cells are the features of the positive distances, free cells of the negative ones
+                      const bool obstacle = voxel.distance_square_ == 0;
+                      line.f[i] = obstacle != negative ? 0 : NO_FEATURE;
+                    }
+                    else
+                    {
+                      line.f[i] = voxel.*distance_square;
+                      line.closest[i] = voxel.*closest_point;
+                    }
+                  }
+
+                  distanceTransform1D(line, n);
+
+                  for (int i = 0; i < n; ++i)
+                  {
+                    loc[axis] = i;
+                    PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+                    const int d = line.d[i];
+                    if (last_pass && (d == NO_FEATURE || d >= max_distance_sq_))
+                    {
+                      // same as the cells propagation does not reach
+                      voxel.*distance_square = max_distance_sq_;
+                      voxel.*closest_point = uninitialized;
+                    }
+                    else
+                    {
+                      voxel.*distance_square = d;
+                      if (d != NO_FEATURE)
+                      {
+                        if (first_pass)
+                        {
+                          voxel.*closest_point = loc;
+                          (voxel.*closest_point)[axis] = line.site[i];
+                        }
+                        else
+                          voxel.*closest_point = line.closest[line.site[i]];
+                      }
+                    }
+                    if (last_pass)
+                      voxel.*update_direction = initial_update_direction;
+                  }
+                });
+  }
+}
+
 void PropagationDistanceField::reset()
 {
+  if (sparse_voxel_grid_)
+  {
+    // Leave the closest negative points of the free cells uninitialized rather than allocating all blocks to point
+    // them at themselves.  The propagation treats an uninitialized closest point like the cell itself.
+    sparse_voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
+    return;
+  }
+
   voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
   for (int x = 0; x < getXNumCells(); ++x)
   {
@@ -587,45 +810,83 @@ Eigen::Vector3i PropagationDistanceField::getLocationDifference(int directionNum
 
 double PropagationDistanceField::getDistance(double x, double y, double z) const
 {
-  return getDistance((*voxel_grid_.get())(x, y, z));
+  if (sparse_voxel_grid_)
+    return getDistance((*sparse_voxel_grid_)(x, y, z));
+  return getDistance((*voxel_grid_)(x, y, z));
 }
 
 double PropagationDistanceField::getDistance(int x, int y, int z) const
 {
-  return getDistance(voxel_grid_->getCell(x, y, z));
+  return getDistance(getCell(x, y, z));
+}
+
+void PropagationDistanceField::getDistanceGradients(const double* x, const double* y, const double* z,
+                                                    std::size_t count, double* distances, double* gradient_x,
+                                                    double* gradient_y, double* gradient_z, bool* in_bounds,
+                                                    bool interpolate) const
+{
+  if (sparse_voxel_grid_)
+  {
+    const SparseVoxelGrid<PropDistanceFieldVoxel>& grid = *sparse_voxel_grid_;
+    computeDistanceGradients(x, y, z, count, distances, gradient_x, gradient_y, gradient_z, in_bounds, interpolate,
+                             [this, &grid](int cx, int cy, int cz) {
+                               const PropDistanceFieldVoxel& cell = grid.getCell(cx, cy, cz);
+                               return sqrt_table_[cell.distance_square_] - sqrt_table_[cell.negative_distance_square_];
+                             });
+    return;
+  }
+
+  const VoxelGrid<PropDistanceFieldVoxel>& grid = *voxel_grid_;
+  computeDistanceGradients(x, y, z, count, distances, gradient_x, gradient_y, gradient_z, in_bounds, interpolate,
+                           [this, &grid](int cx, int cy, int cz) {
+                             const PropDistanceFieldVoxel& cell = grid.getCell(cx, cy, cz);
+                             return sqrt_table_[cell.distance_square_] - sqrt_table_[cell.negative_distance_square_];
+                           });
 }
 
 bool PropagationDistanceField::isCellValid(int x, int y, int z) const
 {
-  return voxel_grid_->isCellValid(x, y, z);
+  return sparse_voxel_grid_ ? sparse_voxel_grid_->isCellValid(x, y, z) : voxel_grid_->isCellValid(x, y, z);
 }
 
 int PropagationDistanceField::getXNumCells() const
 {
-  return voxel_grid_->getNumCells(DIM_X);
+  return sparse_voxel_grid_ ? sparse_voxel_grid_->getNumCells(DIM_X) : voxel_grid_->getNumCells(DIM_X);
 }
 
 int PropagationDistanceField::getYNumCells() const
 {
-  return voxel_grid_->getNumCells(DIM_Y);
+  return sparse_voxel_grid_ ? sparse_voxel_grid_->getNumCells(DIM_Y) : voxel_grid_->getNumCells(DIM_Y);
 }
 
 int PropagationDistanceField::getZNumCells() const
 {
-  return voxel_grid_->getNumCells(DIM_Z);
+  return sparse_voxel_grid_ ? sparse_voxel_grid_->getNumCells(DIM_Z) : voxel_grid_->getNumCells(DIM_Z);
 }
 
 bool PropagationDistanceField::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
 {
-  voxel_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
+  if (sparse_voxel_grid_)
+    sparse_voxel_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
+  else
+    voxel_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
   return true;
 }
 
 bool PropagationDistanceField::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const
 {
+  if (sparse_voxel_grid_)
+    return sparse_voxel_grid_->worldToGrid(world_x, world_y, world_z, x, y, z);
   return voxel_grid_->worldToGrid(world_x, world_y, world_z, x, y, z);
 }
 
+std::size_t PropagationDistanceField::getMemoryUsage() const
+{
+  if (sparse_voxel_grid_)
+    return sparse_voxel_grid_->getMemoryUsage();
+  return static_cast<std::size_t>(getXNumCells()) * getYNumCells() * getZNumCells() * sizeof(PropDistanceFieldVoxel);
+}
+
 bool PropagationDistanceField::writeToStream(std::ostream& os) const
 {
   os << "resolution: " << resolution_ << '\n';
@@ -749,7 +1010,11 @@ bool PropagationDistanceField::readFromStream(std::istream& is)
       }
     }
   }
-  addNewObstacleVoxels(obs_points);
+
+  if (use_distance_transform_ && !use_sparse_storage_)
+    transformNewObstacleVoxels(obs_points);
+  else
+    addNewObstacleVoxels(obs_points);
   return true;
 }
 }  // namespace distance_field
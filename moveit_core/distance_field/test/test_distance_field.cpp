@@ -43,6 +43,7 @@
 #include <tf2_eigen/tf2_eigen.hpp>
 #include <octomap/octomap.h>
 #include <memory>
+#include <numeric>
 
 using namespace distance_field;
 
@@ -840,6 +841,393 @@ TEST(TestSignedPropagationDistanceField, TestPerformance)
          wd.count(), wd.count() / (bad_vec.size() * 1.0));
 }
 
+// checks the distances of the field against the closest obstacle and free cells found by brute force
+void checkDistancesExact(const PropagationDistanceField& df, bool do_negs)
+{
+  for (int x = 0; x < df.getXNumCells(); ++x)
+  {
+    for (int y = 0; y < df.getYNumCells(); ++y)
+    {
+      for (int z = 0; z < df.getZNumCells(); ++z)
+      {
+        int closest_sq = df.getMaximumDistanceSquared();
+        int closest_negative_sq = do_negs ? df.getMaximumDistanceSquared() : 0;
+        for (int ox = 0; ox < df.getXNumCells(); ++ox)
+        {
+          for (int oy = 0; oy < df.getYNumCells(); ++oy)
+          {
+            for (int oz = 0; oz < df.getZNumCells(); ++oz)
+            {
+              int d = dist_sq(ox - x, oy - y, oz - z);
+              if (df.getCell(ox, oy, oz).distance_square_ == 0)
+                closest_sq = std::min(closest_sq, d);
+              else if (do_negs)
+                closest_negative_sq = std::min(closest_negative_sq, d);
+            }
+          }
+        }
+        ASSERT_EQ(df.getCell(x, y, z).distance_square_, closest_sq) << x << " " << y << " " << z;
+        ASSERT_EQ(df.getCell(x, y, z).negative_distance_square_, closest_negative_sq) << x << " " << y << " " << z;
+      }
+    }
+  }
+}
+
+// propagation may overestimate a few distances the transform computes exactly, but never underestimates them
+void checkTransformVersusPropagation(const PropagationDistanceField& transform_df,
+                                     const PropagationDistanceField& propagation_df)
+{
+  for (int x = 0; x < transform_df.getXNumCells(); ++x)
+  {
+    for (int y = 0; y < transform_df.getYNumCells(); ++y)
+    {
+      for (int z = 0; z < transform_df.getZNumCells(); ++z)
+      {
+        ASSERT_LE(transform_df.getCell(x, y, z).distance_square_, propagation_df.getCell(x, y, z).distance_square_);
+        ASSERT_LE(transform_df.getCell(x, y, z).negative_distance_square_,
+                  propagation_df.getCell(x, y, z).negative_distance_square_);
+      }
+    }
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestDistanceTransform)
+{
+  for (bool do_negs : { false, true })
+  {
+    PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, do_negs);
+    PropagationDistanceField transform_df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST,
+                                          do_negs);
+    transform_df.setUseDistanceTransform(true, 3);
+
+    shapes::Sphere sphere(.25);
+    Eigen::Isometry3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    df.addShapeToField(&sphere, p);
+    transform_df.addShapeToField(&sphere, p);
+    checkDistancesExact(transform_df, do_negs);
+    checkTransformVersusPropagation(transform_df, df);
+
+    EigenSTL::vector_Vector3d points;
+    points.push_back(POINT1);
+    points.push_back(POINT2);
+    points.push_back(POINT3);
+    df.addPointsToField(points);
+    transform_df.addPointsToField(points);
+    checkDistancesExact(transform_df, do_negs);
+    checkTransformVersusPropagation(transform_df, df);
+
+    // removing points always propagates, starting from the distances of the transform
+    transform_df.removePointsFromField(points);
+    for (const Eigen::Vector3d& point : points)
+      EXPECT_GT(transform_df.getDistance(point.x(), point.y(), point.z()), 0.0);
+
+    // without obstacle cells, all cells are at the maximum distance
+    transform_df.reset();
+    transform_df.addPointsToField(EigenSTL::vector_Vector3d());
+    checkDistancesExact(transform_df, do_negs);
+  }
+
+  // a box is one of the shapes for which propagation is exact, both engines on a big grid
+  shapes::Box big_table(2.0, 2.0, .5);
+  Eigen::Isometry3d p = Eigen::Translation3d(PERF_WIDTH / 2.0, PERF_DEPTH / 2.0, PERF_HEIGHT / 2.0) *
+                        Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  for (bool do_negs : { false, true })
+  {
+    PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X, PERF_ORIGIN_Y,
+                                PERF_ORIGIN_Z, PERF_MAX_DIST, do_negs);
+    PropagationDistanceField transform_df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X,
+                                          PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, do_negs);
+    transform_df.setUseDistanceTransform(true);
+
+    auto dt = std::chrono::system_clock::now();
+    df.addShapeToField(&big_table, p);
+    std::chrono::duration<double> wd = std::chrono::system_clock::now() - dt;
+    printf("Time for %s adding big table with propagation is %g\n", do_negs ? "signed" : "unsigned", wd.count());
+
+    dt = std::chrono::system_clock::now();
+    transform_df.addShapeToField(&big_table, p);
+    wd = std::chrono::system_clock::now() - dt;
+    printf("Time for %s adding big table with distance transform is %g\n", do_negs ? "signed" : "unsigned",
+           wd.count());
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, transform_df));
+  }
+
+  // uniformly spaced points, the worst case for propagation
+  PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X, PERF_ORIGIN_Y,
+                              PERF_ORIGIN_Z, PERF_MAX_DIST, true);
+  PropagationDistanceField transform_df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X,
+                                        PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, true);
+  transform_df.setUseDistanceTransform(true);
+
+  EigenSTL::vector_Vector3d uniform_points;
+  for (unsigned int z = UNIFORM_DISTANCE; z < df.getZNumCells() - UNIFORM_DISTANCE; z += UNIFORM_DISTANCE)
+  {
+    for (unsigned int x = UNIFORM_DISTANCE; x < df.getXNumCells() - UNIFORM_DISTANCE; x += UNIFORM_DISTANCE)
+    {
+      for (unsigned int y = UNIFORM_DISTANCE; y < df.getYNumCells() - UNIFORM_DISTANCE; y += UNIFORM_DISTANCE)
+      {
+        Eigen::Vector3d loc;
+        if (df.gridToWorld(x, y, z, loc.x(), loc.y(), loc.z()))
+          uniform_points.push_back(loc);
+      }
+    }
+  }
+
+  auto dt = std::chrono::system_clock::now();
+  df.addPointsToField(uniform_points);
+  std::chrono::duration<double> wd = std::chrono::system_clock::now() - dt;
+  printf("Time for signed adding %u uniform points with propagation is %g\n",
+         static_cast<unsigned int>(uniform_points.size()), wd.count());
+
+  dt = std::chrono::system_clock::now();
+  transform_df.addPointsToField(uniform_points);
+  wd = std::chrono::system_clock::now() - dt;
+  printf("Time for signed adding %u uniform points with distance transform is %g\n",
+         static_cast<unsigned int>(uniform_points.size()), wd.count());
+  checkTransformVersusPropagation(transform_df, df);
+}
+
+TEST(TestSignedPropagationDistanceField, TestSparseStorage)
+{
+  for (bool do_negs : { false, true })
+  {
+    PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, do_negs);
+    PropagationDistanceField sparse_df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST,
+                                       do_negs, true);
+    EXPECT_TRUE(sparse_df.usesSparseStorage());
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+
+    EigenSTL::vector_Vector3d points;
+    points.push_back(POINT1);
+    points.push_back(POINT2);
+    points.push_back(POINT3);
+    df.addPointsToField(points);
+    sparse_df.addPointsToField(points);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+
+    shapes::Sphere sphere(.25);
+    Eigen::Isometry3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    Eigen::Isometry3d np = Eigen::Translation3d(0.7, 0.7, 0.7) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    df.addShapeToField(&sphere, p);
+    sparse_df.addShapeToField(&sphere, p);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+
+    df.removePointsFromField(points);
+    sparse_df.removePointsFromField(points);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+
+    df.moveShapeInField(&sphere, p, np);
+    sparse_df.moveShapeInField(&sphere, p, np);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+
+    for (double x = 0.05; x < WIDTH; x += 0.13)
+    {
+      for (double y = 0.05; y < HEIGHT; y += 0.13)
+      {
+        for (double z = 0.05; z < DEPTH; z += 0.13)
+        {
+          Eigen::Vector3d grad, sparse_grad;
+          bool in_bounds, sparse_in_bounds;
+          double dist = df.getDistanceGradient(x, y, z, grad.x(), grad.y(), grad.z(), in_bounds);
+          double sparse_dist = sparse_df.getDistanceGradient(x, y, z, sparse_grad.x(), sparse_grad.y(),
+                                                             sparse_grad.z(), sparse_in_bounds);
+          EXPECT_EQ(dist, sparse_dist);
+          EXPECT_EQ(grad, sparse_grad);
+          EXPECT_EQ(in_bounds, sparse_in_bounds);
+        }
+      }
+    }
+
+    df.reset();
+    sparse_df.reset();
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+  }
+
+  // memory and query latency on a big grid, with an obstacle in one corner
+  PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X, PERF_ORIGIN_Y,
+                              PERF_ORIGIN_Z, PERF_MAX_DIST, true);
+  PropagationDistanceField sparse_df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X,
+                                     PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, true, true);
+  printf("Empty field memory dense %zu bytes, sparse %zu bytes\n", df.getMemoryUsage(), sparse_df.getMemoryUsage());
+
+  shapes::Sphere sphere(.5);
+  Eigen::Isometry3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+
+  auto dt = std::chrono::system_clock::now();
+  df.addShapeToField(&sphere, p);
+  std::chrono::duration<double> wd = std::chrono::system_clock::now() - dt;
+  printf("Time for adding sphere to dense field is %g\n", wd.count());
+
+  dt = std::chrono::system_clock::now();
+  sparse_df.addShapeToField(&sphere, p);
+  wd = std::chrono::system_clock::now() - dt;
+  printf("Time for adding sphere to sparse field is %g\n", wd.count());
+
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sparse_df));
+  EXPECT_LT(sparse_df.getMemoryUsage(), df.getMemoryUsage() / 10);
+  printf("Sphere field memory dense %zu bytes, sparse %zu bytes\n", df.getMemoryUsage(),
+         sparse_df.getMemoryUsage());
+
+  const unsigned int num_queries = 1000000;
+  for (const PropagationDistanceField* field : { &df, &sparse_df })
+  {
+    double sum = 0.0;
+    Eigen::Vector3d grad;
+    bool in_bounds;
+    dt = std::chrono::system_clock::now();
+    for (unsigned int i = 0; i < num_queries; ++i)
+    {
+      // spiral through the grid so that the queries hit both the area around the sphere and the empty space
+      double t = i * (2.0 * M_PI / 1000.0);
+      sum += field->getDistanceGradient(1.5 + 1.2 * cos(t), 1.5 + 1.2 * sin(t), (i * PERF_DEPTH) / num_queries,
+                                        grad.x(), grad.y(), grad.z(), in_bounds);
+    }
+    wd = std::chrono::system_clock::now() - dt;
+    printf("Average time for %s gradient query is %g (distance sum %g)\n",
+           field->usesSparseStorage() ? "sparse" : "dense", wd.count() / num_queries, sum);
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestBatchGradients)
+{
+  // query points on a lattice that is not aligned with the cells and reaches outside the field
+  std::vector<double> xs, ys, zs;
+  for (double x = -0.15; x < WIDTH + 0.15; x += 0.07)
+  {
+    for (double y = -0.15; y < HEIGHT + 0.15; y += 0.07)
+    {
+      for (double z = -0.15; z < DEPTH + 0.15; z += 0.07)
+      {
+        xs.push_back(x);
+        ys.push_back(y);
+        zs.push_back(z);
+      }
+    }
+  }
+  const std::size_t count = xs.size();
+  std::vector<double> dists(count), grad_x(count), grad_y(count), grad_z(count);
+  std::vector<double> base_dists(count), base_grad_x(count), base_grad_y(count), base_grad_z(count);
+  std::unique_ptr<bool[]> in_bounds(new bool[count]);
+  std::unique_ptr<bool[]> base_in_bounds(new bool[count]);
+
+  for (bool do_negs : { false, true })
+  {
+    for (bool sparse : { false, true })
+    {
+      PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, do_negs,
+                                  sparse);
+      shapes::Sphere sphere(.25);
+      Eigen::Isometry3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+      df.addShapeToField(&sphere, p);
+
+      // without interpolation both the specialized and the generic batch match the single point query exactly
+      df.getDistanceGradients(xs.data(), ys.data(), zs.data(), count, dists.data(), grad_x.data(), grad_y.data(),
+                              grad_z.data(), in_bounds.get(), false);
+      df.DistanceField::getDistanceGradients(xs.data(), ys.data(), zs.data(), count, base_dists.data(),
+                                             base_grad_x.data(), base_grad_y.data(), base_grad_z.data(),
+                                             base_in_bounds.get(), false);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        Eigen::Vector3d grad;
+        bool point_in_bounds;
+        double dist = df.getDistanceGradient(xs[i], ys[i], zs[i], grad.x(), grad.y(), grad.z(), point_in_bounds);
+        EXPECT_EQ(dist, dists[i]);
+        EXPECT_EQ(grad, Eigen::Vector3d(grad_x[i], grad_y[i], grad_z[i]));
+        EXPECT_EQ(point_in_bounds, in_bounds[i]);
+        EXPECT_EQ(dists[i], base_dists[i]);
+        EXPECT_EQ(grad_x[i], base_grad_x[i]);
+        EXPECT_EQ(grad_y[i], base_grad_y[i]);
+        EXPECT_EQ(grad_z[i], base_grad_z[i]);
+        EXPECT_EQ(in_bounds[i], base_in_bounds[i]);
+      }
+
+      // interpolation keeps the valid region and stays within the range of the surrounding cells
+      df.getDistanceGradients(xs.data(), ys.data(), zs.data(), count, dists.data(), grad_x.data(), grad_y.data(),
+                              grad_z.data(), in_bounds.get(), true);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        EXPECT_EQ(base_in_bounds[i], in_bounds[i]);
+        if (in_bounds[i])
+        {
+          EXPECT_LE(dists[i], MAX_DIST + 1e-9);
+          EXPECT_GE(dists[i], do_negs ? -MAX_DIST - 1e-9 : 0.0);
+        }
+      }
+
+      // at cell centers the interpolated values are the cell values, and halfway between two cells their mean
+      for (int x = 1; x < df.getXNumCells() - 2; ++x)
+      {
+        for (int y = 1; y < df.getYNumCells() - 2; ++y)
+        {
+          for (int z = 1; z < df.getZNumCells() - 2; ++z)
+          {
+            double wx, wy, wz;
+            df.gridToWorld(x, y, z, wx, wy, wz);
+            const double qx[] = { wx, wx + 0.5 * RESOLUTION };
+            const double qy[] = { wy, wy };
+            const double qz[] = { wz, wz };
+            double qd[2], qgx[2], qgy[2], qgz[2];
+            bool qb[2];
+            df.getDistanceGradients(qx, qy, qz, 2, qd, qgx, qgy, qgz, qb, true);
+            Eigen::Vector3d grad;
+            bool point_in_bounds;
+            double dist = df.getDistanceGradient(wx, wy, wz, grad.x(), grad.y(), grad.z(), point_in_bounds);
+            EXPECT_NEAR(dist, qd[0], 1e-9);
+            EXPECT_NEAR(grad.x(), qgx[0], 1e-9);
+            EXPECT_NEAR(grad.y(), qgy[0], 1e-9);
+            EXPECT_NEAR(grad.z(), qgz[0], 1e-9);
+            EXPECT_NEAR(0.5 * (df.getDistance(x, y, z) + df.getDistance(x + 1, y, z)), qd[1], 1e-9);
+          }
+        }
+      }
+    }
+  }
+
+  // query latency of single point versus batched lookups on a big grid
+  PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X, PERF_ORIGIN_Y,
+                              PERF_ORIGIN_Z, PERF_MAX_DIST, true);
+  shapes::Sphere sphere(.5);
+  Eigen::Isometry3d p = Eigen::Translation3d(1.5, 1.5, 2.0) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  df.addShapeToField(&sphere, p);
+
+  const std::size_t num_queries = 1000000;
+  xs.resize(num_queries);
+  ys.resize(num_queries);
+  zs.resize(num_queries);
+  for (std::size_t i = 0; i < num_queries; ++i)
+  {
+    double t = i * (2.0 * M_PI / 1000.0);
+    xs[i] = 1.5 + 0.8 * cos(t);
+    ys[i] = 1.5 + 0.8 * sin(t);
+    zs[i] = (i * PERF_DEPTH) / num_queries;
+  }
+  dists.resize(num_queries);
+  grad_x.resize(num_queries);
+  grad_y.resize(num_queries);
+  grad_z.resize(num_queries);
+  in_bounds.reset(new bool[num_queries]);
+
+  double sum = 0.0;
+  Eigen::Vector3d grad;
+  bool point_in_bounds;
+  auto dt = std::chrono::system_clock::now();
+  for (std::size_t i = 0; i < num_queries; ++i)
+    sum += df.getDistanceGradient(xs[i], ys[i], zs[i], grad.x(), grad.y(), grad.z(), point_in_bounds);
+  std::chrono::duration<double> wd = std::chrono::system_clock::now() - dt;
+  printf("Average time for single point gradient query is %g (distance sum %g)\n", wd.count() / num_queries, sum);
+
+  for (bool interpolate : { false, true })
+  {
+    dt = std::chrono::system_clock::now();
+    df.getDistanceGradients(xs.data(), ys.data(), zs.data(), num_queries, dists.data(), grad_x.data(), grad_y.data(),
+                            grad_z.data(), in_bounds.get(), interpolate);
+    wd = std::chrono::system_clock::now() - dt;
+    sum = std::accumulate(dists.begin(), dists.end(), 0.0);
+    printf("Average time for batched%s gradient query is %g (distance sum %g)\n", interpolate ? " interpolated" : "",
+           wd.count() / num_queries, sum);
+  }
+}
+
 TEST(TestSignedPropagationDistanceField, TestOcTree)
 {
   PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X, PERF_ORIGIN_Y,
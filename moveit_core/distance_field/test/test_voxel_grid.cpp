@@ -37,6 +37,7 @@
 #include <gtest/gtest.h>
 
 #include <moveit/distance_field/voxel_grid.h>
+#include <moveit/distance_field/sparse_voxel_grid.h>
 #include <rclcpp/rclcpp.hpp>
 
 using namespace distance_field;
@@ -107,6 +108,61 @@ TEST(TestVoxelGrid, TestReadWrite)
   }
 }
 
+TEST(TestVoxelGrid, TestSparseReadWrite)
+{
+  int def = -100;
+  SparseVoxelGrid<int> vg(10.0, 7.5, 5.0, 0.5, 0, 0, 0, def);
+  EXPECT_EQ(vg.getNumCells(DIM_X), 20);
+  EXPECT_EQ(vg.getNumCells(DIM_Y), 15);
+  EXPECT_EQ(vg.getNumCells(DIM_Z), 10);
+
+  // reading cells does not allocate anything
+  vg.reset(0);
+  const SparseVoxelGrid<int>& const_vg = vg;
+  for (int x = 0; x < vg.getNumCells(DIM_X); ++x)
+    for (int y = 0; y < vg.getNumCells(DIM_Y); ++y)
+      for (int z = 0; z < vg.getNumCells(DIM_Z); ++z)
+        EXPECT_EQ(const_vg.getCell(x, y, z), 0);
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 0u);
+  EXPECT_EQ(vg(5.0, 5.0, 2.5), 0);
+  EXPECT_EQ(vg(-1.0, 5.0, 2.5), def);
+
+  // writing a cell allocates its block only
+  vg.setCell(1, 2, 3, 5);
+  vg.getCell(19, 14, 9) = 7;
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 2u);
+  EXPECT_EQ(const_vg.getCell(1, 2, 3), 5);
+  EXPECT_EQ(const_vg.getCell(19, 14, 9), 7);
+  EXPECT_EQ(const_vg.getCell(0, 0, 0), 0);
+  EXPECT_EQ(const_vg.getCell(10, 10, 9), 0);
+
+  // same cell addressing as the dense grid
+  VoxelGrid<int> dense_vg(10.0, 7.5, 5.0, 0.5, 0, 0, 0, def);
+  Eigen::Vector3i cell, dense_cell;
+  EXPECT_TRUE(vg.worldToGrid(Eigen::Vector3d(6.15, 2.25, 4.7), cell));
+  EXPECT_TRUE(dense_vg.worldToGrid(Eigen::Vector3d(6.15, 2.25, 4.7), dense_cell));
+  EXPECT_EQ(cell, dense_cell);
+  EXPECT_FALSE(vg.worldToGrid(Eigen::Vector3d(11.0, 2.25, 4.7), cell));
+
+  // all cells can be set and read back
+  int i = 0;
+  for (int x = 0; x < vg.getNumCells(DIM_X); ++x)
+    for (int y = 0; y < vg.getNumCells(DIM_Y); ++y)
+      for (int z = 0; z < vg.getNumCells(DIM_Z); ++z)
+        vg.getCell(x, y, z) = i++;
+  i = 0;
+  for (int x = 0; x < vg.getNumCells(DIM_X); ++x)
+    for (int y = 0; y < vg.getNumCells(DIM_Y); ++y)
+      for (int z = 0; z < vg.getNumCells(DIM_Z); ++z)
+        EXPECT_EQ(const_vg.getCell(x, y, z), i++);
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 3u * 2u * 2u);
+
+  // reset releases all blocks
+  vg.reset(1);
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 0u);
+  EXPECT_EQ(const_vg.getCell(1, 2, 3), 1);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
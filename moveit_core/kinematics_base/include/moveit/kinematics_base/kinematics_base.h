@@ -366,6 +366,33 @@ public:
     return false;
   }
 
+  /**
+   * @brief Given a sequence of desired poses, search for the joint angles required to reach each of them, e.g. along
+   * a Cartesian path or for a reachability study.
+   * The targets are solved in order, each one seeded with the solution of the last target that was solved (the
+   * first one with ik_seed_state), so that the solutions of nearby targets tend to converge quickly and stay close
+   * to each other. Solver implementations can override this to set up the solver only once for all targets.
+   * @param ik_poses the desired poses. For groups with multiple tips, each target consists of getTipFrames().size()
+   * consecutive poses, in the same order as the getTipFrames() vector
+   * @param ik_seed_state an initial guess solution for the inverse kinematics of the first target
+   * @param timeout The amount of time (in seconds) available to the solver for each target
+   * @param consistency_limits the distance that any joint in a solution can be from the corresponding joints in the
+   * seed state of its target
+   * @param solutions one solution vector per target, empty for targets that could not be solved
+   * @param solution_callback A callback to validate an IK solution
+   * @param error_codes one error code per target that encodes the reason for failure or success
+   * @param options container for other IK options. See definition of KinematicsQueryOptions for details.
+   * @param context_state (optional) the context in which this request is being made, see searchPositionIK()
+   * @return True if a valid solution was found for every target, false otherwise
+   */
+  virtual bool
+  searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                        double timeout, const std::vector<double>& consistency_limits,
+                        std::vector<std::vector<double> >& solutions, const IKCallbackFn& solution_callback,
+                        std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                        const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+                        const moveit::core::RobotState* context_state = nullptr) const;
+
   /**
    * @brief Given a set of joint angles and a set of links, compute their pose
    * @param link_names A set of links for which FK needs to be computed
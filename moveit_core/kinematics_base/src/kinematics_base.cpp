@@ -199,4 +199,48 @@ bool KinematicsBase::getPositionIK(const std::vector<geometry_msgs::msg::Pose>&
 
   return true;
 }
+
+bool KinematicsBase::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                           const std::vector<double>& ik_seed_state, double timeout,
+                                           const std::vector<double>& consistency_limits,
+                                           std::vector<std::vector<double> >& solutions,
+                                           const IKCallbackFn& solution_callback,
+                                           std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                           const KinematicsQueryOptions& options,
+                                           const moveit::core::RobotState* context_state) const
+{
+  const std::size_t num_tips = std::max<std::size_t>(getTipFrames().size(), 1);
+  if (ik_poses.size() % num_tips != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "The number of poses (%zu) is not a multiple of the number of tips (%zu)", ik_poses.size(),
+                 num_tips);
+    solutions.clear();
+    error_codes.clear();
+    return false;
+  }
+
+  const std::size_t num_targets = ik_poses.size() / num_tips;
+  solutions.assign(num_targets, std::vector<double>());
+  error_codes.assign(num_targets, moveit_msgs::msg::MoveItErrorCodes());
+
+  const std::vector<double>* seed = &ik_seed_state;
+  std::vector<geometry_msgs::msg::Pose> target_poses;
+  bool all_solved = true;
+  for (std::size_t i = 0; i < num_targets; ++i)
+  {
+    target_poses.assign(ik_poses.begin() + i * num_tips, ik_poses.begin() + (i + 1) * num_tips);
+    if (searchPositionIK(target_poses, *seed, timeout, consistency_limits, solutions[i], solution_callback,
+                         error_codes[i], options, context_state))
+    {
+      // warm-start the next target from this solution
+      seed = &solutions[i];
+    }
+    else
+    {
+      solutions[i].clear();
+      all_solved = false;
+    }
+  }
+  return all_solved;
+}
 }  // end of namespace kinematics
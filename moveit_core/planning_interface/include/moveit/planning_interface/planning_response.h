@@ -81,6 +81,9 @@ struct MotionPlanDetailedResponse
   std::vector<double> processing_time_;
   moveit_msgs::msg::MoveItErrorCodes error_code_;
   std::string planner_id_;
+  // State validity checks answered from / not found in the planner's validity cache, if it uses one
+  std::size_t validity_cache_hits_ = 0;
+  std::size_t validity_cache_misses_ = 0;
 };
 
 }  // namespace planning_interface
@@ -0,0 +1,148 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_state/robot_state.h>
+#include <eigen_stl_containers/eigen_stl_containers.h>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(BatchForwardKinematics);  // Defines BatchForwardKinematicsPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Forward kinematics of one joint model group for many configurations at once.
+
+    The group variables of all configurations are passed in structure-of-arrays layout: variable \e v of
+    configuration \e i is read from <tt>positions[v * count + i]</tt>, in the order of
+    JointModelGroup::getVariableNames(). All other joints keep the values of a reference state.
+
+    Link transforms are computed for all configurations with one loop per link over plain arrays, with
+    specializations for revolute, prismatic and fixed joints, so no RobotState has to be constructed per
+    configuration. The results are stored in the same layout: 9 rotation (row-major) and 3 translation
+    components per link, each contiguous over the configurations.
+
+    An instance keeps its buffers between calls to compute() and is not thread-safe; use one instance per thread. */
+class BatchForwardKinematics
+{
+public:
+  /** \brief Number of values stored per link transform: a row-major 3x3 rotation followed by the translation */
+  static constexpr std::size_t TRANSFORM_SIZE = 12;
+
+  /** \brief Construct for \e group of \e robot_model, with all joints outside the group at their default values */
+  BatchForwardKinematics(const RobotModelConstPtr& robot_model, const JointModelGroup* group);
+
+  /** \brief Construct for \e group, with all joints outside the group at their values in \e reference */
+  BatchForwardKinematics(const JointModelGroup* group, const RobotState& reference);
+
+  const JointModelGroup* getJointModelGroup() const
+  {
+    return group_;
+  }
+
+  /** \brief The number of configurations passed to the last call of compute() */
+  std::size_t getCount() const
+  {
+    return count_;
+  }
+
+  /** \brief Compute the link transforms of \e count configurations of the group, laid out as described in the class
+      documentation. \e positions must hold <tt>getJointModelGroup()->getVariableCount() * count</tt> values. */
+  void compute(const double* positions, std::size_t count);
+
+  /** \brief Get the transform of \e link in configuration \e index of the last call to compute().
+      Links not affected by the group are returned as in the reference state. */
+  Eigen::Isometry3d getGlobalLinkTransform(const LinkModel* link, std::size_t index) const;
+
+  /** \brief Get the transforms of \e link for all configurations of the last call to compute() */
+  void getGlobalLinkTransforms(const LinkModel* link, EigenSTL::vector_Isometry3d& transforms) const;
+
+  /** \brief Get the raw transform data of \e link: TRANSFORM_SIZE arrays of getCount() values each, component \e c of
+      configuration \e i being at <tt>[c * getCount() + i]</tt>. Returns nullptr for links not affected by the group. */
+  const double* getGlobalLinkTransformData(const LinkModel* link) const;
+
+private:
+  /** \brief How the transform of one updated link is computed from its parent */
+  struct Step
+  {
+    /** \brief Slot of the parent link in transforms_, or -1 if the parent transform is constant */
+    int parent_slot;
+
+    /** \brief Constant global transform of the parent, if parent_slot is -1 */
+    double parent[TRANSFORM_SIZE];
+
+    /** \brief REVOLUTE or PRISMATIC for specialized joints driven by the group, FIXED for constant local
+        transforms, any other type for joints computed through JointModel::computeTransform() */
+    JointModel::JointType type;
+
+    const JointModel* joint;
+
+    /** \brief Group index of each joint variable (the mimicked variable for mimic joints) */
+    std::vector<int> variables;
+
+    double mimic_factor;
+    double mimic_offset;
+
+    /** \brief Local transform for FIXED steps, the joint origin transform otherwise */
+    double local[TRANSFORM_SIZE];
+
+    /** \brief For revolute joints, local rotation = c + cos(q) * a + sin(q) * b; for prismatic joints, local
+        translation = origin + q * a */
+    double a[9];
+    double b[9];
+    double c[9];
+
+    Eigen::Isometry3d origin;
+  };
+
+  void init();
+
+  const JointModelGroup* group_;
+  RobotState reference_;
+
+  std::vector<Step> steps_;
+
+  /** \brief Slot in transforms_ for each link index, -1 for links not affected by the group */
+  std::vector<int> link_slots_;
+
+  std::size_t count_;
+  std::vector<double> transforms_;
+  std::vector<double> local_;
+  std::vector<double> cos_;
+  std::vector<double> sin_;
+  std::vector<double> values_;
+};
+}  // namespace core
+}  // namespace moveit
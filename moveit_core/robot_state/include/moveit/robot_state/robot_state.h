@@ -39,6 +39,7 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/attached_body.h>
+#include <moveit/robot_state/robot_state_memory_pool.h>
 #include <moveit/transforms/transforms.h>
 #include <sensor_msgs/msg/joint_state.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
@@ -92,11 +93,18 @@ public:
   /** \brief A state can be constructed from a specified robot model. No values are initialized.
       Call setToDefaultValues() if a state needs to provide valid information. */
   RobotState(const RobotModelConstPtr& robot_model);
+
+  /** \brief Construct a state for \e robot_model whose memory is taken from \e memory_pool. No values are
+      initialized. Copies of this state use the same pool. */
+  RobotState(const RobotModelConstPtr& robot_model, const RobotStateMemoryPoolPtr& memory_pool);
   ~RobotState();
 
-  /** \brief Copy constructor. */
+  /** \brief Copy constructor. The copy uses the memory pool of \e other, if any. */
   RobotState(const RobotState& other);
 
+  /** \brief Copy \e other into memory taken from \e memory_pool (or the heap, if \e memory_pool is nullptr) */
+  RobotState(const RobotState& other, const RobotStateMemoryPoolPtr& memory_pool);
+
   /** \brief Copy operator */
   RobotState& operator=(const RobotState& other);
 
@@ -106,6 +114,12 @@ public:
     return robot_model_;
   }
 
+  /** \brief Get the pool the memory of this state is taken from, nullptr if it is allocated on the heap */
+  const RobotStateMemoryPoolPtr& getMemoryPool() const
+  {
+    return memory_pool_;
+  }
+
   /** \brief Get the number of variables that make up this state. */
   std::size_t getVariableCount() const
   {
@@ -1823,6 +1837,8 @@ public:
   bool setToIKSolverFrame(Eigen::Isometry3d& pose, const std::string& ik_frame);
 
 private:
+  /** \brief The number of bytes allocMemory() needs for a state of the robot model */
+  std::size_t getMemorySize() const;
   void allocMemory();
   void initTransforms();
   void copyFrom(const RobotState& other);
@@ -1900,6 +1916,7 @@ private:
   bool checkCollisionTransforms() const;
 
   RobotModelConstPtr robot_model_;
+  RobotStateMemoryPoolPtr memory_pool_;
   void* memory_;
 
   double* position_;
@@ -0,0 +1,145 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(RobotState);            // Defines RobotStatePtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(RobotStateMemoryPool);  // Defines RobotStateMemoryPoolPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Pool of memory blocks for RobotState instances.
+
+    A RobotState normally allocates its variables and transforms with one malloc() per instance. States constructed
+    with a pool take fixed-size blocks from it instead, carved out of large contiguous chunks. Freed blocks are kept
+    in a free list and reused, so creating and destroying thousands of states (trajectory waypoints, planner state
+    copies) causes almost no allocator traffic. Copies of a pooled state use the same pool.
+
+    Memory is only returned to the system when the pool is destroyed. Every pooled state holds a reference to its
+    pool, so the pool outlives all its states. All functions are thread-safe. */
+class RobotStateMemoryPool : public std::enable_shared_from_this<RobotStateMemoryPool>
+{
+public:
+  /** \brief Construct a pool that allocates \e blocks_per_chunk blocks of a size at once */
+  explicit RobotStateMemoryPool(std::size_t blocks_per_chunk = 64);
+
+  RobotStateMemoryPool(const RobotStateMemoryPool&) = delete;
+  RobotStateMemoryPool& operator=(const RobotStateMemoryPool&) = delete;
+
+  /** \brief Get a block of at least \e bytes bytes, aligned to alignof(std::max_align_t) */
+  void* allocate(std::size_t bytes);
+
+  /** \brief Return a block obtained from allocate() with the same \e bytes */
+  void deallocate(void* block, std::size_t bytes);
+
+  /** \brief Copy \e state into a new RobotState whose memory, including the shared pointer's control block, comes
+      from this pool. The pool must be owned by a shared pointer. */
+  RobotStatePtr allocateState(const RobotState& state);
+
+  /** \brief Get the total number of bytes allocated from the system so far */
+  std::size_t getAllocatedBytes() const;
+
+private:
+  struct FreeList
+  {
+    std::vector<void*> blocks;
+    std::vector<std::unique_ptr<unsigned char[]>> chunks;
+  };
+
+  static std::size_t roundUp(std::size_t bytes);
+
+  std::size_t blocks_per_chunk_;
+  std::map<std::size_t, FreeList> free_lists_;
+  std::size_t allocated_bytes_;
+  mutable std::mutex lock_;
+};
+
+/** \brief Standard allocator drawing from a RobotStateMemoryPool, used to place shared pointer control blocks in
+    the pool */
+template <class T>
+class RobotStateMemoryPoolAllocator
+{
+public:
+  using value_type = T;
+
+  explicit RobotStateMemoryPoolAllocator(RobotStateMemoryPoolPtr pool) : pool_(std::move(pool))
+  {
+  }
+
+  template <class U>
+  RobotStateMemoryPoolAllocator(const RobotStateMemoryPoolAllocator<U>& other) : pool_(other.getPool())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n)
+  {
+    pool_->deallocate(p, n * sizeof(T));
+  }
+
+  const RobotStateMemoryPoolPtr& getPool() const
+  {
+    return pool_;
+  }
+
+  template <class U>
+  bool operator==(const RobotStateMemoryPoolAllocator<U>& other) const
+  {
+    return pool_ == other.getPool();
+  }
+
+  template <class U>
+  bool operator!=(const RobotStateMemoryPoolAllocator<U>& other) const
+  {
+    return pool_ != other.getPool();
+  }
+
+private:
+  RobotStateMemoryPoolPtr pool_;
+};
+}  // namespace core
+}  // namespace moveit
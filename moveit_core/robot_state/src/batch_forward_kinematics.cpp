@@ -0,0 +1,348 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+
+#include <moveit/robot_state/batch_forward_kinematics.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <algorithm>
+#include <cmath>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+constexpr std::size_t N = BatchForwardKinematics::TRANSFORM_SIZE;
+
+void toArray(const Eigen::Isometry3d& transform, double* out)
+{
+  for (std::size_t r = 0; r < 3; ++r)
+  {
+    for (std::size_t c = 0; c < 3; ++c)
+      out[r * 3 + c] = transform.linear()(r, c);
+    out[9 + r] = transform.translation()(r);
+  }
+}
+
+// g = p * l, where p and l hold one transform per configuration
+void multiply(const double* p, const double* l, double* g, std::size_t n)
+{
+  for (std::size_t r = 0; r < 3; ++r)
+  {
+    const double* p0 = p + (r * 3) * n;
+    const double* p1 = p + (r * 3 + 1) * n;
+    const double* p2 = p + (r * 3 + 2) * n;
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+      const double* l0 = l + c * n;
+      const double* l1 = l + (3 + c) * n;
+      const double* l2 = l + (6 + c) * n;
+      double* out = g + (r * 3 + c) * n;
+      for (std::size_t i = 0; i < n; ++i)
+        out[i] = p0[i] * l0[i] + p1[i] * l1[i] + p2[i] * l2[i];
+    }
+    const double* pt = p + (9 + r) * n;
+    const double* lt0 = l + 9 * n;
+    const double* lt1 = l + 10 * n;
+    const double* lt2 = l + 11 * n;
+    double* out = g + (9 + r) * n;
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = p0[i] * lt0[i] + p1[i] * lt1[i] + p2[i] * lt2[i] + pt[i];
+  }
+}
+
+// g = p * l, where p is the same for all configurations
+void multiplyConstParent(const double* p, const double* l, double* g, std::size_t n)
+{
+  for (std::size_t r = 0; r < 3; ++r)
+  {
+    const double p0 = p[r * 3], p1 = p[r * 3 + 1], p2 = p[r * 3 + 2];
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+      const double* l0 = l + c * n;
+      const double* l1 = l + (3 + c) * n;
+      const double* l2 = l + (6 + c) * n;
+      double* out = g + (r * 3 + c) * n;
+      for (std::size_t i = 0; i < n; ++i)
+        out[i] = p0 * l0[i] + p1 * l1[i] + p2 * l2[i];
+    }
+    const double pt = p[9 + r];
+    const double* lt0 = l + 9 * n;
+    const double* lt1 = l + 10 * n;
+    const double* lt2 = l + 11 * n;
+    double* out = g + (9 + r) * n;
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = p0 * lt0[i] + p1 * lt1[i] + p2 * lt2[i] + pt;
+  }
+}
+
+// g = p * l, where l is the same for all configurations
+void multiplyConstLocal(const double* p, const double* l, double* g, std::size_t n)
+{
+  for (std::size_t r = 0; r < 3; ++r)
+  {
+    const double* p0 = p + (r * 3) * n;
+    const double* p1 = p + (r * 3 + 1) * n;
+    const double* p2 = p + (r * 3 + 2) * n;
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+      const double l0 = l[c], l1 = l[3 + c], l2 = l[6 + c];
+      double* out = g + (r * 3 + c) * n;
+      for (std::size_t i = 0; i < n; ++i)
+        out[i] = p0[i] * l0 + p1[i] * l1 + p2[i] * l2;
+    }
+    const double* pt = p + (9 + r) * n;
+    const double lt0 = l[9], lt1 = l[10], lt2 = l[11];
+    double* out = g + (9 + r) * n;
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = p0[i] * lt0 + p1[i] * lt1 + p2[i] * lt2 + pt[i];
+  }
+}
+}  // namespace
+
+BatchForwardKinematics::BatchForwardKinematics(const RobotModelConstPtr& robot_model, const JointModelGroup* group)
+  : group_(group), reference_(robot_model), count_(0)
+{
+  reference_.setToDefaultValues();
+  init();
+}
+
+BatchForwardKinematics::BatchForwardKinematics(const JointModelGroup* group, const RobotState& reference)
+  : group_(group), reference_(reference), count_(0)
+{
+  init();
+}
+
+void BatchForwardKinematics::init()
+{
+  reference_.update();
+  const RobotModel& model = group_->getParentModel();
+  link_slots_.assign(model.getLinkModelCount(), -1);
+
+  // updated links are ordered by link index, so parents are always processed before their children
+  for (const LinkModel* link : group_->getUpdatedLinkModels())
+  {
+    const JointModel* joint = link->getParentJointModel();
+    Step step;
+    step.joint = joint;
+    step.origin = link->getJointOriginTransform();
+    step.mimic_factor = 1.0;
+    step.mimic_offset = 0.0;
+    toArray(step.origin, step.local);
+
+    const LinkModel* parent = link->getParentLinkModel();
+    step.parent_slot = parent ? link_slots_[parent->getLinkIndex()] : -1;
+    toArray(parent ? reference_.getGlobalLinkTransform(parent) : Eigen::Isometry3d::Identity(), step.parent);
+
+    // find the group variables driving this joint, if any
+    const JointModel* source = joint;
+    if (joint->getMimic() && group_->hasJointModel(joint->getName()))
+    {
+      source = joint->getMimic();
+      step.mimic_factor = joint->getMimicFactor();
+      step.mimic_offset = joint->getMimicOffset();
+    }
+    if (joint->getType() != JointModel::FIXED && group_->hasJointModel(source->getName()))
+    {
+      for (const std::string& variable : source->getVariableNames())
+        step.variables.push_back(group_->getVariableGroupIndex(variable));
+    }
+
+    if (step.variables.empty())
+    {
+      // the joint keeps its reference value: the local transform is constant
+      step.type = JointModel::FIXED;
+      toArray(step.origin * reference_.getJointTransform(joint), step.local);
+    }
+    else
+    {
+      step.type = joint->getType();
+      if (step.type == JointModel::REVOLUTE)
+      {
+        // R(q) = cos(q) * (I - k k^T) + sin(q) * [k]x + k k^T, premultiplied by the origin rotation
+        const Eigen::Vector3d& k = static_cast<const RevoluteJointModel*>(joint)->getAxis();
+        Eigen::Matrix3d cross;
+        cross << 0, -k.z(), k.y(), k.z(), 0, -k.x(), -k.y(), k.x(), 0;
+        const Eigen::Matrix3d outer = k * k.transpose();
+        const Eigen::Matrix3d& rot = step.origin.linear();
+        const Eigen::Matrix3d a = rot * (Eigen::Matrix3d::Identity() - outer);
+        const Eigen::Matrix3d b = rot * cross;
+        const Eigen::Matrix3d c = rot * outer;
+        for (std::size_t r = 0; r < 3; ++r)
+        {
+          for (std::size_t col = 0; col < 3; ++col)
+          {
+            step.a[r * 3 + col] = a(r, col);
+            step.b[r * 3 + col] = b(r, col);
+            step.c[r * 3 + col] = c(r, col);
+          }
+        }
+      }
+      else if (step.type == JointModel::PRISMATIC)
+      {
+        const Eigen::Vector3d d =
+            step.origin.linear() * static_cast<const PrismaticJointModel*>(joint)->getAxis();
+        for (std::size_t r = 0; r < 3; ++r)
+          step.a[r] = d(r);
+      }
+    }
+
+    link_slots_[link->getLinkIndex()] = static_cast<int>(steps_.size());
+    steps_.push_back(std::move(step));
+  }
+}
+
+void BatchForwardKinematics::compute(const double* positions, std::size_t count)
+{
+  count_ = count;
+  transforms_.resize(steps_.size() * N * count);
+  local_.resize(N * count);
+  cos_.resize(count);
+  sin_.resize(count);
+
+  for (std::size_t s = 0; s < steps_.size(); ++s)
+  {
+    const Step& step = steps_[s];
+    double* global = transforms_.data() + s * N * count;
+    const double* parent = step.parent_slot >= 0 ? transforms_.data() + step.parent_slot * N * count : nullptr;
+
+    if (step.type == JointModel::FIXED)
+    {
+      if (parent)
+      {
+        multiplyConstLocal(parent, step.local, global, count);
+      }
+      else
+      {
+        // neither parent nor joint change: all configurations share the reference transform
+        double constant[N];
+        multiplyConstParent(step.parent, step.local, constant, 1);
+        for (std::size_t k = 0; k < N; ++k)
+          std::fill(global + k * count, global + (k + 1) * count, constant[k]);
+      }
+      continue;
+    }
+
+    // compute the local transform of every configuration into local_
+    double* local = local_.data();
+    const double* q = positions + step.variables[0] * count;
+    if (step.type == JointModel::REVOLUTE)
+    {
+      double* cos_q = cos_.data();
+      double* sin_q = sin_.data();
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const double angle = step.mimic_factor * q[i] + step.mimic_offset;
+        cos_q[i] = std::cos(angle);
+        sin_q[i] = std::sin(angle);
+      }
+      for (std::size_t k = 0; k < 9; ++k)
+      {
+        const double a = step.a[k], b = step.b[k], c = step.c[k];
+        double* out = local + k * count;
+        for (std::size_t i = 0; i < count; ++i)
+          out[i] = c + cos_q[i] * a + sin_q[i] * b;
+      }
+      for (std::size_t k = 9; k < N; ++k)
+        std::fill(local + k * count, local + (k + 1) * count, step.local[k]);
+    }
+    else if (step.type == JointModel::PRISMATIC)
+    {
+      for (std::size_t k = 0; k < 9; ++k)
+        std::fill(local + k * count, local + (k + 1) * count, step.local[k]);
+      for (std::size_t r = 0; r < 3; ++r)
+      {
+        const double t = step.local[9 + r], d = step.a[r];
+        double* out = local + (9 + r) * count;
+        for (std::size_t i = 0; i < count; ++i)
+          out[i] = t + (step.mimic_factor * q[i] + step.mimic_offset) * d;
+      }
+    }
+    else
+    {
+      // planar and floating joints are rare in groups, compute them one configuration at a time
+      values_.resize(step.variables.size());
+      double transform[N];
+      Eigen::Isometry3d joint_transform;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        for (std::size_t v = 0; v < step.variables.size(); ++v)
+          values_[v] = positions[step.variables[v] * count + i];
+        step.joint->computeTransform(values_.data(), joint_transform);
+        toArray(step.origin * joint_transform, transform);
+        for (std::size_t k = 0; k < N; ++k)
+          local[k * count + i] = transform[k];
+      }
+    }
+
+    if (parent)
+      multiply(parent, local, global, count);
+    else
+      multiplyConstParent(step.parent, local, global, count);
+  }
+}
+
+const double* BatchForwardKinematics::getGlobalLinkTransformData(const LinkModel* link) const
+{
+  const int slot = link_slots_[link->getLinkIndex()];
+  return slot < 0 ? nullptr : transforms_.data() + slot * N * count_;
+}
+
+Eigen::Isometry3d BatchForwardKinematics::getGlobalLinkTransform(const LinkModel* link, std::size_t index) const
+{
+  const double* data = getGlobalLinkTransformData(link);
+  if (!data)
+    return reference_.getGlobalLinkTransform(link);
+
+  assert(index < count_);
+  Eigen::Isometry3d transform;
+  transform.linear() << data[index], data[count_ + index], data[2 * count_ + index], data[3 * count_ + index],
+      data[4 * count_ + index], data[5 * count_ + index], data[6 * count_ + index], data[7 * count_ + index],
+      data[8 * count_ + index];
+  transform.translation() << data[9 * count_ + index], data[10 * count_ + index], data[11 * count_ + index];
+  transform.makeAffine();
+  return transform;
+}
+
+void BatchForwardKinematics::getGlobalLinkTransforms(const LinkModel* link,
+                                                     EigenSTL::vector_Isometry3d& transforms) const
+{
+  transforms.resize(count_);
+  for (std::size_t i = 0; i < count_; ++i)
+    transforms[i] = getGlobalLinkTransform(link, i);
+}
+}  // namespace core
+}  // namespace moveit
@@ -57,8 +57,13 @@ namespace core
 // Logger
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit_robot_state.robot_state");
 
-RobotState::RobotState(const RobotModelConstPtr& robot_model)
+RobotState::RobotState(const RobotModelConstPtr& robot_model) : RobotState(robot_model, nullptr)
+{
+}
+
+RobotState::RobotState(const RobotModelConstPtr& robot_model, const RobotStateMemoryPoolPtr& memory_pool)
   : robot_model_(robot_model)
+  , memory_pool_(memory_pool)
   , has_velocity_(false)
   , has_acceleration_(false)
   , has_effort_(false)
@@ -76,7 +81,12 @@ RobotState::RobotState(const RobotModelConstPtr& robot_model)
   initTransforms();
 }
 
-RobotState::RobotState(const RobotState& other) : rng_(nullptr)
+RobotState::RobotState(const RobotState& other) : RobotState(other, other.memory_pool_)
+{
+}
+
+RobotState::RobotState(const RobotState& other, const RobotStateMemoryPoolPtr& memory_pool)
+  : memory_pool_(memory_pool), rng_(nullptr)
 {
   robot_model_ = other.robot_model_;
   allocMemory();
@@ -86,26 +96,36 @@ RobotState::RobotState(const RobotState& other) : rng_(nullptr)
 RobotState::~RobotState()
 {
   clearAttachedBodies();
-  free(memory_);
+  if (memory_pool_)
+    memory_pool_->deallocate(memory_, getMemorySize());
+  else
+    free(memory_);
   if (rng_)
     delete rng_;
 }
 
+std::size_t RobotState::getMemorySize() const
+{
+  constexpr unsigned int extra_alignment_bytes = EIGEN_MAX_ALIGN_BYTES - 1;
+  // memory for the dirty joint transforms
+  const int nr_doubles_for_dirty_joint_transforms =
+      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+  return sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
+                                      robot_model_->getLinkGeometryCount()) +
+         sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) +
+         extra_alignment_bytes;
+}
+
 void RobotState::allocMemory()
 {
   static_assert((sizeof(Eigen::Isometry3d) / EIGEN_MAX_ALIGN_BYTES) * EIGEN_MAX_ALIGN_BYTES == sizeof(Eigen::Isometry3d),
                 "sizeof(Eigen::Isometry3d) should be a multiple of EIGEN_MAX_ALIGN_BYTES");
 
   constexpr unsigned int extra_alignment_bytes = EIGEN_MAX_ALIGN_BYTES - 1;
-  // memory for the dirty joint transforms
   const int nr_doubles_for_dirty_joint_transforms =
       1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  const size_t bytes =
-      sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                   robot_model_->getLinkGeometryCount()) +
-      sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) +
-      extra_alignment_bytes;
-  memory_ = malloc(bytes);
+  const size_t bytes = getMemorySize();
+  memory_ = memory_pool_ ? memory_pool_->allocate(bytes) : malloc(bytes);
 
   // make the memory for transforms align at EIGEN_MAX_ALIGN_BYTES
   // https://eigen.tuxfamily.org/dox/classEigen_1_1aligned__allocator.html
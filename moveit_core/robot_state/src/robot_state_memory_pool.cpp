@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/robot_state_memory_pool.h>
+#include <moveit/robot_state/robot_state.h>
+#include <algorithm>
+
+namespace moveit
+{
+namespace core
+{
+RobotStateMemoryPool::RobotStateMemoryPool(std::size_t blocks_per_chunk)
+  : blocks_per_chunk_(std::max<std::size_t>(blocks_per_chunk, 1)), allocated_bytes_(0)
+{
+}
+
+std::size_t RobotStateMemoryPool::roundUp(std::size_t bytes)
+{
+  constexpr std::size_t alignment = alignof(std::max_align_t);
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+void* RobotStateMemoryPool::allocate(std::size_t bytes)
+{
+  const std::size_t block_size = roundUp(bytes);
+  std::scoped_lock slock(lock_);
+  FreeList& list = free_lists_[block_size];
+  if (list.blocks.empty())
+  {
+    // operator new[] returns memory aligned to max_align_t, block_size keeps that alignment for all blocks
+    list.chunks.emplace_back(new unsigned char[block_size * blocks_per_chunk_]);
+    allocated_bytes_ += block_size * blocks_per_chunk_;
+    unsigned char* chunk = list.chunks.back().get();
+    list.blocks.reserve(list.blocks.size() + blocks_per_chunk_);
+    // push in reverse so blocks are handed out in address order
+    for (std::size_t i = blocks_per_chunk_; i > 0; --i)
+      list.blocks.push_back(chunk + (i - 1) * block_size);
+  }
+  void* block = list.blocks.back();
+  list.blocks.pop_back();
+  return block;
+}
+
+void RobotStateMemoryPool::deallocate(void* block, std::size_t bytes)
+{
+  const std::size_t block_size = roundUp(bytes);
+  std::scoped_lock slock(lock_);
+  free_lists_[block_size].blocks.push_back(block);
+}
+
+RobotStatePtr RobotStateMemoryPool::allocateState(const RobotState& state)
+{
+  RobotStateMemoryPoolPtr self = shared_from_this();
+  return std::allocate_shared<RobotState>(RobotStateMemoryPoolAllocator<RobotState>(self), state, self);
+}
+
+std::size_t RobotStateMemoryPool::getAllocatedBytes() const
+{
+  std::scoped_lock slock(lock_);
+  return allocated_bytes_;
+}
+}  // namespace core
+}  // namespace moveit
@@ -35,6 +35,7 @@
 /* Author: Robert Haschke */
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <eigen_stl_containers/eigen_stl_containers.h>
 #include <chrono>
@@ -156,6 +157,85 @@ TEST_F(Timing, inverse)
   }
 }
 
+TEST_F(Timing, stateCopies)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  moveit::core::RobotState state(model);
+  state.setToRandomPositions();
+  state.update();
+
+  const std::size_t runs = 100;
+  const std::size_t count = 1000;
+  std::vector<moveit::core::RobotStatePtr> states;
+  states.reserve(count);
+  double gold_standard = 0;
+  {
+    ScopedTimer t("RobotState copies on the heap: ", &gold_standard);
+    for (std::size_t run = 0; run < runs; ++run)
+    {
+      for (std::size_t i = 0; i < count; ++i)
+        states.push_back(std::make_shared<moveit::core::RobotState>(state));
+      states.clear();
+    }
+  }
+  {
+    auto memory_pool = std::make_shared<moveit::core::RobotStateMemoryPool>(count);
+    ScopedTimer t("RobotState copies from a RobotStateMemoryPool: ", &gold_standard);
+    for (std::size_t run = 0; run < runs; ++run)
+    {
+      for (std::size_t i = 0; i < count; ++i)
+        states.push_back(memory_pool->allocateState(state));
+      states.clear();
+    }
+  }
+}
+
+TEST_F(Timing, batchForwardKinematics)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(group);
+
+  const std::size_t count = 1000;
+  const std::size_t runs = 100;
+  const std::size_t variables = group->getVariableCount();
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+
+  // the same random configurations, once per configuration and once in structure-of-arrays layout
+  std::vector<std::vector<double>> configurations(count);
+  std::vector<double> positions(variables * count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    state.setToRandomPositions(group);
+    state.copyJointGroupPositions(group, configurations[i]);
+    for (std::size_t v = 0; v < variables; ++v)
+      positions[v * count + i] = configurations[i][v];
+  }
+
+  double gold_standard = 0;
+  {
+    ScopedTimer t("RobotState::update() per configuration: ", &gold_standard);
+    for (std::size_t run = 0; run < runs; ++run)
+    {
+      for (const std::vector<double>& configuration : configurations)
+      {
+        state.setJointGroupPositions(group, configuration);
+        state.update();
+      }
+    }
+  }
+  {
+    moveit::core::BatchForwardKinematics fk(model, group);
+    ScopedTimer t("BatchForwardKinematics::compute(): ", &gold_standard);
+    for (std::size_t run = 0; run < runs; ++run)
+      fk.compute(positions.data(), count);
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan */
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <urdf_parser/urdf_parser.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
@@ -714,6 +715,47 @@ TEST_F(OneRobot, rigidlyConnectedParent)
   EXPECT_EQ(nullptr, state.getRigidlyConnectedParentLinkModel("/"));
 }
 
+TEST(BatchForwardKinematics, MatchesRobotState)
+{
+  for (const char* name : { "panda", "pr2" })
+  {
+    moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel(name);
+    ASSERT_TRUE(bool(model));
+    moveit::core::RobotState reference(model);
+    reference.setToRandomPositions();
+    reference.update();
+
+    for (const moveit::core::JointModelGroup* group : model->getJointModelGroups())
+    {
+      const std::size_t count = 17;
+      const std::size_t variables = group->getVariableCount();
+      std::vector<moveit::core::RobotState> states(count, reference);
+      std::vector<double> positions(variables * count);
+      std::vector<double> values;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        states[i].setToRandomPositions(group);
+        states[i].update();
+        states[i].copyJointGroupPositions(group, values);
+        for (std::size_t v = 0; v < variables; ++v)
+          positions[v * count + i] = values[v];
+      }
+
+      moveit::core::BatchForwardKinematics fk(group, reference);
+      fk.compute(positions.data(), count);
+      ASSERT_EQ(fk.getCount(), count);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        for (const moveit::core::LinkModel* link : model->getLinkModels())
+        {
+          EXPECT_TRUE(fk.getGlobalLinkTransform(link, i).isApprox(states[i].getGlobalLinkTransform(link), 1e-10))
+              << name << " group " << group->getName() << " link " << link->getName();
+        }
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -97,6 +97,22 @@ public:
 
   const std::string& getGroupName() const;
 
+  /** @brief Take the memory of waypoints copied into this trajectory from \e memory_pool.
+   *
+   *  Waypoints added by value, deep copies and waypoints created from messages are then allocated from the pool,
+   *  including their shared pointer control blocks. This avoids per-waypoint heap allocations for long trajectories.
+   *  Pass nullptr to allocate waypoints on the heap again. */
+  RobotTrajectory& setMemoryPool(const moveit::core::RobotStateMemoryPoolPtr& memory_pool)
+  {
+    memory_pool_ = memory_pool;
+    return *this;
+  }
+
+  const moveit::core::RobotStateMemoryPoolPtr& getMemoryPool() const
+  {
+    return memory_pool_;
+  }
+
   RobotTrajectory& setGroupName(const std::string& group_name)
   {
     group_ = robot_model_->getJointModelGroup(group_name);
@@ -189,7 +205,7 @@ public:
    */
   RobotTrajectory& addSuffixWayPoint(const moveit::core::RobotState& state, double dt)
   {
-    return addSuffixWayPoint(std::make_shared<moveit::core::RobotState>(state), dt);
+    return addSuffixWayPoint(copyWayPoint(state), dt);
   }
 
   /**
@@ -207,7 +223,7 @@ public:
 
   RobotTrajectory& addPrefixWayPoint(const moveit::core::RobotState& state, double dt)
   {
-    return addPrefixWayPoint(std::make_shared<moveit::core::RobotState>(state), dt);
+    return addPrefixWayPoint(copyWayPoint(state), dt);
   }
 
   RobotTrajectory& addPrefixWayPoint(const moveit::core::RobotStatePtr& state, double dt)
@@ -220,7 +236,7 @@ public:
 
   RobotTrajectory& insertWayPoint(std::size_t index, const moveit::core::RobotState& state, double dt)
   {
-    return insertWayPoint(index, std::make_shared<moveit::core::RobotState>(state), dt);
+    return insertWayPoint(index, copyWayPoint(state), dt);
   }
 
   RobotTrajectory& insertWayPoint(std::size_t index, const moveit::core::RobotStatePtr& state, double dt)
@@ -383,10 +399,17 @@ public:
   void print(std::ostream& out, std::vector<int> variable_indexes = std::vector<int>()) const;
 
 private:
+  /** @brief Copy \e state into a new waypoint, allocated from memory_pool_ if set */
+  moveit::core::RobotStatePtr copyWayPoint(const moveit::core::RobotState& state) const
+  {
+    return memory_pool_ ? memory_pool_->allocateState(state) : std::make_shared<moveit::core::RobotState>(state);
+  }
+
   moveit::core::RobotModelConstPtr robot_model_;
   const moveit::core::JointModelGroup* group_;
   std::deque<moveit::core::RobotStatePtr> waypoints_;
   std::deque<double> duration_from_previous_;
+  moveit::core::RobotStateMemoryPoolPtr memory_pool_;
 };
 
 /** @brief Operator overload for printing trajectory to a stream */
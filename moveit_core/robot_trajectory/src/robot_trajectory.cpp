@@ -71,7 +71,7 @@ RobotTrajectory::RobotTrajectory(const RobotTrajectory& other, bool deepcopy)
     waypoints_.clear();
     for (const auto& waypoint : other.waypoints_)
     {
-      waypoints_.emplace_back(std::make_shared<moveit::core::RobotState>(*waypoint));
+      waypoints_.emplace_back(copyWayPoint(*waypoint));
     }
   }
 }
@@ -414,7 +414,7 @@ RobotTrajectory& RobotTrajectory::setRobotTrajectoryMsg(const moveit::core::Robo
   for (std::size_t i = 0; i < state_count; ++i)
   {
     this_time_stamp = rclcpp::Time(trajectory.header.stamp) + trajectory.points[i].time_from_start;
-    auto st = std::make_shared<moveit::core::RobotState>(copy);
+    auto st = copyWayPoint(copy);
     st->setVariablePositions(trajectory.joint_names, trajectory.points[i].positions);
     if (!trajectory.points[i].velocities.empty())
       st->setVariableVelocities(trajectory.joint_names, trajectory.points[i].velocities);
@@ -445,7 +445,7 @@ RobotTrajectory& RobotTrajectory::setRobotTrajectoryMsg(const moveit::core::Robo
 
   for (std::size_t i = 0; i < state_count; ++i)
   {
-    auto st = std::make_shared<moveit::core::RobotState>(copy);
+    auto st = copyWayPoint(copy);
     if (trajectory.joint_trajectory.points.size() > i)
     {
       st->setVariablePositions(trajectory.joint_trajectory.joint_names, trajectory.joint_trajectory.points[i].positions);
@@ -480,6 +480,38 @@ TEST_F(RobotTrajectoryTestFixture, RobotTrajectoryDeepCopy)
   EXPECT_NE(trajectory->getWayPointDurationFromPrevious(0), trajectory_copy->getWayPointDurationFromPrevious(0));
 }
 
+TEST_F(RobotTrajectoryTestFixture, RobotTrajectoryMemoryPool)
+{
+  auto memory_pool = std::make_shared<moveit::core::RobotStateMemoryPool>(16);
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, arm_jmg_name_);
+  trajectory.setMemoryPool(memory_pool);
+
+  const std::size_t waypoint_count = 100;
+  for (std::size_t ix = 0; ix < waypoint_count; ++ix)
+    trajectory.addSuffixWayPoint(*robot_state_, 0.1);
+  ASSERT_EQ(trajectory.getWayPointCount(), waypoint_count);
+  EXPECT_EQ(trajectory.getWayPoint(0).getMemoryPool(), memory_pool);
+  EXPECT_EQ(trajectory.getWayPoint(0).getVariableVelocity(0), robot_state_->getVariableVelocity(0));
+  EXPECT_EQ(trajectory.getWayPoint(0).getGlobalLinkTransform("panda_hand").matrix(),
+            robot_state_->getGlobalLinkTransform("panda_hand").matrix());
+
+  // freed waypoints are reused, so refilling the trajectory does not grow the pool
+  const std::size_t allocated_bytes = memory_pool->getAllocatedBytes();
+  trajectory.clear();
+  for (std::size_t ix = 0; ix < waypoint_count; ++ix)
+    trajectory.addSuffixWayPoint(*robot_state_, 0.1);
+  EXPECT_EQ(memory_pool->getAllocatedBytes(), allocated_bytes);
+
+  // copies of pooled states stay in the pool, states outlive the trajectory and the pool handle
+  moveit::core::RobotStatePtr waypoint = trajectory.getWayPointPtr(waypoint_count - 1);
+  moveit::core::RobotState copy(*waypoint);
+  EXPECT_EQ(copy.getMemoryPool(), memory_pool);
+  memory_pool.reset();
+  trajectory.clear();
+  EXPECT_EQ(copy.getVariablePosition(0), robot_state_->getVariablePosition(0));
+  EXPECT_EQ(waypoint->getVariablePosition(0), robot_state_->getVariablePosition(0));
+}
+
 TEST_F(RobotTrajectoryTestFixture, RobotTrajectoryIterator)
 {
   robot_trajectory::RobotTrajectoryPtr trajectory;
@@ -40,6 +40,7 @@
 
 #include <Eigen/Core>
 #include <list>
+#include <vector>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/trajectory_processing/time_parameterization.h>
 
@@ -61,6 +62,20 @@ public:
   virtual Eigen::VectorXd getConfig(double s) const = 0;
   virtual Eigen::VectorXd getTangent(double s) const = 0;
   virtual Eigen::VectorXd getCurvature(double s) const = 0;
+  /** \brief Write the configuration at \e s into \e config. Segments override this to reuse the storage of
+   *  \e config, the default implementation calls getConfig(s). */
+  virtual void getConfig(double s, Eigen::VectorXd& config) const
+  {
+    config = getConfig(s);
+  }
+  virtual void getTangent(double s, Eigen::VectorXd& tangent) const
+  {
+    tangent = getTangent(s);
+  }
+  virtual void getCurvature(double s, Eigen::VectorXd& curvature) const
+  {
+    curvature = getCurvature(s);
+  }
   virtual std::list<double> getSwitchingPoints() const = 0;
   virtual PathSegment* clone() const = 0;
 
@@ -73,20 +88,28 @@ protected:
 class Path
 {
 public:
+  Path(const std::vector<Eigen::VectorXd>& path, double max_deviation = 0.0);
   Path(const std::list<Eigen::VectorXd>& path, double max_deviation = 0.0);
   Path(const Path& path);
   double getLength() const;
   Eigen::VectorXd getConfig(double s) const;
   Eigen::VectorXd getTangent(double s) const;
   Eigen::VectorXd getCurvature(double s) const;
+  /** \brief Allocation-free variants writing into preallocated vectors */
+  void getConfig(double s, Eigen::VectorXd& config) const;
+  void getTangent(double s, Eigen::VectorXd& tangent) const;
+  void getCurvature(double s, Eigen::VectorXd& curvature) const;
   double getNextSwitchingPoint(double s, bool& discontinuity) const;
   std::list<std::pair<double, bool>> getSwitchingPoints() const;
 
 private:
+  // Trajectory iterates over the switching points without copying them
+  friend class Trajectory;
+
   PathSegment* getPathSegment(double& s) const;
   double length_;
-  std::list<std::pair<double, bool>> switching_points_;
-  std::list<std::unique_ptr<PathSegment>> path_segments_;
+  std::vector<std::pair<double, bool>> switching_points_;
+  std::vector<std::unique_ptr<PathSegment>> path_segments_;
 };
 
 class Trajectory
@@ -134,8 +157,8 @@ private:
                                          double& before_acceleration, double& after_acceleration);
   bool getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep& next_switching_point, double& before_acceleration,
                                      double& after_acceleration);
-  bool integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration);
-  void integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+  bool integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration);
+  void integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                          double acceleration);
   double getMinMaxPathAcceleration(double path_position, double path_velocity, bool max);
   double getMinMaxPhaseSlope(double path_position, double path_velocity, bool max);
@@ -144,20 +167,28 @@ private:
   double getAccelerationMaxPathVelocityDeriv(double path_pos);
   double getVelocityMaxPathVelocityDeriv(double path_pos);
 
-  std::list<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const;
+  /** \brief Index of the first step with a time greater than \e time (the last step for times past the end) */
+  std::size_t getTrajectorySegment(double time) const;
 
   Path path_;
   Eigen::VectorXd max_velocity_;
   Eigen::VectorXd max_acceleration_;
   unsigned int joint_num_;
   bool valid_;
-  std::list<TrajectoryStep> trajectory_;
-  std::list<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
+  std::vector<TrajectoryStep> trajectory_;
+  std::vector<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
+
+  /** \brief Scratch space of integrateBackward(), in reverse order of path position */
+  std::vector<TrajectoryStep> backward_trajectory_;
+
+  /** \brief Scratch vectors for path derivatives, sized joint_num_ so the integration does not allocate */
+  mutable Eigen::VectorXd tangent_;
+  mutable Eigen::VectorXd curvature_;
 
   const double time_step_;
 
   mutable double cached_time_;
-  mutable std::list<TrajectoryStep>::const_iterator cached_trajectory_segment_;
+  mutable std::size_t cached_trajectory_segment_;
 };
 
 MOVEIT_CLASS_FORWARD(TimeOptimalTrajectoryGeneration);
@@ -59,20 +59,37 @@ class LinearPathSegment : public PathSegment
 {
 public:
   LinearPathSegment(const Eigen::VectorXd& start, const Eigen::VectorXd& end)
-    : PathSegment((end - start).norm()), end_(end), start_(start)
+    : PathSegment((end - start).norm()), end_(end), start_(start), tangent_((end - start) / length_)
   {
   }
 
-  Eigen::VectorXd getConfig(double s) const override
+  void getConfig(double s, Eigen::VectorXd& config) const override
   {
     s /= length_;
     s = std::max(0.0, std::min(1.0, s));
-    return (1.0 - s) * start_ + s * end_;
+    config = (1.0 - s) * start_ + s * end_;
+  }
+
+  void getTangent(double /* s */, Eigen::VectorXd& tangent) const override
+  {
+    tangent = tangent_;
+  }
+
+  void getCurvature(double /* s */, Eigen::VectorXd& curvature) const override
+  {
+    curvature.setZero(start_.size());
+  }
+
+  Eigen::VectorXd getConfig(double s) const override
+  {
+    Eigen::VectorXd config;
+    getConfig(s, config);
+    return config;
   }
 
   Eigen::VectorXd getTangent(double /* s */) const override
   {
-    return (end_ - start_) / length_;
+    return tangent_;
   }
 
   Eigen::VectorXd getCurvature(double /* s */) const override
@@ -93,6 +110,7 @@ public:
 private:
   Eigen::VectorXd end_;
   Eigen::VectorXd start_;
+  Eigen::VectorXd tangent_;
 };
 
 class CircularPathSegment : public PathSegment
@@ -142,22 +160,43 @@ public:
     y = start_direction;
   }
 
-  Eigen::VectorXd getConfig(double s) const override
+  void getConfig(double s, Eigen::VectorXd& config) const override
   {
     const double angle = s / radius;
-    return center + radius * (x * cos(angle) + y * sin(angle));
+    config = center + radius * (x * cos(angle) + y * sin(angle));
   }
 
-  Eigen::VectorXd getTangent(double s) const override
+  void getTangent(double s, Eigen::VectorXd& tangent) const override
   {
     const double angle = s / radius;
-    return -x * sin(angle) + y * cos(angle);
+    tangent = -x * sin(angle) + y * cos(angle);
   }
 
-  Eigen::VectorXd getCurvature(double s) const override
+  void getCurvature(double s, Eigen::VectorXd& curvature) const override
   {
     const double angle = s / radius;
-    return -1.0 / radius * (x * cos(angle) + y * sin(angle));
+    curvature = -1.0 / radius * (x * cos(angle) + y * sin(angle));
+  }
+
+  Eigen::VectorXd getConfig(double s) const override
+  {
+    Eigen::VectorXd config;
+    getConfig(s, config);
+    return config;
+  }
+
+  Eigen::VectorXd getTangent(double s) const override
+  {
+    Eigen::VectorXd tangent;
+    getTangent(s, tangent);
+    return tangent;
+  }
+
+  Eigen::VectorXd getCurvature(double s) const override
+  {
+    Eigen::VectorXd curvature;
+    getCurvature(s, curvature);
+    return curvature;
   }
 
   std::list<double> getSwitchingPoints() const override
@@ -193,24 +232,18 @@ private:
   Eigen::VectorXd y;
 };
 
-Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
+Path::Path(const std::vector<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
 {
   if (path.size() < 2)
     return;
-  std::list<Eigen::VectorXd>::const_iterator path_iterator1 = path.begin();
-  std::list<Eigen::VectorXd>::const_iterator path_iterator2 = path_iterator1;
-  ++path_iterator2;
-  std::list<Eigen::VectorXd>::const_iterator path_iterator3;
-  Eigen::VectorXd start_config = *path_iterator1;
-  while (path_iterator2 != path.end())
+  path_segments_.reserve(max_deviation > 0.0 ? 2 * path.size() : path.size());
+  Eigen::VectorXd start_config = path[0];
+  for (std::size_t i = 1; i < path.size(); ++i)
   {
-    path_iterator3 = path_iterator2;
-    ++path_iterator3;
-    if (max_deviation > 0.0 && path_iterator3 != path.end())
+    if (max_deviation > 0.0 && i + 1 < path.size())
     {
-      CircularPathSegment* blend_segment =
-          new CircularPathSegment(0.5 * (*path_iterator1 + *path_iterator2), *path_iterator2,
-                                  0.5 * (*path_iterator2 + *path_iterator3), max_deviation);
+      CircularPathSegment* blend_segment = new CircularPathSegment(0.5 * (path[i - 1] + path[i]), path[i],
+                                                                   0.5 * (path[i] + path[i + 1]), max_deviation);
       Eigen::VectorXd end_config = blend_segment->getConfig(0.0);
       if ((end_config - start_config).norm() > 0.000001)
       {
@@ -222,11 +255,9 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
     }
     else
     {
-      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, *path_iterator2));
-      start_config = *path_iterator2;
+      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, path[i]));
+      start_config = path[i];
     }
-    path_iterator1 = path_iterator2;
-    ++path_iterator2;
   }
 
   // Create list of switching point candidates, calculate total path length and
@@ -234,11 +265,9 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   for (std::unique_ptr<PathSegment>& path_segment : path_segments_)
   {
     path_segment->position_ = length_;
-    std::list<double> local_switching_points = path_segment->getSwitchingPoints();
-    for (std::list<double>::const_iterator point = local_switching_points.begin();
-         point != local_switching_points.end(); ++point)
+    for (const double point : path_segment->getSwitchingPoints())
     {
-      switching_points_.push_back(std::make_pair(length_ + *point, false));
+      switching_points_.push_back(std::make_pair(length_ + point, false));
     }
     length_ += path_segment->getLength();
     while (!switching_points_.empty() && switching_points_.back().first >= length_)
@@ -248,8 +277,14 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   switching_points_.pop_back();
 }
 
+Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation)
+  : Path(std::vector<Eigen::VectorXd>(path.begin(), path.end()), max_deviation)
+{
+}
+
 Path::Path(const Path& path) : length_(path.length_), switching_points_(path.switching_points_)
 {
+  path_segments_.reserve(path.path_segments_.size());
   for (const std::unique_ptr<PathSegment>& path_segment : path.path_segments_)
   {
     path_segments_.emplace_back(path_segment->clone());
@@ -263,16 +298,13 @@ double Path::getLength() const
 
 PathSegment* Path::getPathSegment(double& s) const
 {
-  std::list<std::unique_ptr<PathSegment>>::const_iterator it = path_segments_.begin();
-  std::list<std::unique_ptr<PathSegment>>::const_iterator next = it;
-  ++next;
-  while (next != path_segments_.end() && s >= (*next)->position_)
-  {
-    it = next;
-    ++next;
-  }
-  s -= (*it)->position_;
-  return (*it).get();
+  // The last segment starting at or before s, or the first one if s lies before the path
+  const auto next = std::upper_bound(
+      path_segments_.begin() + 1, path_segments_.end(), s,
+      [](double s, const std::unique_ptr<PathSegment>& path_segment) { return s < path_segment->position_; });
+  const std::unique_ptr<PathSegment>& path_segment = *(next - 1);
+  s -= path_segment->position_;
+  return path_segment.get();
 }
 
 Eigen::VectorXd Path::getConfig(double s) const
@@ -293,13 +325,29 @@ Eigen::VectorXd Path::getCurvature(double s) const
   return path_segment->getCurvature(s);
 }
 
+void Path::getConfig(double s, Eigen::VectorXd& config) const
+{
+  const PathSegment* path_segment = getPathSegment(s);
+  path_segment->getConfig(s, config);
+}
+
+void Path::getTangent(double s, Eigen::VectorXd& tangent) const
+{
+  const PathSegment* path_segment = getPathSegment(s);
+  path_segment->getTangent(s, tangent);
+}
+
+void Path::getCurvature(double s, Eigen::VectorXd& curvature) const
+{
+  const PathSegment* path_segment = getPathSegment(s);
+  path_segment->getCurvature(s, curvature);
+}
+
 double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
 {
-  std::list<std::pair<double, bool>>::const_iterator it = switching_points_.begin();
-  while (it != switching_points_.end() && it->first <= s)
-  {
-    ++it;
-  }
+  const auto it = std::upper_bound(
+      switching_points_.begin(), switching_points_.end(), s,
+      [](double s, const std::pair<double, bool>& switching_point) { return s < switching_point.first; });
   if (it == switching_points_.end())
   {
     discontinuity = true;
@@ -311,7 +359,7 @@ double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
 
 std::list<std::pair<double, bool>> Path::getSwitchingPoints() const
 {
-  return switching_points_;
+  return std::list<std::pair<double, bool>>(switching_points_.begin(), switching_points_.end());
 }
 
 Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
@@ -321,8 +369,11 @@ Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, co
   , max_acceleration_(max_acceleration)
   , joint_num_(max_velocity.size())
   , valid_(true)
+  , tangent_(max_velocity.size())
+  , curvature_(max_velocity.size())
   , time_step_(time_step)
   , cached_time_(std::numeric_limits<double>::max())
+  , cached_trajectory_segment_(0)
 {
   trajectory_.push_back(TrajectoryStep(0.0, 0.0));
   double after_acceleration = getMinMaxPathAcceleration(0.0, 0.0, true);
@@ -346,18 +397,18 @@ Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, co
   if (valid_)
   {
     // Calculate timing
-    std::list<TrajectoryStep>::iterator previous = trajectory_.begin();
-    std::list<TrajectoryStep>::iterator it = previous;
-    it->time_ = 0.0;
-    ++it;
-    while (it != trajectory_.end())
+    trajectory_.front().time_ = 0.0;
+    for (std::size_t i = 1; i < trajectory_.size(); ++i)
     {
-      it->time_ =
-          previous->time_ + (it->path_pos_ - previous->path_pos_) / ((it->path_vel_ + previous->path_vel_) / 2.0);
-      previous = it;
-      ++it;
+      const TrajectoryStep& previous = trajectory_[i - 1];
+      TrajectoryStep& step = trajectory_[i];
+      step.time_ =
+          previous.time_ + (step.path_pos_ - previous.path_pos_) / ((step.path_vel_ + previous.path_vel_) / 2.0);
     }
   }
+
+  // The scratch space is not needed anymore once the trajectory is complete
+  std::vector<TrajectoryStep>().swap(backward_trajectory_);
 }
 
 Trajectory::~Trajectory()
@@ -508,13 +559,13 @@ bool Trajectory::getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep&
 }
 
 // Returns true if end of path is reached
-bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration)
+bool Trajectory::integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration)
 {
   double path_pos = trajectory.back().path_pos_;
   double path_vel = trajectory.back().path_vel_;
 
-  std::list<std::pair<double, bool>> switching_points = path_.getSwitchingPoints();
-  std::list<std::pair<double, bool>>::iterator next_discontinuity = switching_points.begin();
+  const std::vector<std::pair<double, bool>>& switching_points = path_.switching_points_;
+  std::vector<std::pair<double, bool>>::const_iterator next_discontinuity = switching_points.begin();
 
   while (true)
   {
@@ -624,32 +675,32 @@ bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double
   }
 }
 
-void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+void Trajectory::integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                                    double acceleration)
 {
-  std::list<TrajectoryStep>::iterator start2 = start_trajectory.end();
-  --start2;
-  std::list<TrajectoryStep>::iterator start1 = start2;
-  --start1;
-  std::list<TrajectoryStep> trajectory;
+  std::size_t start2 = start_trajectory.size() - 1;
+  std::size_t start1 = start2 - 1;
+  // Steps are collected with decreasing path position, so trajectory.back() is the most recent one
+  std::vector<TrajectoryStep>& trajectory = backward_trajectory_;
+  trajectory.clear();
   double slope;
-  assert(start1->path_pos_ <= path_pos);
+  assert(start_trajectory[start1].path_pos_ <= path_pos);
 
-  while (start1 != start_trajectory.begin() || path_pos >= 0.0)
+  while (start1 != 0 || path_pos >= 0.0)
   {
-    if (start1->path_pos_ <= path_pos)
+    if (start_trajectory[start1].path_pos_ <= path_pos)
     {
-      trajectory.push_front(TrajectoryStep(path_pos, path_vel));
+      trajectory.push_back(TrajectoryStep(path_pos, path_vel));
       path_vel -= time_step_ * acceleration;
-      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.front().path_vel_);
+      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.back().path_vel_);
       acceleration = getMinMaxPathAcceleration(path_pos, path_vel, false);
-      slope = (trajectory.front().path_vel_ - path_vel) / (trajectory.front().path_pos_ - path_pos);
+      slope = (trajectory.back().path_vel_ - path_vel) / (trajectory.back().path_pos_ - path_pos);
 
       if (path_vel < 0.0)
       {
         valid_ = false;
         RCLCPP_ERROR(LOGGER, "Error while integrating backward: Negative path velocity");
-        end_trajectory_ = trajectory;
+        end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
         return;
       }
     }
@@ -661,30 +712,33 @@ void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory,
 
     // Check for intersection between current start trajectory and backward
     // trajectory segments
-    const double start_slope = (start2->path_vel_ - start1->path_vel_) / (start2->path_pos_ - start1->path_pos_);
+    const TrajectoryStep& step1 = start_trajectory[start1];
+    const TrajectoryStep& step2 = start_trajectory[start2];
+    const double start_slope = (step2.path_vel_ - step1.path_vel_) / (step2.path_pos_ - step1.path_pos_);
     const double intersection_path_pos =
-        (start1->path_vel_ - path_vel + slope * path_pos - start_slope * start1->path_pos_) / (slope - start_slope);
-    if (std::max(start1->path_pos_, path_pos) - EPS <= intersection_path_pos &&
-        intersection_path_pos <= EPS + std::min(start2->path_pos_, trajectory.front().path_pos_))
+        (step1.path_vel_ - path_vel + slope * path_pos - start_slope * step1.path_pos_) / (slope - start_slope);
+    if (std::max(step1.path_pos_, path_pos) - EPS <= intersection_path_pos &&
+        intersection_path_pos <= EPS + std::min(step2.path_pos_, trajectory.back().path_pos_))
     {
-      const double intersection_path_vel =
-          start1->path_vel_ + start_slope * (intersection_path_pos - start1->path_pos_);
-      start_trajectory.erase(start2, start_trajectory.end());
+      const double intersection_path_vel = step1.path_vel_ + start_slope * (intersection_path_pos - step1.path_pos_);
+      start_trajectory.resize(start2);
       start_trajectory.push_back(TrajectoryStep(intersection_path_pos, intersection_path_vel));
-      start_trajectory.splice(start_trajectory.end(), trajectory);
+      start_trajectory.insert(start_trajectory.end(), trajectory.rbegin(), trajectory.rend());
       return;
     }
   }
 
   valid_ = false;
   RCLCPP_ERROR(LOGGER, "Error while integrating backward: Did not hit start trajectory");
-  end_trajectory_ = trajectory;
+  end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
 }
 
 double Trajectory::getMinMaxPathAcceleration(double path_pos, double path_vel, bool max)
 {
-  Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
-  Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  path_.getCurvature(path_pos, curvature_);
+  const Eigen::VectorXd& config_deriv = tangent_;
+  const Eigen::VectorXd& config_deriv2 = curvature_;
   double factor = max ? 1.0 : -1.0;
   double max_path_acceleration = std::numeric_limits<double>::max();
   for (unsigned int i = 0; i < joint_num_; ++i)
@@ -707,8 +761,10 @@ double Trajectory::getMinMaxPhaseSlope(double path_pos, double path_vel, bool ma
 double Trajectory::getAccelerationMaxPathVelocity(double path_pos) const
 {
   double max_path_velocity = std::numeric_limits<double>::infinity();
-  const Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
-  const Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  path_.getCurvature(path_pos, curvature_);
+  const Eigen::VectorXd& config_deriv = tangent_;
+  const Eigen::VectorXd& config_deriv2 = curvature_;
   for (unsigned int i = 0; i < joint_num_; ++i)
   {
     if (config_deriv[i] != 0.0)
@@ -737,7 +793,8 @@ double Trajectory::getAccelerationMaxPathVelocity(double path_pos) const
 
 double Trajectory::getVelocityMaxPathVelocity(double path_pos) const
 {
-  const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  const Eigen::VectorXd& tangent = tangent_;
   double max_path_velocity = std::numeric_limits<double>::max();
   for (unsigned int i = 0; i < joint_num_; ++i)
   {
@@ -754,7 +811,8 @@ double Trajectory::getAccelerationMaxPathVelocityDeriv(double path_pos)
 
 double Trajectory::getVelocityMaxPathVelocityDeriv(double path_pos)
 {
-  const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  const Eigen::VectorXd& tangent = tangent_;
   double max_path_velocity = std::numeric_limits<double>::max();
   unsigned int active_constraint;
   for (unsigned int i = 0; i < joint_num_; ++i)
@@ -766,7 +824,8 @@ double Trajectory::getVelocityMaxPathVelocityDeriv(double path_pos)
       active_constraint = i;
     }
   }
-  return -(max_velocity_[active_constraint] * path_.getCurvature(path_pos)[active_constraint]) /
+  path_.getCurvature(path_pos, curvature_);
+  return -(max_velocity_[active_constraint] * curvature_[active_constraint]) /
          (tangent[active_constraint] * std::abs(tangent[active_constraint]));
 }
 
@@ -780,21 +839,23 @@ double Trajectory::getDuration() const
   return trajectory_.back().time_;
 }
 
-std::list<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectorySegment(double time) const
+std::size_t Trajectory::getTrajectorySegment(double time) const
 {
   if (time >= trajectory_.back().time_)
   {
-    std::list<TrajectoryStep>::const_iterator last = trajectory_.end();
-    last--;
-    return last;
+    return trajectory_.size() - 1;
   }
   else
   {
     if (time < cached_time_)
     {
-      cached_trajectory_segment_ = trajectory_.begin();
+      // Jumping backwards: search the whole trajectory instead of scanning from its start
+      cached_trajectory_segment_ =
+          std::upper_bound(trajectory_.begin(), trajectory_.end(), time,
+                           [](double time, const TrajectoryStep& step) { return time < step.time_; }) -
+          trajectory_.begin();
     }
-    while (time >= cached_trajectory_segment_->time_)
+    while (time >= trajectory_[cached_trajectory_segment_].time_)
     {
       ++cached_trajectory_segment_;
     }
@@ -805,8 +866,8 @@ std::list<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectoryS
 
 Eigen::VectorXd Trajectory::getPosition(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
+  std::vector<TrajectoryStep>::const_iterator it = trajectory_.begin() + getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it;
   previous--;
 
   double time_step = it->time_ - previous->time_;
@@ -822,8 +883,8 @@ Eigen::VectorXd Trajectory::getPosition(double time) const
 
 Eigen::VectorXd Trajectory::getVelocity(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
+  std::vector<TrajectoryStep>::const_iterator it = trajectory_.begin() + getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it;
   previous--;
 
   double time_step = it->time_ - previous->time_;
@@ -840,8 +901,8 @@ Eigen::VectorXd Trajectory::getVelocity(double time) const
 
 Eigen::VectorXd Trajectory::getAcceleration(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
+  std::vector<TrajectoryStep>::const_iterator it = trajectory_.begin() + getTrajectorySegment(time);
+  std::vector<TrajectoryStep>::const_iterator previous = it;
   previous--;
 
   double time_step = it->time_ - previous->time_;
@@ -1109,7 +1170,8 @@ bool TimeOptimalTrajectoryGeneration::doTimeParameterizationCalculations(robot_t
 
   // Have to convert into Eigen data structs and remove repeated points
   //  (https://github.com/tobiaskunz/trajectories/issues/3)
-  std::list<Eigen::VectorXd> points;
+  std::vector<Eigen::VectorXd> points;
+  points.reserve(num_points);
   for (size_t p = 0; p < num_points; ++p)
   {
     moveit::core::RobotStatePtr waypoint = trajectory.getWayPointPtr(p);
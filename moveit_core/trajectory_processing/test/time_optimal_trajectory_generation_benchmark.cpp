@@ -0,0 +1,135 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmark of TOTG on long trajectories */
+
+#include <gtest/gtest.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+using trajectory_processing::Path;
+using trajectory_processing::TimeOptimalTrajectoryGeneration;
+using trajectory_processing::Trajectory;
+
+namespace
+{
+// Helper class to measure time within a scoped block and output the result
+class ScopedTimer
+{
+  const char* const msg_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  ScopedTimer(const char* msg = "") : msg_(msg), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    std::cerr << msg_ << elapsed.count() * 1000. << "ms\n";
+  }
+};
+
+/** \brief A smooth, non-degenerate joint space curve through \e count waypoints of dimension \e dof */
+std::vector<Eigen::VectorXd> makeWaypoints(std::size_t count, std::size_t dof)
+{
+  std::vector<Eigen::VectorXd> waypoints(count, Eigen::VectorXd(dof));
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    for (std::size_t j = 0; j < dof; ++j)
+      waypoints[i][j] = 0.5 * std::sin(0.01 * i * (j + 1) + j);
+  }
+  return waypoints;
+}
+}  // namespace
+
+TEST(TimeOptimalTrajectoryGenerationBenchmark, retimePath)
+{
+  constexpr std::size_t DOF = 7;
+  const Eigen::VectorXd max_velocity = Eigen::VectorXd::Constant(DOF, 1.0);
+  const Eigen::VectorXd max_acceleration = Eigen::VectorXd::Constant(DOF, 2.0);
+
+  for (const std::size_t count : { 1000, 10000 })
+  {
+    const std::vector<Eigen::VectorXd> waypoints = makeWaypoints(count, DOF);
+    const std::string msg = "Trajectory of " + std::to_string(count) + " waypoints: ";
+    ScopedTimer t(msg.c_str());
+    Trajectory trajectory(Path(waypoints, 0.1), max_velocity, max_acceleration);
+    ASSERT_TRUE(trajectory.isValid());
+  }
+}
+
+TEST(TimeOptimalTrajectoryGenerationBenchmark, computeTimeStamps)
+{
+  const moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  ASSERT_TRUE(robot_model);
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup("panda_arm");
+  ASSERT_TRUE(group);
+
+  // The URDF does not specify acceleration limits
+  std::unordered_map<std::string, double> velocity_limits;
+  std::unordered_map<std::string, double> acceleration_limits;
+  for (const std::string& name : group->getVariableNames())
+  {
+    velocity_limits[name] = 1.0;
+    acceleration_limits[name] = 2.0;
+  }
+
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  TimeOptimalTrajectoryGeneration totg;
+  for (const std::size_t count : { 1000, 10000 })
+  {
+    robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+    for (const Eigen::VectorXd& waypoint : makeWaypoints(count, group->getVariableCount()))
+    {
+      state.setJointGroupPositions(group, waypoint);
+      trajectory.addSuffixWayPoint(state, 0.0);
+    }
+
+    const std::string msg = "computeTimeStamps() on " + std::to_string(count) + " waypoints: ";
+    ScopedTimer t(msg.c_str());
+    ASSERT_TRUE(totg.computeTimeStamps(trajectory, velocity_limits, acceleration_limits));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
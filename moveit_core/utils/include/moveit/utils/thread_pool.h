@@ -0,0 +1,137 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief A fixed set of worker threads which run parallel loops.
+ *
+ *  The workers are started once and wait for work in between loops, so starting a loop only hands out its tasks. The
+ *  calling thread always takes part in its loop and runs the tasks no worker has picked up yet itself. Loops can thus
+ *  be started from several threads at once, and from within other loops, without waiting on each other. */
+class ThreadPool
+{
+public:
+  /** \brief Start the workers of the pool.
+   *  @param num_threads The number of threads running a loop, the calling thread included. 0 uses one per core. */
+  explicit ThreadPool(std::size_t num_threads = 0);
+
+  /** \brief Stop and join the workers. No loop may be running anymore. */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /** \brief The number of threads running a loop, the calling thread included */
+  std::size_t getNumThreads() const
+  {
+    return workers_.size() + 1;
+  }
+
+  /** \brief The number of threads a loop asking for \e num_threads threads runs on.
+   *  @param num_threads The requested number of threads, 0 asks for all threads of the pool */
+  std::size_t getNumThreads(std::size_t num_threads) const
+  {
+    return num_threads == 0 || num_threads > getNumThreads() ? getNumThreads() : num_threads;
+  }
+
+  /** \brief Call \e worker once for every thread index in [0, getNumThreads(num_threads)) concurrently and wait for all
+   *  calls to return. If calls throw, the first exception is rethrown once all calls have returned. */
+  void run(std::size_t num_threads, const std::function<void(std::size_t)>& worker);
+
+  /** \brief Call \e body for every index in [0, \e count). The indices are handed out one at a time to the threads as
+   *  they become free, so iterations may take different amounts of time.
+   *  @param num_threads The maximum number of threads to use, 0 for all threads of the pool */
+  void parallelFor(std::size_t count, std::size_t num_threads, const std::function<void(std::size_t)>& body)
+  {
+    parallelForWithState(count, num_threads, [&body] { return std::cref(body); });
+  }
+
+  /** \brief Like parallelFor(), for loops which need state per thread, e.g. scratch space.
+   *  @param make_body Called once by every thread taking part in the loop. Returns the callable that is invoked with
+   *  the indices the thread processes, and which owns or refers to that thread's state. */
+  template <typename MakeBody>
+  void parallelForWithState(std::size_t count, std::size_t num_threads, const MakeBody& make_body)
+  {
+    if (count == 0)
+      return;
+    std::atomic<std::size_t> next(0);
+    run(std::min(getNumThreads(num_threads), count), [&](std::size_t /*thread_index*/) {
+      auto body = make_body();
+      for (std::size_t i = next++; i < count; i = next++)
+        body(i);
+    });
+  }
+
+private:
+  struct Job;
+
+  struct Task
+  {
+    Job* job;
+    std::size_t thread_index;
+  };
+
+  void workerThread();
+
+  /** \brief Run a task and record its exception, if any */
+  static void runTask(const Task& task);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable task_done_;
+  std::deque<Task> tasks_;
+  bool stop_ = false;
+};
+
+/** \brief The thread pool shared by the parallel loops of MoveIt, with one thread per core. It is started on first
+ *  use. Callers limit the number of threads of their loops to what they were configured to use. */
+ThreadPool& getThreadPool();
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,159 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/utils/thread_pool.h>
+#include <algorithm>
+#include <exception>
+
+namespace moveit
+{
+namespace core
+{
+struct ThreadPool::Job
+{
+  const std::function<void(std::size_t)>* worker;
+  /** \brief Tasks of the job that were picked up by workers and did not finish yet */
+  std::size_t running = 0;
+  std::exception_ptr error;
+  std::mutex error_mutex;
+};
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+{
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  workers_.reserve(num_threads - 1);
+  for (std::size_t i = 1; i < num_threads; ++i)
+    workers_.emplace_back([this] { workerThread(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& worker : workers_)
+    worker.join();
+}
+
+void ThreadPool::runTask(const Task& task)
+{
+  try
+  {
+    (*task.job->worker)(task.thread_index);
+  }
+  catch (...)
+  {
+    std::scoped_lock lock(task.job->error_mutex);
+    if (!task.job->error)
+      task.job->error = std::current_exception();
+  }
+}
+
+void ThreadPool::run(std::size_t num_threads, const std::function<void(std::size_t)>& worker)
+{
+  num_threads = getNumThreads(num_threads);
+  if (num_threads == 1)
+  {
+    worker(0);
+    return;
+  }
+
+  Job job;
+  job.worker = &worker;
+  {
+    std::scoped_lock lock(mutex_);
+    for (std::size_t i = 1; i < num_threads; ++i)
+      tasks_.push_back({ &job, i });
+  }
+  work_available_.notify_all();
+
+  runTask({ &job, 0 });
+
+  // take back the tasks no worker started yet, so the job does not wait for workers busy with other loops
+  std::vector<Task> remaining;
+  {
+    std::scoped_lock lock(mutex_);
+    for (auto it = tasks_.begin(); it != tasks_.end();)
+    {
+      if (it->job == &job)
+      {
+        remaining.push_back(*it);
+        it = tasks_.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+  for (const Task& task : remaining)
+    runTask(task);
+
+  {
+    std::unique_lock lock(mutex_);
+    task_done_.wait(lock, [&job] { return job.running == 0; });
+  }
+  if (job.error)
+    std::rethrow_exception(job.error);
+}
+
+void ThreadPool::workerThread()
+{
+  std::unique_lock lock(mutex_);
+  while (true)
+  {
+    work_available_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+    if (stop_)
+      return;
+    Task task = tasks_.front();
+    tasks_.pop_front();
+    ++task.job->running;
+    lock.unlock();
+
+    runTask(task);
+
+    lock.lock();
+    if (--task.job->running == 0)
+      task_done_.notify_all();
+  }
+}
+
+ThreadPool& getThreadPool()
+{
+  static ThreadPool pool;
+  return pool;
+}
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,127 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/utils/thread_pool.h>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+
+TEST(ThreadPool, ParallelForVisitsEveryIndexOnce)
+{
+  moveit::core::ThreadPool pool(4);
+  EXPECT_EQ(pool.getNumThreads(), 4u);
+  EXPECT_EQ(pool.getNumThreads(0), 4u);
+  EXPECT_EQ(pool.getNumThreads(2), 2u);
+  EXPECT_EQ(pool.getNumThreads(16), 4u);
+
+  for (std::size_t num_threads : { 0, 1, 3 })
+  {
+    std::vector<std::atomic<int>> visits(1000);
+    pool.parallelFor(visits.size(), num_threads, [&](std::size_t i) { ++visits[i]; });
+    for (const std::atomic<int>& count : visits)
+      EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(ThreadPool, StatePerThread)
+{
+  moveit::core::ThreadPool pool(4);
+  std::mutex mutex;
+  std::vector<std::size_t> sums;
+  pool.parallelForWithState(10000, 0, [&] {
+    // the sum of each thread is handed over when its body is destroyed
+    auto sum = std::shared_ptr<std::size_t>(new std::size_t(0), [&](std::size_t* s) {
+      std::scoped_lock lock(mutex);
+      sums.push_back(*s);
+      delete s;
+    });
+    return [sum](std::size_t i) { *sum += i; };
+  });
+  EXPECT_LE(sums.size(), 4u);
+  EXPECT_EQ(std::accumulate(sums.begin(), sums.end(), std::size_t(0)), 10000u * 9999u / 2);
+}
+
+TEST(ThreadPool, RunGivesDistinctThreadIndices)
+{
+  moveit::core::ThreadPool pool(3);
+  std::mutex mutex;
+  std::multiset<std::size_t> indices;
+  pool.run(0, [&](std::size_t thread_index) {
+    std::scoped_lock lock(mutex);
+    indices.insert(thread_index);
+  });
+  EXPECT_EQ(indices, std::multiset<std::size_t>({ 0, 1, 2 }));
+}
+
+TEST(ThreadPool, NestedAndConcurrentLoops)
+{
+  moveit::core::ThreadPool pool(2);
+  std::atomic<std::size_t> total(0);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 4; ++c)
+  {
+    callers.emplace_back([&] {
+      pool.parallelFor(20, 0, [&](std::size_t) {
+        pool.parallelFor(50, 0, [&](std::size_t) { ++total; });
+      });
+    });
+  }
+  for (std::thread& caller : callers)
+    caller.join();
+  EXPECT_EQ(total, 4u * 20u * 50u);
+}
+
+TEST(ThreadPool, RethrowsExceptions)
+{
+  moveit::core::ThreadPool pool(4);
+  std::atomic<std::size_t> done(0);
+  EXPECT_THROW(pool.parallelFor(100, 0,
+                                [&](std::size_t i) {
+                                  if (i == 42)
+                                    throw std::runtime_error("failed");
+                                  ++done;
+                                }),
+               std::runtime_error);
+  // the pool is still usable afterwards
+  pool.parallelFor(100, 0, [&](std::size_t) { ++done; });
+  EXPECT_GE(done, 100u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
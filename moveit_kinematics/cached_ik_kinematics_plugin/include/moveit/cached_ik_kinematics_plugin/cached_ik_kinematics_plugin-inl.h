@@ -79,7 +79,8 @@ bool CachedMultiTipIKKinematicsPlugin<KinematicsPlugin>::initialize(
   std::string cache_name = base_frame;
   std::accumulate(tip_frames.begin(), tip_frames.end(), cache_name);
   CachedIKKinematicsPlugin<KinematicsPlugin>::cache_.initializeCache(robot_model.getName(), group_name, cache_name,
-                                                                     KinematicsPlugin::getJointNames().size());
+                                                                     KinematicsPlugin::getJointNames().size(),
+                                                                     IKCache::Options(), tip_frames.size());
   return true;
 }
 
@@ -91,7 +92,7 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::getPositionIK(const geometry_ms
                                                                const KinematicsQueryOptions& options) const
 {
   Pose pose(ik_pose);
-  const IKEntry& nearest = cache_.getBestApproximateIKSolution(pose);
+  const IKEntry nearest = cache_.getBestApproximateIKSolution(pose);
   bool solution_found = KinematicsPlugin::getPositionIK(ik_pose, nearest.second, solution, error_code, options) ||
                         KinematicsPlugin::getPositionIK(ik_pose, ik_seed_state, solution, error_code, options);
   if (solution_found)
@@ -108,7 +109,7 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(const geometry
 {
   std::chrono::time_point<std::chrono::system_clock> start(std::chrono::system_clock::now());
   Pose pose(ik_pose);
-  const IKEntry& nearest = cache_.getBestApproximateIKSolution(pose);
+  const IKEntry nearest = cache_.getBestApproximateIKSolution(pose);
   bool solution_found =
       KinematicsPlugin::searchPositionIK(ik_pose, nearest.second, timeout, solution, error_code, options);
   if (!solution_found)
@@ -130,7 +131,7 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
 {
   std::chrono::time_point<std::chrono::system_clock> start(std::chrono::system_clock::now());
   Pose pose(ik_pose);
-  const IKEntry& nearest = cache_.getBestApproximateIKSolution(pose);
+  const IKEntry nearest = cache_.getBestApproximateIKSolution(pose);
   bool solution_found = KinematicsPlugin::searchPositionIK(ik_pose, nearest.second, timeout, consistency_limits,
                                                            solution, error_code, options);
   if (!solution_found)
@@ -154,7 +155,7 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(const geometry
 {
   std::chrono::time_point<std::chrono::system_clock> start(std::chrono::system_clock::now());
   Pose pose(ik_pose);
-  const IKEntry& nearest = cache_.getBestApproximateIKSolution(pose);
+  const IKEntry nearest = cache_.getBestApproximateIKSolution(pose);
   bool solution_found = KinematicsPlugin::searchPositionIK(ik_pose, nearest.second, timeout, solution,
                                                            solution_callback, error_code, options);
   if (!solution_found)
@@ -176,7 +177,7 @@ bool CachedIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
 {
   std::chrono::time_point<std::chrono::system_clock> start(std::chrono::system_clock::now());
   Pose pose(ik_pose);
-  const IKEntry& nearest = cache_.getBestApproximateIKSolution(pose);
+  const IKEntry nearest = cache_.getBestApproximateIKSolution(pose);
   bool solution_found = KinematicsPlugin::searchPositionIK(ik_pose, nearest.second, timeout, consistency_limits,
                                                            solution, solution_callback, error_code, options);
   if (!solution_found)
@@ -201,7 +202,7 @@ bool CachedMultiTipIKKinematicsPlugin<KinematicsPlugin>::searchPositionIK(
   std::vector<Pose> poses(ik_poses.size());
   for (unsigned int i = 0; i < poses.size(); ++i)
     poses[i] = Pose(ik_poses[i]);
-  const IKEntry& nearest = CachedIKKinematicsPlugin<KinematicsPlugin>::cache_.getBestApproximateIKSolution(poses);
+  const IKEntry nearest = CachedIKKinematicsPlugin<KinematicsPlugin>::cache_.getBestApproximateIKSolution(poses);
   bool solution_found =
       KinematicsPlugin::searchPositionIK(ik_poses, nearest.second, timeout, consistency_limits, solution,
                                          solution_callback, error_code, options, context_state);
@@ -36,13 +36,16 @@
 
 #pragma once
 
-#include <moveit/cached_ik_kinematics_plugin/detail/NearestNeighborsGNAT.h>
 #include <moveit/kdl_kinematics_plugin/kdl_kinematics_plugin.h>
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_model/robot_model.h>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2/LinearMath/Vector3.h>
+#include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <filesystem>
@@ -53,7 +56,26 @@ namespace cached_ik_kinematics_plugin
 static const rclcpp::Logger LOGGER =
     rclcpp::get_logger("moveit_cached_ik_kinematics_plugin.cached_ik_kinematics_plugin");
 
-/** \brief A cache of inverse kinematic solutions */
+/**
+  \brief A cache of inverse kinematic solutions
+
+   The cache lives in a file that is mapped into memory. Entries are
+   appended to the mapping in place and a spatial index over the
+   entries is stored in the same file, so opening a cache does not
+   require reading or indexing its entries. The index is over the poses
+   of all end effectors of an entry, using the sum of their pose
+   distances as the metric, so that lookups are exact nearest neighbor
+   searches.
+
+   Only one process maps a cache file at a time. A process that opens a
+   cache file that is already mapped by another process keeps a private
+   copy of it and replaces the file as a whole when saving.
+
+   Lookups can run concurrently. New entries are queued and added to
+   the cache in batches by a background thread, which also updates the
+   spatial index without blocking lookups for longer than it takes to
+   copy the updated part of the index.
+*/
 class IKCache
 {
 public:
@@ -97,33 +119,119 @@ public:
   IKCache(const IKCache&) = delete;
 
   /** get the entry from the IK cache that best matches a given pose */
-  const IKEntry& getBestApproximateIKSolution(const Pose& pose) const;
+  IKEntry getBestApproximateIKSolution(const Pose& pose) const;
   /** get the entry from the IK cache that best matches a given vector of poses */
-  const IKEntry& getBestApproximateIKSolution(const std::vector<Pose>& poses) const;
-  /** initialize cache, read from disk if found */
+  IKEntry getBestApproximateIKSolution(const std::vector<Pose>& poses) const;
+  /**
+    initialize cache, map the cache file if found. Cache files in the
+    format of earlier versions are converted.
+  */
   void initializeCache(const std::string& robot_id, const std::string& group_name, const std::string& cache_name,
-                       const unsigned int num_joints, const Options& opts = Options());
+                       const unsigned int num_joints, const Options& opts = Options(),
+                       const unsigned int num_tips = 1);
   /**
     insert (pose,config) as an entry if it's different enough from the
-    most similar cache entry
+    most similar cache entry. The entry is added asynchronously.
   */
   void updateCache(const IKEntry& nearest, const Pose& pose, const std::vector<double>& config) const;
   /**
-    insert (pose,config) as an entry if it's different enough from the
-    most similar cache entry
+    insert (poses,config) as an entry if it's different enough from the
+    most similar cache entry. The entry is added asynchronously.
   */
   void updateCache(const IKEntry& nearest, const std::vector<Pose>& poses, const std::vector<double>& config) const;
+  /** wait until all entries queued by updateCache() are added to the cache */
+  void flush() const;
   /** verify with forward kinematics that the cache entries are correct */
   void verifyCache(kdl_kinematics_plugin::KDLKinematicsPlugin& fk) const;
+  /** number of entries in the cache */
+  unsigned int size() const;
 
 protected:
+  /**
+    header at the start of a cache file. It is followed by space for
+    \e capacity entries and by the spatial index over the entries. Each
+    entry consists of a pose (position and quaternion) per end effector
+    followed by a joint configuration.
+  */
+  struct FileHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t num_dofs;
+    std::uint32_t num_tips;
+    std::uint32_t capacity;
+    /** number of entries stored */
+    std::uint32_t num_entries;
+    /** entries [0, num_indexed) are contained in the spatial index */
+    std::uint32_t num_indexed;
+  };
+
   /** compute the distance between two joint configurations */
   double configDistance2(const std::vector<double>& config1, const std::vector<double>& config2) const;
   /** save current state of cache to disk */
   void saveCache() const;
 
+  /**
+    map the cache file into memory and lock it against other processes,
+    replacing it by a new file if \e create is true. Fails if another
+    process holds the lock.
+  */
+  bool mapCacheFile(bool create);
+  /** add the queued entries, save the cache and release its memory */
+  void closeCache();
+  /** queue (poses,config) to be added to the cache */
+  void queueEntry(const std::vector<Pose>& poses, const std::vector<double>& config) const;
+  /** add batches of queued entries to the cache until the cache is closed */
+  void updateThread();
+  /**
+    extend the spatial index to the entries appended since it was last
+    updated. The index consists of vantage point trees over consecutive
+    blocks of entries, with block sizes that are distinct powers of two
+    times a minimum block size, so that only the smallest blocks need to
+    be rebuilt to add entries. The blocks are built while lookups
+    continue to use the previous index.
+  */
+  void updateIndex();
+  /**
+    build a vantage point tree over the \e size entries in \e order.
+    The root is stored first, followed by the subtrees of the entries
+    closer and farther than \e radius[0] from the root.
+  */
+  void buildTree(std::uint32_t* order, double* radius, std::uint32_t size,
+                 std::vector<std::pair<double, std::uint32_t>>& scratch) const;
+  /** search a vantage point tree for an entry closer than \e best_dist to \e poses */
+  void searchTree(const std::uint32_t* order, const double* radius, std::uint32_t size, const std::vector<Pose>& poses,
+                  unsigned int& best, double& best_dist) const;
+  /** get the index of the entry that best matches a given vector of poses */
+  unsigned int nearestEntry(const std::vector<Pose>& poses) const;
+  /** compute the distance between an entry and a vector of poses */
+  double entryDistance(unsigned int i, const std::vector<Pose>& poses) const;
+  /** append (poses,config) to the cache */
+  void appendEntry(const std::vector<Pose>& poses, const std::vector<double>& config);
+  IKEntry readEntry(unsigned int i) const;
+  FileHeader& header() const
+  {
+    return *reinterpret_cast<FileHeader*>(data_);
+  }
+  char* entryData(unsigned int i) const
+  {
+    return data_ + sizeof(FileHeader) + i * entry_size_;
+  }
+  /** the distance from each inner node of the index to the median of the entries in its subtree */
+  double* indexRadius() const
+  {
+    return reinterpret_cast<double*>(entryData(max_cache_size_));
+  }
+  /** the entries of the index, in the order of the vantage point trees */
+  std::uint32_t* indexOrder() const
+  {
+    return reinterpret_cast<std::uint32_t*>(indexRadius() + max_cache_size_);
+  }
+
   /** number of joints in the system */
   unsigned int num_joints_;
+  /** number of end effectors */
+  unsigned int num_tips_{ 1 };
 
   /** for all cache entries, the poses are at least minPoseDistance_ apart ... */
   double min_pose_distance_;
@@ -134,19 +242,38 @@ protected:
   /** file name for loading / saving cache */
   std::filesystem::path cache_file_name_;
 
+  /** size in bytes of a cache entry */
+  std::size_t entry_size_{ 0 };
+
   /**
-    the IK methods are declared const in the base class, but the
-    wrapped methods need to modify the cache, so the next four members
-    are mutable
-    cache of IK solutions
+    contents of the cache file, mapped into memory or, where mapping
+    fails, held in buffer_ and written out as a whole. Only the update
+    thread modifies the contents once the cache is initialized.
   */
-  mutable std::vector<IKEntry> ik_cache_;
-  /** nearest neighbor data structure over IK cache entries */
-  mutable NearestNeighborsGNAT<IKEntry*> ik_nn_;
+  char* data_{ nullptr };
+  std::size_t data_size_{ 0 };
+  bool mapped_{ false };
+  /** descriptor of the mapped cache file, which holds its lock */
+  int cache_fd_{ -1 };
+  std::vector<char> buffer_;
   /** size of the cache when it was last saved */
   mutable unsigned int last_saved_cache_size_{ 0 };
-  /** mutex for changing IK cache */
-  mutable std::mutex lock_;
+  /** shared by lookups, exclusive while entries or index blocks are added */
+  mutable std::shared_mutex lock_;
+
+  /**
+    the IK methods are declared const in the base class, but the
+    wrapped methods need to queue new entries, so the next members are
+    mutable
+    entries waiting to be added by update_thread_
+  */
+  mutable std::vector<IKEntry> queued_entries_;
+  /** number of entries update_thread_ is adding */
+  mutable std::size_t adding_entries_{ 0 };
+  mutable std::mutex queue_lock_;
+  mutable std::condition_variable queue_condition_;
+  bool stop_update_thread_{ false };
+  std::thread update_thread_;
 };
 
 /** a container of IK caches for cases where there is no fixed base frame */
@@ -162,9 +289,8 @@ public:
     get the entry from the IK cache that best matches a given vector of
     poses, with a specified set of fixed and active tip links
   */
-  const IKEntry& getBestApproximateIKSolution(const std::vector<std::string>& fixed,
-                                              const std::vector<std::string>& active,
-                                              const std::vector<Pose>& poses) const;
+  IKEntry getBestApproximateIKSolution(const std::vector<std::string>& fixed, const std::vector<std::string>& active,
+                                       const std::vector<Pose>& poses) const;
   /**
     insert (pose,config) as an entry if it's different enough from the
     most similar cache entry
@@ -34,44 +34,121 @@
 
 /* Author: Mark Moll */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <numeric>
 #include <filesystem>
 #include <fstream>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <moveit/cached_ik_kinematics_plugin/cached_ik_kinematics_plugin.h>
 
 namespace cached_ik_kinematics_plugin
 {
+namespace
+{
+constexpr char CACHE_FILE_MAGIC[8] = { 'I', 'K', 'C', 'A', 'C', 'H', 'E', '\0' };
+constexpr std::uint32_t CACHE_FILE_VERSION = 2;
+// entries are added to the spatial index in blocks of this size, until then they are searched linearly
+constexpr std::uint32_t MIN_INDEX_BLOCK_SIZE = 1024;
+// subtrees of the spatial index up to this size are searched linearly
+constexpr std::uint32_t MAX_LEAF_SIZE = 8;
+
+constexpr std::size_t POSITION_SIZE = 3 * sizeof(tf2Scalar);
+constexpr std::size_t ORIENTATION_SIZE = 4 * sizeof(tf2Scalar);
+constexpr std::size_t POSE_SIZE = POSITION_SIZE + ORIENTATION_SIZE;
+
+IKCache::Pose readPose(const char* entry, unsigned int tip)
+{
+  IKCache::Pose pose;
+  memcpy(&pose.position[0], entry + tip * POSE_SIZE, POSITION_SIZE);
+  memcpy(&pose.orientation[0], entry + tip * POSE_SIZE + POSITION_SIZE, ORIENTATION_SIZE);
+  return pose;
+}
+
+void writePose(char* entry, unsigned int tip, const IKCache::Pose& pose)
+{
+  memcpy(entry + tip * POSE_SIZE, &pose.position[0], POSITION_SIZE);
+  memcpy(entry + tip * POSE_SIZE + POSITION_SIZE, &pose.orientation[0], ORIENTATION_SIZE);
+}
+
+// read the entries of a cache file written by earlier versions, which store just the number of entries,
+// the number of dofs and the number of tips, followed by the entries in the same layout as the current format
+bool readLegacyCache(std::ifstream& cache_file, unsigned int num_dofs, unsigned int num_tips, std::size_t entry_size,
+                     std::vector<char>& entries)
+{
+  std::uint32_t header[3];
+  cache_file.clear();
+  cache_file.seekg(0);
+  if (!cache_file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[1] != num_dofs ||
+      header[2] != num_tips)
+    return false;
+  entries.resize(header[0] * entry_size);
+  return static_cast<bool>(cache_file.read(entries.data(), entries.size()));
+}
+
+// files replacing a cache file are written next to it first, the process id keeps processes from sharing one
+std::filesystem::path temporaryPath(const std::filesystem::path& path)
+{
+#ifndef _WIN32
+  return path.string() + "." + std::to_string(getpid()) + ".tmp";
+#else
+  return path.string() + ".tmp";
+#endif
+}
+
+#ifndef _WIN32
+// open a file and lock it for this process; fails if another process holds the lock or the file was replaced
+// between opening and locking it
+int openLocked(const std::filesystem::path& path, int flags)
+{
+  int fd = open(path.c_str(), flags, 0644);
+  if (fd < 0)
+    return -1;
+  struct stat fd_stat, path_stat;
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0 || fstat(fd, &fd_stat) != 0 || stat(path.c_str(), &path_stat) != 0 ||
+      fd_stat.st_dev != path_stat.st_dev || fd_stat.st_ino != path_stat.st_ino)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+#endif
+}  // namespace
+
 IKCache::IKCache()
 {
-  // set distance function for nearest-neighbor queries
-  ik_nn_.setDistanceFunction([](const IKEntry* entry1, const IKEntry* entry2) {
-    double dist = 0.;
-    for (unsigned int i = 0; i < entry1->first.size(); ++i)
-      dist += entry1->first[i].distance(entry2->first[i]);
-    return dist;
-  });
 }
 
 IKCache::~IKCache()
 {
-  if (!ik_cache_.empty())
-    saveCache();
+  closeCache();
 }
 
 void IKCache::initializeCache(const std::string& robot_id, const std::string& group_name, const std::string& cache_name,
-                              const unsigned int num_joints, const Options& opts)
+                              const unsigned int num_joints, const Options& opts, const unsigned int num_tips)
 {
+  closeCache();
+
   // read ROS parameters
   max_cache_size_ = opts.max_cache_size;
-  ik_cache_.reserve(max_cache_size_);
   min_pose_distance_ = opts.min_pose_distance;
   min_config_distance2_ = opts.min_joint_config_distance;
   min_config_distance2_ *= min_config_distance2_;
   std::string cached_ik_path = opts.cached_ik_path;
 
-  // use mutex lock for rest of initialization
-  std::lock_guard<std::mutex> slock(lock_);
+  // use mutex lock for setting up the cache file
+  std::unique_lock<std::shared_mutex> ulock(lock_);
   // determine cache file name
   std::filesystem::path prefix(!cached_ik_path.empty() ? std::filesystem::path(cached_ik_path) :
                                                          std::filesystem::current_path());
@@ -82,59 +159,202 @@ void IKCache::initializeCache(const std::string& robot_id, const std::string& gr
                                std::to_string(min_pose_distance_) + "_" +
                                std::to_string(std::sqrt(min_config_distance2_)) + ".ikcache");
 
-  ik_cache_.clear();
-  ik_nn_.clear();
-  last_saved_cache_size_ = 0;
+  num_joints_ = num_joints;
+  num_tips_ = num_tips;
+  entry_size_ = num_tips_ * POSE_SIZE + num_joints_ * sizeof(double);
+  data_size_ = sizeof(FileHeader) + max_cache_size_ * (entry_size_ + sizeof(double) + sizeof(std::uint32_t));
+
+  // check whether an existing file can be used as is or needs to be converted
+  bool reuse_file = false;
+  std::vector<char> legacy_entries;
   if (std::filesystem::exists(cache_file_name_))
   {
-    // read cache
     std::ifstream cache_file(cache_file_name_, std::ios_base::binary | std::ios_base::in);
-    cache_file.read(reinterpret_cast<char*>(&last_saved_cache_size_), sizeof(unsigned int));
-    unsigned int num_dofs;
-    cache_file.read(reinterpret_cast<char*>(&num_dofs), sizeof(unsigned int));
-    unsigned int num_tips;
-    cache_file.read(reinterpret_cast<char*>(&num_tips), sizeof(unsigned int));
-
-    RCLCPP_INFO(LOGGER, "Found %d IK solutions for a %d-dof system with %d end effectors in %s", last_saved_cache_size_,
-                num_dofs, num_tips, cache_file_name_.string().c_str());
-
-    unsigned int position_size = 3 * sizeof(tf2Scalar);
-    unsigned int orientation_size = 4 * sizeof(tf2Scalar);
-    unsigned int pose_size = position_size + orientation_size;
-    unsigned int config_size = num_dofs * sizeof(double);
-    unsigned int offset_conf = pose_size * num_tips;
-    unsigned int bufsize = offset_conf + config_size;
-    char* buffer = new char[bufsize];
-    IKEntry entry;
-    entry.first.resize(num_tips);
-    entry.second.resize(num_dofs);
-    ik_cache_.reserve(last_saved_cache_size_);
+    FileHeader file_header;
+    if (cache_file.read(reinterpret_cast<char*>(&file_header), sizeof(FileHeader)) &&
+        memcmp(file_header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) == 0)
+    {
+      reuse_file = file_header.version == CACHE_FILE_VERSION && file_header.num_dofs == num_joints_ &&
+                   file_header.num_tips == num_tips_ && file_header.capacity == max_cache_size_ &&
+                   std::filesystem::file_size(cache_file_name_) == data_size_;
+      if (!reuse_file)
+        RCLCPP_WARN(LOGGER, "Cache file %s has an incompatible layout, replacing it",
+                    cache_file_name_.string().c_str());
+    }
+    else if (readLegacyCache(cache_file, num_joints_, num_tips_, entry_size_, legacy_entries))
+      RCLCPP_INFO(LOGGER, "Converting %zu IK solutions in %s to the current file format",
+                  legacy_entries.size() / entry_size_, cache_file_name_.string().c_str());
+    else
+      RCLCPP_WARN(LOGGER, "Could not read cache file %s, replacing it", cache_file_name_.string().c_str());
+  }
+
+  if (!mapCacheFile(!reuse_file))
+  {
+    RCLCPP_WARN(LOGGER,
+                "Could not map cache file %s into memory or it is in use by another process, "
+                "the cache will be saved as a whole",
+                cache_file_name_.string().c_str());
+    buffer_.assign(data_size_, 0);
+    data_ = buffer_.data();
+    if (reuse_file)
+    {
+      std::ifstream cache_file(cache_file_name_, std::ios_base::binary | std::ios_base::in);
+      cache_file.read(data_, data_size_);
+      // another process may update the file while it is read, which leaves the entries counted in the header
+      // complete but not necessarily the index, so the index is rebuilt
+      header().num_indexed = 0;
+    }
+  }
 
-    for (unsigned i = 0; i < last_saved_cache_size_; ++i)
+  FileHeader& file_header = header();
+  if (!reuse_file)
+  {
+    memcpy(file_header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+    file_header.version = CACHE_FILE_VERSION;
+    file_header.num_dofs = num_joints_;
+    file_header.num_tips = num_tips_;
+    file_header.capacity = max_cache_size_;
+    file_header.num_indexed = 0;
+    file_header.num_entries = std::min<std::size_t>(legacy_entries.size() / entry_size_, max_cache_size_);
+    if (file_header.num_entries > 0)
+      memcpy(entryData(0), legacy_entries.data(), file_header.num_entries * entry_size_);
+  }
+  ulock.unlock();
+  updateIndex();
+  saveCache();
+
+  RCLCPP_INFO(LOGGER, "Found %d IK solutions for a %d-dof system with %d end effectors in %s",
+              file_header.num_entries, num_joints_, num_tips_, cache_file_name_.string().c_str());
+
+  stop_update_thread_ = false;
+  update_thread_ = std::thread([this] { updateThread(); });
+}
+
+bool IKCache::mapCacheFile(bool create)
+{
+#ifndef _WIN32
+  // the lock is held for as long as the file is mapped, so no other process maps or replaces it meanwhile
+  int fd = openLocked(cache_file_name_, create ? O_RDWR | O_CREAT : O_RDWR);
+  if (fd < 0)
+    return false;
+  if (create)
+  {
+    // processes that do not map the file may still read it, so it is replaced by a new file instead of truncated;
+    // the new file is sized for all entries right away and the space of entries not stored yet remains sparse
+    const std::filesystem::path new_file_name = temporaryPath(cache_file_name_);
+    int new_fd = openLocked(new_file_name, O_RDWR | O_CREAT | O_TRUNC);
+    const bool replaced = new_fd >= 0 && ftruncate(new_fd, data_size_) == 0 &&
+                          rename(new_file_name.c_str(), cache_file_name_.c_str()) == 0;
+    close(fd);
+    if (!replaced)
     {
-      unsigned int j = 0;
-      cache_file.read(buffer, bufsize);
-      for (auto& pose : entry.first)
+      if (new_fd >= 0)
       {
-        memcpy(&pose.position[0], buffer + j * pose_size, position_size);
-        memcpy(&pose.orientation[0], buffer + j * pose_size + position_size, orientation_size);
-        ++j;
+        close(new_fd);
+        unlink(new_file_name.c_str());
       }
-      memcpy(&entry.second[0], buffer + offset_conf, config_size);
-      ik_cache_.push_back(entry);
+      return false;
     }
-    RCLCPP_INFO(LOGGER, "freeing buffer");
-    delete[] buffer;
-    RCLCPP_INFO(LOGGER, "freed buffer");
-    std::vector<IKEntry*> ik_entry_ptrs(last_saved_cache_size_);
-    for (unsigned int i = 0; i < last_saved_cache_size_; ++i)
-      ik_entry_ptrs[i] = &ik_cache_[i];
-    ik_nn_.add(ik_entry_ptrs);
+    fd = new_fd;
   }
+  void* addr = mmap(nullptr, data_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED)
+  {
+    close(fd);
+    return false;
+  }
+  data_ = static_cast<char*>(addr);
+  mapped_ = true;
+  cache_fd_ = fd;
+  return true;
+#else
+  (void)create;
+  return false;
+#endif
+}
 
-  num_joints_ = num_joints;
+void IKCache::closeCache()
+{
+  if (update_thread_.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> qlock(queue_lock_);
+      stop_update_thread_ = true;
+    }
+    queue_condition_.notify_all();
+    update_thread_.join();
+  }
+  if (data_ == nullptr)
+    return;
+  saveCache();
+#ifndef _WIN32
+  if (mapped_)
+    munmap(data_, data_size_);
+  if (cache_fd_ >= 0)
+    close(cache_fd_);
+  cache_fd_ = -1;
+#endif
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+  data_ = nullptr;
+  mapped_ = false;
+}
+
+void IKCache::queueEntry(const std::vector<Pose>& poses, const std::vector<double>& config) const
+{
+  {
+    std::lock_guard<std::mutex> qlock(queue_lock_);
+    // entries beyond the capacity of the cache would be dropped anyway
+    if (!update_thread_.joinable() || queued_entries_.size() >= max_cache_size_)
+      return;
+    queued_entries_.emplace_back(poses, config);
+  }
+  queue_condition_.notify_all();
+}
+
+void IKCache::updateThread()
+{
+  std::vector<IKEntry> batch;
+  std::unique_lock<std::mutex> qlock(queue_lock_);
+  while (true)
+  {
+    queue_condition_.wait(qlock, [this] { return stop_update_thread_ || !queued_entries_.empty(); });
+    // when stopping, the queued entries are still added
+    if (queued_entries_.empty())
+      break;
+    batch.swap(queued_entries_);
+    adding_entries_ = batch.size();
+    qlock.unlock();
+
+    {
+      std::unique_lock<std::shared_mutex> ulock(lock_);
+      for (const auto& entry : batch)
+        appendEntry(entry.first, entry.second);
+    }
+    batch.clear();
+    updateIndex();
+    // only this thread modifies the header, so it can be read without lock
+    const unsigned int num_entries = header().num_entries;
+    if (num_entries >= last_saved_cache_size_ + 500u ||
+        (num_entries == max_cache_size_ && num_entries > last_saved_cache_size_))
+      saveCache();
 
-  RCLCPP_INFO(LOGGER, "cache file %s initialized!", cache_file_name_.string().c_str());
+    qlock.lock();
+    adding_entries_ = 0;
+    queue_condition_.notify_all();
+  }
+}
+
+void IKCache::flush() const
+{
+  std::unique_lock<std::mutex> qlock(queue_lock_);
+  queue_condition_.wait(qlock, [this] { return queued_entries_.empty() && adding_entries_ == 0; });
+}
+
+unsigned int IKCache::size() const
+{
+  std::shared_lock<std::shared_mutex> slock(lock_);
+  return data_ != nullptr ? header().num_entries : 0u;
 }
 
 double IKCache::configDistance2(const std::vector<double>& config1, const std::vector<double>& config2) const
@@ -148,105 +368,256 @@ double IKCache::configDistance2(const std::vector<double>& config1, const std::v
   return dist;
 }
 
-const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const Pose& pose) const
+IKCache::IKEntry IKCache::getBestApproximateIKSolution(const Pose& pose) const
+{
+  return getBestApproximateIKSolution(std::vector<Pose>(1, pose));
+}
+
+IKCache::IKEntry IKCache::getBestApproximateIKSolution(const std::vector<Pose>& poses) const
+{
+  std::shared_lock<std::shared_mutex> slock(lock_);
+  if (data_ == nullptr || header().num_entries == 0 || poses.size() != num_tips_)
+    return std::make_pair(poses, std::vector<double>(num_joints_, 0.));
+  return readEntry(nearestEntry(poses));
+}
+
+double IKCache::entryDistance(unsigned int i, const std::vector<Pose>& poses) const
+{
+  const char* entry = entryData(i);
+  double dist = 0.;
+  for (unsigned int j = 0; j < num_tips_; ++j)
+    dist += readPose(entry, j).distance(poses[j]);
+  return dist;
+}
+
+unsigned int IKCache::nearestEntry(const std::vector<Pose>& poses) const
 {
-  if (ik_cache_.empty())
+  const FileHeader& file_header = header();
+  unsigned int best = 0;
+  double best_dist = std::numeric_limits<double>::infinity();
+
+  // search the trees over the blocks of the index, from the largest to the smallest block
+  std::uint32_t num_blocks = file_header.num_indexed / MIN_INDEX_BLOCK_SIZE;
+  std::uint32_t begin = 0;
+  for (std::uint32_t bit = std::numeric_limits<std::uint32_t>::max() / 2 + 1; bit > 0; bit >>= 1)
+    if (num_blocks & bit)
+    {
+      searchTree(indexOrder() + begin, indexRadius() + begin, bit * MIN_INDEX_BLOCK_SIZE, poses, best, best_dist);
+      begin += bit * MIN_INDEX_BLOCK_SIZE;
+    }
+
+  // search the entries that are not indexed yet
+  for (unsigned int i = file_header.num_indexed; i < file_header.num_entries; ++i)
   {
-    static IKEntry dummy = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>(num_joints_, 0.));
-    return dummy;
+    double dist = entryDistance(i, poses);
+    if (dist < best_dist)
+    {
+      best_dist = dist;
+      best = i;
+    }
   }
-  IKEntry query = std::make_pair(std::vector<Pose>(1, pose), std::vector<double>());
-  return *ik_nn_.nearest(&query);
+  return best;
 }
 
-const IKCache::IKEntry& IKCache::getBestApproximateIKSolution(const std::vector<Pose>& poses) const
+void IKCache::searchTree(const std::uint32_t* order, const double* radius, std::uint32_t size,
+                         const std::vector<Pose>& poses, unsigned int& best, double& best_dist) const
 {
-  if (ik_cache_.empty())
+  if (size <= MAX_LEAF_SIZE)
+  {
+    for (std::uint32_t k = 0; k < size; ++k)
+    {
+      double dist = entryDistance(order[k], poses);
+      if (dist < best_dist)
+      {
+        best_dist = dist;
+        best = order[k];
+      }
+    }
+    return;
+  }
+
+  double dist = entryDistance(order[0], poses);
+  if (dist < best_dist)
+  {
+    best_dist = dist;
+    best = order[0];
+  }
+  // the entries of the inner subtree are at most radius[0] away from the root, those of the outer subtree at least
+  const std::uint32_t inner_size = (size - 1) / 2;
+  const std::uint32_t* outer_order = order + 1 + inner_size;
+  const double* outer_radius = radius + 1 + inner_size;
+  if (dist < radius[0])
+  {
+    searchTree(order + 1, radius + 1, inner_size, poses, best, best_dist);
+    if (radius[0] - dist < best_dist)
+      searchTree(outer_order, outer_radius, size - 1 - inner_size, poses, best, best_dist);
+  }
+  else
   {
-    static IKEntry dummy = std::make_pair(poses, std::vector<double>(num_joints_, 0.));
-    return dummy;
+    searchTree(outer_order, outer_radius, size - 1 - inner_size, poses, best, best_dist);
+    if (dist - radius[0] < best_dist)
+      searchTree(order + 1, radius + 1, inner_size, poses, best, best_dist);
   }
-  IKEntry query = std::make_pair(poses, std::vector<double>());
-  return *ik_nn_.nearest(&query);
+}
+
+void IKCache::updateIndex()
+{
+  // only the update thread modifies the header, so it can be read without lock
+  FileHeader& file_header = header();
+  const std::uint32_t num_blocks = file_header.num_indexed / MIN_INDEX_BLOCK_SIZE;
+  const std::uint32_t target_num_blocks = file_header.num_entries / MIN_INDEX_BLOCK_SIZE;
+  if (num_blocks >= target_num_blocks)
+    return;
+
+  // blocks are kept up to the largest block size in which the old and new number of blocks differ
+  std::uint32_t bit = 1;
+  while ((num_blocks ^ target_num_blocks) >= bit << 1)
+    bit <<= 1;
+  const std::uint32_t begin = (target_num_blocks & ~(2 * bit - 1)) * MIN_INDEX_BLOCK_SIZE;
+  const std::uint32_t end = target_num_blocks * MIN_INDEX_BLOCK_SIZE;
+
+  // build the new blocks while lookups continue to use the current index
+  std::vector<std::uint32_t> order(end - begin);
+  std::vector<double> radius(end - begin);
+  std::vector<std::pair<double, std::uint32_t>> scratch;
+  std::uint32_t block_begin = 0;
+  for (; bit > 0; bit >>= 1)
+    if (target_num_blocks & bit)
+    {
+      const std::uint32_t block_size = bit * MIN_INDEX_BLOCK_SIZE;
+      std::iota(order.begin() + block_begin, order.begin() + block_begin + block_size, begin + block_begin);
+      scratch.resize(block_size);
+      buildTree(order.data() + block_begin, radius.data() + block_begin, block_size, scratch);
+      block_begin += block_size;
+    }
+
+  // while the new blocks are copied, the entries beyond the blocks that are kept are not indexed
+  std::unique_lock<std::shared_mutex> ulock(lock_);
+  file_header.num_indexed = begin;
+  std::copy(order.begin(), order.end(), indexOrder() + begin);
+  std::copy(radius.begin(), radius.end(), indexRadius() + begin);
+  file_header.num_indexed = end;
+}
+
+void IKCache::buildTree(std::uint32_t* order, double* radius, std::uint32_t size,
+                        std::vector<std::pair<double, std::uint32_t>>& scratch) const
+{
+  if (size <= MAX_LEAF_SIZE)
+    return;
+
+  // entries are appended in no particular order, so any entry serves as root
+  std::swap(order[0], order[size / 2]);
+  const std::vector<Pose> root = readEntry(order[0]).first;
+
+  // split the other entries at the median of their distance to the root
+  const std::uint32_t num_children = size - 1;
+  for (std::uint32_t k = 0; k < num_children; ++k)
+    scratch[k] = std::make_pair(entryDistance(order[1 + k], root), order[1 + k]);
+  const std::uint32_t inner_size = num_children / 2;
+  std::nth_element(scratch.begin(), scratch.begin() + inner_size, scratch.begin() + num_children);
+  for (std::uint32_t k = 0; k < num_children; ++k)
+    order[1 + k] = scratch[k].second;
+  radius[0] = scratch[inner_size].first;
+
+  buildTree(order + 1, radius + 1, inner_size, scratch);
+  buildTree(order + 1 + inner_size, radius + 1 + inner_size, num_children - inner_size, scratch);
+}
+
+IKCache::IKEntry IKCache::readEntry(unsigned int i) const
+{
+  const char* entry = entryData(i);
+  IKEntry result;
+  result.first.resize(num_tips_);
+  for (unsigned int j = 0; j < num_tips_; ++j)
+    result.first[j] = readPose(entry, j);
+  result.second.resize(num_joints_);
+  memcpy(result.second.data(), entry + num_tips_ * POSE_SIZE, num_joints_ * sizeof(double));
+  return result;
+}
+
+void IKCache::appendEntry(const std::vector<Pose>& poses, const std::vector<double>& config)
+{
+  if (data_ == nullptr || poses.size() != num_tips_ || config.size() != num_joints_)
+    return;
+  FileHeader& file_header = header();
+  if (file_header.num_entries >= max_cache_size_)
+    return;
+
+  char* entry = entryData(file_header.num_entries);
+  for (unsigned int j = 0; j < num_tips_; ++j)
+    writePose(entry, j, poses[j]);
+  memcpy(entry + num_tips_ * POSE_SIZE, config.data(), num_joints_ * sizeof(double));
+  // count the entry only once it is complete
+  ++file_header.num_entries;
 }
 
 void IKCache::updateCache(const IKEntry& nearest, const Pose& pose, const std::vector<double>& config) const
 {
-  if (ik_cache_.size() < ik_cache_.capacity() && (nearest.first[0].distance(pose) > min_pose_distance_ ||
-                                                  configDistance2(nearest.second, config) > min_config_distance2_))
-  {
-    std::lock_guard<std::mutex> slock(lock_);
-    ik_cache_.emplace_back(std::vector<Pose>(1u, pose), config);
-    ik_nn_.add(&ik_cache_.back());
-    if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
-      saveCache();
-  }
+  if (nearest.first[0].distance(pose) > min_pose_distance_ ||
+      configDistance2(nearest.second, config) > min_config_distance2_)
+    queueEntry(std::vector<Pose>(1u, pose), config);
 }
 
 void IKCache::updateCache(const IKEntry& nearest, const std::vector<Pose>& poses,
                           const std::vector<double>& config) const
 {
-  if (ik_cache_.size() < ik_cache_.capacity())
+  bool add_to_cache = configDistance2(nearest.second, config) > min_config_distance2_;
+  if (!add_to_cache)
   {
-    bool add_to_cache = configDistance2(nearest.second, config) > min_config_distance2_;
-    if (!add_to_cache)
+    double dist = 0.;
+    for (unsigned int i = 0; i < poses.size(); ++i)
     {
-      double dist = 0.;
-      for (unsigned int i = 0; i < poses.size(); ++i)
+      dist += nearest.first[i].distance(poses[i]);
+      if (dist > min_pose_distance_)
       {
-        dist += nearest.first[i].distance(poses[i]);
-        if (dist > min_pose_distance_)
-        {
-          add_to_cache = true;
-          break;
-        }
+        add_to_cache = true;
+        break;
       }
     }
-    if (add_to_cache)
-    {
-      std::lock_guard<std::mutex> slock(lock_);
-      ik_cache_.emplace_back(poses, config);
-      ik_nn_.add(&ik_cache_.back());
-      if (ik_cache_.size() >= last_saved_cache_size_ + 500u || ik_cache_.size() == max_cache_size_)
-        saveCache();
-    }
   }
+  if (add_to_cache)
+    queueEntry(poses, config);
 }
 
 void IKCache::saveCache() const
 {
-  if (cache_file_name_.empty())
+  if (data_ == nullptr)
+  {
     RCLCPP_ERROR(LOGGER, "can't save cache before initialization");
+    return;
+  }
 
-  RCLCPP_INFO(LOGGER, "writing %ld IK solutions to %s", ik_cache_.size(), cache_file_name_.string().c_str());
-
-  std::ofstream cache_file(cache_file_name_, std::ios_base::binary | std::ios_base::out);
-  unsigned int position_size = 3 * sizeof(tf2Scalar);
-  unsigned int orientation_size = 4 * sizeof(tf2Scalar);
-  unsigned int pose_size = position_size + orientation_size;
-  unsigned int num_tips = ik_cache_[0].first.size();
-  unsigned int config_size = ik_cache_[0].second.size() * sizeof(double);
-  unsigned int offset_conf = num_tips * pose_size;
-  unsigned int bufsize = offset_conf + config_size;
-  char* buffer = new char[bufsize];
-
-  // write number of IK entries and size of each configuration first
-  last_saved_cache_size_ = ik_cache_.size();
-  cache_file.write(reinterpret_cast<char*>(&last_saved_cache_size_), sizeof(unsigned int));
-  unsigned int sz = ik_cache_[0].second.size();
-  cache_file.write(reinterpret_cast<char*>(&sz), sizeof(unsigned int));
-  cache_file.write(reinterpret_cast<char*>(&num_tips), sizeof(unsigned int));
-  for (const auto& entry : ik_cache_)
+  // entries are written to the mapped file in place, so saving only needs to schedule writing them to disk
+  last_saved_cache_size_ = header().num_entries;
+#ifndef _WIN32
+  if (mapped_)
   {
-    for (unsigned int i = 0; i < num_tips; ++i)
+    msync(data_, data_size_, MS_ASYNC);
+    return;
+  }
+#endif
+  RCLCPP_INFO(LOGGER, "writing %d IK solutions to %s", last_saved_cache_size_, cache_file_name_.string().c_str());
+  // another process may have the file mapped, so it is replaced by a new file instead of overwritten
+  const std::filesystem::path new_file_name = temporaryPath(cache_file_name_);
+  {
+    std::ofstream cache_file(new_file_name, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    cache_file.write(data_, data_size_);
+    if (!cache_file)
     {
-      memcpy(buffer + i * pose_size, &entry.first[i].position[0], position_size);
-      memcpy(buffer + i * pose_size + position_size, &entry.first[i].orientation[0], orientation_size);
+      RCLCPP_ERROR(LOGGER, "Could not write cache file %s", new_file_name.string().c_str());
+      std::error_code error;
+      std::filesystem::remove(new_file_name, error);
+      return;
     }
-    memcpy(buffer + offset_conf, &entry.second[0], config_size);
-    cache_file.write(buffer, bufsize);
   }
-  delete[] buffer;
+  std::error_code error;
+  std::filesystem::rename(new_file_name, cache_file_name_, error);
+  if (error)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not replace cache file %s: %s", cache_file_name_.string().c_str(),
+                 error.message().c_str());
+    std::filesystem::remove(new_file_name, error);
+  }
 }
 
 void IKCache::verifyCache(kdl_kinematics_plugin::KDLKinematicsPlugin& fk) const
@@ -255,8 +626,13 @@ void IKCache::verifyCache(kdl_kinematics_plugin::KDLKinematicsPlugin& fk) const
   std::vector<geometry_msgs::msg::Pose> poses(tip_names.size());
   double error, max_error = 0.;
 
-  for (const auto& entry : ik_cache_)
+  for (unsigned int entry_index = 0; entry_index < size(); ++entry_index)
   {
+    IKEntry entry;
+    {
+      std::shared_lock<std::shared_mutex> slock(lock_);
+      entry = readEntry(entry_index);
+    }
     fk.getPositionFK(tip_names, entry.second, poses);
     error = 0.;
     for (unsigned int i = 0; i < poses.size(); ++i)
@@ -295,9 +671,9 @@ IKCacheMap::~IKCacheMap()
     delete cache.second;
 }
 
-const IKCache::IKEntry& IKCacheMap::getBestApproximateIKSolution(const std::vector<std::string>& fixed,
-                                                                 const std::vector<std::string>& active,
-                                                                 const std::vector<Pose>& poses) const
+IKCache::IKEntry IKCacheMap::getBestApproximateIKSolution(const std::vector<std::string>& fixed,
+                                                          const std::vector<std::string>& active,
+                                                          const std::vector<Pose>& poses) const
 {
   auto key(getKey(fixed, active));
   auto it = find(key);
@@ -307,8 +683,7 @@ const IKCache::IKEntry& IKCacheMap::getBestApproximateIKSolution(const std::vect
   }
   else
   {
-    static IKEntry dummy = std::make_pair(poses, std::vector<double>(num_joints_, 0.));
-    return dummy;
+    return std::make_pair(poses, std::vector<double>(num_joints_, 0.));
   }
 }
 
@@ -327,7 +702,7 @@ void IKCacheMap::updateCache(const IKEntry& nearest, const std::vector<std::stri
     value_type val = std::make_pair(key, nullptr);
     auto it = insert(val).first;
     it->second = new IKCache;
-    it->second->initializeCache(robot_description_, group_name_, key, num_joints_);
+    it->second->initializeCache(robot_description_, group_name_, key, num_joints_, IKCache::Options(), poses.size());
   }
 }
 
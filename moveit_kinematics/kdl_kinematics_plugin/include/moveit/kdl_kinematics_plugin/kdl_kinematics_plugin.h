@@ -108,6 +108,13 @@ public:
       const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code,
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  bool searchPositionIKBatch(
+      const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state, double timeout,
+      const std::vector<double>& consistency_limits, std::vector<std::vector<double>>& solutions,
+      const IKCallbackFn& solution_callback, std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+      const moveit::core::RobotState* context_state = nullptr) const override;
+
   bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                      std::vector<geometry_msgs::msg::Pose>& poses) const override;
 
@@ -134,10 +141,31 @@ protected:
                 KDL::JntArray& q_out, const unsigned int max_iter, const Eigen::VectorXd& joint_weights,
                 const Twist& cartesian_weights) const;
 
+  /// Solve position IK given initial joint values, using the given forward kinematics solver.
+  /// Concurrent calls need to use separate solvers.
+  // NOLINTNEXTLINE(readability-identifier-naming)
+  int CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, KDL::ChainFkSolverPos& fk_solver,
+                const KDL::JntArray& q_init, const KDL::Frame& p_in, KDL::JntArray& q_out,
+                const unsigned int max_iter, const Eigen::VectorXd& joint_weights,
+                const Twist& cartesian_weights) const;
+
 private:
   void getJointWeights();
   bool timedOut(const rclcpp::Time& start_time, double duration) const;
 
+  /// Check the seed state and consistency limits of a request, removing the mimic joints from the consistency limits
+  bool checkRequest(const std::vector<double>& ik_seed_state, const std::vector<double>& consistency_limits,
+                    std::vector<double>& consistency_limits_mimic,
+                    moveit_msgs::msg::MoveItErrorCodes& error_code) const;
+
+  /// Search IK for a checked request, using the given velocity solver for the seed attempt and the first thread
+  bool solvePositionIK(KDL::ChainIkSolverVelMimicSVD& ik_solver_vel, double orientation_vs_position_weight,
+                       const geometry_msgs::msg::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                       double timeout, const std::vector<double>& consistency_limits_mimic,
+                       std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                       moveit_msgs::msg::MoveItErrorCodes& error_code,
+                       const kinematics::KinematicsQueryOptions& options) const;
+
   /** @brief Check whether the solution lies within the consistency limits of the seed state
    *  @param seed_state Seed state
    *  @param consistency_limits
@@ -147,15 +175,16 @@ private:
   bool checkConsistency(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
                         const Eigen::VectorXd& solution) const;
 
-  void getRandomConfiguration(Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(random_numbers::RandomNumberGenerator& rng, Eigen::VectorXd& jnt_array) const;
 
   /** @brief Get a random configuration within consistency limits close to the seed state
+   *  @param rng Random number generator to use
    *  @param seed_state Seed state
    *  @param consistency_limits
    *  @param jnt_array Returned random configuration
    */
-  void getRandomConfiguration(const Eigen::VectorXd& seed_state, const std::vector<double>& consistency_limits,
-                              Eigen::VectorXd& jnt_array) const;
+  void getRandomConfiguration(random_numbers::RandomNumberGenerator& rng, const Eigen::VectorXd& seed_state,
+                              const std::vector<double>& consistency_limits, Eigen::VectorXd& jnt_array) const;
 
   /// clip q_delta such that joint limits will not be violated
   void clipToJointLimits(const KDL::JntArray& q, KDL::JntArray& q_delta, Eigen::ArrayXd& weighting) const;
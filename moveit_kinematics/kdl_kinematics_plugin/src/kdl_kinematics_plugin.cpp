@@ -44,6 +44,10 @@
 #include <kdl/chainfksolverpos_recursive.hpp>
 #include <kdl/frames_io.hpp>
 #include <kdl/kinfam_io.hpp>
+#include <moveit/utils/thread_pool.h>
+
+#include <atomic>
+#include <mutex>
 
 namespace kdl_kinematics_plugin
 {
@@ -55,18 +59,18 @@ KDLKinematicsPlugin::KDLKinematicsPlugin() : initialized_(false)
 {
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(Eigen::VectorXd& jnt_array) const
+void KDLKinematicsPlugin::getRandomConfiguration(random_numbers::RandomNumberGenerator& rng,
+                                                 Eigen::VectorXd& jnt_array) const
 {
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array[0]);
+  joint_model_group_->getVariableRandomPositions(rng, &jnt_array[0]);
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(const Eigen::VectorXd& seed_state,
+void KDLKinematicsPlugin::getRandomConfiguration(random_numbers::RandomNumberGenerator& rng,
+                                                 const Eigen::VectorXd& seed_state,
                                                  const std::vector<double>& consistency_limits,
                                                  Eigen::VectorXd& jnt_array) const
 {
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), &jnt_array[0],
-                                                       &seed_state[0], consistency_limits);
+  joint_model_group_->getVariableRandomPositionsNearBy(rng, &jnt_array[0], &seed_state[0], consistency_limits);
 }
 
 bool KDLKinematicsPlugin::checkConsistency(const Eigen::VectorXd& seed_state,
@@ -295,7 +299,69 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                            moveit_msgs::msg::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& options) const
 {
-  const rclcpp::Time start_time = steady_clock_.now();
+  std::vector<double> consistency_limits_mimic;
+  if (!checkRequest(ik_seed_state, consistency_limits, consistency_limits_mimic, error_code))
+    return false;
+
+  const double orientation_vs_position_weight = params_.position_only_ik ? 0.0 : params_.orientation_vs_position;
+  if (orientation_vs_position_weight == 0.0)
+    RCLCPP_INFO(LOGGER, "Using position only ik");
+
+  KDL::ChainIkSolverVelMimicSVD ik_solver_vel(kdl_chain_, mimic_joints_, orientation_vs_position_weight == 0.0);
+  return solvePositionIK(ik_solver_vel, orientation_vs_position_weight, ik_pose, ik_seed_state, timeout,
+                         consistency_limits_mimic, solution, solution_callback, error_code, options);
+}
+
+bool KDLKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                                const std::vector<double>& ik_seed_state, double timeout,
+                                                const std::vector<double>& consistency_limits,
+                                                std::vector<std::vector<double>>& solutions,
+                                                const IKCallbackFn& solution_callback,
+                                                std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                                const kinematics::KinematicsQueryOptions& options,
+                                                const moveit::core::RobotState* /*context_state*/) const
+{
+  solutions.assign(ik_poses.size(), std::vector<double>());
+  error_codes.assign(ik_poses.size(), moveit_msgs::msg::MoveItErrorCodes());
+
+  // validate the request and set up the solver only once for all targets
+  std::vector<double> consistency_limits_mimic;
+  moveit_msgs::msg::MoveItErrorCodes error_code;
+  if (!checkRequest(ik_seed_state, consistency_limits, consistency_limits_mimic, error_code))
+  {
+    error_codes.assign(ik_poses.size(), error_code);
+    return false;
+  }
+
+  const double orientation_vs_position_weight = params_.position_only_ik ? 0.0 : params_.orientation_vs_position;
+  if (orientation_vs_position_weight == 0.0)
+    RCLCPP_INFO(LOGGER, "Using position only ik");
+
+  KDL::ChainIkSolverVelMimicSVD ik_solver_vel(kdl_chain_, mimic_joints_, orientation_vs_position_weight == 0.0);
+  const std::vector<double>* seed = &ik_seed_state;
+  bool all_solved = true;
+  for (std::size_t i = 0; i < ik_poses.size(); ++i)
+  {
+    if (solvePositionIK(ik_solver_vel, orientation_vs_position_weight, ik_poses[i], *seed, timeout,
+                        consistency_limits_mimic, solutions[i], solution_callback, error_codes[i], options))
+    {
+      // warm-start the next target from this solution
+      seed = &solutions[i];
+    }
+    else
+    {
+      solutions[i].clear();
+      all_solved = false;
+    }
+  }
+  return all_solved;
+}
+
+bool KDLKinematicsPlugin::checkRequest(const std::vector<double>& ik_seed_state,
+                                       const std::vector<double>& consistency_limits,
+                                       std::vector<double>& consistency_limits_mimic,
+                                       moveit_msgs::msg::MoveItErrorCodes& error_code) const
+{
   if (!initialized_)
   {
     RCLCPP_ERROR(LOGGER, "kinematics solver not initialized");
@@ -311,7 +377,7 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
   }
 
   // Resize consistency limits to remove mimic joints
-  std::vector<double> consistency_limits_mimic;
+  consistency_limits_mimic.clear();
   if (!consistency_limits.empty())
   {
     if (consistency_limits.size() != dimension_)
@@ -328,22 +394,27 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
         consistency_limits_mimic.push_back(consistency_limits[i]);
     }
   }
+  return true;
+}
 
-  auto orientation_vs_position_weight = params_.position_only_ik ? 0.0 : params_.orientation_vs_position;
-  if (orientation_vs_position_weight == 0.0)
-    RCLCPP_INFO(LOGGER, "Using position only ik");
-
+bool KDLKinematicsPlugin::solvePositionIK(KDL::ChainIkSolverVelMimicSVD& ik_solver_vel,
+                                          double orientation_vs_position_weight,
+                                          const geometry_msgs::msg::Pose& ik_pose,
+                                          const std::vector<double>& ik_seed_state, double timeout,
+                                          const std::vector<double>& consistency_limits_mimic,
+                                          std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                          moveit_msgs::msg::MoveItErrorCodes& error_code,
+                                          const kinematics::KinematicsQueryOptions& options) const
+{
+  const rclcpp::Time start_time = steady_clock_.now();
   Eigen::Matrix<double, 6, 1> cartesian_weights;
   cartesian_weights.topRows<3>().setConstant(1.0);
   cartesian_weights.bottomRows<3>().setConstant(orientation_vs_position_weight);
 
+  const bool position_only = orientation_vs_position_weight == 0.0;
+  const Eigen::Map<const Eigen::VectorXd> joint_weights(joint_weights_.data(), joint_weights_.size());
   KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
   jnt_seed_state.data = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
-  jnt_pos_in = jnt_seed_state;
-
-  KDL::ChainIkSolverVelMimicSVD ik_solver_vel(kdl_chain_, mimic_joints_, orientation_vs_position_weight == 0.0);
   solution.resize(dimension_);
 
   KDL::Frame pose_desired;
@@ -354,47 +425,88 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                   << ik_pose.orientation.x << " " << ik_pose.orientation.y << " "
                                   << ik_pose.orientation.z << " " << ik_pose.orientation.w);
 
-  unsigned int attempt = 0;
-  do
-  {
-    ++attempt;
-    if (attempt > 1)  // randomly re-seed after first attempt
+  // Attempts may run concurrently. Their solutions are checked one at a time, so that the solution callback is
+  // never called concurrently, and the first one to pass is returned.
+  std::mutex solution_mutex;
+  std::atomic<bool> solved{ false };
+  std::atomic<unsigned int> attempt{ 0 };
+  auto attempt_ik = [&](KDL::ChainIkSolverVelMimicSVD& ik_solver_vel, KDL::ChainFkSolverPos& fk_solver,
+                        const KDL::JntArray& jnt_pos_in, KDL::JntArray& jnt_pos_out) {
+    const unsigned int current_attempt = ++attempt;
+    int ik_valid = CartToJnt(ik_solver_vel, fk_solver, jnt_pos_in, pose_desired, jnt_pos_out,
+                             params_.max_solver_iterations, joint_weights, cartesian_weights);
+    if (ik_valid != 0 && !options.return_approximate_solution)
+      return;
+    if (!consistency_limits_mimic.empty() &&
+        !checkConsistency(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_out.data))
+      return;
+
+    std::scoped_lock slock(solution_mutex);
+    if (solved)  // another attempt succeeded in the meantime
+      return;
+    Eigen::Map<Eigen::VectorXd>(solution.data(), solution.size()) = jnt_pos_out.data;
+    if (solution_callback)
     {
-      if (!consistency_limits_mimic.empty())
-      {
-        getRandomConfiguration(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_in.data);
-      }
-      else
+      solution_callback(ik_pose, solution, error_code);
+      if (error_code.val != error_code.SUCCESS)
+        return;
+    }
+
+    // solution passed consistency check and solution callback
+    error_code.val = error_code.SUCCESS;
+    solved = true;
+    RCLCPP_DEBUG_STREAM(LOGGER, "Solved after " << (steady_clock_.now() - start_time).seconds() << " < " << timeout
+                                                << "s and " << current_attempt << " attempts");
+  };
+  // randomly re-seeded attempts until one succeeds or the time is up
+  auto random_attempts = [&](random_numbers::RandomNumberGenerator& rng, KDL::ChainIkSolverVelMimicSVD& ik_solver_vel,
+                             KDL::ChainFkSolverPos& fk_solver) {
+    KDL::JntArray jnt_pos_in(dimension_);
+    KDL::JntArray jnt_pos_out(dimension_);
+    try
+    {
+      while (!solved && !timedOut(start_time, timeout))
       {
-        getRandomConfiguration(jnt_pos_in.data);
+        if (!consistency_limits_mimic.empty())
+        {
+          getRandomConfiguration(rng, jnt_seed_state.data, consistency_limits_mimic, jnt_pos_in.data);
+        }
+        else
+        {
+          getRandomConfiguration(rng, jnt_pos_in.data);
+        }
+        RCLCPP_DEBUG_STREAM(LOGGER, "New random configuration: " << jnt_pos_in);
+        attempt_ik(ik_solver_vel, fk_solver, jnt_pos_in, jnt_pos_out);
       }
-      RCLCPP_DEBUG_STREAM(LOGGER, "New random configuration (" << attempt << "): " << jnt_pos_in);
     }
-
-    int ik_valid =
-        CartToJnt(ik_solver_vel, jnt_pos_in, pose_desired, jnt_pos_out, params_.max_solver_iterations,
-                  Eigen::Map<const Eigen::VectorXd>(joint_weights_.data(), joint_weights_.size()), cartesian_weights);
-    if (ik_valid == 0 || options.return_approximate_solution)  // found acceptable solution
+    catch (...)
     {
-      if (!consistency_limits_mimic.empty() &&
-          !checkConsistency(jnt_seed_state.data, consistency_limits_mimic, jnt_pos_out.data))
-        continue;
+      // stop the other attempts, the thread pool rethrows in the calling thread
+      solved = true;
+      throw;
+    }
+  };
 
-      Eigen::Map<Eigen::VectorXd>(solution.data(), solution.size()) = jnt_pos_out.data;
-      if (solution_callback)
+  // the first attempt starts at the seed state
+  KDL::JntArray jnt_pos_out(dimension_);
+  attempt_ik(ik_solver_vel, *fk_solver_, jnt_seed_state, jnt_pos_out);
+  if (!solved && !timedOut(start_time, timeout))
+  {
+    // each additional thread uses solvers and a random number generator of its own
+    moveit::core::getThreadPool().run(static_cast<std::size_t>(params_.parallel_attempts), [&](std::size_t thread) {
+      if (thread == 0)
       {
-        solution_callback(ik_pose, solution, error_code);
-        if (error_code.val != error_code.SUCCESS)
-          continue;
+        random_attempts(state_->getRandomNumberGenerator(), ik_solver_vel, *fk_solver_);
+        return;
       }
-
-      // solution passed consistency check and solution callback
-      error_code.val = error_code.SUCCESS;
-      RCLCPP_DEBUG_STREAM(LOGGER, "Solved after " << (steady_clock_.now() - start_time).seconds() << " < " << timeout
-                                                  << "s and " << attempt << " attempts");
-      return true;
-    }
-  } while (!timedOut(start_time, timeout));
+      random_numbers::RandomNumberGenerator rng;
+      KDL::ChainIkSolverVelMimicSVD thread_ik_solver_vel(kdl_chain_, mimic_joints_, position_only);
+      KDL::ChainFkSolverPos_recursive thread_fk_solver(kdl_chain_);
+      random_attempts(rng, thread_ik_solver_vel, thread_fk_solver);
+    });
+  }
+  if (solved)
+    return true;
 
   RCLCPP_DEBUG_STREAM(LOGGER, "IK timed out after " << (steady_clock_.now() - start_time).seconds() << " > " << timeout
                                                     << "s and " << attempt << " attempts");
@@ -406,6 +518,15 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
 int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, const KDL::JntArray& q_init,
                                    const KDL::Frame& p_in, KDL::JntArray& q_out, const unsigned int max_iter,
                                    const Eigen::VectorXd& joint_weights, const Twist& cartesian_weights) const
+{
+  return CartToJnt(ik_solver, *fk_solver_, q_init, p_in, q_out, max_iter, joint_weights, cartesian_weights);
+}
+
+// NOLINTNEXTLINE(readability-identifier-naming)
+int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, KDL::ChainFkSolverPos& fk_solver,
+                                   const KDL::JntArray& q_init, const KDL::Frame& p_in, KDL::JntArray& q_out,
+                                   const unsigned int max_iter, const Eigen::VectorXd& joint_weights,
+                                   const Twist& cartesian_weights) const
 {
   double last_delta_twist_norm = DBL_MAX;
   double step_size = 1.0;
@@ -422,7 +543,7 @@ int KDLKinematicsPlugin::CartToJnt(KDL::ChainIkSolverVelMimicSVD& ik_solver, con
   bool success = false;
   for (i = 0; i < max_iter; ++i)
   {
-    fk_solver_->JntToCart(q_out, f);
+    fk_solver.JntToCart(q_out, f);
     delta_twist = diff(f, p_in);
     RCLCPP_DEBUG_STREAM(LOGGER, "[" << std::setw(3) << i << "] delta_twist: " << delta_twist);
 
@@ -58,6 +58,13 @@
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 
+#include <memory>
+
+namespace KDL
+{
+class ChainIkSolverPos_LMA;
+}
+
 namespace lma_kinematics_plugin
 {
 /**
@@ -100,6 +107,13 @@ public:
       const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code,
       const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const override;
 
+  bool searchPositionIKBatch(
+      const std::vector<geometry_msgs::msg::Pose>& ik_poses, const std::vector<double>& ik_seed_state, double timeout,
+      const std::vector<double>& consistency_limits, std::vector<std::vector<double>>& solutions,
+      const IKCallbackFn& solution_callback, std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions(),
+      const moveit::core::RobotState* context_state = nullptr) const override;
+
   bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                      std::vector<geometry_msgs::msg::Pose>& poses) const override;
 
@@ -120,6 +134,18 @@ public:
 private:
   bool timedOut(const rclcpp::Time& start_time, double duration) const;
 
+  /** Check the seed state and consistency limits of a request */
+  bool checkRequest(const std::vector<double>& ik_seed_state, const std::vector<double>& consistency_limits,
+                    moveit_msgs::msg::MoveItErrorCodes& error_code) const;
+  /** Create a solver for the configured weights, tolerance and number of iterations */
+  std::unique_ptr<KDL::ChainIkSolverPos_LMA> createIKSolver() const;
+  /** Search IK for a checked request with the given solver */
+  bool solvePositionIK(KDL::ChainIkSolverPos_LMA& ik_solver_pos, const geometry_msgs::msg::Pose& ik_pose,
+                       const std::vector<double>& ik_seed_state, double timeout,
+                       const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                       const IKCallbackFn& solution_callback, moveit_msgs::msg::MoveItErrorCodes& error_code,
+                       const kinematics::KinematicsQueryOptions& options) const;
+
   /** @brief Check whether the solution lies within the consistency limits of the seed state
    *  @param seed_state Seed state
    *  @param consistency_limits
@@ -216,7 +216,58 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
                                            moveit_msgs::msg::MoveItErrorCodes& error_code,
                                            const kinematics::KinematicsQueryOptions& options) const
 {
-  rclcpp::Time start_time = node_->now();
+  if (!checkRequest(ik_seed_state, consistency_limits, error_code))
+    return false;
+
+  std::unique_ptr<KDL::ChainIkSolverPos_LMA> ik_solver_pos = createIKSolver();
+  return solvePositionIK(*ik_solver_pos, ik_pose, ik_seed_state, timeout, consistency_limits, solution,
+                         solution_callback, error_code, options);
+}
+
+bool LMAKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::msg::Pose>& ik_poses,
+                                                const std::vector<double>& ik_seed_state, double timeout,
+                                                const std::vector<double>& consistency_limits,
+                                                std::vector<std::vector<double>>& solutions,
+                                                const IKCallbackFn& solution_callback,
+                                                std::vector<moveit_msgs::msg::MoveItErrorCodes>& error_codes,
+                                                const kinematics::KinematicsQueryOptions& options,
+                                                const moveit::core::RobotState* /*context_state*/) const
+{
+  solutions.assign(ik_poses.size(), std::vector<double>());
+  error_codes.assign(ik_poses.size(), moveit_msgs::msg::MoveItErrorCodes());
+
+  // validate the request and set up the solver only once for all targets
+  moveit_msgs::msg::MoveItErrorCodes error_code;
+  if (!checkRequest(ik_seed_state, consistency_limits, error_code))
+  {
+    error_codes.assign(ik_poses.size(), error_code);
+    return false;
+  }
+
+  std::unique_ptr<KDL::ChainIkSolverPos_LMA> ik_solver_pos = createIKSolver();
+  const std::vector<double>* seed = &ik_seed_state;
+  bool all_solved = true;
+  for (std::size_t i = 0; i < ik_poses.size(); ++i)
+  {
+    if (solvePositionIK(*ik_solver_pos, ik_poses[i], *seed, timeout, consistency_limits, solutions[i],
+                        solution_callback, error_codes[i], options))
+    {
+      // warm-start the next target from this solution
+      seed = &solutions[i];
+    }
+    else
+    {
+      solutions[i].clear();
+      all_solved = false;
+    }
+  }
+  return all_solved;
+}
+
+bool LMAKinematicsPlugin::checkRequest(const std::vector<double>& ik_seed_state,
+                                       const std::vector<double>& consistency_limits,
+                                       moveit_msgs::msg::MoveItErrorCodes& error_code) const
+{
   if (!initialized_)
   {
     RCLCPP_ERROR(LOGGER, "kinematics solver not initialized");
@@ -238,7 +289,11 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
     error_code.val = error_code.NO_IK_SOLUTION;
     return false;
   }
+  return true;
+}
 
+std::unique_ptr<KDL::ChainIkSolverPos_LMA> LMAKinematicsPlugin::createIKSolver() const
+{
   const auto orientation_vs_position_weight = params_.position_only_ik ? 0.0 : params_.orientation_vs_position;
   if (orientation_vs_position_weight == 0.0)
     RCLCPP_INFO(LOGGER, "Using position only ik");
@@ -251,13 +306,24 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::msg::Pose& ik_po
   cartesian_weights(4) = orientation_vs_position_weight;
   cartesian_weights(5) = orientation_vs_position_weight;
 
+  return std::make_unique<KDL::ChainIkSolverPos_LMA>(kdl_chain_, cartesian_weights, params_.epsilon,
+                                                     params_.max_solver_iterations);
+}
+
+bool LMAKinematicsPlugin::solvePositionIK(KDL::ChainIkSolverPos_LMA& ik_solver_pos,
+                                          const geometry_msgs::msg::Pose& ik_pose,
+                                          const std::vector<double>& ik_seed_state, double timeout,
+                                          const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                                          const IKCallbackFn& solution_callback,
+                                          moveit_msgs::msg::MoveItErrorCodes& error_code,
+                                          const kinematics::KinematicsQueryOptions& options) const
+{
+  rclcpp::Time start_time = node_->now();
   KDL::JntArray jnt_seed_state(dimension_);
   KDL::JntArray jnt_pos_in(dimension_);
   KDL::JntArray jnt_pos_out(dimension_);
   jnt_seed_state.data = Eigen::Map<const Eigen::VectorXd>(ik_seed_state.data(), ik_seed_state.size());
   jnt_pos_in = jnt_seed_state;
-
-  KDL::ChainIkSolverPos_LMA ik_solver_pos(kdl_chain_, cartesian_weights, params_.epsilon, params_.max_solver_iterations);
   solution.resize(dimension_);
 
   KDL::Frame pose_desired;
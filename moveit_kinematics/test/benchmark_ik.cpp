@@ -51,6 +51,7 @@ int main(int argc, char* argv[])
   std::string group;
   std::string tip;
   unsigned int num;
+  double timeout;
   bool reset_to_default;
   po::options_description desc("Options");
   // clang-format off
@@ -59,6 +60,7 @@ int main(int argc, char* argv[])
       ("group", po::value<std::string>(&group)->default_value("all"), "name of planning group")
       ("tip", po::value<std::string>(&tip)->default_value("default"), "name of the end effector in the planning group")
       ("num", po::value<unsigned int>(&num)->default_value(100000), "number of IK solutions to compute")
+      ("timeout", po::value<double>(&timeout)->default_value(0.1), "timeout of each IK solver call in seconds")
       ("reset_to_default", po::value<bool>(&reset_to_default)->default_value(true),
        "whether to reset IK seed to default state. If set to false, the seed is the "
        "correct IK solution (to accelerate filling the cache).");
@@ -127,11 +129,11 @@ int main(int argc, char* argv[])
       default_eef_states.push_back(kinematic_state.getGlobalLinkTransform(end_effector));
     if (end_effectors.size() == 1)
     {
-      kinematic_state.setFromIK(group, default_eef_states[0], end_effectors[0], 0.1);
+      kinematic_state.setFromIK(group, default_eef_states[0], end_effectors[0], timeout);
     }
     else
     {
-      kinematic_state.setFromIK(group, default_eef_states, end_effectors, 0.1);
+      kinematic_state.setFromIK(group, default_eef_states, end_effectors, timeout);
     }
 
     bool found_ik;
@@ -155,11 +157,11 @@ int main(int argc, char* argv[])
       start = std::chrono::system_clock::now();
       if (end_effectors.size() == 1)
       {
-        found_ik = kinematic_state.setFromIK(group, end_effector_states[0], end_effectors[0], 0.1);
+        found_ik = kinematic_state.setFromIK(group, end_effector_states[0], end_effectors[0], timeout);
       }
       else
       {
-        found_ik = kinematic_state.setFromIK(group, end_effector_states, end_effectors, 0.1);
+        found_ik = kinematic_state.setFromIK(group, end_effector_states, end_effectors, timeout);
       }
       ik_time += std::chrono::system_clock::now() - start;
       if (!found_ik)
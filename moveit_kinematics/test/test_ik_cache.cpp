@@ -0,0 +1,228 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/cached_ik_kinematics_plugin/cached_ik_kinematics_plugin.h>
+
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <thread>
+
+using cached_ik_kinematics_plugin::IKCache;
+
+class IKCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    opts_.cached_ik_path = (std::filesystem::temp_directory_path() / "test_ik_cache").string();
+    std::filesystem::remove_all(opts_.cached_ik_path);
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove_all(opts_.cached_ik_path);
+  }
+
+  IKCache::Pose randomPose()
+  {
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    IKCache::Pose pose;
+    pose.position = tf2::Vector3(uniform(rng_), uniform(rng_), uniform(rng_));
+    pose.orientation = tf2::Quaternion(uniform(rng_), uniform(rng_), uniform(rng_), uniform(rng_)).normalized();
+    return pose;
+  }
+
+  IKCache::Options opts_;
+  std::mt19937 rng_{ 42 };
+};
+
+TEST_F(IKCacheTest, NearestEntryAfterReopening)
+{
+  opts_.max_cache_size = 5000;
+  opts_.min_pose_distance = 0.;
+  opts_.min_joint_config_distance = 0.;
+
+  // fill enough entries to be spread over several blocks of the index and the unindexed entries
+  std::vector<IKCache::IKEntry> entries;
+  {
+    IKCache cache;
+    cache.initializeCache("robot", "group", "two_tips", 3, opts_, 2);
+    for (unsigned int i = 0; i < 3500; ++i)
+    {
+      std::vector<IKCache::Pose> poses{ randomPose(), randomPose() };
+      std::vector<double> config{ static_cast<double>(i + 1), 0., 0. };
+      cache.updateCache(cache.getBestApproximateIKSolution(poses), poses, config);
+      entries.emplace_back(poses, config);
+    }
+    cache.flush();
+    EXPECT_EQ(cache.size(), entries.size());
+  }
+
+  IKCache cache;
+  cache.initializeCache("robot", "group", "two_tips", 3, opts_, 2);
+  ASSERT_EQ(cache.size(), entries.size());
+  for (unsigned int i = 0; i < 100; ++i)
+  {
+    std::vector<IKCache::Pose> poses{ randomPose(), randomPose() };
+    double best_dist = std::numeric_limits<double>::infinity();
+    double best_config = -1.;
+    for (const auto& entry : entries)
+    {
+      double dist = entry.first[0].distance(poses[0]) + entry.first[1].distance(poses[1]);
+      if (dist < best_dist)
+      {
+        best_dist = dist;
+        best_config = entry.second[0];
+      }
+    }
+    EXPECT_EQ(cache.getBestApproximateIKSolution(poses).second[0], best_config);
+  }
+}
+
+TEST_F(IKCacheTest, ConvertLegacyCacheFile)
+{
+  opts_.max_cache_size = 100;
+  std::filesystem::create_directories(opts_.cached_ik_path);
+  std::filesystem::path file_name = std::filesystem::path(opts_.cached_ik_path) /
+                                    ("robotgroup_legacy_100_" + std::to_string(opts_.min_pose_distance) + "_" +
+                                     std::to_string(opts_.min_joint_config_distance) + ".ikcache");
+  {
+    // number of entries, dofs and tips, followed by a position, orientation and configuration per entry
+    std::ofstream cache_file(file_name, std::ios_base::binary | std::ios_base::out);
+    unsigned int header[3] = { 2, 2, 1 };
+    cache_file.write(reinterpret_cast<char*>(header), sizeof(header));
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+      double entry[9] = { static_cast<double>(i), 0., 0., 0., 0., 0., 1., static_cast<double>(i), 7. };
+      cache_file.write(reinterpret_cast<char*>(entry), sizeof(entry));
+    }
+  }
+
+  IKCache cache;
+  cache.initializeCache("robot", "group", "legacy", 2, opts_);
+  ASSERT_EQ(cache.size(), 2u);
+  IKCache::Pose pose;
+  pose.position = tf2::Vector3(0.9, 0., 0.);
+  pose.orientation = tf2::Quaternion(0., 0., 0., 1.);
+  EXPECT_EQ(cache.getBestApproximateIKSolution(pose).second, std::vector<double>({ 1., 7. }));
+}
+
+TEST_F(IKCacheTest, ConcurrentLookupsAndUpdates)
+{
+  opts_.max_cache_size = 10000;
+  opts_.min_pose_distance = 0.;
+  opts_.min_joint_config_distance = 0.;
+  IKCache cache;
+  cache.initializeCache("robot", "group", "concurrent", 1, opts_);
+
+  // every thread adds distinct entries while looking up the entries added by all threads
+  const unsigned int num_threads = 4;
+  const unsigned int num_entries_per_thread = 1500;
+  std::vector<std::vector<IKCache::Pose>> poses(num_threads);
+  for (auto& thread_poses : poses)
+    for (unsigned int i = 0; i < num_entries_per_thread; ++i)
+      thread_poses.push_back(randomPose());
+
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < num_threads; ++t)
+    threads.emplace_back([&, t] {
+      for (unsigned int i = 0; i < num_entries_per_thread; ++i)
+      {
+        const IKCache::IKEntry nearest = cache.getBestApproximateIKSolution(poses[t][i]);
+        cache.updateCache(nearest, poses[t][i], { static_cast<double>(t * num_entries_per_thread + i + 1) });
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+  cache.flush();
+
+  ASSERT_EQ(cache.size(), num_threads * num_entries_per_thread);
+  for (unsigned int t = 0; t < num_threads; ++t)
+    for (unsigned int i = 0; i < num_entries_per_thread; i += 100)
+      EXPECT_EQ(cache.getBestApproximateIKSolution(poses[t][i]).second[0], t * num_entries_per_thread + i + 1);
+}
+
+TEST_F(IKCacheTest, SharedCacheFile)
+{
+  opts_.max_cache_size = 5000;
+  opts_.min_pose_distance = 0.;
+  opts_.min_joint_config_distance = 0.;
+  auto add_entries = [this](IKCache& cache, unsigned int first, unsigned int count) {
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+      const IKCache::Pose pose = randomPose();
+      cache.updateCache(cache.getBestApproximateIKSolution(pose), pose, { static_cast<double>(i + 1) });
+    }
+    cache.flush();
+  };
+
+  // the second cache on the same file can't lock it, so it works on a private copy of the file
+  std::vector<IKCache::Pose> poses;
+  {
+    IKCache first;
+    first.initializeCache("robot", "group", "shared", 1, opts_);
+    add_entries(first, 0, 1500);
+    {
+      IKCache second;
+      second.initializeCache("robot", "group", "shared", 1, opts_);
+      EXPECT_EQ(second.size(), 1500u);
+      add_entries(second, 1500, 600);
+      add_entries(first, 2100, 600);
+      EXPECT_EQ(second.size(), 2100u);
+    }
+    // replacing the file as a whole leaves the mapping of the first cache intact
+    EXPECT_EQ(first.size(), 2100u);
+    for (unsigned int i = 0; i < 20; ++i)
+      poses.push_back(randomPose());
+    for (const auto& pose : poses)
+      EXPECT_GT(first.getBestApproximateIKSolution(pose).second[0], 0.);
+  }
+
+  // the file holds the entries of the cache that replaced it last and no temporary files are left behind
+  IKCache cache;
+  cache.initializeCache("robot", "group", "shared", 1, opts_);
+  EXPECT_EQ(cache.size(), 2100u);
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(opts_.cached_ik_path),
+                          std::filesystem::directory_iterator()),
+            1);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -403,6 +403,68 @@ TEST_F(KinematicsTest, randomWalkIK)
   }
 }
 
+TEST_F(KinematicsTest, randomWalkIKBatch)
+{
+  std::vector<double> seed, goal;
+  const std::vector<std::string>& tip_frames = kinematics_solver_->getTipFrames();
+  moveit::core::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+
+  if (!seed_.empty())
+    robot_state.setJointGroupPositions(jmg_, seed_);
+  robot_state.copyJointGroupPositions(jmg_, seed);
+
+  // sample a random walk and solve IK for all of its poses at once
+  static constexpr double NEAR_JOINT = 0.1;
+  const std::vector<double> consistency_limits(jmg_->getVariableCount(), 1.05 * NEAR_JOINT);
+  std::vector<std::vector<double>> goals;
+  std::vector<geometry_msgs::msg::Pose> poses;
+  for (unsigned int i = 0; i < num_ik_tests_; ++i)
+  {
+    robot_state.setToRandomPositionsNearBy(jmg_, robot_state, NEAR_JOINT);
+    robot_state.copyJointGroupPositions(jmg_, goal);
+    std::vector<geometry_msgs::msg::Pose> goal_poses;
+    ASSERT_TRUE(kinematics_solver_->getPositionFK(tip_frames, goal, goal_poses));
+    poses.insert(poses.end(), goal_poses.begin(), goal_poses.end());
+    goals.push_back(goal);
+  }
+
+  std::vector<std::vector<double>> solutions;
+  std::vector<moveit_msgs::msg::MoveItErrorCodes> error_codes;
+  kinematics_solver_->searchPositionIKBatch(poses, seed, 0.1, consistency_limits, solutions,
+                                            kinematics::KinematicsBase::IKCallbackFn(), error_codes);
+  ASSERT_EQ(solutions.size(), num_ik_tests_);
+  ASSERT_EQ(error_codes.size(), num_ik_tests_);
+
+  unsigned int failures = 0;
+  for (unsigned int i = 0; i < num_ik_tests_; ++i)
+  {
+    if (error_codes[i].val != moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+    {
+      EXPECT_TRUE(solutions[i].empty());
+      ++failures;
+      continue;
+    }
+
+    // on success: validate reached poses
+    std::vector<geometry_msgs::msg::Pose> reached_poses;
+    kinematics_solver_->getPositionFK(tip_frames, solutions[i], reached_poses);
+    const std::vector<geometry_msgs::msg::Pose> goal_poses(poses.begin() + i * tip_frames.size(),
+                                                           poses.begin() + (i + 1) * tip_frames.size());
+    EXPECT_NEAR_POSES(goal_poses, reached_poses, tolerance_);
+
+    // validate closeness of solution pose to goal
+    auto diff = Eigen::Map<Eigen::ArrayXd>(solutions[i].data(), solutions[i].size()) -
+                Eigen::Map<Eigen::ArrayXd>(goals[i].data(), goals[i].size());
+    if (!diff.isZero(1.05 * NEAR_JOINT))
+    {
+      ++failures;
+      RCLCPP_WARN_STREAM(LOGGER, "jump in [" << i << "]: " << diff.transpose());
+    }
+  }
+  EXPECT_LE(failures, (1.0 - EXPECTED_SUCCESS_RATE) * num_ik_tests_);
+}
+
 static bool parsePose(const std::vector<double>& pose_values, Eigen::Isometry3d& goal)
 {
   std::vector<double> vec;
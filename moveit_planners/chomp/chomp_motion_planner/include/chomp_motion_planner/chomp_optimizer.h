@@ -80,6 +80,12 @@ public:
     return is_collision_free_;
   }
 
+  /** \brief Number of iterations performed by the last call to optimize() */
+  int getIterations() const
+  {
+    return iteration_;
+  }
+
 private:
   inline double getPotential(double field_distance, double radius, double clearance)
   {
@@ -108,7 +114,7 @@ private:
   //                     const std::string& group_name,
   //                     Eigen::VectorXd& state_vec);
 
-  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i);
+  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i, moveit::core::RobotState& state) const;
 
   // collision_proximity::CollisionProximitySpace::TrajectorySafety checkCurrentIterValidity();
 
@@ -136,6 +142,11 @@ private:
   collision_detection::GroupStateRepresentationPtr gsr_;
   bool initialized_;
 
+  // scratch space of the additional threads evaluating trajectory points in performForwardKinematics(),
+  // the first thread uses state_ and gsr_
+  std::vector<moveit::core::RobotState> thread_states_;
+  std::vector<collision_detection::GroupStateRepresentationPtr> thread_gsrs_;
+
   std::vector<std::vector<std::string> > collision_point_joint_names_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_pos_eigen_;
   std::vector<EigenSTL::vector_Vector3d> collision_point_vel_eigen_;
@@ -213,7 +224,15 @@ private:
   void updateMomentum();
   void updatePositionFromMomentum();
   void calculatePseudoInverse();
-  void computeJointProperties(int trajectoryPoint);
+  void computeJointProperties(int trajectoryPoint, const moveit::core::RobotState& state);
+
+  /**
+   * Computes the collision point positions, potentials and gradients of a single trajectory point, using \e state and
+   * \e gsr as scratch space. Different trajectory points can be evaluated concurrently with different scratch space.
+   * @return true if the trajectory point is in collision
+   */
+  bool computeCollisionPoints(int i, moveit::core::RobotState& state,
+                              collision_detection::GroupStateRepresentationPtr& gsr);
   bool isCurrentTrajectoryMeshToMeshCollisionFree() const;
 };
 }  // namespace chomp
@@ -94,6 +94,8 @@ public:
                                     an initial path is not found with the specified chomp parameters */
   int max_recovery_attempts_;    /*!< this the maximum recovery attempts to find a collision free path after an initial
                                     failure to find a solution */
+  int num_threads_;              /*!< number of threads evaluating the collision costs of the trajectory points,
+                                    1 by default, 0 uses one thread per core */
 };
 
 }  // namespace chomp
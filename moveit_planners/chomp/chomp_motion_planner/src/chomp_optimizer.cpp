@@ -39,11 +39,13 @@
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/utils/thread_pool.h>
 
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/LU>
+#include <atomic>
 #include <random>
 #include <visualization_msgs/msg/marker_array.hpp>
 
@@ -101,6 +103,20 @@ void ChompOptimizer::initialize()
     num_collision_points_ += gradient.gradients.size();
   }
 
+  // set up the scratch space of the additional threads, one after the other as this may update the collision env cache
+  const std::size_t num_threads =
+      std::min(moveit::core::getThreadPool().getNumThreads(std::max(0, parameters_->num_threads_)),
+               static_cast<std::size_t>(num_vars_all_));
+  thread_states_.clear();
+  thread_gsrs_.clear();
+  for (std::size_t t = 1; t < num_threads; ++t)
+  {
+    thread_states_.push_back(state_);
+    thread_gsrs_.emplace_back();
+    hy_env_->getCollisionGradients(req, res, thread_states_.back(), &planning_scene_->getAllowedCollisionMatrix(),
+                                   thread_gsrs_.back());
+  }
+
   // set up the joint costs:
   joint_costs_.reserve(num_joints_);
 
@@ -752,11 +768,11 @@ double ChompOptimizer::getCollisionCost()
   return parameters_->obstacle_cost_weight_ * collision_cost;
 }
 
-void ChompOptimizer::computeJointProperties(int trajectory_point)
+void ChompOptimizer::computeJointProperties(int trajectory_point, const moveit::core::RobotState& state)
 {
   for (int j = 0; j < num_joints_; ++j)
   {
-    const moveit::core::JointModel* joint_model = state_.getJointModel(joint_names_[j]);
+    const moveit::core::JointModel* joint_model = state.getJointModel(joint_names_[j]);
     const moveit::core::RevoluteJointModel* revolute_joint =
         dynamic_cast<const moveit::core::RevoluteJointModel*>(joint_model);
     const moveit::core::PrismaticJointModel* prismatic_joint =
@@ -764,9 +780,9 @@ void ChompOptimizer::computeJointProperties(int trajectory_point)
 
     std::string parent_link_name = joint_model->getParentLinkModel()->getName();
     std::string child_link_name = joint_model->getChildLinkModel()->getName();
-    Eigen::Isometry3d joint_transform = state_.getGlobalLinkTransform(parent_link_name) *
+    Eigen::Isometry3d joint_transform = state.getGlobalLinkTransform(parent_link_name) *
                                         (robot_model_->getLinkModel(child_link_name)->getJointOriginTransform() *
-                                         (state_.getJointTransform(joint_model)));
+                                         (state.getJointTransform(joint_model)));
 
     // joint_transform = inverseWorldTransform * jointTransform;
     Eigen::Vector3d axis;
@@ -911,67 +927,22 @@ void ChompOptimizer::performForwardKinematics()
     end = num_vars_all_ - 1;
   }
 
-  is_collision_free_ = true;
-
-  auto total_dur = std::chrono::duration<double>::zero();
+  // the trajectory points are independent of each other, so they are handed out to the threads one by one
+  std::atomic<int> next_point(start);
+  moveit::core::getThreadPool().run(thread_states_.size() + 1, [this, end, &next_point](std::size_t thread) {
+    moveit::core::RobotState& state = thread == 0 ? state_ : thread_states_[thread - 1];
+    collision_detection::GroupStateRepresentationPtr& gsr = thread == 0 ? gsr_ : thread_gsrs_[thread - 1];
+    for (int i = next_point++; i <= end; i = next_point++)
+      state_is_in_collision_[i] = computeCollisionPoints(i, state, gsr);
+  });
 
-  // for each point in the trajectory
+  is_collision_free_ = true;
   for (int i = start; i <= end; ++i)
   {
-    // Set Robot state from trajectory point...
-    collision_detection::CollisionRequest req;
-    collision_detection::CollisionResult res;
-    req.group_name = planning_group_;
-    setRobotStateFromPoint(group_trajectory_, i);
-    auto grad = std::chrono::system_clock::now();
-
-    hy_env_->getCollisionGradients(req, res, state_, nullptr, gsr_);
-    total_dur += (std::chrono::system_clock::now() - grad);
-    computeJointProperties(i);
-    state_is_in_collision_[i] = false;
-
-    // Keep vars in scope
-    {
-      size_t j = 0;
-      for (const collision_detection::GradientInfo& info : gsr_->gradients_)
-      {
-        for (size_t k = 0; k < info.sphere_locations.size(); ++k)
-        {
-          collision_point_pos_eigen_[i][j][0] = info.sphere_locations[k].x();
-          collision_point_pos_eigen_[i][j][1] = info.sphere_locations[k].y();
-          collision_point_pos_eigen_[i][j][2] = info.sphere_locations[k].z();
-
-          collision_point_potential_[i][j] =
-              getPotential(info.distances[k], info.sphere_radii[k], parameters_->min_clearance_);
-          collision_point_potential_gradient_[i][j][0] = info.gradients[k].x();
-          collision_point_potential_gradient_[i][j][1] = info.gradients[k].y();
-          collision_point_potential_gradient_[i][j][2] = info.gradients[k].z();
-
-          point_is_in_collision_[i][j] = (info.distances[k] - info.sphere_radii[k] < info.sphere_radii[k]);
-
-          if (point_is_in_collision_[i][j])
-          {
-            state_is_in_collision_[i] = true;
-            // if(is_collision_free_ == true) {
-            //   RCLCPP_INFO(LOGGER,"We know it's not collision free " << g);
-            //   RCLCPP_INFO(LOGGER,"Sphere location " << info.sphere_locations[k].x() << " " <<
-            //   info.sphere_locations[k].y() << " " << info.sphere_locations[k].z());
-            //   RCLCPP_INFO(LOGGER,"Gradient " << info.gradients[k].x() << " " << info.gradients[k].y() << " " <<
-            //   info.gradients[k].z() << " distance " << info.distances[k] << " radii " << info.sphere_radii[k]);
-            //   RCLCPP_INFO(LOGGER,"Radius " << info.sphere_radii[k] << " potential " <<
-            //   collision_point_potential_[i][j]);
-            // }
-
-            is_collision_free_ = false;
-          }
-          j++;
-        }
-      }
-    }
+    if (state_is_in_collision_[i])
+      is_collision_free_ = false;
   }
 
-  // RCLCPP_INFO(LOGGER,"Total dur " << total_dur << " total checks " << end-start+1);
-
   // now, get the vel and acc for each collision point (using finite differencing)
   for (int i = free_vars_start_; i <= free_vars_end_; ++i)
   {
@@ -993,7 +964,46 @@ void ChompOptimizer::performForwardKinematics()
   }
 }
 
-void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i)
+bool ChompOptimizer::computeCollisionPoints(int i, moveit::core::RobotState& state,
+                                            collision_detection::GroupStateRepresentationPtr& gsr)
+{
+  // Set Robot state from trajectory point...
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  req.group_name = planning_group_;
+  setRobotStateFromPoint(group_trajectory_, i, state);
+
+  hy_env_->getCollisionGradients(req, res, state, nullptr, gsr);
+  computeJointProperties(i, state);
+  bool in_collision = false;
+
+  size_t j = 0;
+  for (const collision_detection::GradientInfo& info : gsr->gradients_)
+  {
+    for (size_t k = 0; k < info.sphere_locations.size(); ++k)
+    {
+      collision_point_pos_eigen_[i][j][0] = info.sphere_locations[k].x();
+      collision_point_pos_eigen_[i][j][1] = info.sphere_locations[k].y();
+      collision_point_pos_eigen_[i][j][2] = info.sphere_locations[k].z();
+
+      collision_point_potential_[i][j] =
+          getPotential(info.distances[k], info.sphere_radii[k], parameters_->min_clearance_);
+      collision_point_potential_gradient_[i][j][0] = info.gradients[k].x();
+      collision_point_potential_gradient_[i][j][1] = info.gradients[k].y();
+      collision_point_potential_gradient_[i][j][2] = info.gradients[k].z();
+
+      point_is_in_collision_[i][j] = (info.distances[k] - info.sphere_radii[k] < info.sphere_radii[k]);
+
+      if (point_is_in_collision_[i][j])
+        in_collision = true;
+      j++;
+    }
+  }
+  return in_collision;
+}
+
+void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i,
+                                            moveit::core::RobotState& state) const
 {
   const Eigen::MatrixXd::RowXpr& point = group_trajectory.getTrajectoryPoint(i);
 
@@ -1002,8 +1012,8 @@ void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, i
   for (size_t j = 0; j < group_trajectory.getNumJoints(); ++j)
     joint_states.emplace_back(point(0, j));
 
-  state_.setJointGroupPositions(planning_group_, joint_states);
-  state_.update();
+  state.setJointGroupPositions(planning_group_, joint_states);
+  state.update();
 }
 
 void ChompOptimizer::perturbTrajectory()
@@ -0,0 +1,134 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <chomp_motion_planner/chomp_optimizer.h>
+#include <chomp_motion_planner/chomp_parameters.h>
+#include <chomp_motion_planner/chomp_trajectory.h>
+#include <chomp_motion_planner/chomp_utils.h>
+#include <moveit/collision_distance_field/collision_detector_allocator_hybrid.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <moveit/utils/thread_pool.h>
+#include <geometric_shapes/shapes.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+// Helper class to measure time within a scoped block and output the result
+class ScopedTimer
+{
+  const char* const msg_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  ScopedTimer(const char* msg = "") : msg_(msg), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  double elapsed() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+  ~ScopedTimer()
+  {
+    std::cerr << msg_ << elapsed() * 1000. << "ms\n";
+  }
+};
+}  // namespace
+
+TEST(ChompOptimizerBenchmark, iterationTime)
+{
+  const std::string group = "panda_arm";
+  const moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  auto planning_scene = std::make_shared<planning_scene::PlanningScene>(robot_model);
+  planning_scene->allocateCollisionDetector(collision_detection::CollisionDetectorAllocatorHybrid::create());
+  planning_scene->getWorldNonConst()->addToObject("pole", std::make_shared<const shapes::Box>(0.1, 0.1, 1.0),
+                                                  Eigen::Isometry3d(Eigen::Translation3d(0.5, 0.0, 0.5)));
+
+  moveit::core::RobotState start_state(robot_model);
+  start_state.setToDefaultValues();
+  const moveit::core::JointModelGroup* joint_model_group = robot_model->getJointModelGroup(group);
+  ASSERT_TRUE(start_state.setToDefaultValues(joint_model_group, "ready"));
+  start_state.update();
+  moveit::core::RobotState goal_state(start_state);
+  ASSERT_TRUE(goal_state.setToDefaultValues(joint_model_group, "extended"));
+  goal_state.update();
+
+  // 100 trajectory points, as used by the CHOMP planner
+  chomp::ChompTrajectory initial_trajectory(robot_model, 3.0, 0.03, group);
+  const size_t goal_index = initial_trajectory.getNumPoints() - 1;
+  chomp::robotStateToArray(start_state, group, initial_trajectory.getTrajectoryPoint(0));
+  chomp::robotStateToArray(goal_state, group, initial_trajectory.getTrajectoryPoint(goal_index));
+  initial_trajectory.fillInMinJerk();
+
+  chomp::ChompParameters params;
+  params.max_iterations_ = 50;
+  params.planning_time_limit_ = 60.0;
+  // run all iterations deterministically, so the results of different thread counts can be compared
+  params.use_stochastic_descent_ = false;
+  params.filter_mode_ = true;
+
+  std::vector<Eigen::MatrixXd> results;
+  for (const int num_threads : { 1, 0 })
+  {
+    params.num_threads_ = num_threads;
+    chomp::ChompTrajectory trajectory(initial_trajectory);
+    chomp::ChompOptimizer optimizer(&trajectory, planning_scene, group, &params, start_state);
+    ASSERT_TRUE(optimizer.isInitialized());
+
+    const std::string msg = "optimize() on " +
+                            std::to_string(moveit::core::getThreadPool().getNumThreads(num_threads)) + " threads: ";
+    double elapsed;
+    {
+      ScopedTimer t(msg.c_str());
+      optimizer.optimize();
+      elapsed = t.elapsed();
+    }
+    ASSERT_GT(optimizer.getIterations(), 0);
+    std::cerr << "  " << optimizer.getIterations() << " iterations, "
+              << elapsed * 1000. / optimizer.getIterations() << "ms per iteration\n";
+    results.push_back(trajectory.getTrajectory());
+  }
+  EXPECT_TRUE(results[0] == results[1]);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(StateValidityCache);  // Defines StateValidityCachePtr, ConstPtr, WeakPtr... etc
+
+/** \brief A bounded, thread-safe cache of state validity keyed on configurations discretized to a fixed resolution.
+ *
+ * Configurations whose values all round to the same multiple of the resolution share one entry, so the resolution
+ * needs to be well below the distance at which validity can change (e.g. the collision checking resolution).
+ * Entries are stored in a set-associative table: when a set is full, its entries are replaced round-robin. */
+class StateValidityCache
+{
+public:
+  /** \brief Cache configurations of \e dimension values discretized to \e resolution, holding about \e max_size
+   * entries */
+  StateValidityCache(unsigned int dimension, double resolution, std::size_t max_size);
+
+  /** \brief Look up the configuration \e values. Returns false if it is not cached, otherwise sets \e valid. */
+  bool lookup(const double* values, bool& valid) const;
+
+  /** \brief Store the validity of the configuration \e values */
+  void insert(const double* values, bool valid);
+
+  /** \brief Remove all entries and reset the statistics */
+  void clear();
+
+  unsigned int getDimension() const
+  {
+    return dimension_;
+  }
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+  /** \brief Number of lookups that found an entry */
+  std::size_t getHits() const
+  {
+    return hits_;
+  }
+
+  /** \brief Number of lookups that did not find an entry */
+  std::size_t getMisses() const
+  {
+    return misses_;
+  }
+
+private:
+  /** \brief Number of entries per set */
+  static constexpr std::size_t WAYS = 4;
+
+  /** \brief Number of mutexes the sets are distributed over */
+  static constexpr std::size_t LOCK_COUNT = 64;
+
+  enum Entry : std::uint8_t
+  {
+    EMPTY = 0,
+    INVALID = 1,
+    VALID = 2
+  };
+
+  std::int64_t discretize(double value) const;
+  std::size_t getSet(const double* values) const;
+  bool matches(std::size_t slot, const double* values) const;
+
+  unsigned int dimension_;
+  double resolution_;
+  std::size_t set_count_;
+
+  /** \brief Discretized configurations, dimension_ values per slot */
+  std::vector<std::int64_t> keys_;
+  std::vector<Entry> entries_;
+
+  /** \brief Slot within each set to replace next */
+  std::vector<std::uint8_t> next_replaced_;
+
+  mutable std::array<std::mutex, LOCK_COUNT> locks_;
+  mutable std::atomic<std::size_t> hits_;
+  mutable std::atomic<std::size_t> misses_;
+};
+}  // namespace ompl_interface
@@ -87,6 +87,12 @@ public:
   void setVerbose(bool flag);
 
 protected:
+  /** \brief Check path constraints, feasibility and collisions of \e state and mark \e model_state accordingly.
+   *
+   * \e model_state is the ModelBasedStateSpace::StateType that stores the validity flags, which is \e state itself
+   * unless \e state wraps it. If the planning context has a StateValidityCache, it is consulted first and updated. */
+  bool checkAndMarkValidity(const ompl::base::State* state, const ompl::base::State* model_state, bool verbose) const;
+
   const ModelBasedPlanningContext* planning_context_;
   std::string group_name_;
   TSStateStorage tss_;
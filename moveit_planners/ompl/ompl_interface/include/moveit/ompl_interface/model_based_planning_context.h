@@ -37,6 +37,7 @@
 #pragma once
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/ompl_interface/detail/state_validity_cache.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/planning_interface/planning_interface.h>
 
@@ -289,6 +290,13 @@ public:
     hybridize_ = flag;
   }
 
+  /** \brief Get the cache of state validity used for the current problem, nullptr if it is disabled.
+   * The cache is enabled by setting 'validity_cache_resolution' to a positive value in the planner configuration. */
+  const StateValidityCachePtr& getStateValidityCache() const
+  {
+    return validity_cache_;
+  }
+
   /* @brief Solve the planning problem. Return true if the problem is solved
      @param timeout The time to spend on solving
      @param count The number of runs to combine the paths of, in an attempt to generate better quality paths
@@ -452,5 +460,14 @@ protected:
 
   // if false parallel plan returns the first solution found
   bool hybridize_;
+
+  /// discretization of configurations in the validity cache; the cache is disabled if this is not positive
+  double validity_cache_resolution_;
+
+  /// maximum number of configurations in the validity cache
+  std::size_t validity_cache_size_;
+
+  /// validity of already checked configurations, cleared on every call to configure()
+  StateValidityCachePtr validity_cache_;
 };
 }  // namespace ompl_interface
@@ -0,0 +1,132 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/state_validity_cache.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ompl_interface
+{
+StateValidityCache::StateValidityCache(unsigned int dimension, double resolution, std::size_t max_size)
+  : dimension_(dimension)
+  , resolution_(resolution)
+  , set_count_(std::max<std::size_t>(1, max_size / WAYS))
+  , keys_(set_count_ * WAYS * dimension, 0)
+  , entries_(set_count_ * WAYS, EMPTY)
+  , next_replaced_(set_count_, 0)
+  , hits_(0)
+  , misses_(0)
+{
+}
+
+std::int64_t StateValidityCache::discretize(double value) const
+{
+  return std::llround(value / resolution_);
+}
+
+std::size_t StateValidityCache::getSet(const double* values) const
+{
+  // FNV-1a over the discretized values
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned int i = 0; i < dimension_; ++i)
+  {
+    hash ^= static_cast<std::uint64_t>(discretize(values[i]));
+    hash *= 1099511628211ull;
+  }
+  return (hash ^ (hash >> 32)) % set_count_;
+}
+
+bool StateValidityCache::matches(std::size_t slot, const double* values) const
+{
+  const std::int64_t* key = &keys_[slot * dimension_];
+  for (unsigned int i = 0; i < dimension_; ++i)
+  {
+    if (key[i] != discretize(values[i]))
+      return false;
+  }
+  return true;
+}
+
+bool StateValidityCache::lookup(const double* values, bool& valid) const
+{
+  const std::size_t set = getSet(values);
+  {
+    std::scoped_lock slock(locks_[set % LOCK_COUNT]);
+    for (std::size_t slot = set * WAYS; slot < (set + 1) * WAYS; ++slot)
+    {
+      if (entries_[slot] != EMPTY && matches(slot, values))
+      {
+        valid = entries_[slot] == VALID;
+        ++hits_;
+        return true;
+      }
+    }
+  }
+  ++misses_;
+  return false;
+}
+
+void StateValidityCache::insert(const double* values, bool valid)
+{
+  const std::size_t set = getSet(values);
+  std::scoped_lock slock(locks_[set % LOCK_COUNT]);
+
+  // another thread may have inserted the same configuration in the meantime
+  std::size_t slot = set * WAYS;
+  while (slot < (set + 1) * WAYS && entries_[slot] != EMPTY && !matches(slot, values))
+    ++slot;
+  if (slot == (set + 1) * WAYS)
+  {
+    slot = set * WAYS + next_replaced_[set];
+    next_replaced_[set] = (next_replaced_[set] + 1) % WAYS;
+  }
+
+  std::int64_t* key = &keys_[slot * dimension_];
+  for (unsigned int i = 0; i < dimension_; ++i)
+    key[i] = discretize(values[i]);
+  entries_[slot] = valid ? VALID : INVALID;
+}
+
+void StateValidityCache::clear()
+{
+  for (std::mutex& lock : locks_)
+    lock.lock();
+  std::fill(entries_.begin(), entries_.end(), EMPTY);
+  std::fill(next_replaced_.begin(), next_replaced_.end(), 0);
+  hits_ = 0;
+  misses_ = 0;
+  for (std::mutex& lock : locks_)
+    lock.unlock();
+}
+}  // namespace ompl_interface
@@ -92,6 +92,27 @@ bool StateValidityChecker::isValid(const ompl::base::State* state, bool verbose)
     return false;
   }
 
+  return checkAndMarkValidity(state, state, verbose);
+}
+
+bool StateValidityChecker::checkAndMarkValidity(const ompl::base::State* state, const ompl::base::State* model_state,
+                                                bool verbose) const
+{
+  ModelBasedStateSpace::StateType* marked_state =
+      const_cast<ob::State*>(model_state)->as<ModelBasedStateSpace::StateType>();
+
+  // Use the validity of an equivalent configuration checked before, if it is available
+  const StateValidityCachePtr& cache = planning_context_->getStateValidityCache();
+  bool valid;
+  if (cache && !verbose && cache->lookup(marked_state->values, valid))
+  {
+    if (valid)
+      marked_state->markValid();
+    else
+      marked_state->markInvalid();
+    return valid;
+  }
+
   moveit::core::RobotState* robot_state = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, state);
 
@@ -99,30 +120,29 @@ bool StateValidityChecker::isValid(const ompl::base::State* state, bool verbose)
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
   if (kset && !kset->decide(*robot_state, verbose).satisfied)
   {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
+    valid = false;
   }
-
   // check feasibility
-  if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
+  else if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
   {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
+    valid = false;
   }
-
   // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(
-      verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *robot_state);
-  if (!res.collision)
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
-  }
   else
   {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+    collision_detection::CollisionResult res;
+    planning_context_->getPlanningScene()->checkCollision(
+        verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *robot_state);
+    valid = !res.collision;
   }
-  return !res.collision;
+
+  if (valid)
+    marked_state->markValid();
+  else
+    marked_state->markInvalid();
+  if (cache)
+    cache->insert(marked_state->values, valid);
+  return valid;
 }
 
 bool StateValidityChecker::isValid(const ompl::base::State* state, double& dist, bool verbose) const
@@ -231,38 +251,9 @@ bool ConstrainedPlanningStateValidityChecker::isValid(const ompl::base::State* w
     return false;
   }
 
-  moveit::core::RobotState* robot_state = tss_.getStateStorage();
-  // do not use the unwrapped state here, as copyToRobotState expects a state of type ConstrainedStateSpace::StateType
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*robot_state, wrapped_state);
-
-  // check path constraints
-  const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset && !kset->decide(*robot_state, verbose).satisfied)
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
-  }
-
-  // check feasibility
-  if (!planning_context_->getPlanningScene()->isStateFeasible(*robot_state, verbose))
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
-  }
-
-  // check collision avoidance
-  collision_detection::CollisionResult res;
-  planning_context_->getPlanningScene()->checkCollision(
-      verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *robot_state);
-  if (!res.collision)
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
-  }
-  else
-  {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-  }
-  return !res.collision;
+  // do not use the unwrapped state for the robot state, as copyToRobotState expects a state of type
+  // ConstrainedStateSpace::StateType
+  return checkAndMarkValidity(wrapped_state, state, verbose);
 }
 
 bool ConstrainedPlanningStateValidityChecker::isValid(const ompl::base::State* wrapped_state, double& dist,
@@ -93,6 +93,8 @@ ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::
   , simplify_solutions_(true)
   , interpolate_(true)
   , hybridize_(true)
+  , validity_cache_resolution_(0.0)
+  , validity_cache_size_(100000)
 {
   complete_initial_robot_state_.setToDefaultValues();  // avoid uninitialized memory
   complete_initial_robot_state_.update();
@@ -142,6 +144,18 @@ void ompl_interface::ModelBasedPlanningContext::configure(const rclcpp::Node::Sh
   }
 
   useConfig();
+
+  // the scene and constraints may have changed since the last problem, so start with an empty validity cache
+  if (validity_cache_resolution_ > 0.0)
+  {
+    validity_cache_ = std::make_shared<StateValidityCache>(spec_.state_space_->getJointModelGroup()->getVariableCount(),
+                                                           validity_cache_resolution_, validity_cache_size_);
+  }
+  else
+  {
+    validity_cache_.reset();
+  }
+
   if (ompl_simple_setup_->getGoal())
     ompl_simple_setup_->setup();
 }
@@ -394,6 +408,21 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // check whether results of state validity checks should be cached
+  it = cfg.find("validity_cache_resolution");
+  if (it != cfg.end())
+  {
+    validity_cache_resolution_ = moveit::core::toDouble(it->second);
+    cfg.erase(it);
+  }
+
+  it = cfg.find("validity_cache_size");
+  if (it != cfg.end())
+  {
+    validity_cache_size_ = boost::lexical_cast<std::size_t>(it->second);
+    cfg.erase(it);
+  }
+
   // remove the 'type' parameter; the rest are parameters for the planner itself
   it = cfg.find("type");
   if (it == cfg.end())
@@ -753,6 +782,11 @@ void ompl_interface::ModelBasedPlanningContext::postSolve()
   int v = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getValidMotionCount();
   int iv = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getInvalidMotionCount();
   RCLCPP_DEBUG(LOGGER, "There were %d valid motions and %d invalid motions.", v, iv);
+  if (validity_cache_)
+  {
+    RCLCPP_DEBUG(LOGGER, "The state validity cache answered %zu of %zu checks.", validity_cache_->getHits(),
+                 validity_cache_->getHits() + validity_cache_->getMisses());
+  }
 
   // Debug OMPL setup and solution
   std::stringstream debug_out;
@@ -831,6 +865,12 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
       getSolutionPath(*res.trajectory_.back());
     }
 
+    if (validity_cache_)
+    {
+      res.validity_cache_hits_ = validity_cache_->getHits();
+      res.validity_cache_misses_ = validity_cache_->getMisses();
+    }
+
     RCLCPP_DEBUG(LOGGER, "%s: Returning successful solution with %lu states", getName().c_str(),
                  getOMPLSimpleSetup()->getSolutionPath().getStateCount());
     res.error_code_.val = moveit_result.val;
@@ -0,0 +1,132 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/state_validity_cache.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+using ompl_interface::StateValidityCache;
+
+TEST(StateValidityCache, lookupAndInsert)
+{
+  StateValidityCache cache(3, 0.01, 1000);
+  bool valid = false;
+
+  const double q1[] = { 0.1, 0.2, 0.3 };
+  EXPECT_FALSE(cache.lookup(q1, valid));
+  cache.insert(q1, true);
+  ASSERT_TRUE(cache.lookup(q1, valid));
+  EXPECT_TRUE(valid);
+
+  // configurations discretized to the same key share the entry
+  const double q1_close[] = { 0.1 + 0.002, 0.2 - 0.002, 0.3 };
+  ASSERT_TRUE(cache.lookup(q1_close, valid));
+  EXPECT_TRUE(valid);
+
+  const double q2[] = { 0.1, 0.2, 0.32 };
+  EXPECT_FALSE(cache.lookup(q2, valid));
+  cache.insert(q2, false);
+  ASSERT_TRUE(cache.lookup(q2, valid));
+  EXPECT_FALSE(valid);
+
+  // overwriting an entry
+  cache.insert(q2, true);
+  ASSERT_TRUE(cache.lookup(q2, valid));
+  EXPECT_TRUE(valid);
+
+  EXPECT_EQ(cache.getHits(), 4u);
+  EXPECT_EQ(cache.getMisses(), 2u);
+
+  cache.clear();
+  EXPECT_FALSE(cache.lookup(q1, valid));
+  EXPECT_EQ(cache.getHits(), 0u);
+  EXPECT_EQ(cache.getMisses(), 1u);
+}
+
+TEST(StateValidityCache, bounded)
+{
+  constexpr std::size_t MAX_SIZE = 64;
+  StateValidityCache cache(2, 0.01, MAX_SIZE);
+
+  // insert many more configurations than fit, every lookup has to return what was inserted or nothing
+  std::size_t found = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double q[] = { 0.1 * i, -0.1 * i };
+    cache.insert(q, i % 3 == 0);
+  }
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double q[] = { 0.1 * i, -0.1 * i };
+    bool valid;
+    if (cache.lookup(q, valid))
+    {
+      EXPECT_EQ(valid, i % 3 == 0);
+      ++found;
+    }
+  }
+  EXPECT_GT(found, 0u);
+  EXPECT_LE(found, MAX_SIZE);
+}
+
+TEST(StateValidityCache, concurrentAccess)
+{
+  StateValidityCache cache(4, 0.001, 10000);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&cache] {
+      for (int i = 0; i < 5000; ++i)
+      {
+        const double q[] = { 0.01 * (i % 500), 0.5, -0.5, 0.001 * (i % 7) };
+        const bool expected = (i % 500) % 2 == 0;
+        bool valid;
+        if (cache.lookup(q, valid))
+          EXPECT_EQ(valid, expected);
+        else
+          cache.insert(q, expected);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  EXPECT_EQ(cache.getHits() + cache.getMisses(), 4u * 5000u);
+  EXPECT_GT(cache.getHits(), 0u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -50,6 +50,7 @@
 #include <pluginlib/class_loader.hpp>
 
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <functional>
@@ -58,6 +59,12 @@ namespace moveit_ros_benchmarks
 {
 /// A class that executes motion plan requests and aggregates data across multiple runs
 /// Note: This class operates outside of MoveGroup and does NOT use PlanningRequestAdapters
+/// The runs of a planner can be executed by several threads (see BenchmarkOptions::getNumThreads()). The event
+/// functions are then still called one at a time, but collectMetrics() is called concurrently. Each thread plans in
+/// and collects metrics in a copy of the planning scene.
+/// The completed queries of a benchmark and the results of the completed planners of each query are checkpointed in
+/// the output directory, so that an interrupted benchmark can be resumed (see BenchmarkOptions::getResume()). The
+/// checkpoints are removed once the benchmark completes.
 class BenchmarkExecutor
 {
 public:
@@ -147,8 +154,9 @@ protected:
                                       std::vector<TrajectoryConstraints>& traj_constraints,
                                       std::vector<BenchmarkRequest>& queries);
 
+  /// Collect the metrics of a run, checking its trajectories in the given planning scene, which the run was planned in
   virtual void collectMetrics(PlannerRunData& metrics, const planning_interface::MotionPlanDetailedResponse& mp_res,
-                              bool solved, double total_time);
+                              bool solved, double total_time, const planning_scene::PlanningScene& planning_scene);
 
   /// Compute the similarity of each (final) trajectory to all other (final) trajectories in the experiment and write
   /// the results to planner_data metrics
@@ -199,6 +207,40 @@ protected:
   void runBenchmark(moveit_msgs::msg::MotionPlanRequest request,
                     const std::map<std::string, std::vector<std::string>>& planners, int runs);
 
+  /// Load the planning pipeline with the given name
+  planning_pipeline::PlanningPipelinePtr loadPlanningPipeline(const std::string& planning_pipeline_name);
+
+  /// Load the planning pipelines of the additional threads for benchmarking with the given number of threads
+  void initializeThreads(unsigned int num_threads);
+
+  /// Get the path of the output files of the given request, without the start time and extension
+  std::string getOutputFilePrefix(const BenchmarkRequest& brequest) const;
+
+  /// Get the path of the checkpoint of the completed queries of the benchmark
+  std::string getRunCheckpointFilename() const;
+
+  /// Start a new checkpoint of the completed queries of the benchmark
+  void startRunCheckpoint();
+
+  /// Restore the names of the queries that completed before the benchmark was interrupted.
+  /// Returns false if there is no checkpoint of the benchmark, i.e. it was not interrupted.
+  bool loadRunCheckpoint(std::set<std::string>& completed_queries);
+
+  /// Append the name of a completed query to the checkpoint of the benchmark
+  void writeRunCheckpoint(const std::string& query_name);
+
+  /// Start a new checkpoint of the current query that was started at the given time
+  void startCheckpoint(const std::string& start_time);
+
+  /// Restore the data of the planners that completed before the benchmark of the current query was interrupted.
+  /// Returns false if there is no checkpoint of the query.
+  bool loadCheckpoint(const std::map<std::string, std::vector<std::string>>& planners, std::string& start_time,
+                      double& duration);
+
+  /// Append the data of a completed planner to the checkpoint of the current query
+  void writeCheckpoint(const std::string& planning_pipeline_name, const std::string& planner_id, double duration,
+                       const PlannerBenchmarkData& planner_data);
+
   planning_scene_monitor::PlanningSceneMonitor* psm_;
   moveit_warehouse::PlanningSceneStorage* pss_;
   moveit_warehouse::PlanningSceneWorldStorage* psws_;
@@ -213,6 +255,15 @@ protected:
   BenchmarkOptions options_;
 
   std::map<std::string, planning_pipeline::PlanningPipelinePtr> planning_pipelines_;
+  /// Planning pipelines of the additional threads running the benchmark
+  std::vector<std::map<std::string, planning_pipeline::PlanningPipelinePtr>> thread_planning_pipelines_;
+
+  /// Checkpoint file of the completed queries of the benchmark
+  std::string run_checkpoint_filename_;
+  /// Checkpoint file of the current query
+  std::string checkpoint_filename_;
+  /// Data of the planners restored from the checkpoint of the current query
+  std::vector<PlannerBenchmarkData> checkpoint_data_;
 
   std::vector<PlannerBenchmarkData> benchmark_data_;
 
@@ -68,6 +68,10 @@ public:
   int getNumRuns() const;
   /** \brief Get the maximum timeout per planning attempt */
   double getTimeout() const;
+  /** \brief Get the number of threads executing the runs of a planner concurrently (0 for one per CPU core) */
+  int getNumThreads() const;
+  /** \brief Get whether to continue an interrupted benchmark from its checkpoints instead of starting over */
+  bool getResume() const;
   /** \brief Get the reference name of the benchmark */
   const std::string& getBenchmarkName() const;
   /** \brief Get the name of the planning group to run the benchmark with */
@@ -118,6 +122,8 @@ protected:
   /// benchmark parameters
   int runs_;
   double timeout_;
+  int num_threads_ = 1;
+  bool resume_ = false;
   std::string benchmark_name_;
   std::string group_name_;
   std::string output_directory_;
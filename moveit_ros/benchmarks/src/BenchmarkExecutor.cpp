@@ -36,6 +36,7 @@
 
 #include <moveit/benchmarks/BenchmarkExecutor.h>
 #include <moveit/utils/lexical_casts.h>
+#include <moveit/utils/thread_pool.h>
 #include <moveit/version.h>
 #include <tf2_eigen/tf2_eigen.hpp>
 
@@ -48,8 +49,13 @@
 #undef BOOST_ALLOW_DEPRECATED_HEADERS
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <math.h>
+#include <atomic>
+#include <cmath>
 #include <limits>
 #include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
 #ifndef _WIN32
 #include <unistd.h>
 #else
@@ -62,6 +68,9 @@ using namespace moveit_ros_benchmarks;
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.benchmarks.BenchmarkExecutor");
 
+static const std::string CHECKPOINT_HEADER = "MoveIt benchmark checkpoint";
+static const std::string RUN_CHECKPOINT_HEADER = "MoveIt benchmark run checkpoint";
+
 template <class Clock, class Duration>
 boost::posix_time::ptime toBoost(const std::chrono::time_point<Clock, Duration>& from)
 {
@@ -120,26 +129,13 @@ void BenchmarkExecutor::initialize(const std::vector<std::string>& planning_pipe
 {
   planning_pipelines_.clear();
 
-  // ros::NodeHandle pnh("~");
-  std::string parent_node_name = node_->get_name();
+  thread_planning_pipelines_.clear();
+
   for (const std::string& planning_pipeline_name : planning_pipeline_names)
   {
-    // Initialize planning pipelines from configured child namespaces
-    static rclcpp::Node::SharedPtr child_node = rclcpp::Node::make_shared(planning_pipeline_name, parent_node_name);
-    planning_pipeline::PlanningPipelinePtr pipeline(new planning_pipeline::PlanningPipeline(
-        planning_scene_->getRobotModel(), child_node, "planning_plugin", "request_adapters"));
-
-    // Verify the pipeline has successfully initialized a planner
-    if (!pipeline->getPlannerManager())
-    {
-      RCLCPP_ERROR(LOGGER, "Failed to initialize planning pipeline '%s'", planning_pipeline_name.c_str());
-      continue;
-    }
-
-    // Disable visualizations and store pipeline
-    pipeline->displayComputedMotionPlans(false);
-    pipeline->checkSolutionPaths(false);
-    planning_pipelines_[planning_pipeline_name] = pipeline;
+    planning_pipeline::PlanningPipelinePtr pipeline = loadPlanningPipeline(planning_pipeline_name);
+    if (pipeline)
+      planning_pipelines_[planning_pipeline_name] = pipeline;
   }
 
   // Error check
@@ -155,6 +151,45 @@ void BenchmarkExecutor::initialize(const std::vector<std::string>& planning_pipe
   }
 }
 
+planning_pipeline::PlanningPipelinePtr
+BenchmarkExecutor::loadPlanningPipeline(const std::string& planning_pipeline_name)
+{
+  // ros::NodeHandle pnh("~");
+  std::string parent_node_name = node_->get_name();
+
+  // Initialize planning pipelines from configured child namespaces. Every pipeline gets a node of its own, which it
+  // keeps alive.
+  rclcpp::Node::SharedPtr child_node = rclcpp::Node::make_shared(planning_pipeline_name, parent_node_name);
+  planning_pipeline::PlanningPipelinePtr pipeline(new planning_pipeline::PlanningPipeline(
+      planning_scene_->getRobotModel(), child_node, "planning_plugin", "request_adapters"));
+
+  // Verify the pipeline has successfully initialized a planner
+  if (!pipeline->getPlannerManager())
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to initialize planning pipeline '%s'", planning_pipeline_name.c_str());
+    return planning_pipeline::PlanningPipelinePtr();
+  }
+
+  // Disable visualizations
+  pipeline->displayComputedMotionPlans(false);
+  pipeline->checkSolutionPaths(false);
+  return pipeline;
+}
+
+void BenchmarkExecutor::initializeThreads(unsigned int num_threads)
+{
+  // The calling thread uses planning_pipelines_, each additional thread gets pipelines of its own
+  thread_planning_pipelines_.resize(std::max(num_threads, 1u) - 1);
+  for (std::map<std::string, planning_pipeline::PlanningPipelinePtr>& pipelines : thread_planning_pipelines_)
+  {
+    for (const std::pair<const std::string, planning_pipeline::PlanningPipelinePtr>& entry : planning_pipelines_)
+    {
+      if (pipelines.find(entry.first) == pipelines.end())
+        pipelines[entry.first] = loadPlanningPipeline(entry.first);
+    }
+  }
+}
+
 void BenchmarkExecutor::clear()
 {
   if (pss_)
@@ -238,8 +273,48 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
     if (!queriesAndPlannersCompatible(queries, opts.getPlanningPipelineConfigurations()))
       return false;
 
+    const auto num_threads = static_cast<unsigned int>(
+        moveit::core::getThreadPool().getNumThreads(static_cast<std::size_t>(std::max(options_.getNumThreads(), 0))));
+    initializeThreads(num_threads);
+    for (const std::map<std::string, planning_pipeline::PlanningPipelinePtr>& pipelines : thread_planning_pipelines_)
+    {
+      for (const std::pair<const std::string, planning_pipeline::PlanningPipelinePtr>& entry : pipelines)
+      {
+        if (!entry.second)
+        {
+          RCLCPP_ERROR(LOGGER, "Failed to load planning pipeline '%s' for %u threads", entry.first.c_str(),
+                       num_threads);
+          return false;
+        }
+      }
+    }
+
+    // Only a benchmark that was interrupted is resumed, the results of completed benchmarks are not reused
+    run_checkpoint_filename_ = getRunCheckpointFilename();
+    std::set<std::string> completed_queries;
+    const bool resume = options_.getResume() && loadRunCheckpoint(completed_queries);
+    if (resume)
+    {
+      RCLCPP_INFO(LOGGER, "Resuming the interrupted benchmark from '%s'", run_checkpoint_filename_.c_str());
+    }
+    else
+    {
+      if (options_.getResume())
+        RCLCPP_INFO(LOGGER, "There is no interrupted benchmark to resume, starting a new one");
+      startRunCheckpoint();
+    }
+
     for (std::size_t i = 0; i < queries.size(); ++i)
     {
+      // Skip the queries that completed before the benchmark was interrupted
+      if (resume && completed_queries.count(queries[i].name))
+      {
+        RCLCPP_INFO(LOGGER, "Skipping query '%s' (%lu of %lu), it completed before the benchmark was interrupted",
+                    queries[i].name.c_str(), i + 1, queries.size());
+        continue;
+      }
+      const std::string output_prefix = getOutputFilePrefix(queries[i]);
+
       // Configure planning scene
       if (scene_msg.robot_model_name != planning_scene_->getRobotModel()->getName())
       {
@@ -259,16 +334,39 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
 
       RCLCPP_INFO(LOGGER, "Benchmarking query '%s' (%lu of %lu)", queries[i].name.c_str(), i + 1, queries.size());
       std::chrono::system_clock::time_point start_time = std::chrono::system_clock::now();
+      std::string start_time_str = boost::posix_time::to_iso_extended_string(toBoost(start_time));
+      double restored_duration = 0.0;
+      checkpoint_filename_ = output_prefix + ".checkpoint";
+      checkpoint_data_.clear();
+      if (resume && loadCheckpoint(options_.getPlanningPipelineConfigurations(), start_time_str, restored_duration))
+      {
+        RCLCPP_INFO(LOGGER, "Restored the results of %zu planners from '%s'", checkpoint_data_.size(),
+                    checkpoint_filename_.c_str());
+      }
+      else
+      {
+        startCheckpoint(start_time_str);
+      }
+
       runBenchmark(queries[i].request, options_.getPlanningPipelineConfigurations(), options_.getNumRuns());
       std::chrono::duration<double> dt = std::chrono::system_clock::now() - start_time;
-      double duration = dt.count();
+      double duration = restored_duration + dt.count();
 
       for (QueryCompletionEventFunction& query_end_fn : query_end_fns_)
         query_end_fn(queries[i].request, planning_scene_);
 
-      writeOutput(queries[i], boost::posix_time::to_iso_extended_string(toBoost(start_time)), duration);
+      writeOutput(queries[i], start_time_str, duration);
+
+      // The results are complete now
+      writeRunCheckpoint(queries[i].name);
+      std::error_code ec;
+      std::filesystem::remove(checkpoint_filename_, ec);
+      checkpoint_data_.clear();
     }
 
+    // The benchmark is complete, a later benchmark with the same output does not resume it
+    std::error_code ec;
+    std::filesystem::remove(run_checkpoint_filename_, ec);
     return true;
   }
   return false;
@@ -798,20 +896,42 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
 
   boost::progress_display progress(num_planners * runs, std::cout);
 
+  // A single thread plans in planning_scene_. Several threads each plan and collect metrics in a clone of it, so that
+  // no thread reads a scene another thread plans in.
+  const std::size_t num_threads =
+      std::max<std::size_t>(std::min<std::size_t>(thread_planning_pipelines_.size() + 1, runs), 1);
+  std::vector<planning_scene::PlanningScenePtr> planning_scenes{ planning_scene_ };
+  if (num_threads > 1)
+  {
+    planning_scenes.clear();
+    for (std::size_t k = 0; k < num_threads; ++k)
+      planning_scenes.push_back(planning_scene::PlanningScene::clone(planning_scene_));
+  }
+
   // Iterate through all planning pipelines
+  std::size_t planner_index = 0;
   for (const std::pair<const std::string, std::vector<std::string>>& pipeline_entry : pipeline_map)
   {
-    planning_pipeline::PlanningPipelinePtr planning_pipeline = planning_pipelines_[pipeline_entry.first];
     // Use the planning context if the pipeline only contains the planner plugin
-    bool use_planning_context = planning_pipeline->getAdapterPluginNames().empty();
+    bool use_planning_context = planning_pipelines_[pipeline_entry.first]->getAdapterPluginNames().empty();
     // Iterate through all planners configured for the pipeline
     for (const std::string& planner_id : pipeline_entry.second)
     {
+      // Skip the planners restored from the checkpoint
+      if (planner_index < checkpoint_data_.size())
+      {
+        benchmark_data_.push_back(checkpoint_data_[planner_index++]);
+        progress += runs;
+        continue;
+      }
+      ++planner_index;
+      std::chrono::system_clock::time_point planner_start = std::chrono::system_clock::now();
+
       // This container stores all of the benchmark data for this planner
       PlannerBenchmarkData planner_data(runs);
       // This vector stores all motion plan results for further evaluation
       std::vector<planning_interface::MotionPlanDetailedResponse> responses(runs);
-      std::vector<bool> solved(runs);
+      std::vector<char> solved_runs(runs);
 
       request.planner_id = planner_id;
 
@@ -819,53 +939,87 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
       for (PlannerStartEventFunction& planner_start_fn : planner_start_fns_)
         planner_start_fn(request, planner_data);
 
-      planning_interface::PlanningContextPtr planning_context;
-      if (use_planning_context)
-        planning_context = planning_pipeline->getPlannerManager()->getPlanningContext(planning_scene_, request);
-
-      // Iterate runs
-      for (int j = 0; j < runs; ++j)
-      {
-        // Pre-run events
-        for (PreRunEventFunction& pre_event_fn : pre_event_fns_)
-          pre_event_fn(request);
-
-        // Solve problem
-        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-        if (use_planning_context)
-        {
-          solved[j] = planning_context->solve(responses[j]);
-        }
-        else
+      // The threads take the runs in turns. The event functions are called one at a time.
+      // Each additional thread plans with a copy of the request.
+      std::vector<moveit_msgs::msg::MotionPlanRequest> thread_requests(num_threads - 1, request);
+      std::mutex event_mutex;
+      std::atomic<int> next_run{ 0 };
+      moveit::core::getThreadPool().run(num_threads, [&](std::size_t thread_index) {
+        try
         {
-          // The planning pipeline does not support MotionPlanDetailedResponse
-          planning_interface::MotionPlanResponse response;
-          solved[j] = planning_pipeline->generatePlan(planning_scene_, request, response);
-          responses[j].error_code_ = response.error_code_;
-          if (response.trajectory_)
+          moveit_msgs::msg::MotionPlanRequest& thread_request =
+              thread_index == 0 ? request : thread_requests[thread_index - 1];
+          const planning_scene::PlanningScenePtr& planning_scene = planning_scenes[thread_index];
+          const planning_pipeline::PlanningPipelinePtr& planning_pipeline =
+              thread_index == 0 ? planning_pipelines_.at(pipeline_entry.first) :
+                                  thread_planning_pipelines_[thread_index - 1].at(pipeline_entry.first);
+
+          planning_interface::PlanningContextPtr planning_context;
+          if (use_planning_context)
           {
-            responses[j].description_.push_back("plan");
-            responses[j].trajectory_.push_back(response.trajectory_);
-            responses[j].processing_time_.push_back(response.planning_time_);
+            planning_context =
+                planning_pipeline->getPlannerManager()->getPlanningContext(planning_scene, thread_request);
           }
-        }
-        std::chrono::duration<double> dt = std::chrono::system_clock::now() - start;
-        double total_time = dt.count();
 
-        // Collect data
-        start = std::chrono::system_clock::now();
-
-        // Post-run events
-        for (PostRunEventFunction& post_event_fn : post_event_fns_)
-          post_event_fn(request, responses[j], planner_data[j]);
-        collectMetrics(planner_data[j], responses[j], solved[j], total_time);
-        dt = std::chrono::system_clock::now() - start;
-        double metrics_time = dt.count();
-        RCLCPP_DEBUG(LOGGER, "Spent %lf seconds collecting metrics", metrics_time);
-
-        ++progress;
-      }
+          // Iterate runs
+          for (int j = next_run++; j < runs; j = next_run++)
+          {
+            // Pre-run events
+            {
+              std::scoped_lock lock(event_mutex);
+              for (PreRunEventFunction& pre_event_fn : pre_event_fns_)
+                pre_event_fn(thread_request);
+            }
+
+            // Solve problem
+            std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+            if (use_planning_context)
+            {
+              solved_runs[j] = planning_context->solve(responses[j]);
+            }
+            else
+            {
+              // The planning pipeline does not support MotionPlanDetailedResponse
+              planning_interface::MotionPlanResponse response;
+              solved_runs[j] = planning_pipeline->generatePlan(planning_scene, thread_request, response);
+              responses[j].error_code_ = response.error_code_;
+              if (response.trajectory_)
+              {
+                responses[j].description_.push_back("plan");
+                responses[j].trajectory_.push_back(response.trajectory_);
+                responses[j].processing_time_.push_back(response.planning_time_);
+              }
+            }
+            std::chrono::duration<double> dt = std::chrono::system_clock::now() - start;
+            double total_time = dt.count();
+
+            // Collect data
+            start = std::chrono::system_clock::now();
+
+            // Post-run events
+            {
+              std::scoped_lock lock(event_mutex);
+              for (PostRunEventFunction& post_event_fn : post_event_fns_)
+                post_event_fn(thread_request, responses[j], planner_data[j]);
+            }
+            collectMetrics(planner_data[j], responses[j], solved_runs[j], total_time, *planning_scene);
+            dt = std::chrono::system_clock::now() - start;
+            double metrics_time = dt.count();
+            RCLCPP_DEBUG(LOGGER, "Spent %lf seconds collecting metrics", metrics_time);
+
+            std::scoped_lock lock(event_mutex);
+            ++progress;
+          }
+        }
+        catch (...)
+        {
+          // stop the other threads, the thread pool rethrows in the calling thread
+          next_run = runs;
+          throw;
+        }
+      });
 
+      const std::vector<bool> solved(solved_runs.begin(), solved_runs.end());
       computeAveragePathSimilarities(planner_data, responses, solved);
 
       // Planner completion events
@@ -873,13 +1027,16 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::msg::MotionPlanRequest request
         planner_completion_fn(request, planner_data);
 
       benchmark_data_.push_back(planner_data);
+
+      std::chrono::duration<double> planner_duration = std::chrono::system_clock::now() - planner_start;
+      writeCheckpoint(pipeline_entry.first, planner_id, planner_duration.count(), planner_data);
     }
   }
 }
 
 void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
                                        const planning_interface::MotionPlanDetailedResponse& mp_res, bool solved,
-                                       double total_time)
+                                       double total_time, const planning_scene::PlanningScene& planning_scene)
 {
   metrics["time REAL"] = moveit::core::toString(total_time);
   metrics["solved BOOLEAN"] = solved ? "true" : "false";
@@ -907,12 +1064,12 @@ void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
       for (std::size_t k = 0; k < p.getWayPointCount(); ++k)
       {
         collision_detection::CollisionResult res;
-        planning_scene_->checkCollisionUnpadded(req, res, p.getWayPoint(k));
+        planning_scene.checkCollisionUnpadded(req, res, p.getWayPoint(k));
         if (res.collision)
           correct = false;
         if (!p.getWayPoint(k).satisfiesBounds())
           correct = false;
-        double d = planning_scene_->distanceToCollisionUnpadded(p.getWayPoint(k));
+        double d = planning_scene.distanceToCollisionUnpadded(p.getWayPoint(k));
         if (d > 0.0)  // in case of collision, distance is negative
           clearance += d;
       }
@@ -953,15 +1110,15 @@ void BenchmarkExecutor::computeAveragePathSimilarities(
   RCLCPP_INFO(LOGGER, "Computing result path similarity");
   const size_t result_count = planner_data.size();
   size_t unsolved = std::count_if(solved.begin(), solved.end(), [](bool s) { return !s; });
-  std::vector<double> average_distances(responses.size());
-  for (size_t first_traj_i = 0; first_traj_i < result_count; ++first_traj_i)
-  {
-    // If trajectory was not solved there is no valid average distance so it's set to max double only
+
+  // Compute the distances of all pairs of solved trajectories concurrently. distances[i][j - i - 1] holds the distance
+  // between trajectory i and j > i, or NaN if there is none.
+  std::vector<std::vector<double>> distances(result_count);
+  const size_t num_threads = thread_planning_pipelines_.size() + 1;
+  moveit::core::getThreadPool().parallelFor(result_count, num_threads, [&](size_t first_traj_i) {
     if (!solved[first_traj_i])
-    {
-      average_distances[first_traj_i] = std::numeric_limits<double>::max();
-      continue;
-    }
+      return;
+    distances[first_traj_i].assign(result_count - first_traj_i - 1, std::numeric_limits<double>::quiet_NaN());
     // Iterate all result trajectories that haven't been compared yet
     for (size_t second_traj_i = first_traj_i + 1; second_traj_i < result_count; ++second_traj_i)
     {
@@ -975,7 +1132,25 @@ void BenchmarkExecutor::computeAveragePathSimilarities(
 
       // Compute trajectory distance
       double trajectory_distance;
-      if (!computeTrajectoryDistance(traj_first, traj_second, trajectory_distance))
+      if (computeTrajectoryDistance(traj_first, traj_second, trajectory_distance))
+        distances[first_traj_i][second_traj_i - first_traj_i - 1] = trajectory_distance;
+    }
+  });
+
+  // Sum up the distances in a fixed order, so that the results do not depend on the number of threads
+  std::vector<double> average_distances(responses.size());
+  for (size_t first_traj_i = 0; first_traj_i < result_count; ++first_traj_i)
+  {
+    // If trajectory was not solved there is no valid average distance so it's set to max double only
+    if (!solved[first_traj_i])
+    {
+      average_distances[first_traj_i] = std::numeric_limits<double>::max();
+      continue;
+    }
+    for (size_t second_traj_i = first_traj_i + 1; second_traj_i < result_count; ++second_traj_i)
+    {
+      const double trajectory_distance = distances[first_traj_i][second_traj_i - first_traj_i - 1];
+      if (std::isnan(trajectory_distance))
         continue;
 
       // Add average distance to counters of both trajectories
@@ -1074,15 +1249,7 @@ void BenchmarkExecutor::writeOutput(const BenchmarkRequest& brequest, const std:
   if (hostname.empty())
     hostname = "UNKNOWN";
 
-  std::string filename = options_.getOutputDirectory();
-  if (!filename.empty() && filename[filename.size() - 1] != '/')
-    filename.append("/");
-
-  // Ensure directories exist
-  std::filesystem::create_directories(filename);
-
-  filename += (options_.getBenchmarkName().empty() ? "" : options_.getBenchmarkName() + "_") + brequest.name + "_" +
-              getHostname() + "_" + start_time + ".log";
+  std::string filename = getOutputFilePrefix(brequest) + "_" + start_time + ".log";
   std::ofstream out(filename.c_str());
   if (!out)
   {
@@ -1177,3 +1344,171 @@ void BenchmarkExecutor::writeOutput(const BenchmarkRequest& brequest, const std:
   out.close();
   RCLCPP_INFO(LOGGER, "Benchmark results saved to '%s'", filename.c_str());
 }
+
+std::string BenchmarkExecutor::getOutputFilePrefix(const BenchmarkRequest& brequest) const
+{
+  std::string filename = options_.getOutputDirectory();
+  if (!filename.empty() && filename[filename.size() - 1] != '/')
+    filename.append("/");
+
+  // Ensure directories exist
+  std::filesystem::create_directories(filename);
+
+  filename += (options_.getBenchmarkName().empty() ? "" : options_.getBenchmarkName() + "_") + brequest.name + "_" +
+              getHostname();
+  return filename;
+}
+
+std::string BenchmarkExecutor::getRunCheckpointFilename() const
+{
+  std::string filename = options_.getOutputDirectory();
+  if (!filename.empty() && filename[filename.size() - 1] != '/')
+    filename.append("/");
+
+  // Ensure directories exist
+  std::filesystem::create_directories(filename);
+
+  filename += (options_.getBenchmarkName().empty() ? "" : options_.getBenchmarkName() + "_") + getHostname() +
+              "_run.checkpoint";
+  return filename;
+}
+
+void BenchmarkExecutor::startRunCheckpoint()
+{
+  std::ofstream out(run_checkpoint_filename_.c_str(), std::ios::trunc);
+  if (!out)
+  {
+    RCLCPP_WARN(LOGGER, "Failed to open '%s' for the benchmark checkpoint", run_checkpoint_filename_.c_str());
+    return;
+  }
+  out << RUN_CHECKPOINT_HEADER << '\n';
+}
+
+bool BenchmarkExecutor::loadRunCheckpoint(std::set<std::string>& completed_queries)
+{
+  completed_queries.clear();
+  std::ifstream in(run_checkpoint_filename_.c_str());
+  std::string line;
+  if (!std::getline(in, line) || line != RUN_CHECKPOINT_HEADER)
+    return false;
+
+  // A query name that was interrupted while it was written is not terminated by a newline and ignored
+  std::streampos valid_size = in.tellg();
+  while (std::getline(in, line) && !in.eof())
+  {
+    completed_queries.insert(line);
+    valid_size = in.tellg();
+  }
+  in.close();
+
+  // Drop an incomplete name, so that more queries can be appended
+  std::error_code ec;
+  std::filesystem::resize_file(run_checkpoint_filename_, static_cast<std::uintmax_t>(valid_size), ec);
+  return true;
+}
+
+void BenchmarkExecutor::writeRunCheckpoint(const std::string& query_name)
+{
+  std::ofstream out(run_checkpoint_filename_.c_str(), std::ios::app);
+  if (!out)
+  {
+    RCLCPP_WARN(LOGGER, "Failed to open '%s' for the benchmark checkpoint", run_checkpoint_filename_.c_str());
+    return;
+  }
+  out << query_name << '\n';
+}
+
+void BenchmarkExecutor::startCheckpoint(const std::string& start_time)
+{
+  std::ofstream out(checkpoint_filename_.c_str(), std::ios::trunc);
+  if (!out)
+  {
+    RCLCPP_WARN(LOGGER, "Failed to open '%s' for the benchmark checkpoint", checkpoint_filename_.c_str());
+    return;
+  }
+  out << CHECKPOINT_HEADER << '\n';
+  out << start_time << '\n';
+}
+
+bool BenchmarkExecutor::loadCheckpoint(const std::map<std::string, std::vector<std::string>>& pipelines,
+                                       std::string& start_time, double& duration)
+{
+  checkpoint_data_.clear();
+  std::ifstream in(checkpoint_filename_.c_str());
+  std::string line, checkpoint_start_time;
+  if (!std::getline(in, line) || line != CHECKPOINT_HEADER || !std::getline(in, checkpoint_start_time))
+    return false;
+
+  auto read_count = [&in, &line](std::size_t& count) {
+    return std::getline(in, line) && static_cast<bool>(std::istringstream(line) >> count);
+  };
+
+  // The planners are checkpointed in the order they are benchmarked in. A planner that was interrupted while its
+  // data was written is incomplete and ignored, like all planners after it.
+  double checkpoint_duration = 0.0;
+  std::streampos valid_size = in.tellg();
+  bool complete = true;
+  for (const std::pair<const std::string, std::vector<std::string>>& pipeline : pipelines)
+  {
+    for (std::size_t i = 0; complete && i < pipeline.second.size(); ++i)
+    {
+      std::string pipeline_name, planner_id;
+      double planner_duration;
+      std::size_t num_runs;
+      complete = std::getline(in, pipeline_name) && pipeline_name == pipeline.first &&
+                 std::getline(in, planner_id) && planner_id == pipeline.second[i] && std::getline(in, line) &&
+                 static_cast<bool>(std::istringstream(line) >> planner_duration) && read_count(num_runs);
+
+      PlannerBenchmarkData planner_data(complete ? num_runs : 0);
+      for (PlannerRunData& run_data : planner_data)
+      {
+        std::size_t num_properties;
+        complete = complete && read_count(num_properties);
+        for (std::size_t k = 0; complete && k < num_properties; ++k)
+        {
+          std::string property;
+          complete = std::getline(in, property) && std::getline(in, run_data[property]);
+        }
+      }
+      complete = complete && std::getline(in, line) && line == ".";
+      if (complete)
+      {
+        checkpoint_data_.push_back(planner_data);
+        checkpoint_duration += planner_duration;
+        valid_size = in.tellg();
+      }
+    }
+  }
+  in.close();
+
+  // Drop any incomplete data, so that more planners can be appended
+  std::error_code ec;
+  std::filesystem::resize_file(checkpoint_filename_, static_cast<std::uintmax_t>(valid_size), ec);
+
+  start_time = checkpoint_start_time;
+  duration = checkpoint_duration;
+  return true;
+}
+
+void BenchmarkExecutor::writeCheckpoint(const std::string& planning_pipeline_name, const std::string& planner_id,
+                                        double duration, const PlannerBenchmarkData& planner_data)
+{
+  std::ofstream out(checkpoint_filename_.c_str(), std::ios::app);
+  if (!out)
+  {
+    RCLCPP_WARN(LOGGER, "Failed to open '%s' for the benchmark checkpoint", checkpoint_filename_.c_str());
+    return;
+  }
+
+  out << planning_pipeline_name << '\n';
+  out << planner_id << '\n';
+  out << moveit::core::toString(duration) << '\n';
+  out << planner_data.size() << '\n';
+  for (const PlannerRunData& run_data : planner_data)
+  {
+    out << run_data.size() << '\n';
+    for (const std::pair<const std::string, std::string>& property : run_data)
+      out << property.first << '\n' << property.second << '\n';
+  }
+  out << "." << '\n';  // end the planner
+}
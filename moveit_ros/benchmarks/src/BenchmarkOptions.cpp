@@ -95,6 +95,16 @@ double BenchmarkOptions::getTimeout() const
   return timeout_;
 }
 
+int BenchmarkOptions::getNumThreads() const
+{
+  return num_threads_;
+}
+
+bool BenchmarkOptions::getResume() const
+{
+  return resume_;
+}
+
 const std::string& BenchmarkOptions::getBenchmarkName() const
 {
   return benchmark_name_;
@@ -191,6 +201,8 @@ void BenchmarkOptions::readBenchmarkParameters(const rclcpp::Node::SharedPtr& no
   node->get_parameter_or(std::string("benchmark_config.parameters.name"), benchmark_name_, std::string(""));
   node->get_parameter_or(std::string("benchmark_config.parameters.runs"), runs_, 10);
   node->get_parameter_or(std::string("benchmark_config.parameters.timeout"), timeout_, 10.0);
+  node->get_parameter_or(std::string("benchmark_config.parameters.num_threads"), num_threads_, 1);
+  node->get_parameter_or(std::string("benchmark_config.parameters.resume"), resume_, false);
   node->get_parameter_or(std::string("benchmark_config.parameters.output_directory"), output_directory_,
                          std::string(""));
   node->get_parameter_or(std::string("benchmark_config.parameters.queries"), query_regex_, std::string(".*"));
@@ -222,6 +234,8 @@ void BenchmarkOptions::readBenchmarkParameters(const rclcpp::Node::SharedPtr& no
   RCLCPP_INFO(LOGGER, "Benchmark name: '%s'", benchmark_name_.c_str());
   RCLCPP_INFO(LOGGER, "Benchmark #runs: %d", runs_);
   RCLCPP_INFO(LOGGER, "Benchmark timeout: %f secs", timeout_);
+  RCLCPP_INFO(LOGGER, "Benchmark #threads: %d", num_threads_);
+  RCLCPP_INFO(LOGGER, "Benchmark resume: %s", resume_ ? "true" : "false");
   RCLCPP_INFO(LOGGER, "Benchmark group: %s", group_name_.c_str());
   RCLCPP_INFO(LOGGER, "Benchmark query regex: '%s'", query_regex_.c_str());
   RCLCPP_INFO(LOGGER, "Benchmark start state regex: '%s':", start_state_regex_.c_str());
@@ -0,0 +1,237 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <moveit/benchmarks/BenchmarkExecutor.h>
+#include <moveit/rdf_loader/rdf_loader.h>
+#include <rclcpp/rclcpp.hpp>
+
+using moveit_ros_benchmarks::BenchmarkExecutor;
+
+/** \brief Exposes the checkpoint functions of BenchmarkExecutor */
+class CheckpointBenchmarkExecutor : public BenchmarkExecutor
+{
+public:
+  using BenchmarkExecutor::BenchmarkExecutor;
+  using BenchmarkExecutor::checkpoint_data_;
+  using BenchmarkExecutor::checkpoint_filename_;
+  using BenchmarkExecutor::loadCheckpoint;
+  using BenchmarkExecutor::loadRunCheckpoint;
+  using BenchmarkExecutor::run_checkpoint_filename_;
+  using BenchmarkExecutor::startCheckpoint;
+  using BenchmarkExecutor::startRunCheckpoint;
+  using BenchmarkExecutor::writeCheckpoint;
+  using BenchmarkExecutor::writeRunCheckpoint;
+};
+
+class BenchmarkCheckpointTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    std::string urdf, srdf;
+    ASSERT_TRUE(rdf_loader::RDFLoader::loadPkgFileToString(urdf, "moveit_resources_panda_description",
+                                                           "urdf/panda.urdf", {}));
+    ASSERT_TRUE(rdf_loader::RDFLoader::loadPkgFileToString(srdf, "moveit_resources_panda_moveit_config",
+                                                           "config/panda.srdf", {}));
+    node_ = std::make_shared<rclcpp::Node>(
+        "benchmark_checkpoint_test",
+        rclcpp::NodeOptions().parameter_overrides({ { "robot_description", urdf },
+                                                    { "robot_description_semantic", srdf } }));
+    executor_ = std::make_unique<CheckpointBenchmarkExecutor>(node_);
+    executor_->checkpoint_filename_ = (std::filesystem::temp_directory_path() /
+                                       (std::string("benchmark_checkpoint_test_") +
+                                        testing::UnitTest::GetInstance()->current_test_info()->name()))
+                                          .string();
+    executor_->run_checkpoint_filename_ = executor_->checkpoint_filename_ + "_run";
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove(executor_->checkpoint_filename_);
+    std::filesystem::remove(executor_->run_checkpoint_filename_);
+  }
+
+  /** \brief Data of a planner with \e runs runs, with properties depending on \e value */
+  static BenchmarkExecutor::PlannerBenchmarkData makePlannerData(std::size_t runs, double value)
+  {
+    BenchmarkExecutor::PlannerBenchmarkData planner_data(runs);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      planner_data[i]["time REAL"] = std::to_string(value + static_cast<double>(i));
+      planner_data[i]["solved BOOLEAN"] = i % 2 ? "true" : "false";
+      planner_data[i]["path_plan_correct BOOLEAN"] = "";
+      planner_data[i]["planner output STRING"] = "a value with spaces";
+    }
+    return planner_data;
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  std::unique_ptr<CheckpointBenchmarkExecutor> executor_;
+  const std::map<std::string, std::vector<std::string>> pipelines_{ { "ompl", { "RRT", "PRM", "EST" } },
+                                                                     { "stomp", { "stomp" } } };
+};
+
+TEST_F(BenchmarkCheckpointTest, NoCheckpoint)
+{
+  std::string start_time;
+  double duration = 0.0;
+  EXPECT_FALSE(executor_->loadCheckpoint(pipelines_, start_time, duration));
+  EXPECT_TRUE(executor_->checkpoint_data_.empty());
+}
+
+TEST_F(BenchmarkCheckpointTest, RoundTrip)
+{
+  const BenchmarkExecutor::PlannerBenchmarkData rrt = makePlannerData(3, 1.0);
+  const BenchmarkExecutor::PlannerBenchmarkData prm = makePlannerData(2, 5.0);
+  executor_->startCheckpoint("2023-01-01T12:00:00");
+  executor_->writeCheckpoint("ompl", "RRT", 1.5, rrt);
+  executor_->writeCheckpoint("ompl", "PRM", 2.25, prm);
+
+  std::string start_time;
+  double duration = 0.0;
+  ASSERT_TRUE(executor_->loadCheckpoint(pipelines_, start_time, duration));
+  EXPECT_EQ(start_time, "2023-01-01T12:00:00");
+  EXPECT_DOUBLE_EQ(duration, 3.75);
+  ASSERT_EQ(executor_->checkpoint_data_.size(), 2u);
+  EXPECT_EQ(executor_->checkpoint_data_[0], rrt);
+  EXPECT_EQ(executor_->checkpoint_data_[1], prm);
+
+  // The benchmark continues with the next planner
+  const BenchmarkExecutor::PlannerBenchmarkData est = makePlannerData(1, 9.0);
+  executor_->writeCheckpoint("ompl", "EST", 0.5, est);
+  ASSERT_TRUE(executor_->loadCheckpoint(pipelines_, start_time, duration));
+  EXPECT_DOUBLE_EQ(duration, 4.25);
+  ASSERT_EQ(executor_->checkpoint_data_.size(), 3u);
+  EXPECT_EQ(executor_->checkpoint_data_[2], est);
+}
+
+TEST_F(BenchmarkCheckpointTest, IncompletePlannerIsDiscarded)
+{
+  const BenchmarkExecutor::PlannerBenchmarkData rrt = makePlannerData(3, 1.0);
+  executor_->startCheckpoint("start");
+  executor_->writeCheckpoint("ompl", "RRT", 1.0, rrt);
+  const std::uintmax_t complete_size = std::filesystem::file_size(executor_->checkpoint_filename_);
+
+  // Interrupt the benchmark while the next planner is written
+  executor_->writeCheckpoint("ompl", "PRM", 2.0, makePlannerData(2, 5.0));
+  std::filesystem::resize_file(executor_->checkpoint_filename_,
+                               (complete_size + std::filesystem::file_size(executor_->checkpoint_filename_)) / 2);
+
+  std::string start_time;
+  double duration = 0.0;
+  ASSERT_TRUE(executor_->loadCheckpoint(pipelines_, start_time, duration));
+  EXPECT_DOUBLE_EQ(duration, 1.0);
+  ASSERT_EQ(executor_->checkpoint_data_.size(), 1u);
+  EXPECT_EQ(executor_->checkpoint_data_[0], rrt);
+  EXPECT_EQ(std::filesystem::file_size(executor_->checkpoint_filename_), complete_size);
+
+  // The planner is run again and appended after the complete data
+  const BenchmarkExecutor::PlannerBenchmarkData prm = makePlannerData(2, 7.0);
+  executor_->writeCheckpoint("ompl", "PRM", 3.0, prm);
+  ASSERT_TRUE(executor_->loadCheckpoint(pipelines_, start_time, duration));
+  EXPECT_DOUBLE_EQ(duration, 4.0);
+  ASSERT_EQ(executor_->checkpoint_data_.size(), 2u);
+  EXPECT_EQ(executor_->checkpoint_data_[1], prm);
+}
+
+TEST_F(BenchmarkCheckpointTest, OtherPlannersAreNotRestored)
+{
+  executor_->startCheckpoint("start");
+  executor_->writeCheckpoint("ompl", "RRT", 1.0, makePlannerData(1, 1.0));
+
+  // The checkpoint was written for a different benchmark configuration
+  std::string start_time;
+  double duration = 0.0;
+  ASSERT_TRUE(executor_->loadCheckpoint({ { "ompl", { "PRM", "RRT" } } }, start_time, duration));
+  EXPECT_TRUE(executor_->checkpoint_data_.empty());
+  EXPECT_DOUBLE_EQ(duration, 0.0);
+}
+
+TEST_F(BenchmarkCheckpointTest, NoRunCheckpoint)
+{
+  // Without the checkpoint of an interrupted benchmark there is nothing to resume
+  std::set<std::string> completed_queries;
+  EXPECT_FALSE(executor_->loadRunCheckpoint(completed_queries));
+
+  executor_->startRunCheckpoint();
+  ASSERT_TRUE(executor_->loadRunCheckpoint(completed_queries));
+  EXPECT_TRUE(completed_queries.empty());
+}
+
+TEST_F(BenchmarkCheckpointTest, RunCheckpointRoundTrip)
+{
+  executor_->startRunCheckpoint();
+  executor_->writeRunCheckpoint("Pick1");
+  executor_->writeRunCheckpoint("Place 1");
+  const std::uintmax_t complete_size = std::filesystem::file_size(executor_->run_checkpoint_filename_);
+
+  // Interrupt the benchmark while the next query is written
+  {
+    std::ofstream out(executor_->run_checkpoint_filename_, std::ios::app);
+    out << "Pic";
+  }
+
+  std::set<std::string> completed_queries;
+  ASSERT_TRUE(executor_->loadRunCheckpoint(completed_queries));
+  EXPECT_EQ(completed_queries, std::set<std::string>({ "Pick1", "Place 1" }));
+  EXPECT_EQ(std::filesystem::file_size(executor_->run_checkpoint_filename_), complete_size);
+
+  // The query is benchmarked again and appended after the complete names
+  executor_->writeRunCheckpoint("Pick2");
+  ASSERT_TRUE(executor_->loadRunCheckpoint(completed_queries));
+  EXPECT_EQ(completed_queries, std::set<std::string>({ "Pick1", "Pick2", "Place 1" }));
+
+  // A new benchmark starts over
+  executor_->startRunCheckpoint();
+  ASSERT_TRUE(executor_->loadRunCheckpoint(completed_queries));
+  EXPECT_TRUE(completed_queries.empty());
+}
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  const int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
@@ -43,13 +43,17 @@
 #include <rclcpp/rclcpp.hpp>
 #include <moveit/local_planner/local_constraint_solver_interface.h>
 
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
 namespace moveit::hybrid_planning
 {
 class ForwardTrajectory : public LocalConstraintSolverInterface
 {
 public:
   ForwardTrajectory() = default;
-  ~ForwardTrajectory() = default;
+  ~ForwardTrajectory() override;
   bool initialize(const rclcpp::Node::SharedPtr& node,
                   const planning_scene_monitor::PlanningSceneMonitorPtr& planning_scene_monitor,
                   const std::string& /* unused */) override;
@@ -61,10 +65,29 @@ public:
         trajectory_msgs::msg::JointTrajectory& local_solution) override;
 
 private:
+  /** \brief Hash of the joint positions of a waypoint */
+  struct WaypointHash
+  {
+    std::size_t operator()(const std::vector<double>& positions) const;
+  };
+
+  /** \brief Check the waypoints of \e local_trajectory within the lookahead time for validity in \e planning_scene.
+      Waypoints that were found valid since the last geometry update of the scene are not checked again.
+      \e world_version needs to be read before the planning scene is locked. */
+  bool isPathValid(const planning_scene::PlanningScene& planning_scene,
+                   const robot_trajectory::RobotTrajectory& local_trajectory, uint64_t world_version);
+
   rclcpp::Node::SharedPtr node_;
   planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
   bool path_invalidation_event_send_;  // Send path invalidation event only once
   bool stop_before_collision_;
+  double lookahead_time_;  // Only validate waypoints this far ahead [s], 0 validates the entire trajectory
+
+  // Incremental path validation
+  std::size_t update_callback_id_ = 0;      // Id of the scene update callback registered with the monitor
+  std::atomic<uint64_t> world_version_{ 0 };  // Incremented on every geometry update of the scene
+  uint64_t validated_world_version_;
+  std::unordered_set<std::vector<double>, WaypointHash> validated_waypoints_;
 
   // Detect when the local planner gets stuck
   size_t num_iterations_stuck_;
@@ -37,6 +37,8 @@
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/robot_state/conversions.h>
 
+#include <functional>
+
 namespace
 {
 const rclcpp::Logger LOGGER = rclcpp::get_logger("local_planner_component");
@@ -60,21 +62,97 @@ bool ForwardTrajectory::initialize(const rclcpp::Node::SharedPtr& node,
   {
     stop_before_collision_ = node->declare_parameter<bool>("stop_before_collision", false);
   }
+  if (node->has_parameter("lookahead_time"))
+  {
+    node->get_parameter<double>("lookahead_time", lookahead_time_);
+  }
+  else
+  {
+    lookahead_time_ = node->declare_parameter<double>("lookahead_time", 0.0);
+  }
+  if (planning_scene_monitor_)
+    planning_scene_monitor_->removeUpdateCallback(update_callback_id_);
   planning_scene_monitor_ = planning_scene_monitor;
   node_ = node;
   path_invalidation_event_send_ = false;
   num_iterations_stuck_ = 0;
+
+  // Validated waypoints only need to be checked again once the geometry of the scene changes
+  validated_world_version_ = world_version_;
+  update_callback_id_ = planning_scene_monitor_->addUpdateCallback(
+      [this](planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType type) {
+        if (type & planning_scene_monitor::PlanningSceneMonitor::UPDATE_GEOMETRY)
+          ++world_version_;
+      });
   return true;
 }
 
+ForwardTrajectory::~ForwardTrajectory()
+{
+  if (planning_scene_monitor_)
+    planning_scene_monitor_->removeUpdateCallback(update_callback_id_);
+}
+
 bool ForwardTrajectory::reset()
 {
   num_iterations_stuck_ = 0;
   prev_waypoint_target_.reset();
   path_invalidation_event_send_ = false;
+  validated_waypoints_.clear();
   return true;
 };
 
+std::size_t ForwardTrajectory::WaypointHash::operator()(const std::vector<double>& positions) const
+{
+  std::size_t hash = positions.size();
+  for (const double position : positions)
+    hash ^= std::hash<double>()(position) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+bool ForwardTrajectory::isPathValid(const planning_scene::PlanningScene& planning_scene,
+                                    const robot_trajectory::RobotTrajectory& local_trajectory, uint64_t world_version)
+{
+  if (world_version != validated_world_version_)
+  {
+    validated_waypoints_.clear();
+    validated_world_version_ = world_version;
+  }
+
+  // Only the waypoints of this trajectory are kept, the ones left behind are forgotten
+  std::unordered_set<std::vector<double>, WaypointHash> validated_waypoints;
+  double time_from_start = 0.0;
+  for (std::size_t i = 0; i < local_trajectory.getWayPointCount(); ++i)
+  {
+    if (i > 0)
+    {
+      time_from_start += local_trajectory.getWayPointDurationFromPrevious(i);
+      if (lookahead_time_ > 0.0 && time_from_start > lookahead_time_)
+        break;
+    }
+
+    const moveit::core::RobotState& waypoint = local_trajectory.getWayPoint(i);
+    std::vector<double> positions(waypoint.getVariablePositions(),
+                                  waypoint.getVariablePositions() + waypoint.getVariableCount());
+    auto validated = validated_waypoints_.find(positions);
+    if (validated != validated_waypoints_.end())
+    {
+      validated_waypoints.insert(validated_waypoints_.extract(validated));
+    }
+    else if (planning_scene.isStateValid(waypoint, local_trajectory.getGroupName(), false))
+    {
+      validated_waypoints.insert(std::move(positions));
+    }
+    else
+    {
+      validated_waypoints_.swap(validated_waypoints);
+      return false;
+    }
+  }
+  validated_waypoints_.swap(validated_waypoints);
+  return true;
+}
+
 moveit_msgs::action::LocalPlanner::Feedback
 ForwardTrajectory::solve(const robot_trajectory::RobotTrajectory& local_trajectory,
                          const std::shared_ptr<const moveit_msgs::action::LocalPlanner::Goal> /* unused */,
@@ -104,11 +182,13 @@ ForwardTrajectory::solve(const robot_trajectory::RobotTrajectory& local_trajecto
 
     moveit::core::RobotStatePtr current_state;
     bool is_path_valid = false;
+    // Read the version first, so that a geometry update while validating makes the next iteration check again
+    const uint64_t world_version = world_version_;
     // Lock the planning scene as briefly as possible
     {
       planning_scene_monitor::LockedPlanningSceneRO locked_planning_scene(planning_scene_monitor_);
       current_state = std::make_shared<moveit::core::RobotState>(locked_planning_scene->getCurrentState());
-      is_path_valid = locked_planning_scene->isPathValid(local_trajectory, local_trajectory.getGroupName(), false);
+      is_path_valid = isPathValid(*locked_planning_scene, local_trajectory, world_version);
     }
 
     // Check if path is valid
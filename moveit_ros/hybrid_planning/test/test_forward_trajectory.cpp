@@ -0,0 +1,172 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <geometric_shapes/shapes.h>
+#include <moveit/local_constraint_solver_plugins/forward_trajectory.h>
+#include <moveit/local_planner/feedback_types.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit/rdf_loader/rdf_loader.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <rclcpp/rclcpp.hpp>
+
+using moveit::hybrid_planning::ForwardTrajectory;
+using planning_scene_monitor::PlanningSceneMonitor;
+
+static const std::string GROUP = "panda_arm";
+
+class ForwardTrajectoryTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    node_ = std::make_shared<rclcpp::Node>("forward_trajectory_test");
+    robot_model_loader::RobotModelLoader::Options opt;
+    ASSERT_TRUE(rdf_loader::RDFLoader::loadPkgFileToString(opt.urdf_string_, "moveit_resources_panda_description",
+                                                           "urdf/panda.urdf", {}));
+    ASSERT_TRUE(rdf_loader::RDFLoader::loadPkgFileToString(opt.srdf_string_, "moveit_resources_panda_moveit_config",
+                                                           "config/panda.srdf", {}));
+    opt.load_kinematics_solvers_ = false;
+    psm_ = std::make_shared<PlanningSceneMonitor>(node_,
+                                                  std::make_shared<robot_model_loader::RobotModelLoader>(node_, opt));
+    ASSERT_TRUE(psm_->getPlanningScene());
+
+    // The hand sweeps around the base, the last waypoint is two seconds ahead of the first
+    trajectory_ = std::make_shared<robot_trajectory::RobotTrajectory>(psm_->getRobotModel(), GROUP);
+    for (const double joint1 : { 0.0, 0.1, 1.5 })
+    {
+      moveit::core::RobotState waypoint(psm_->getRobotModel());
+      waypoint.setToDefaultValues(waypoint.getJointModelGroup(GROUP), "ready");
+      waypoint.setVariablePosition("panda_joint1", joint1);
+      waypoint.update();
+      trajectory_->addSuffixWayPoint(waypoint, trajectory_->empty() ? 0.0 : 1.0);
+    }
+  }
+
+  /** \brief Create a solver that stops before collisions and validates \e lookahead_time seconds ahead */
+  std::unique_ptr<ForwardTrajectory> makeSolver(double lookahead_time)
+  {
+    const auto solver_node = std::make_shared<rclcpp::Node>(
+        "forward_trajectory_solver_" + std::to_string(++solver_count_),
+        rclcpp::NodeOptions().parameter_overrides(
+            { { "stop_before_collision", true }, { "lookahead_time", lookahead_time } }));
+    auto solver = std::make_unique<ForwardTrajectory>();
+    EXPECT_TRUE(solver->initialize(solver_node, psm_, GROUP));
+    return solver;
+  }
+
+  /** \brief Place a box around the hand at the last waypoint of the trajectory without notifying the monitor */
+  void addBoxAtLastWaypoint()
+  {
+    planning_scene_monitor::LockedPlanningSceneRW scene(psm_);
+    const Eigen::Isometry3d pose(
+        Eigen::Translation3d(trajectory_->getLastWayPoint().getGlobalLinkTransform("panda_hand").translation()));
+    scene->getWorldNonConst()->addToObject("box", std::make_shared<const shapes::Box>(0.1, 0.1, 0.1), pose);
+  }
+
+  /** \brief Run one iteration of \e solver and tell whether it reported a collision ahead */
+  bool collisionAhead(ForwardTrajectory& solver)
+  {
+    trajectory_msgs::msg::JointTrajectory local_solution;
+    return solver.solve(*trajectory_, nullptr, local_solution).feedback ==
+           toString(moveit::hybrid_planning::LocalFeedbackEnum::COLLISION_AHEAD);
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  planning_scene_monitor::PlanningSceneMonitorPtr psm_;
+  robot_trajectory::RobotTrajectoryPtr trajectory_;
+  int solver_count_ = 0;
+};
+
+TEST_F(ForwardTrajectoryTest, ValidatedWaypointsAreNotCheckedAgain)
+{
+  const std::unique_ptr<ForwardTrajectory> solver = makeSolver(0.0);
+  EXPECT_FALSE(collisionAhead(*solver));
+
+  // Without a geometry update the remembered waypoints are trusted
+  addBoxAtLastWaypoint();
+  EXPECT_FALSE(collisionAhead(*solver));
+
+  // A new solver does not know the waypoints yet
+  EXPECT_TRUE(collisionAhead(*makeSolver(0.0)));
+}
+
+TEST_F(ForwardTrajectoryTest, GeometryUpdateInvalidatesWaypoints)
+{
+  const std::unique_ptr<ForwardTrajectory> solver = makeSolver(0.0);
+  EXPECT_FALSE(collisionAhead(*solver));
+  addBoxAtLastWaypoint();
+
+  // Robot state updates do not change the world
+  psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_STATE);
+  EXPECT_FALSE(collisionAhead(*solver));
+
+  psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_GEOMETRY);
+  EXPECT_TRUE(collisionAhead(*solver));
+}
+
+TEST_F(ForwardTrajectoryTest, LookaheadTimeLimitsValidation)
+{
+  addBoxAtLastWaypoint();
+  psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_GEOMETRY);
+
+  EXPECT_FALSE(collisionAhead(*makeSolver(1.5)));
+  EXPECT_TRUE(collisionAhead(*makeSolver(2.0)));
+  EXPECT_TRUE(collisionAhead(*makeSolver(0.0)));
+}
+
+TEST_F(ForwardTrajectoryTest, DestructionRemovesUpdateCallback)
+{
+  makeSolver(0.0).reset();
+
+  // The callback of the destroyed solver must not be called anymore
+  psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_GEOMETRY);
+  const std::unique_ptr<ForwardTrajectory> solver = makeSolver(0.0);
+  psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_GEOMETRY);
+  EXPECT_FALSE(collisionAhead(*solver));
+}
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  const int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
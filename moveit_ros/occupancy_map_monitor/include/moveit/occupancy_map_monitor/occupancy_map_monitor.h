@@ -263,6 +263,14 @@ public:
    */
   void publishDebugInformation(bool flag);
 
+  /**
+   * @brief      Gets the counters of the update pipeline stages of all updaters. The stage names are prefixed with
+   *             the type of their updater, e.g. "PointCloudUpdater/raycast".
+   *
+   * @return     The statistics of all stages.
+   */
+  std::vector<UpdatePipelineStageStatistics> getPipelineStatistics() const;
+
   /**
    * @brief      Determines if active.
    *
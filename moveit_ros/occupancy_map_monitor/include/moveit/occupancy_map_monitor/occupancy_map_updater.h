@@ -38,6 +38,7 @@
 
 #include <moveit/macros/class_forward.h>
 #include <moveit/collision_detection/occupancy_map.h>
+#include <moveit/occupancy_map_monitor/update_pipeline.h>
 
 #include <geometric_shapes/shapes.h>
 #include <rclcpp/rclcpp.hpp>
@@ -48,6 +49,7 @@
 #include <map>
 #include <string>
 #include <functional>
+#include <vector>
 
 namespace occupancy_map_monitor
 {
@@ -102,6 +104,13 @@ public:
     debug_info_ = flag;
   }
 
+  /** @brief Get the counters of the stages of the update pipeline, if the updater processes its sensor data in one.
+   * The default implementation returns no stages. */
+  virtual std::vector<UpdatePipelineStageStatistics> getPipelineStatistics() const
+  {
+    return {};
+  }
+
 protected:
   OccupancyMapMonitor* monitor_;
   std::string type_;
@@ -112,6 +121,11 @@ protected:
 
   bool updateTransformCache(const std::string& target_frame, const rclcpp::Time& target_time);
 
+  /** @brief Update \e cache instead of transform_cache_, for updaters that look up transforms on a different thread
+   * than the one that uses them */
+  bool updateTransformCache(const std::string& target_frame, const rclcpp::Time& target_time,
+                            ShapeTransformCache& cache);
+
   // TODO rework this function
   // static void readXmlParam(XmlRpc::XmlRpcValue& params, const std::string& param_name, double* value);
   // static void readXmlParam(XmlRpc::XmlRpcValue& params, const std::string& param_name, unsigned int* value);
@@ -0,0 +1,302 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace occupancy_map_monitor
+{
+/** \brief Counters of a single stage of an UpdatePipeline. Latencies are the time spent in the stage function,
+    in seconds. */
+struct UpdatePipelineStageStatistics
+{
+  std::string name;
+  /** \brief Number of items the stage function was called for */
+  std::size_t processed = 0;
+  /** \brief Number of items replaced by a newer one in the input queue of the stage before it could take them */
+  std::size_t dropped = 0;
+  double last_latency = 0.0;
+  double average_latency = 0.0;
+  double max_latency = 0.0;
+};
+
+/** \brief A bounded queue in which a new item replaces the oldest one once the queue is full, so producers never
+    wait for consumers. */
+template <typename T>
+class LatestWinsQueue
+{
+public:
+  explicit LatestWinsQueue(std::size_t capacity = 1) : capacity_(std::max<std::size_t>(capacity, 1)), closed_(false)
+  {
+  }
+
+  /** \brief Add \e item to the queue. Returns false if the oldest item had to be dropped to make room for it.
+      Items pushed to a closed queue are discarded. */
+  bool push(T item)
+  {
+    bool dropped = false;
+    {
+      std::scoped_lock slock(lock_);
+      if (closed_)
+        return true;
+      if (items_.size() >= capacity_)
+      {
+        items_.pop_front();
+        dropped = true;
+      }
+      items_.push_back(std::move(item));
+    }
+    condition_.notify_one();
+    return !dropped;
+  }
+
+  /** \brief Wait for the oldest item and take it from the queue. Returns false if the queue was closed. */
+  bool pop(T& item)
+  {
+    std::unique_lock<std::mutex> ulock(lock_);
+    condition_.wait(ulock, [this] { return closed_ || !items_.empty(); });
+    if (closed_)
+      return false;
+    item = std::move(items_.front());
+    items_.pop_front();
+    return true;
+  }
+
+  /** \brief Discard all items and wake up all threads waiting in pop() */
+  void close()
+  {
+    {
+      std::scoped_lock slock(lock_);
+      closed_ = true;
+      items_.clear();
+    }
+    condition_.notify_all();
+  }
+
+  /** \brief Allow the queue to be used again after close() */
+  void open()
+  {
+    std::scoped_lock slock(lock_);
+    closed_ = false;
+  }
+
+  std::size_t size() const
+  {
+    std::scoped_lock slock(lock_);
+    return items_.size();
+  }
+
+private:
+  const std::size_t capacity_;
+  bool closed_;
+  std::deque<T> items_;
+  mutable std::mutex lock_;
+  std::condition_variable condition_;
+};
+
+/** \brief A sequence of stages that each run on a thread of their own and pass items of type \e T on to the next
+    stage through a LatestWinsQueue.
+
+    push() never blocks: if a stage is still busy when the next item arrives, the older item waiting for it is
+    replaced, so the throughput of the pipeline is limited only by its slowest stage and the items that get through
+    are always the most recent ones. A stage function returns false to discard an item instead of passing it on. */
+template <typename T>
+class UpdatePipeline
+{
+public:
+  using StageFunction = std::function<bool(T&)>;
+
+  /** \brief Create an empty pipeline in which at most \e queue_capacity items wait in front of each stage */
+  explicit UpdatePipeline(std::size_t queue_capacity = 1) : queue_capacity_(queue_capacity), running_(false)
+  {
+  }
+
+  ~UpdatePipeline()
+  {
+    stop();
+  }
+
+  UpdatePipeline(const UpdatePipeline&) = delete;
+  UpdatePipeline& operator=(const UpdatePipeline&) = delete;
+
+  /** \brief Append a stage called \e name. Stages can only be added while the pipeline is stopped. */
+  void addStage(const std::string& name, const StageFunction& function)
+  {
+    if (running_)
+      throw std::runtime_error("Cannot add stage '" + name + "' to a running pipeline");
+    stages_.push_back(std::make_unique<Stage>(name, function, queue_capacity_));
+  }
+
+  /** \brief Start one thread per stage */
+  void start()
+  {
+    if (running_)
+      return;
+    running_ = true;
+    for (std::size_t i = 0; i < stages_.size(); ++i)
+    {
+      stages_[i]->input.open();
+      stages_[i]->thread = std::thread([this, i] { runStage(i); });
+    }
+  }
+
+  /** \brief Discard all items in the pipeline and wait for the stage threads to finish their current item */
+  void stop()
+  {
+    if (!running_)
+      return;
+    for (const std::unique_ptr<Stage>& stage : stages_)
+      stage->input.close();
+    for (const std::unique_ptr<Stage>& stage : stages_)
+    {
+      if (stage->thread.joinable())
+        stage->thread.join();
+    }
+    running_ = false;
+  }
+
+  bool isRunning() const
+  {
+    return running_;
+  }
+
+  /** \brief Hand \e item to the first stage. Returns false if an older item that the first stage had not taken yet
+      was dropped in favor of \e item. */
+  bool push(T item)
+  {
+    if (stages_.empty())
+      return true;
+    return enqueue(0, std::move(item));
+  }
+
+  std::vector<UpdatePipelineStageStatistics> getStatistics() const
+  {
+    std::vector<UpdatePipelineStageStatistics> statistics;
+    statistics.reserve(stages_.size());
+    for (const std::unique_ptr<Stage>& stage : stages_)
+    {
+      UpdatePipelineStageStatistics& s = statistics.emplace_back();
+      s.name = stage->name;
+      s.processed = stage->processed;
+      s.dropped = stage->dropped;
+      s.last_latency = stage->last_latency_ns * 1e-9;
+      s.max_latency = stage->max_latency_ns * 1e-9;
+      s.average_latency = s.processed ? stage->total_latency_ns * 1e-9 / s.processed : 0.0;
+    }
+    return statistics;
+  }
+
+private:
+  struct Stage
+  {
+    Stage(const std::string& name, const StageFunction& function, std::size_t queue_capacity)
+      : name(name), function(function), input(queue_capacity)
+    {
+    }
+
+    const std::string name;
+    const StageFunction function;
+    LatestWinsQueue<T> input;
+    std::thread thread;
+
+    std::atomic<std::size_t> processed{ 0 };
+    std::atomic<std::size_t> dropped{ 0 };
+    std::atomic<std::uint64_t> last_latency_ns{ 0 };
+    std::atomic<std::uint64_t> max_latency_ns{ 0 };
+    std::atomic<std::uint64_t> total_latency_ns{ 0 };
+  };
+
+  bool enqueue(std::size_t index, T item)
+  {
+    if (stages_[index]->input.push(std::move(item)))
+      return true;
+    ++stages_[index]->dropped;
+    return false;
+  }
+
+  void runStage(std::size_t index)
+  {
+    Stage& stage = *stages_[index];
+    T item;
+    while (stage.input.pop(item))
+    {
+      const auto start = std::chrono::steady_clock::now();
+      bool pass_on = false;
+      try
+      {
+        pass_on = stage.function(item);
+      }
+      catch (std::exception& ex)
+      {
+        RCLCPP_ERROR(rclcpp::get_logger("moveit.ros.occupancy_map_update_pipeline"),
+                     "Exception in stage '%s' of the update pipeline: %s", stage.name.c_str(), ex.what());
+      }
+      const std::uint64_t latency =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+      stage.last_latency_ns = latency;
+      stage.total_latency_ns += latency;
+      std::uint64_t max_latency = stage.max_latency_ns;
+      while (latency > max_latency && !stage.max_latency_ns.compare_exchange_weak(max_latency, latency))
+        ;
+      ++stage.processed;
+
+      if (pass_on && index + 1 < stages_.size())
+        enqueue(index + 1, std::move(item));
+      item = T();
+    }
+  }
+
+  const std::size_t queue_capacity_;
+  std::atomic<bool> running_;
+  std::vector<std::unique_ptr<Stage>> stages_;
+};
+}  // namespace occupancy_map_monitor
@@ -189,6 +189,20 @@ void OccupancyMapMonitor::publishDebugInformation(bool flag)
     map_updater->publishDebugInformation(debug_info_);
 }
 
+std::vector<UpdatePipelineStageStatistics> OccupancyMapMonitor::getPipelineStatistics() const
+{
+  std::vector<UpdatePipelineStageStatistics> statistics;
+  for (const OccupancyMapUpdaterPtr& map_updater : map_updaters_)
+  {
+    for (UpdatePipelineStageStatistics& stage : map_updater->getPipelineStatistics())
+    {
+      stage.name = map_updater->getType() + "/" + stage.name;
+      statistics.push_back(std::move(stage));
+    }
+  }
+  return statistics;
+}
+
 void OccupancyMapMonitor::setMapFrame(const std::string& frame)
 {
   std::lock_guard<std::mutex> _(parameters_lock_);  // we lock since an updater could specify a new frame for us
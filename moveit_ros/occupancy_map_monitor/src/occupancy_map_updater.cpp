@@ -79,10 +79,16 @@ void OccupancyMapUpdater::setMonitor(OccupancyMapMonitor* monitor)
 
 bool OccupancyMapUpdater::updateTransformCache(const std::string& target_frame, const rclcpp::Time& target_time)
 {
-  transform_cache_.clear();
+  return updateTransformCache(target_frame, target_time, transform_cache_);
+}
+
+bool OccupancyMapUpdater::updateTransformCache(const std::string& target_frame, const rclcpp::Time& target_time,
+                                               ShapeTransformCache& cache)
+{
+  cache.clear();
   if (transform_provider_callback_)
   {
-    bool success = transform_provider_callback_(target_frame, target_time, transform_cache_);
+    bool success = transform_provider_callback_(target_frame, target_time, cache);
     if (!success)
     {
       rclcpp::Clock steady_clock(RCL_STEADY_TIME);
@@ -0,0 +1,200 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/update_pipeline.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using occupancy_map_monitor::LatestWinsQueue;
+using occupancy_map_monitor::UpdatePipeline;
+
+TEST(LatestWinsQueueTests, DropsOldestItem)
+{
+  LatestWinsQueue<int> queue(2);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(3));
+  EXPECT_EQ(queue.size(), 2u);
+
+  int item;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 2);
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 3);
+}
+
+TEST(LatestWinsQueueTests, CloseWakesUpConsumer)
+{
+  LatestWinsQueue<int> queue;
+  std::future<bool> popped = std::async(std::launch::async, [&queue] {
+    int item;
+    return queue.pop(item);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.close();
+  EXPECT_FALSE(popped.get());
+
+  // pushing to a closed queue discards the item
+  queue.push(1);
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(UpdatePipelineTests, StagesRunInOrder)
+{
+  std::promise<std::vector<int>> result;
+  UpdatePipeline<std::vector<int>> pipeline;
+  for (int i = 0; i < 3; ++i)
+  {
+    pipeline.addStage("stage" + std::to_string(i), [i](std::vector<int>& item) {
+      item.push_back(i);
+      return true;
+    });
+  }
+  pipeline.addStage("result", [&result](std::vector<int>& item) {
+    result.set_value(item);
+    return true;
+  });
+  pipeline.start();
+  pipeline.push({});
+
+  std::future<std::vector<int>> future = result.get_future();
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_EQ(future.get(), std::vector<int>({ 0, 1, 2 }));
+  pipeline.stop();
+
+  const std::vector<occupancy_map_monitor::UpdatePipelineStageStatistics> statistics = pipeline.getStatistics();
+  ASSERT_EQ(statistics.size(), 4u);
+  EXPECT_EQ(statistics[0].name, "stage0");
+  for (const occupancy_map_monitor::UpdatePipelineStageStatistics& stage : statistics)
+  {
+    EXPECT_EQ(stage.processed, 1u);
+    EXPECT_EQ(stage.dropped, 0u);
+    EXPECT_LE(stage.average_latency, stage.max_latency);
+  }
+}
+
+TEST(UpdatePipelineTests, LatestItemWins)
+{
+  // the first stage blocks until released, so the items pushed in the meantime pile up in front of it
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::atomic<bool> taken(false);
+  std::mutex results_lock;
+  std::vector<int> results;
+
+  UpdatePipeline<int> pipeline;
+  pipeline.addStage("slow", [&taken, released](int& /*item*/) {
+    taken = true;
+    released.wait();
+    return true;
+  });
+  pipeline.addStage("integrate", [&](int& item) {
+    std::scoped_lock slock(results_lock);
+    results.push_back(item);
+    return true;
+  });
+  pipeline.start();
+
+  EXPECT_TRUE(pipeline.push(0));
+  while (!taken)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_TRUE(pipeline.push(1));
+  for (int i = 2; i <= 5; ++i)
+    EXPECT_FALSE(pipeline.push(i));
+  release.set_value();
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    {
+      std::scoped_lock slock(results_lock);
+      if (!results.empty() && results.back() == 5)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pipeline.stop();
+
+  // the most recent item gets through, the ones that arrived while the first stage was busy were dropped.
+  // item 0 may also have been replaced by item 5 in front of the second stage.
+  std::scoped_lock slock(results_lock);
+  ASSERT_FALSE(results.empty());
+  EXPECT_EQ(results.back(), 5);
+  EXPECT_LE(results.size(), 2u);
+  EXPECT_EQ(pipeline.getStatistics()[0].dropped, 4u);
+  EXPECT_EQ(pipeline.getStatistics()[1].dropped, 2u - results.size());
+}
+
+TEST(UpdatePipelineTests, DiscardedItemsAreNotPassedOn)
+{
+  std::atomic<int> first(0), second(0);
+  UpdatePipeline<int> pipeline;
+  pipeline.addStage("filter", [&first](int& item) {
+    ++first;
+    return item % 2 == 0;
+  });
+  pipeline.addStage("sink", [&second](int& /*item*/) {
+    ++second;
+    return true;
+  });
+  pipeline.start();
+
+  // wait for each item to be taken before pushing the next one, so none are dropped
+  for (int i = 0; i < 4; ++i)
+  {
+    pipeline.push(i);
+    while (first <= i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (second < 2 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  pipeline.stop();
+
+  EXPECT_EQ(first, 4);
+  EXPECT_EQ(second, 2);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
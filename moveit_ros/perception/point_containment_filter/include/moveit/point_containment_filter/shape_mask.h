@@ -73,9 +73,16 @@ public:
 
   void setTransformCallback(const TransformCallback& transform_callback);
 
+  /** \brief Set the number of threads maskContainment() distributes the points over. 1 (the default) masks on the
+      calling thread, 0 uses one thread per hardware core. More threads mask large clouds faster, but can result in
+      a very high CPU consumption. */
+  void setThreadCount(unsigned int thread_count);
+
   /** \brief Compute the containment mask (INSIDE or OUTSIDE) for a given pointcloud. If a mask element is INSIDE, the
      point
       is inside the robot. The point is outside if the mask element is OUTSIDE.
+      Points closer than \e min_sensor_dist or farther than \e max_sensor_dist from the origin of the cloud's frame are
+      marked CLIP. The cloud is processed in blocks on up to setThreadCount() threads.
   */
   void maskContainment(const sensor_msgs::msg::PointCloud2& data_in, const Eigen::Vector3d& sensor_pos,
                        const double min_sensor_dist, const double max_sensor_dist, std::vector<int>& mask);
@@ -126,6 +133,7 @@ private:
 
   ShapeHandle next_handle_;
   ShapeHandle min_handle_;
+  unsigned int thread_count_;
   std::map<ShapeHandle, std::set<SeeShape, SortBodies>::iterator> used_handles_;
 };
 }  // namespace point_containment_filter
@@ -37,13 +37,49 @@
 #include <moveit/point_containment_filter/shape_mask.h>
 #include <geometric_shapes/body_operations.h>
 #include <sensor_msgs/point_cloud2_iterator.hpp>
+#include <moveit/utils/thread_pool.h>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/logging.hpp>
+#include <Eigen/Geometry>
+#include <cmath>
+#include <cstring>
 
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.perception.shape_mask");
 
+namespace
+{
+// Points are processed in blocks of this size, which is also the unit of work distributed over the threads
+constexpr std::size_t BLOCK_SIZE = 1024;
+
+// Handing out work to another thread for fewer points costs more than it saves
+constexpr std::size_t MIN_POINTS_PER_THREAD = 16384;
+
+// Copy the coordinates of points [first, first + count) into the arrays x, y and z
+void loadPoints(const sensor_msgs::msg::PointCloud2& cloud, std::size_t first, std::size_t count, double* x, double* y,
+                double* z)
+{
+  sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud, "z");
+  const std::size_t offset = first * cloud.point_step;
+  const auto* data_x = reinterpret_cast<const uint8_t*>(&*iter_x) + offset;
+  const auto* data_y = reinterpret_cast<const uint8_t*>(&*iter_y) + offset;
+  const auto* data_z = reinterpret_cast<const uint8_t*>(&*iter_z) + offset;
+  for (std::size_t k = 0; k < count; ++k)
+  {
+    float value;
+    std::memcpy(&value, data_x + k * cloud.point_step, sizeof(float));
+    x[k] = value;
+    std::memcpy(&value, data_y + k * cloud.point_step, sizeof(float));
+    y[k] = value;
+    std::memcpy(&value, data_z + k * cloud.point_step, sizeof(float));
+    z[k] = value;
+  }
+}
+}  // namespace
+
 point_containment_filter::ShapeMask::ShapeMask(const TransformCallback& transform_callback)
-  : transform_callback_(transform_callback), next_handle_(1), min_handle_(1)
+  : transform_callback_(transform_callback), next_handle_(1), min_handle_(1), thread_count_(1)
 {
 }
 
@@ -65,6 +101,12 @@ void point_containment_filter::ShapeMask::setTransformCallback(const TransformCa
   transform_callback_ = transform_callback;
 }
 
+void point_containment_filter::ShapeMask::setThreadCount(unsigned int thread_count)
+{
+  std::scoped_lock _(shapes_lock_);
+  thread_count_ = thread_count;
+}
+
 point_containment_filter::ShapeHandle point_containment_filter::ShapeMask::addShape(const shapes::ShapeConstPtr& shape,
                                                                                     double scale, double padding)
 {
@@ -133,8 +175,8 @@ void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::msg
   else
   {
     Eigen::Isometry3d tmp;
-    bspheres_.resize(bodies_.size());
-    std::size_t j = 0;
+    std::vector<const bodies::Body*> posed_bodies;
+    bspheres_.clear();
     for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end(); ++it)
     {
       if (!transform_callback_(it->handle, tmp))
@@ -152,42 +194,94 @@ void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::msg
       else
       {
         it->body->setPose(tmp);
-        it->body->computeBoundingSphere(bspheres_[j++]);
+        bspheres_.emplace_back();
+        it->body->computeBoundingSphere(bspheres_.back());
+        posed_bodies.push_back(it->body);
       }
     }
 
-    // compute a sphere that bounds the entire robot
-    bodies::BoundingSphere bound;
-    bodies::mergeBoundingSpheres(bspheres_, bound);
-    const double radius_squared = bound.radius * bound.radius;
-
-    // we now decide which points we keep
-    sensor_msgs::PointCloud2ConstIterator<float> iter_x(data_in, "x");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_y(data_in, "y");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_z(data_in, "z");
+    // Masking on several threads can result in very high CPU consumption, so it is only done if requested
+    moveit::core::ThreadPool& thread_pool = moveit::core::getThreadPool();
+    const std::size_t thread_count = std::min<std::size_t>(thread_pool.getNumThreads(thread_count_),
+                                                           std::max<std::size_t>(1, np / MIN_POINTS_PER_THREAD));
+    const std::size_t block_count = (np + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
-    // Cloud iterators are not incremented in the for loop, because of the pragma
-    // Comment out below parallelization as it can result in very high CPU consumption
-    //#pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < static_cast<int>(np); ++i)
-    {
-      Eigen::Vector3d pt = Eigen::Vector3d(*(iter_x + i), *(iter_y + i), *(iter_z + i));
-      double d = pt.norm();
-      int out = OUTSIDE;
-      if (d < min_sensor_dist || d > max_sensor_dist)
+    // first pass: clip points outside of the sensor range and bound the remaining ones
+    std::vector<Eigen::AlignedBox3d> block_bounds(block_count);
+    thread_pool.parallelFor(block_count, thread_count, [&](std::size_t block) {
+      const std::size_t first = block * BLOCK_SIZE;
+      const std::size_t count = std::min<std::size_t>(BLOCK_SIZE, np - first);
+      double x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+      loadPoints(data_in, first, count, x, y, z);
+      for (std::size_t k = 0; k < count; ++k)
       {
-        out = CLIP;
+        const double d = std::sqrt(x[k] * x[k] + y[k] * y[k] + z[k] * z[k]);
+        if (d < min_sensor_dist || d > max_sensor_dist)
+        {
+          mask[first + k] = CLIP;
+        }
+        else
+        {
+          mask[first + k] = OUTSIDE;
+          // invalid (NaN) points are not inside any body
+          if (!std::isnan(d))
+            block_bounds[block].extend(Eigen::Vector3d(x[k], y[k], z[k]));
+        }
       }
-      else if ((bound.center - pt).squaredNorm() < radius_squared)
+    });
+
+    Eigen::AlignedBox3d cloud_bounds;
+    for (const Eigen::AlignedBox3d& bounds : block_bounds)
+      cloud_bounds.extend(bounds);
+
+    // only bodies whose bounding sphere reaches into the bounds of the cloud can contain any points,
+    // they remain ordered by decreasing volume, so the most likely ones are tested first
+    struct Candidate
+    {
+      const bodies::Body* body;
+      Eigen::Vector3d center;
+      double radius_squared;
+    };
+    std::vector<Candidate> candidates;
+    for (std::size_t j = 0; j < posed_bodies.size(); ++j)
+    {
+      // leave some room for rounding in containsPoint()
+      const double radius = bspheres_[j].radius + 1e-6;
+      if (!cloud_bounds.isEmpty() && cloud_bounds.exteriorDistance(bspheres_[j].center) <= radius)
+        candidates.push_back({ posed_bodies[j], bspheres_[j].center, radius * radius });
+    }
+    if (candidates.empty())
+      return;
+
+    // second pass: test the remaining points against the candidate bodies,
+    // first against their bounding spheres for a whole block at once, then against the bodies themselves
+    thread_pool.parallelFor(block_count, thread_count, [&](std::size_t block) {
+      const std::size_t first = block * BLOCK_SIZE;
+      const std::size_t count = std::min<std::size_t>(BLOCK_SIZE, np - first);
+      double x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+      bool in_sphere[BLOCK_SIZE];
+      loadPoints(data_in, first, count, x, y, z);
+      int* block_mask = &mask[first];
+      for (const Candidate& candidate : candidates)
       {
-        for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end() && out == OUTSIDE; ++it)
+        const double cx = candidate.center.x();
+        const double cy = candidate.center.y();
+        const double cz = candidate.center.z();
+        for (std::size_t k = 0; k < count; ++k)
         {
-          if (it->body->containsPoint(pt))
-            out = INSIDE;
+          const double dx = x[k] - cx;
+          const double dy = y[k] - cy;
+          const double dz = z[k] - cz;
+          in_sphere[k] = dx * dx + dy * dy + dz * dz <= candidate.radius_squared;
+        }
+        for (std::size_t k = 0; k < count; ++k)
+        {
+          if (in_sphere[k] && block_mask[k] == OUTSIDE &&
+              candidate.body->containsPoint(Eigen::Vector3d(x[k], y[k], z[k])))
+            block_mask[k] = INSIDE;
         }
       }
-      mask[i] = out;
-    }
+    });
   }
 }
 
@@ -0,0 +1,171 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmark of ShapeMask::maskContainment() on synthetic clouds, checking the mask against single point queries */
+
+#include <moveit/point_containment_filter/shape_mask.h>
+#include <geometric_shapes/shapes.h>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using point_containment_filter::ShapeMask;
+
+namespace
+{
+// Helper class to measure time within a scoped block and output the result
+class ScopedTimer
+{
+  const char* const msg_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  ScopedTimer(const char* msg = "") : msg_(msg), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    std::cerr << msg_ << elapsed.count() * 1000. << "ms\n";
+  }
+};
+
+/** \brief A cloud of \e count points in the view frustum of a camera looking along z, 5% of them invalid */
+sensor_msgs::msg::PointCloud2 makeCloud(std::size_t count)
+{
+  sensor_msgs::msg::PointCloud2 cloud;
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(1, "xyz");
+  modifier.resize(count);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> depth(0.2f, 3.0f);
+  std::uniform_real_distribution<float> angle(-0.6f, 0.6f);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  for (std::size_t i = 0; i < count; ++i, ++iter_x, ++iter_y, ++iter_z)
+  {
+    const float z = unit(rng) < 0.05f ? std::nanf("") : depth(rng);
+    *iter_x = z * angle(rng);
+    *iter_y = z * angle(rng);
+    *iter_z = z;
+  }
+  return cloud;
+}
+}  // namespace
+
+TEST(ShapeMaskBenchmark, maskContainment)
+{
+  // a robot-like collection of links in front of the camera, and some out of its view
+  std::vector<Eigen::Isometry3d> poses(1);
+  ShapeMask shape_mask([&poses](point_containment_filter::ShapeHandle handle, Eigen::Isometry3d& pose) {
+    pose = poses.at(handle);
+    return true;
+  });
+  for (int i = 0; i < 30; ++i)
+  {
+    shapes::ShapeConstPtr shape;
+    switch (i % 3)
+    {
+      case 0:
+        shape = std::make_shared<shapes::Cylinder>(0.06, 0.3);
+        break;
+      case 1:
+        shape = std::make_shared<shapes::Box>(0.1, 0.15, 0.2);
+        break;
+      default:
+        shape = std::make_shared<shapes::Sphere>(0.08);
+    }
+    const point_containment_filter::ShapeHandle handle = shape_mask.addShape(shape, 1.0, 0.02);
+    ASSERT_NE(handle, 0u);
+    poses.resize(std::max<std::size_t>(poses.size(), handle + 1));
+    // the last third of the links is behind the camera
+    const double z = i < 20 ? 0.6 + 0.05 * i : -1.0 - 0.05 * i;
+    poses[handle] = Eigen::Translation3d(0.3 * std::sin(i), 0.2 * std::cos(i), z) *
+                    Eigen::AngleAxisd(0.4 * i, Eigen::Vector3d(1.0, 0.5, 0.2).normalized());
+  }
+
+  for (const std::size_t count : { 100000, 1000000 })
+  {
+    const sensor_msgs::msg::PointCloud2 cloud = makeCloud(count);
+    std::vector<int> mask_serial, mask_parallel;
+
+    shape_mask.setThreadCount(1);
+    {
+      const std::string msg = "maskContainment() of " + std::to_string(count) + " points on 1 thread: ";
+      ScopedTimer t(msg.c_str());
+      shape_mask.maskContainment(cloud, Eigen::Vector3d::Zero(), 0.3, 2.5, mask_serial);
+    }
+
+    shape_mask.setThreadCount(0);
+    {
+      const std::string msg = "maskContainment() of " + std::to_string(count) + " points on all cores: ";
+      ScopedTimer t(msg.c_str());
+      shape_mask.maskContainment(cloud, Eigen::Vector3d::Zero(), 0.3, 2.5, mask_parallel);
+    }
+    ASSERT_EQ(mask_serial, mask_parallel);
+
+    // compare to querying the points one by one
+    std::size_t inside = 0;
+    sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud, "z");
+    for (std::size_t i = 0; i < count; ++i, ++iter_x, ++iter_y, ++iter_z)
+    {
+      const Eigen::Vector3d point(*iter_x, *iter_y, *iter_z);
+      const double distance = point.norm();
+      if (distance < 0.3 || distance > 2.5)
+      {
+        ASSERT_EQ(mask_serial[i], ShapeMask::CLIP) << "point " << i;
+      }
+      else
+      {
+        ASSERT_EQ(mask_serial[i], shape_mask.getMaskContainment(point)) << "point " << i;
+        inside += mask_serial[i] == ShapeMask::INSIDE;
+      }
+    }
+    EXPECT_GT(inside, 0u);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
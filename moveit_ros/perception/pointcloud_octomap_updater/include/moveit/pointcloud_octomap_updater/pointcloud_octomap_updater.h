@@ -42,9 +42,12 @@
 #include <message_filters/subscriber.h>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <moveit/occupancy_map_monitor/occupancy_map_updater.h>
+#include <moveit/occupancy_map_monitor/update_pipeline.h>
 #include <moveit/point_containment_filter/shape_mask.h>
+#include <tf2/LinearMath/Transform.h>
 
 #include <memory>
+#include <vector>
 
 namespace occupancy_map_monitor
 {
@@ -61,14 +64,39 @@ public:
   void stop() override;
   ShapeHandle excludeShape(const shapes::ShapeConstPtr& shape) override;
   void forgetShape(ShapeHandle handle) override;
+  std::vector<UpdatePipelineStageStatistics> getPipelineStatistics() const override;
 
 protected:
   virtual void updateMask(const sensor_msgs::msg::PointCloud2& cloud, const Eigen::Vector3d& sensor_origin,
                           std::vector<int>& mask);
 
 private:
+  /** \brief A point cloud on its way through the update pipeline, along with the results of the stages so far */
+  struct CloudUpdate
+  {
+    sensor_msgs::msg::PointCloud2::ConstSharedPtr cloud;
+    rclcpp::Time received;
+    tf2::Transform map_h_sensor;
+    ShapeTransformCache transform_cache;
+    std::vector<int> mask;
+    octomap::KeySet free_cells, occupied_cells, model_cells;
+    std::unique_ptr<sensor_msgs::msg::PointCloud2> filtered_cloud;
+  };
+
   bool getShapeTransform(ShapeHandle h, Eigen::Isometry3d& transform) const;
   void cloudMsgCallback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& cloud_msg);
+
+  /* the stages of the update pipeline, in order */
+  bool ingestStage(CloudUpdate& update);
+  bool selfFilterStage(CloudUpdate& update);
+  bool raycastStage(CloudUpdate& update);
+  bool integrateStage(CloudUpdate& update);
+
+  /** \brief Compute the cells passed through by the rays from \e sensor_origin to each of the \e end_cells.
+      The rays are distributed over ray_casting_threads_ threads that collect the cells in sets of their own,
+      which are merged into \e free_cells at the end. The caller needs to hold the read lock of the tree. */
+  void computeFreeCells(const octomap::point3d& sensor_origin, const std::vector<octomap::OcTreeKey>& end_cells,
+                        octomap::KeySet& free_cells);
   void stopHelper();
 
   // TODO: Enable private node for publishing filtered point cloud
@@ -89,6 +117,11 @@ private:
   double max_range_;
   unsigned int point_subsample_;
   double max_update_rate_;
+  /** \brief Number of threads the free space of a cloud is ray cast on. 1 (the default) casts on the pipeline
+      thread, 0 uses one thread per core. More threads update large clouds faster, at the cost of CPU load. */
+  unsigned int ray_casting_threads_;
+  /** \brief Number of threads the self filter masks a cloud on, see ShapeMask::setThreadCount() */
+  unsigned int self_filter_threads_;
   std::string filtered_cloud_topic_;
   std::string ns_;
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr filtered_cloud_publisher_;
@@ -96,11 +129,14 @@ private:
   message_filters::Subscriber<sensor_msgs::msg::PointCloud2>* point_cloud_subscriber_;
   tf2_ros::MessageFilter<sensor_msgs::msg::PointCloud2>* point_cloud_filter_;
 
-  /* used to store all cells in the map which a given ray passes through during raycasting.
-     we cache this here because it dynamically pre-allocates a lot of memory in its contsructor */
-  octomap::KeyRay key_ray_;
+  /* used to store all cells in the map which a given ray passes through during raycasting, one per thread.
+     we cache these here because they dynamically pre-allocate a lot of memory in their constructor */
+  std::vector<octomap::KeyRay> key_rays_;
 
   std::unique_ptr<point_containment_filter::ShapeMask> shape_mask_;
-  std::vector<int> mask_;
+
+  /* the callback only hands clouds to this pipeline, so it never waits for a cloud to be integrated.
+     declared last, so its threads are stopped before any of the members above are destroyed */
+  std::unique_ptr<UpdatePipeline<CloudUpdate>> pipeline_;
 };
 }  // namespace occupancy_map_monitor
@@ -43,12 +43,22 @@
 #include <sensor_msgs/point_cloud2_iterator.hpp>
 #include <tf2_ros/create_timer_interface.h>
 #include <tf2_ros/create_timer_ros.h>
+#include <moveit/utils/thread_pool.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 namespace occupancy_map_monitor
 {
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("moveit.ros.perception.pointcloud_octomap_updater");
+
+// Rays are handed out to the ray casting threads in chunks of this size
+static constexpr std::size_t RAY_CHUNK_SIZE = 256;
+
+// Handing out work to another thread for fewer rays costs more than it saves
+static constexpr std::size_t MIN_RAYS_PER_THREAD = 2048;
+
 PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   : OccupancyMapUpdater("PointCloudUpdater")
   , scale_(1.0)
@@ -56,6 +66,8 @@ PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   , max_range_(std::numeric_limits<double>::infinity())
   , point_subsample_(1)
   , max_update_rate_(0)
+  , ray_casting_threads_(1)
+  , self_filter_threads_(1)
   , point_cloud_subscriber_(nullptr)
   , point_cloud_filter_(nullptr)
 {
@@ -70,6 +82,11 @@ bool PointCloudOctomapUpdater::setParams(const std::string& name_space)
 {
   // This parameter is optional
   node_->get_parameter_or(name_space + ".ns", ns_, std::string());
+  // These parameters are optional, 0 uses one thread per core
+  node_->get_parameter_or(name_space + ".ray_casting_threads", ray_casting_threads_, 1u);
+  node_->get_parameter_or(name_space + ".self_filter_threads", self_filter_threads_, 1u);
+  if (shape_mask_)
+    shape_mask_->setThreadCount(self_filter_threads_);
   return node_->get_parameter(name_space + ".point_cloud_topic", point_cloud_topic_) &&
          node_->get_parameter(name_space + ".max_range", max_range_) &&
          node_->get_parameter(name_space + ".padding_offset", padding_) &&
@@ -91,6 +108,12 @@ bool PointCloudOctomapUpdater::initialize(const rclcpp::Node::SharedPtr& node)
   shape_mask_->setTransformCallback(
       [this](ShapeHandle shape, Eigen::Isometry3d& tf) { return getShapeTransform(shape, tf); });
 
+  pipeline_ = std::make_unique<UpdatePipeline<CloudUpdate>>();
+  pipeline_->addStage("ingest", [this](CloudUpdate& update) { return ingestStage(update); });
+  pipeline_->addStage("self_filter", [this](CloudUpdate& update) { return selfFilterStage(update); });
+  pipeline_->addStage("raycast", [this](CloudUpdate& update) { return raycastStage(update); });
+  pipeline_->addStage("integrate", [this](CloudUpdate& update) { return integrateStage(update); });
+
   return true;
 }
 
@@ -109,6 +132,7 @@ void PointCloudOctomapUpdater::start()
 
   if (point_cloud_subscriber_)
     return;
+  pipeline_->start();
   /* subscribe to point cloud topic using tf filter*/
   point_cloud_subscriber_ = new message_filters::Subscriber<sensor_msgs::msg::PointCloud2>(node_, point_cloud_topic_,
                                                                                            rmw_qos_profile_sensor_data);
@@ -133,6 +157,8 @@ void PointCloudOctomapUpdater::stopHelper()
 {
   delete point_cloud_filter_;
   delete point_cloud_subscriber_;
+  if (pipeline_)
+    pipeline_->stop();
 }
 
 void PointCloudOctomapUpdater::stop()
@@ -162,6 +188,11 @@ void PointCloudOctomapUpdater::forgetShape(ShapeHandle handle)
     shape_mask_->removeShape(handle);
 }
 
+std::vector<UpdatePipelineStageStatistics> PointCloudOctomapUpdater::getPipelineStatistics() const
+{
+  return pipeline_ ? pipeline_->getStatistics() : std::vector<UpdatePipelineStageStatistics>();
+}
+
 bool PointCloudOctomapUpdater::getShapeTransform(ShapeHandle h, Eigen::Isometry3d& transform) const
 {
   ShapeTransformCache::const_iterator it = transform_cache_.find(h);
@@ -177,10 +208,48 @@ void PointCloudOctomapUpdater::updateMask(const sensor_msgs::msg::PointCloud2& /
 {
 }
 
+void PointCloudOctomapUpdater::computeFreeCells(const octomap::point3d& sensor_origin,
+                                                const std::vector<octomap::OcTreeKey>& end_cells,
+                                                octomap::KeySet& free_cells)
+{
+  moveit::core::ThreadPool& thread_pool = moveit::core::getThreadPool();
+  const std::size_t thread_count =
+      std::min<std::size_t>(thread_pool.getNumThreads(ray_casting_threads_),
+                            std::max<std::size_t>(1, end_cells.size() / MIN_RAYS_PER_THREAD));
+  if (key_rays_.size() < thread_count)
+    key_rays_.resize(thread_count);
+
+  // exceptions of the workers are rethrown here once all of them are done
+  std::vector<octomap::KeySet> thread_free_cells(thread_count);
+  std::atomic<std::size_t> next_ray(0);
+  thread_pool.run(thread_count, [&](std::size_t thread) {
+    octomap::KeyRay& key_ray = key_rays_[thread];
+    octomap::KeySet& cells = thread_free_cells[thread];
+    for (std::size_t first = next_ray.fetch_add(RAY_CHUNK_SIZE); first < end_cells.size();
+         first = next_ray.fetch_add(RAY_CHUNK_SIZE))
+    {
+      const std::size_t last = std::min(first + RAY_CHUNK_SIZE, end_cells.size());
+      for (std::size_t i = first; i < last; ++i)
+      {
+        if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(end_cells[i]), key_ray))
+          cells.insert(key_ray.begin(), key_ray.end());
+      }
+    }
+  });
+
+  // rays from the same origin share many cells, so start from the largest set and merge the others into it
+  auto largest =
+      std::max_element(thread_free_cells.begin(), thread_free_cells.end(),
+                       [](const octomap::KeySet& a, const octomap::KeySet& b) { return a.size() < b.size(); });
+  if (free_cells.empty())
+    free_cells.swap(*largest);
+  for (const octomap::KeySet& cells : thread_free_cells)
+    free_cells.insert(cells.begin(), cells.end());
+}
+
 void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& cloud_msg)
 {
   RCLCPP_DEBUG(LOGGER, "Received a new point cloud message");
-  rclcpp::Time start = rclcpp::Clock(RCL_ROS_TIME).now();
 
   if (max_update_rate_ > 0)
   {
@@ -190,49 +259,72 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
     last_update_time_ = node_->now();
   }
 
+  CloudUpdate update;
+  update.cloud = cloud_msg;
+  update.received = node_->now();
+  if (!pipeline_->push(std::move(update)))
+    RCLCPP_DEBUG(LOGGER, "Dropped a point cloud that was superseded before it could be processed");
+}
+
+bool PointCloudOctomapUpdater::ingestStage(CloudUpdate& update)
+{
+  const sensor_msgs::msg::PointCloud2& cloud = *update.cloud;
   if (monitor_->getMapFrame().empty())
-    monitor_->setMapFrame(cloud_msg->header.frame_id);
+    monitor_->setMapFrame(cloud.header.frame_id);
 
   /* get transform for cloud into map frame */
-  tf2::Stamped<tf2::Transform> map_h_sensor;
-  if (monitor_->getMapFrame() == cloud_msg->header.frame_id)
+  if (monitor_->getMapFrame() == cloud.header.frame_id)
   {
-    map_h_sensor.setIdentity();
+    update.map_h_sensor.setIdentity();
   }
   else
   {
-    if (tf_buffer_)
+    if (!tf_buffer_)
+      return false;
+    try
     {
-      try
-      {
-        tf2::fromMsg(tf_buffer_->lookupTransform(monitor_->getMapFrame(), cloud_msg->header.frame_id,
-                                                 cloud_msg->header.stamp),
-                     map_h_sensor);
-      }
-      catch (tf2::TransformException& ex)
-      {
-        RCLCPP_ERROR_STREAM(LOGGER, "Transform error of sensor data: " << ex.what() << "; quitting callback");
-        return;
-      }
+      tf2::Stamped<tf2::Transform> map_h_sensor;
+      tf2::fromMsg(tf_buffer_->lookupTransform(monitor_->getMapFrame(), cloud.header.frame_id, cloud.header.stamp),
+                   map_h_sensor);
+      update.map_h_sensor = map_h_sensor;
+    }
+    catch (tf2::TransformException& ex)
+    {
+      RCLCPP_ERROR_STREAM(LOGGER, "Transform error of sensor data: " << ex.what() << "; quitting callback");
+      return false;
     }
-    else
-      return;
   }
 
-  /* compute sensor origin in map frame */
-  const tf2::Vector3& sensor_origin_tf = map_h_sensor.getOrigin();
-  octomap::point3d sensor_origin(sensor_origin_tf.getX(), sensor_origin_tf.getY(), sensor_origin_tf.getZ());
-  Eigen::Vector3d sensor_origin_eigen(sensor_origin_tf.getX(), sensor_origin_tf.getY(), sensor_origin_tf.getZ());
+  return updateTransformCache(cloud.header.frame_id, cloud.header.stamp, update.transform_cache);
+}
 
-  if (!updateTransformCache(cloud_msg->header.frame_id, cloud_msg->header.stamp))
-    return;
+bool PointCloudOctomapUpdater::selfFilterStage(CloudUpdate& update)
+{
+  /* the shape mask looks up the transforms of the shapes in transform_cache_, which only this stage accesses */
+  transform_cache_.swap(update.transform_cache);
 
   /* mask out points on the robot */
-  shape_mask_->maskContainment(*cloud_msg, sensor_origin_eigen, 0.0, max_range_, mask_);
-  updateMask(*cloud_msg, sensor_origin_eigen, mask_);
+  const tf2::Vector3& sensor_origin_tf = update.map_h_sensor.getOrigin();
+  Eigen::Vector3d sensor_origin_eigen(sensor_origin_tf.getX(), sensor_origin_tf.getY(), sensor_origin_tf.getZ());
+  shape_mask_->maskContainment(*update.cloud, sensor_origin_eigen, 0.0, max_range_, update.mask);
+  updateMask(*update.cloud, sensor_origin_eigen, update.mask);
+  return true;
+}
 
-  octomap::KeySet free_cells, occupied_cells, model_cells, clip_cells;
-  std::unique_ptr<sensor_msgs::msg::PointCloud2> filtered_cloud;
+bool PointCloudOctomapUpdater::raycastStage(CloudUpdate& update)
+{
+  const sensor_msgs::msg::PointCloud2& cloud = *update.cloud;
+  const tf2::Transform& map_h_sensor = update.map_h_sensor;
+  const std::vector<int>& mask = update.mask;
+
+  /* compute sensor origin in map frame */
+  const tf2::Vector3& sensor_origin_tf = map_h_sensor.getOrigin();
+  octomap::point3d sensor_origin(sensor_origin_tf.getX(), sensor_origin_tf.getY(), sensor_origin_tf.getZ());
+
+  octomap::KeySet& free_cells = update.free_cells;
+  octomap::KeySet& occupied_cells = update.occupied_cells;
+  octomap::KeySet& model_cells = update.model_cells;
+  octomap::KeySet clip_cells;
 
   // We only use these iterators if we are creating a filtered_cloud for
   // publishing. We cannot default construct these, so we use unique_ptr's
@@ -243,16 +335,16 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
 
   if (!filtered_cloud_topic_.empty())
   {
-    filtered_cloud = std::make_unique<sensor_msgs::msg::PointCloud2>();
-    filtered_cloud->header = cloud_msg->header;
-    sensor_msgs::PointCloud2Modifier pcd_modifier(*filtered_cloud);
+    update.filtered_cloud = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    update.filtered_cloud->header = cloud.header;
+    sensor_msgs::PointCloud2Modifier pcd_modifier(*update.filtered_cloud);
     pcd_modifier.setPointCloud2FieldsByString(1, "xyz");
-    pcd_modifier.resize(cloud_msg->width * cloud_msg->height);
+    pcd_modifier.resize(cloud.width * cloud.height);
 
     // we have created a filtered_out, so we can create the iterators now
-    iter_filtered_x = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*filtered_cloud, "x");
-    iter_filtered_y = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*filtered_cloud, "y");
-    iter_filtered_z = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*filtered_cloud, "z");
+    iter_filtered_x = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*update.filtered_cloud, "x");
+    iter_filtered_y = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*update.filtered_cloud, "y");
+    iter_filtered_z = std::make_unique<sensor_msgs::PointCloud2Iterator<float>>(*update.filtered_cloud, "z");
   }
   size_t filtered_cloud_size = 0;
 
@@ -262,16 +354,16 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
   {
     /* do ray tracing to find which cells this point cloud indicates should be free, and which it indicates
      * should be occupied */
-    for (unsigned int row = 0; row < cloud_msg->height; row += point_subsample_)
+    for (unsigned int row = 0; row < cloud.height; row += point_subsample_)
     {
-      unsigned int row_c = row * cloud_msg->width;
-      sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
+      unsigned int row_c = row * cloud.width;
+      sensor_msgs::PointCloud2ConstIterator<float> pt_iter(cloud, "x");
       // set iterator to point at start of the current row
       pt_iter += row_c;
 
-      for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
+      for (unsigned int col = 0; col < cloud.width; col += point_subsample_, pt_iter += point_subsample_)
       {
-        // if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
+        // if (mask[row_c + col] == point_containment_filter::ShapeMask::CLIP)
         //  continue;
 
         /* check for NaN */
@@ -279,13 +371,13 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
         {
           /* occupied cell at ray endpoint if ray is shorter than max range and this point
              isn't on a part of the robot*/
-          if (mask_[row_c + col] == point_containment_filter::ShapeMask::INSIDE)
+          if (mask[row_c + col] == point_containment_filter::ShapeMask::INSIDE)
           {
             // transform to map frame
             tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
             model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
           }
-          else if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
+          else if (mask[row_c + col] == point_containment_filter::ShapeMask::CLIP)
           {
             tf2::Vector3 clipped_point_tf =
                 map_h_sensor * (tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]).normalize() * max_range_);
@@ -297,7 +389,7 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
             tf2::Vector3 point_tf = map_h_sensor * tf2::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
             occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
             // build list of valid points if we want to publish them
-            if (filtered_cloud)
+            if (update.filtered_cloud)
             {
               **iter_filtered_x = pt_iter[0];
               **iter_filtered_y = pt_iter[1];
@@ -312,31 +404,18 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
       }
     }
 
-    /* compute the free cells along each ray that ends at an occupied cell */
-    for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
-    {
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(occupied_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
-    }
-
-    /* compute the free cells along each ray that ends at a model cell */
-    for (const octomap::OcTreeKey& model_cell : model_cells)
-    {
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(model_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
-    }
-
-    /* compute the free cells along each ray that ends at a clipped cell */
-    for (const octomap::OcTreeKey& clip_cell : clip_cells)
-    {
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(clip_cell), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
-    }
+    /* compute the free cells along each ray that ends at an occupied, model or clipped cell */
+    std::vector<octomap::OcTreeKey> end_cells;
+    end_cells.reserve(occupied_cells.size() + model_cells.size() + clip_cells.size());
+    end_cells.insert(end_cells.end(), occupied_cells.begin(), occupied_cells.end());
+    end_cells.insert(end_cells.end(), model_cells.begin(), model_cells.end());
+    end_cells.insert(end_cells.end(), clip_cells.begin(), clip_cells.end());
+    computeFreeCells(sensor_origin, end_cells, free_cells);
   }
   catch (...)
   {
     tree_->unlockRead();
-    return;
+    return false;
   }
 
   tree_->unlockRead();
@@ -349,21 +428,31 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
   for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
     free_cells.erase(occupied_cell);
 
+  if (update.filtered_cloud)
+  {
+    sensor_msgs::PointCloud2Modifier pcd_modifier(*update.filtered_cloud);
+    pcd_modifier.resize(filtered_cloud_size);
+  }
+  return true;
+}
+
+bool PointCloudOctomapUpdater::integrateStage(CloudUpdate& update)
+{
   tree_->lockWrite();
 
   try
   {
     /* mark free cells only if not seen occupied in this cloud */
-    for (const octomap::OcTreeKey& free_cell : free_cells)
+    for (const octomap::OcTreeKey& free_cell : update.free_cells)
       tree_->updateNode(free_cell, false);
 
     /* now mark all occupied cells */
-    for (const octomap::OcTreeKey& occupied_cell : occupied_cells)
+    for (const octomap::OcTreeKey& occupied_cell : update.occupied_cells)
       tree_->updateNode(occupied_cell, true);
 
     // set the logodds to the minimum for the cells that are part of the model
     const float lg = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
-    for (const octomap::OcTreeKey& model_cell : model_cells)
+    for (const octomap::OcTreeKey& model_cell : update.model_cells)
       tree_->updateNode(model_cell, lg);
   }
   catch (...)
@@ -371,14 +460,11 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::msg::PointClo
     RCLCPP_ERROR(LOGGER, "Internal error while updating octree");
   }
   tree_->unlockWrite();
-  RCLCPP_DEBUG(LOGGER, "Processed point cloud in %lf ms", (node_->now() - start).seconds() * 1000.0);
+  RCLCPP_DEBUG(LOGGER, "Processed point cloud in %lf ms", (node_->now() - update.received).seconds() * 1000.0);
   tree_->triggerUpdateCallback();
 
-  if (filtered_cloud)
-  {
-    sensor_msgs::PointCloud2Modifier pcd_modifier(*filtered_cloud);
-    pcd_modifier.resize(filtered_cloud_size);
-    filtered_cloud_publisher_->publish(*filtered_cloud);
-  }
+  if (update.filtered_cloud)
+    filtered_cloud_publisher_->publish(*update.filtered_cloud);
+  return true;
 }
 }  // namespace occupancy_map_monitor
@@ -0,0 +1,129 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+using namespace std::chrono_literals;
+
+static const std::string ROBOT_DESCRIPTION = "robot_description";
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("evaluate_collision_checking_batch_speed");
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  auto node = rclcpp::Node::make_shared("evaluate_collision_checking_batch_speed");
+
+  unsigned int nstates = 10000;
+  unsigned int nthreads = 4;
+  boost::program_options::options_description desc;
+  desc.add_options()("nstates", boost::program_options::value<unsigned int>(&nstates)->default_value(nstates),
+                     "Number of random states in the batch")(
+      "nthreads", boost::program_options::value<unsigned int>(&nthreads)->default_value(nthreads),
+      "Number of threads for the parallel batch check")("help", "this screen");
+  boost::program_options::variables_map vm;
+  boost::program_options::parsed_options po = boost::program_options::parse_command_line(argc, argv, desc);
+  boost::program_options::store(po, vm);
+  boost::program_options::notify(vm);
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << '\n';
+    return 0;
+  }
+
+  planning_scene_monitor::PlanningSceneMonitor psm(node, ROBOT_DESCRIPTION);
+  if (!psm.getPlanningScene())
+  {
+    RCLCPP_ERROR(LOGGER, "Planning scene not configured");
+    return 1;
+  }
+  rclcpp::sleep_for(500ms);
+
+  const planning_scene::PlanningScene& scene = *psm.getPlanningScene();
+  const collision_detection::CollisionEnvConstPtr& env = scene.getCollisionEnv();
+  const collision_detection::AllowedCollisionMatrix& acm = scene.getAllowedCollisionMatrix();
+
+  RCLCPP_INFO(LOGGER, "Sampling %u random states...", nstates);
+  std::vector<moveit::core::RobotState> states(nstates, moveit::core::RobotState(scene.getRobotModel()));
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  state_ptrs.reserve(nstates);
+  for (moveit::core::RobotState& state : states)
+  {
+    state.setToRandomPositions();
+    state.update();
+    state_ptrs.push_back(&state);
+  }
+
+  collision_detection::CollisionRequest req;
+  auto report = [nstates](const char* name, const std::chrono::steady_clock::time_point& start, std::size_t hits) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    RCLCPP_INFO(LOGGER, "%s: %lf collision checks per second, %zu states in collision", name,
+                static_cast<double>(nstates) / elapsed.count(), hits);
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::size_t hits = 0;
+  for (const moveit::core::RobotState& state : states)
+  {
+    collision_detection::CollisionResult res;
+    env->checkCollision(req, res, state, acm);
+    hits += res.collision;
+  }
+  report("Individual checks", start, hits);
+
+  std::vector<collision_detection::CollisionResult> results;
+  auto count = [&results] {
+    return std::count_if(results.begin(), results.end(), [](const auto& res) { return res.collision; });
+  };
+
+  start = std::chrono::steady_clock::now();
+  env->checkCollisionBatch(req, results, state_ptrs, acm, 1);
+  report("Batch, 1 thread", start, count());
+
+  start = std::chrono::steady_clock::now();
+  env->checkCollisionBatch(req, results, state_ptrs, acm, nthreads);
+  report(("Batch, " + std::to_string(nthreads) + " threads").c_str(), start, count());
+
+  start = std::chrono::steady_clock::now();
+  env->checkCollisionBatch(req, results, state_ptrs, acm, nthreads, true);
+  report("Batch, stop at first collision", start, count());
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -46,6 +46,9 @@
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
 #include <moveit/collision_plugin_loader/collision_plugin_loader.h>
 #include <moveit_msgs/srv/get_planning_scene.hpp>
+#include <atomic>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <thread>
 #include <shared_mutex>
@@ -57,6 +60,21 @@
 namespace planning_scene_monitor
 {
 MOVEIT_CLASS_FORWARD(PlanningSceneMonitor);  // Defines PlanningSceneMonitorPtr, ConstPtr, WeakPtr... etc
+MOVEIT_STRUCT_FORWARD(PlanningSceneSnapshot);  // Defines PlanningSceneSnapshotPtr, ConstPtr, WeakPtr... etc
+
+/** @brief An immutable copy of the monitored scene, see PlanningSceneMonitor::getPlanningSceneSnapshot() */
+struct PlanningSceneSnapshot
+{
+  /** @brief The scene without the latest robot state. It is shared by consecutive snapshots for as long as only the
+   *  robot state changes, so its own current state may be older than \e state. */
+  planning_scene::PlanningSceneConstPtr scene;
+
+  /** @brief The current robot state of the monitored scene */
+  moveit::core::RobotStateConstPtr state;
+
+  /** @brief The planning scene version (see PlanningSceneMonitor::getPlanningSceneVersion()) of the snapshot */
+  std::uint64_t version;
+};
 
 /**
  * @brief PlanningSceneMonitor
@@ -222,6 +240,33 @@ public:
     return scene_const_;
   }
 
+  /** @brief Enable or disable publishing immutable snapshots of the monitored scene.
+   *
+   * While enabled, each update of the monitored scene publishes a copy of it that is never modified afterwards.
+   * getPlanningSceneSnapshot() returns the latest copy without taking any lock, so readers are neither blocked by
+   * nor block the (high-rate) state and geometry updates. A state update only copies the robot state, the scene is
+   * shared with the previous snapshot. Objects of the world, including a monitored octree, are shared with the
+   * snapshots: the octree still has to be locked for reading. */
+  void enablePlanningSceneSnapshots(bool flag);
+
+  /** @brief Return true if snapshots of the monitored scene are published */
+  bool planningSceneSnapshotsEnabled() const
+  {
+    return publish_snapshots_;
+  }
+
+  /** @brief Return the latest snapshot of the monitored scene, or nullptr if snapshots are not enabled.
+   * This function does not lock and the returned snapshot can be used for as long as needed. Queries should pass
+   * the snapshot's state explicitly, e.g. snapshot->scene->isStateColliding(*snapshot->state). */
+  PlanningSceneSnapshotConstPtr getPlanningSceneSnapshot() const;
+
+  /** @brief Return a counter that is incremented on every update of the monitored scene.
+   * Consumers caching data derived from the scene can compare versions to decide whether it is still valid. */
+  std::uint64_t getPlanningSceneVersion() const
+  {
+    return scene_version_;
+  }
+
   /** @brief Return true if the scene \e scene can be updated directly
       or indirectly by this monitor. This function will return true if
       the pointer of the scene is the same as the one maintained,
@@ -390,8 +435,13 @@ public:
   /** @brief Stop the world geometry monitor */
   void stopWorldGeometryMonitor();
 
-  /** @brief Add a function to be called when an update to the scene is received */
-  void addUpdateCallback(const std::function<void(SceneUpdateType)>& fn);
+  /** @brief Add a function to be called when an update to the scene is received
+   *  @return An id to remove the function again with removeUpdateCallback(), 0 if \e fn is empty */
+  std::size_t addUpdateCallback(const std::function<void(SceneUpdateType)>& fn);
+
+  /** @brief Remove the function with the id \e callback_id returned by addUpdateCallback(). The function is not
+   *  running anymore and will not be called again once this returns. Unknown ids are ignored. */
+  void removeUpdateCallback(std::size_t callback_id);
 
   /** @brief Clear the functions to be called when an update to the scene is received */
   void clearUpdateCallbacks();
@@ -442,6 +492,9 @@ protected:
    */
   void unlockSceneWrite();
 
+  /** @brief Publish a new snapshot of the scene, the caller has to hold scene_update_mutex_ (shared or exclusive) */
+  void publishPlanningSceneSnapshot(SceneUpdateType update_type);
+
   /** @brief Configure the collision matrix for a particular scene */
   void configureCollisionMatrix(const planning_scene::PlanningScenePtr& scene);
 
@@ -490,6 +543,13 @@ protected:
   planning_scene::PlanningSceneConstPtr scene_const_;
   planning_scene::PlanningScenePtr parent_scene_;  /// if diffs are monitored, this is the pointer to the parent scene
   std::shared_mutex scene_update_mutex_;           /// mutex for stored scene
+
+  std::atomic<bool> publish_snapshots_;
+  std::atomic<std::uint64_t> scene_version_;
+  /// updates beyond the robot state that are counted in scene_version_ but whose snapshot is not published yet
+  std::atomic<unsigned int> pending_scene_updates_;
+  std::mutex snapshot_lock_;  /// serializes publishers of scene_snapshot_, always taken after scene_update_mutex_
+  PlanningSceneSnapshotConstPtr scene_snapshot_;  /// read and written with std::atomic_load/store
   rclcpp::Time last_update_time_;                  /// Last time the state was updated
   rclcpp::Time last_robot_motion_time_;            /// Last time the robot has moved
 
@@ -560,8 +620,9 @@ protected:
 
   /// lock access to update_callbacks_
   std::recursive_mutex update_lock_;
-  std::vector<std::function<void(SceneUpdateType)> > update_callbacks_;  /// List of callbacks to trigger when updates
-                                                                         /// are received
+  std::map<std::size_t, std::function<void(SceneUpdateType)> > update_callbacks_;  /// Callbacks to trigger when
+                                                                                  /// updates are received, by id
+  std::size_t last_update_callback_id_ = 0;
 
 private:
   void getUpdatedFrameTransforms(std::vector<geometry_msgs::msg::TransformStamped>& transforms);
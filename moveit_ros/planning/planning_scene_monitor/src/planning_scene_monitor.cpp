@@ -199,6 +199,9 @@ void PlanningSceneMonitor::initialize(const planning_scene::PlanningScenePtr& sc
 
   publish_planning_scene_frequency_ = 2.0;
   new_scene_update_ = UPDATE_NONE;
+  publish_snapshots_ = false;
+  scene_version_ = 0;
+  pending_scene_updates_ = 0;
 
   last_update_time_ = last_robot_motion_time_ = rclcpp::Clock().now();
   last_robot_state_update_wall_time_ = std::chrono::system_clock::now();
@@ -534,13 +537,75 @@ bool PlanningSceneMonitor::updatesScene(const planning_scene::PlanningSceneConst
   return sceneIsParentOf(scene_const_, scene.get());
 }
 
+void PlanningSceneMonitor::enablePlanningSceneSnapshots(bool flag)
+{
+  std::shared_lock<std::shared_mutex> lock(scene_update_mutex_);
+  publish_snapshots_ = flag;
+  if (flag)
+  {
+    publishPlanningSceneSnapshot(UPDATE_SCENE);
+  }
+  else
+  {
+    std::scoped_lock slock(snapshot_lock_);
+    std::atomic_store(&scene_snapshot_, PlanningSceneSnapshotConstPtr());
+  }
+}
+
+PlanningSceneSnapshotConstPtr PlanningSceneMonitor::getPlanningSceneSnapshot() const
+{
+  return std::atomic_load(&scene_snapshot_);
+}
+
+void PlanningSceneMonitor::publishPlanningSceneSnapshot(SceneUpdateType update_type)
+{
+  if (!scene_)
+    return;
+
+  std::scoped_lock slock(snapshot_lock_);
+  if (!publish_snapshots_)
+    return;
+
+  auto snapshot = std::make_shared<PlanningSceneSnapshot>();
+  // read the version before copying: the copy contains at least all updates counted so far
+  snapshot->version = scene_version_;
+
+  const PlanningSceneSnapshotConstPtr previous = std::atomic_load(&scene_snapshot_);
+  if (update_type == UPDATE_STATE && previous && pending_scene_updates_ == 0)
+  {
+    // only the robot state changed since the previous snapshot, the rest of the scene is shared with it
+    snapshot->scene = previous->scene;
+  }
+  else
+  {
+    // the world objects and their collision geometry are shared copy-on-write, they are not duplicated
+    snapshot->scene = planning_scene::PlanningScene::clone(scene_);
+  }
+  snapshot->state = std::make_shared<const moveit::core::RobotState>(scene_->getCurrentState());
+  std::atomic_store(&scene_snapshot_, PlanningSceneSnapshotConstPtr(std::move(snapshot)));
+}
+
 void PlanningSceneMonitor::triggerSceneUpdateEvent(SceneUpdateType update_type)
 {
+  // the scene was modified before the version is counted, so until its snapshot is published, snapshots of state
+  // updates with a newer version must copy the scene instead of sharing the scene of the previous snapshot
+  const bool scene_update = update_type != UPDATE_STATE;
+  if (scene_update)
+    ++pending_scene_updates_;
+  ++scene_version_;
+  if (publish_snapshots_)
+  {
+    std::shared_lock<std::shared_mutex> slock(scene_update_mutex_);
+    publishPlanningSceneSnapshot(update_type);
+  }
+  if (scene_update)
+    --pending_scene_updates_;
+
   // do not modify update functions while we are calling them
   std::scoped_lock lock(update_lock_);
 
-  for (std::function<void(SceneUpdateType)>& update_callback : update_callbacks_)
-    update_callback(update_type);
+  for (std::pair<const std::size_t, std::function<void(SceneUpdateType)> >& update_callback : update_callbacks_)
+    update_callback.second(update_type);
   new_scene_update_ = static_cast<SceneUpdateType>(static_cast<int>(new_scene_update_) | static_cast<int>(update_type));
   new_scene_update_condition_.notify_all();
 }
@@ -1114,6 +1179,9 @@ void PlanningSceneMonitor::lockSceneWrite()
 
 void PlanningSceneMonitor::unlockSceneWrite()
 {
+  // the scene may have been modified in any way through a LockedPlanningSceneRW
+  ++scene_version_;
+  publishPlanningSceneSnapshot(UPDATE_SCENE);
   if (octomap_monitor_)
     octomap_monitor_->getOcTreePtr()->unlockWrite();
   scene_update_mutex_.unlock();
@@ -1479,11 +1547,19 @@ void PlanningSceneMonitor::updateSceneWithCurrentState()
   }
 }
 
-void PlanningSceneMonitor::addUpdateCallback(const std::function<void(SceneUpdateType)>& fn)
+std::size_t PlanningSceneMonitor::addUpdateCallback(const std::function<void(SceneUpdateType)>& fn)
+{
+  std::scoped_lock lock(update_lock_);
+  if (!fn)
+    return 0;
+  update_callbacks_.emplace(++last_update_callback_id_, fn);
+  return last_update_callback_id_;
+}
+
+void PlanningSceneMonitor::removeUpdateCallback(std::size_t callback_id)
 {
   std::scoped_lock lock(update_lock_);
-  if (fn)
-    update_callbacks_.push_back(fn);
+  update_callbacks_.erase(callback_id);
 }
 
 void PlanningSceneMonitor::clearUpdateCallbacks()
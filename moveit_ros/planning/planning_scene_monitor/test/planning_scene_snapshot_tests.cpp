@@ -0,0 +1,256 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2023, PickNik Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <geometric_shapes/shapes.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit/rdf_loader/rdf_loader.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <rclcpp/rclcpp.hpp>
+
+using planning_scene_monitor::PlanningSceneMonitor;
+
+static const std::vector<std::string> ARM_JOINTS = { "panda_joint1", "panda_joint2", "panda_joint3", "panda_joint4",
+                                                     "panda_joint5", "panda_joint6", "panda_joint7" };
+
+class PlanningSceneSnapshotTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    node_ = std::make_shared<rclcpp::Node>("planning_scene_snapshot_test");
+    robot_model_loader::RobotModelLoader::Options opt;
+    ASSERT_TRUE(rdf_loader::RDFLoader::loadPkgFileToString(opt.urdf_string_, "moveit_resources_panda_description",
+                                                           "urdf/panda.urdf", {}));
+    ASSERT_TRUE(rdf_loader::RDFLoader::loadPkgFileToString(opt.srdf_string_, "moveit_resources_panda_moveit_config",
+                                                           "config/panda.srdf", {}));
+    opt.load_kinematics_solvers_ = false;
+    psm_ = std::make_shared<PlanningSceneMonitor>(node_,
+                                                  std::make_shared<robot_model_loader::RobotModelLoader>(node_, opt));
+    ASSERT_TRUE(psm_->getPlanningScene());
+  }
+
+  /** \brief Move all arm joints of the monitored scene to \e position and report a state-only update */
+  void updateState(double position)
+  {
+    moveit::core::RobotState& state = psm_->getPlanningScene()->getCurrentStateNonConst();
+    for (const std::string& joint : ARM_JOINTS)
+      state.setVariablePosition(joint, position);
+    state.update();
+    psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_STATE);
+  }
+
+  /** \brief Add a box to the world of the monitored scene through a write lock */
+  void addBox(const std::string& id, double x)
+  {
+    planning_scene_monitor::LockedPlanningSceneRW scene(psm_);
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation().x() = x;
+    scene->getWorldNonConst()->addToObject(id, std::make_shared<const shapes::Box>(0.1, 0.1, 0.1), pose);
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  planning_scene_monitor::PlanningSceneMonitorPtr psm_;
+};
+
+TEST_F(PlanningSceneSnapshotTest, DisabledByDefault)
+{
+  EXPECT_FALSE(psm_->planningSceneSnapshotsEnabled());
+  EXPECT_FALSE(psm_->getPlanningSceneSnapshot());
+
+  const std::uint64_t version = psm_->getPlanningSceneVersion();
+  updateState(0.1);
+  EXPECT_GT(psm_->getPlanningSceneVersion(), version);
+  EXPECT_FALSE(psm_->getPlanningSceneSnapshot());
+
+  psm_->enablePlanningSceneSnapshots(true);
+  ASSERT_TRUE(psm_->getPlanningSceneSnapshot());
+  psm_->enablePlanningSceneSnapshots(false);
+  EXPECT_FALSE(psm_->getPlanningSceneSnapshot());
+}
+
+TEST_F(PlanningSceneSnapshotTest, StateUpdateSharesScene)
+{
+  psm_->enablePlanningSceneSnapshots(true);
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr first = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(first);
+
+  updateState(0.2);
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr second = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(second);
+  EXPECT_GT(second->version, first->version);
+  EXPECT_EQ(second->version, psm_->getPlanningSceneVersion());
+
+  // only the state is copied, the scene is the same object
+  EXPECT_EQ(second->scene, first->scene);
+  EXPECT_NE(second->state, first->state);
+  EXPECT_DOUBLE_EQ(second->state->getVariablePosition("panda_joint1"), 0.2);
+
+  // earlier snapshots are not modified
+  EXPECT_NE(first->state->getVariablePosition("panda_joint1"), 0.2);
+  EXPECT_NE(first->scene->getCurrentState().getVariablePosition("panda_joint1"), 0.2);
+}
+
+TEST_F(PlanningSceneSnapshotTest, GeometryUpdateCopiesScene)
+{
+  psm_->enablePlanningSceneSnapshots(true);
+  updateState(0.3);
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr first = psm_->getPlanningSceneSnapshot();
+
+  addBox("box", 1.0);
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr second = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(second);
+  EXPECT_GT(second->version, first->version);
+  EXPECT_NE(second->scene, first->scene);
+  EXPECT_TRUE(second->scene->getWorld()->hasObject("box"));
+  EXPECT_FALSE(first->scene->getWorld()->hasObject("box"));
+
+  // the new scene carries the current state as well
+  EXPECT_DOUBLE_EQ(second->state->getVariablePosition("panda_joint1"), 0.3);
+  EXPECT_DOUBLE_EQ(second->scene->getCurrentState().getVariablePosition("panda_joint1"), 0.3);
+
+  // the next state update shares the scene with the box
+  updateState(0.4);
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr third = psm_->getPlanningSceneSnapshot();
+  EXPECT_EQ(third->scene, second->scene);
+  EXPECT_DOUBLE_EQ(third->state->getVariablePosition("panda_joint1"), 0.4);
+}
+
+TEST_F(PlanningSceneSnapshotTest, ConsistentUnderConcurrentUpdates)
+{
+  psm_->enablePlanningSceneSnapshots(true);
+  constexpr int UPDATES = 500;
+  std::atomic<bool> done(false);
+
+  // every snapshot has to show one complete update, and neither versions nor states may go backwards
+  auto read = [&]() {
+    std::uint64_t last_version = 0;
+    double last_position = -1.0;
+    while (!done)
+    {
+      const planning_scene_monitor::PlanningSceneSnapshotConstPtr snapshot = psm_->getPlanningSceneSnapshot();
+      ASSERT_TRUE(snapshot && snapshot->scene && snapshot->state);
+      EXPECT_GE(snapshot->version, last_version);
+      const double position = snapshot->state->getVariablePosition(ARM_JOINTS.front());
+      for (const std::string& joint : ARM_JOINTS)
+        EXPECT_EQ(snapshot->state->getVariablePosition(joint), position);
+      EXPECT_GE(position, last_position);
+      last_version = snapshot->version;
+      last_position = position;
+    }
+  };
+
+  updateState(0.0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i)
+    readers.emplace_back(read);
+
+  for (int k = 1; k <= UPDATES; ++k)
+  {
+    updateState(k * 1e-3);
+    if (k % 50 == 0)
+      addBox("box" + std::to_string(k), k * 1e-2);
+  }
+  done = true;
+  for (std::thread& reader : readers)
+    reader.join();
+
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr last = psm_->getPlanningSceneSnapshot();
+  EXPECT_EQ(last->version, psm_->getPlanningSceneVersion());
+  EXPECT_DOUBLE_EQ(last->state->getVariablePosition(ARM_JOINTS.back()), UPDATES * 1e-3);
+  EXPECT_TRUE(last->scene->getWorld()->hasObject("box" + std::to_string(UPDATES)));
+}
+
+TEST_F(PlanningSceneSnapshotTest, StateUpdatesDoNotHideGeometryUpdates)
+{
+  psm_->enablePlanningSceneSnapshots(true);
+  constexpr int UPDATES = 100;
+  std::atomic<bool> done(false);
+
+  // geometry updates are counted after the scene update lock is released, the snapshots of state updates running in
+  // between must not pair the new version with the old world
+  std::thread state_updates([&]() {
+    while (!done)
+      psm_->triggerSceneUpdateEvent(PlanningSceneMonitor::UPDATE_STATE);
+  });
+  std::thread reader([&]() {
+    std::map<std::uint64_t, std::size_t> num_objects;
+    while (!done)
+    {
+      const planning_scene_monitor::PlanningSceneSnapshotConstPtr snapshot = psm_->getPlanningSceneSnapshot();
+      const std::size_t size = snapshot->scene->getWorld()->size();
+      const auto it = num_objects.emplace(snapshot->version, size).first;
+      EXPECT_EQ(it->second, size) << "version " << snapshot->version;
+      if (it != num_objects.begin())
+        EXPECT_LE(std::prev(it)->second, size);
+    }
+  });
+
+  for (int k = 0; k < UPDATES; ++k)
+  {
+    moveit_msgs::msg::PlanningScene msg;
+    msg.is_diff = true;
+    moveit_msgs::msg::CollisionObject& object = msg.world.collision_objects.emplace_back();
+    object.header.frame_id = psm_->getPlanningScene()->getPlanningFrame();
+    object.id = "box" + std::to_string(k);
+    object.operation = moveit_msgs::msg::CollisionObject::ADD;
+    object.primitives.emplace_back().type = shape_msgs::msg::SolidPrimitive::BOX;
+    object.primitives.back().dimensions = { 0.1, 0.1, 0.1 };
+    object.primitive_poses.emplace_back().orientation.w = 1.0;
+    ASSERT_TRUE(psm_->newPlanningSceneMessage(msg));
+  }
+  done = true;
+  state_updates.join();
+  reader.join();
+
+  const planning_scene_monitor::PlanningSceneSnapshotConstPtr last = psm_->getPlanningSceneSnapshot();
+  EXPECT_EQ(last->version, psm_->getPlanningSceneVersion());
+  EXPECT_EQ(last->scene->getWorld()->size(), static_cast<std::size_t>(UPDATES));
+}
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  ::testing::InitGoogleTest(&argc, argv);
+  const int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}